@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <BenchHarness.h>
+
+////////////////// STATE /////////////////////////
+
+bool BenchState::KeepRunning()
+{
+    if (!m_started)
+    {
+        m_started = true;
+        m_scenarioStart = Clock::now();
+        m_batchStart = m_scenarioStart;
+    }
+    if (m_batchDone < m_batchSize)
+    {
+        m_batchDone++;
+        return true;
+    }
+
+    EndSample();
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - m_scenarioStart).count();
+    if (m_sampleNs.size() >= BENCH_NUM_SAMPLES
+        || (m_sampleNs.size() >= BENCH_MIN_SAMPLES && elapsed > BENCH_MAX_SCENARIO_SECONDS))
+    {
+        return false;
+    }
+
+    m_batchTime = Clock::duration(0);
+    m_batchDone = 1;
+    m_batchStart = Clock::now();
+    return true;
+}
+
+void BenchState::EndSample()
+{
+    if (!m_paused)
+    {
+        m_batchTime += Clock::now() - m_batchStart;
+    }
+    m_paused = false;
+    double batchNs = std::chrono::duration<double, std::nano>(m_batchTime).count();
+
+    if (m_calibrating)
+    {
+        const double minSampleNs = BENCH_MIN_SAMPLE_MS * 1000000.0;
+        if (batchNs < minSampleNs)
+        {
+            // Aim a little past the minimum, but never grow more than 10x on one noisy sample
+            double scale = batchNs > 0.0 ? minSampleNs / batchNs * 1.2 : 10.0;
+            unsigned long long grown = (unsigned long long)(m_batchSize * std::min(scale, 10.0));
+            m_batchSize = std::max(m_batchSize + 1, grown);
+            return;
+        }
+        m_calibrating = false;
+    }
+
+    if (m_warmupLeft > 0)
+    {
+        m_warmupLeft--;
+        return;
+    }
+    m_sampleNs.push_back(batchNs / m_batchSize);
+    m_result->iterations += m_batchSize;
+}
+
+void BenchState::PauseTiming()
+{
+    if (!m_paused)
+    {
+        m_batchTime += Clock::now() - m_batchStart;
+        m_paused = true;
+    }
+}
+
+void BenchState::ResumeTiming()
+{
+    if (m_paused)
+    {
+        m_paused = false;
+        m_batchStart = Clock::now();
+    }
+}
+
+void BenchState::Skip(const std::string& reason)
+{
+    m_result->skipped = true;
+    m_result->skipReason = reason;
+}
+
+void BenchState::Fail(const std::string& reason)
+{
+    // The first failure is usually the one that explains the rest
+    if (!m_result->failed)
+    {
+        m_result->failed = true;
+        m_result->failReason = reason;
+    }
+}
+
+void BenchState::SetItemsPerIteration(unsigned long long items)
+{
+    m_result->itemsPerIteration = items;
+}
+
+////////////////// HARNESS /////////////////////////
+
+static std::string FormatTime(double ns)
+{
+    char text[32];
+    if (ns < 1000.0)
+    {
+        std::snprintf(text, sizeof(text), "%.1f ns", ns);
+    }
+    else if (ns < 1000000.0)
+    {
+        std::snprintf(text, sizeof(text), "%.2f us", ns / 1000.0);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.2f ms", ns / 1000000.0);
+    }
+    return text;
+}
+
+static void WriteJsonString(FILE* file, const std::string& text)
+{
+    std::fputc('"', file);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            std::fputc('\\', file);
+        }
+        std::fputc((unsigned char)c < 0x20 ? ' ' : c, file);
+    }
+    std::fputc('"', file);
+}
+
+void BenchHarness::Add(const std::string& name, Scenario scenario)
+{
+    m_scenarios.push_back({ name, scenario });
+}
+
+void BenchHarness::SetFilter(const std::string& filter)
+{
+    m_filter = filter;
+}
+
+void BenchHarness::RunAll()
+{
+    std::printf("%-40s %12s %12s %8s %14s\n", "Scenario", "median", "min", "stddev", "items/s");
+    for (const Entry& entry : m_scenarios)
+    {
+        if (!m_filter.empty() && entry.name.find(m_filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        BenchResult result;
+        result.name = entry.name;
+        BenchState state;
+        state.m_result = &result;
+        entry.scenario(state);
+
+        // Timings for a wrong result aren't worth comparing
+        if (result.failed)
+        {
+            std::printf("%-40s FAILED: %s\n", result.name.c_str(), result.failReason.c_str());
+            m_results.push_back(result);
+            continue;
+        }
+        if (!result.skipped && state.m_sampleNs.empty())
+        {
+            result.skipped = true;
+            result.skipReason = "never entered its loop";
+        }
+        if (result.skipped)
+        {
+            std::printf("%-40s skipped: %s\n", result.name.c_str(), result.skipReason.c_str());
+            m_results.push_back(result);
+            continue;
+        }
+
+        std::vector<double> samples = state.m_sampleNs;
+        std::sort(samples.begin(), samples.end());
+        size_t count = samples.size();
+        result.samples = (unsigned int)count;
+        result.minNs = samples[0];
+        result.medianNs = (count % 2) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+        double sum = 0.0;
+        for (double sample : samples)
+        {
+            sum += sample;
+        }
+        result.meanNs = sum / count;
+        double variance = 0.0;
+        for (double sample : samples)
+        {
+            variance += (sample - result.meanNs) * (sample - result.meanNs);
+        }
+        result.stddevNs = count > 1 ? std::sqrt(variance / (count - 1)) : 0.0;
+
+        char itemsPerSecond[32] = "";
+        if (result.itemsPerIteration > 0)
+        {
+            std::snprintf(itemsPerSecond, sizeof(itemsPerSecond), "%.3g", result.itemsPerIteration * 1e9 / result.medianNs);
+        }
+        std::printf("%-40s %12s %12s %7.1f%% %14s\n", result.name.c_str(), FormatTime(result.medianNs).c_str(),
+            FormatTime(result.minNs).c_str(), result.stddevNs / result.meanNs * 100.0, itemsPerSecond);
+        std::fflush(stdout);
+        m_results.push_back(result);
+    }
+}
+
+const std::vector<BenchResult>& BenchHarness::GetResults() const
+{
+    return m_results;
+}
+
+unsigned int BenchHarness::GetNumFailed() const
+{
+    unsigned int numFailed = 0;
+    for (const BenchResult& result : m_results)
+    {
+        if (result.failed)
+        {
+            numFailed++;
+        }
+    }
+    return numFailed;
+}
+
+bool BenchHarness::WriteJSON(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    char date[32];
+    std::time_t now = std::time(NULL);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+
+    std::fprintf(file, "{\n  \"context\": {\"date\": \"%s\", \"build_type\": \"%s\", \"hardware_threads\": %u, "
+        "\"min_sample_ms\": %.1f, \"samples\": %d},\n  \"benchmarks\": [\n",
+        date, buildType, std::thread::hardware_concurrency(), BENCH_MIN_SAMPLE_MS, BENCH_NUM_SAMPLES);
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const BenchResult& result = m_results[i];
+        std::fprintf(file, "    {\"name\": ");
+        WriteJsonString(file, result.name);
+        if (result.failed)
+        {
+            std::fprintf(file, ", \"failed\": true, \"reason\": ");
+            WriteJsonString(file, result.failReason);
+        }
+        else if (result.skipped)
+        {
+            std::fprintf(file, ", \"skipped\": true, \"reason\": ");
+            WriteJsonString(file, result.skipReason);
+        }
+        else
+        {
+            std::fprintf(file, ", \"iterations\": %llu, \"samples\": %u, \"median_ns\": %.3f, \"mean_ns\": %.3f, "
+                "\"min_ns\": %.3f, \"stddev_ns\": %.3f, \"items_per_iteration\": %llu",
+                result.iterations, result.samples, result.medianNs, result.meanNs, result.minNs, result.stddevNs,
+                result.itemsPerIteration);
+        }
+        std::fprintf(file, "}%s\n", i + 1 < m_results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Compares two engine_bench result files and flags scenarios that got slower.
+
+    python3 compare.py baseline.json current.json [--threshold 10]
+
+A scenario regresses when its median time grew by more than the threshold (percent), or when its
+own checks failed in the current run. Exits with 1 if anything regressed, so it can gate a build.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        results = json.load(file)
+    return {bench["name"]: bench for bench in results["benchmarks"]}
+
+
+def format_time(ns):
+    if ns < 1e3:
+        return "%.1f ns" % ns
+    if ns < 1e6:
+        return "%.2f us" % (ns / 1e3)
+    return "%.2f ms" % (ns / 1e6)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two engine_bench result files")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slowdown of the median that counts as a regression (default 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = []
+    print("%-40s %12s %12s %9s" % ("Scenario", "baseline", "current", "change"))
+    for name in sorted(set(baseline) | set(current)):
+        old = baseline.get(name)
+        new = current.get(name)
+        if old is None or new is None:
+            print("%-40s %s" % (name, "only in current" if old is None else "only in baseline"))
+            continue
+        if new.get("failed"):
+            print("%-40s FAILED: %s" % (name, new.get("reason", "")))
+            regressions.append(name)
+            continue
+        if old.get("failed") or old.get("skipped") or new.get("skipped"):
+            print("%-40s skipped" % name)
+            continue
+
+        change = (new["median_ns"] - old["median_ns"]) / old["median_ns"] * 100.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        elif change < -args.threshold:
+            flag = "  faster"
+        print("%-40s %12s %12s %+8.1f%%%s" % (name, format_time(old["median_ns"]), format_time(new["median_ns"]),
+                                            change, flag))
+
+    if regressions:
+        print("\n%d scenario(s) failed or regressed by more than %.0f%%: %s"
+              % (len(regressions), args.threshold, ", ".join(regressions)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
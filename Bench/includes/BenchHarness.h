@@ -0,0 +1,109 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A sample keeps adding iterations until it takes at least this long, so the timer resolution
+// and loop overhead don't show up in the per iteration numbers
+#define BENCH_MIN_SAMPLE_MS 10.0
+// Samples thrown away first, then samples kept. The reported numbers are over the kept ones
+#define BENCH_WARMUP_SAMPLES 2
+#define BENCH_NUM_SAMPLES 15
+// Slow scenarios (a big model import) stop early once they have this many samples and
+// have run for BENCH_MAX_SCENARIO_SECONDS
+#define BENCH_MIN_SAMPLES 3
+#define BENCH_MAX_SCENARIO_SECONDS 5.0
+
+struct BenchResult
+{
+    std::string name;
+    bool skipped = false;
+    std::string skipReason;
+    // Set by scenarios that check their own results and found them wrong
+    bool failed = false;
+    std::string failReason;
+    unsigned long long iterations = 0;
+    unsigned int samples = 0;
+    // Per iteration, in nanoseconds
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double minNs = 0.0;
+    double stddevNs = 0.0;
+    // Vertices, pixels, uniforms, ... whatever the scenario counts, 0 if it doesn't
+    unsigned long long itemsPerIteration = 0;
+};
+
+// Handed to each scenario. Setup goes before the loop and isn't timed:
+//
+//     harness.Add("tiles/rebuild_all", [&](BenchState& state)
+//     {
+//         TileMap map(256, 256);
+//         while (state.KeepRunning())
+//         {
+//             ...
+//         }
+//     });
+class BenchState
+{
+public:
+    bool KeepRunning();
+    // For per iteration resets that shouldn't count, e.g. marking every chunk dirty again
+    void PauseTiming();
+    void ResumeTiming();
+    // Call instead of the loop when the scenario can't run here (missing asset, ...)
+    void Skip(const std::string& reason);
+    // Call when the scenario's own checks find a wrong result. It's reported instead of the
+    // timings and the run exits with an error, so a broken change can't pass as a speedup
+    void Fail(const std::string& reason);
+    void SetItemsPerIteration(unsigned long long items);
+
+private:
+    friend class BenchHarness;
+    typedef std::chrono::steady_clock Clock;
+
+    void EndSample();
+
+    BenchResult* m_result = nullptr;
+    std::vector<double> m_sampleNs;
+    Clock::time_point m_scenarioStart;
+    Clock::time_point m_batchStart;
+    Clock::duration m_batchTime{ 0 };
+    unsigned long long m_batchSize = 1;
+    unsigned long long m_batchDone = 0;
+    unsigned int m_warmupLeft = BENCH_WARMUP_SAMPLES;
+    bool m_started = false;
+    bool m_calibrating = true;
+    bool m_paused = false;
+};
+
+// Runs every scenario whose name contains the filter, one after the other on the calling thread
+class BenchHarness
+{
+public:
+    typedef std::function<void(BenchState&)> Scenario;
+
+    void Add(const std::string& name, Scenario scenario);
+    void SetFilter(const std::string& filter);
+
+    void RunAll();
+    const std::vector<BenchResult>& GetResults() const;
+    unsigned int GetNumFailed() const;
+    // Same layout compare.py reads
+    bool WriteJSON(const std::string& path) const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Scenario scenario;
+    };
+
+    std::vector<Entry> m_scenarios;
+    std::vector<BenchResult> m_results;
+    std::string m_filter;
+};
+
+#endif
@@ -0,0 +1,1654 @@
+#define GLFW_INCLUDE_NONE
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <BenchHarness.h>
+#include <Camera.h>
+#include <EditHistory.h>
+#include <EntityStore.h>
+#include <JobSystem.h>
+#include <Model.h>
+#include <NullRenderDevice.h>
+#include <Picking.h>
+#include <RenderDevice.h>
+#include <SceneComponents.h>
+#include <SceneGraph.h>
+#include <SHADER.h>
+#include <ShaderCache.h>
+#include <SoftwareRenderDevice.h>
+#include <TileImposters.h>
+#include <TileMap.h>
+#include <TileOperations.h>
+#include <TileRenderer.h>
+#include <TransformBatch.h>
+
+// Every scenario runs on the null or software device, so none of them need a GPU or a window.
+// Inputs are either files in the repo or generated from fixed seeds, so two runs on the same
+// machine measure the same work.
+
+// Repo root, assets are looked up from here. The default matches running from the build directory
+static std::string s_root = "..";
+
+static std::string AssetPath(const std::string& relative)
+{
+    return s_root + "/" + relative;
+}
+
+static bool FileExists(const std::string& path)
+{
+    std::ifstream file(path);
+    return file.good();
+}
+
+// Makes the device active for the scenario and puts the default back afterwards
+struct ScopedDevice
+{
+    explicit ScopedDevice(RenderDevice* device) { RenderDevice::Set(device); }
+    ~ScopedDevice() { RenderDevice::Set(NULL); }
+};
+
+// Makes a job system with a fixed thread count the one engine code uses for the scenario
+struct ScopedJobSystem
+{
+    explicit ScopedJobSystem(unsigned int numThreads) : jobSystem(numThreads) { JobSystem::Set(&jobSystem); }
+    ~ScopedJobSystem() { JobSystem::Set(NULL); }
+    JobSystem jobSystem;
+};
+
+// 1, 2, 4... up to every hardware thread, which is included even when it isn't a power of two
+static std::vector<unsigned int> GetThreadCounts()
+{
+    unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned int> counts;
+    for (unsigned int count = 1; count < maxThreads; count *= 2)
+    {
+        counts.push_back(count);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// A size x size grid of quads with a gentle height field, written as an OBJ once per run
+static std::string WriteGridObj(unsigned int size)
+{
+    std::string path = (std::filesystem::temp_directory_path()
+        / ("engine_bench_grid_" + std::to_string(size) + ".obj")).string();
+    std::ofstream out(path);
+    for (unsigned int z = 0; z <= size; ++z)
+    {
+        for (unsigned int x = 0; x <= size; ++x)
+        {
+            float u = (float)x / size;
+            float v = (float)z / size;
+            float height = 0.05f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+            out << "v " << (u - 0.5f) * 2.0f << " " << height << " " << (v - 0.5f) * 2.0f << "\n";
+            out << "vt " << u << " " << v << "\n";
+        }
+    }
+    out << "vn 0 1 0\n";
+    for (unsigned int z = 0; z < size; ++z)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            // OBJ indices are 1 based
+            unsigned int a = z * (size + 1) + x + 1;
+            unsigned int b = a + 1;
+            unsigned int c = a + size + 2;
+            unsigned int d = a + size + 1;
+            out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+                << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+        }
+    }
+    return path;
+}
+
+// numMeshes separate objects of size x size quads each, laid out in a row. Assimp's OBJ
+// importer makes a mesh per object, so this is a scene that's wide rather than deep
+static std::string WriteManyMeshObj(unsigned int numMeshes, unsigned int size)
+{
+    std::string path = (std::filesystem::temp_directory_path()
+        / ("engine_bench_meshes_" + std::to_string(numMeshes) + ".obj")).string();
+    std::ofstream out(path);
+    out << "vn 0 1 0\n";
+    unsigned int base = 1;
+    for (unsigned int mesh = 0; mesh < numMeshes; ++mesh)
+    {
+        out << "o part_" << mesh << "\n";
+        for (unsigned int z = 0; z <= size; ++z)
+        {
+            for (unsigned int x = 0; x <= size; ++x)
+            {
+                out << "v " << mesh * 1.5f + (float)x / size << " 0 " << (float)z / size << "\n";
+                out << "vt " << (float)x / size << " " << (float)z / size << "\n";
+            }
+        }
+        for (unsigned int z = 0; z < size; ++z)
+        {
+            for (unsigned int x = 0; x < size; ++x)
+            {
+                unsigned int a = base + z * (size + 1) + x;
+                unsigned int b = a + 1;
+                unsigned int c = a + size + 2;
+                unsigned int d = a + size + 1;
+                out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+                    << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+            }
+        }
+        base += (size + 1) * (size + 1);
+    }
+    return path;
+}
+
+////////////////// MODEL IMPORT /////////////////////////
+
+static void AddImportScenarios(BenchHarness& harness)
+{
+    for (unsigned int size : { 64u, 256u })
+    {
+        harness.Add("import/grid_" + std::to_string(size), [size](BenchState& state)
+        {
+            std::string path = WriteGridObj(size);
+            NullRenderDevice device;
+            device.SetRecording(false);
+            ScopedDevice scopedDevice(&device);
+            state.SetItemsPerIteration((size + 1) * (size + 1));
+            while (state.KeepRunning())
+            {
+                Model model(path);
+            }
+        });
+    }
+
+    harness.Add("import/backpack", [](BenchState& state)
+    {
+        std::string path = AssetPath("Models/backpack/backpack.obj");
+        if (!FileExists(path))
+        {
+            state.Skip(path + " not found");
+            return;
+        }
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        while (state.KeepRunning())
+        {
+            Model model(path);
+        }
+    });
+
+    // Mesh conversion spread over a growing number of threads. The Assimp parse is still serial
+    // and included, so this is what a real load gains
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        harness.Add("import/many_meshes_2000_t" + std::to_string(numThreads), [numThreads](BenchState& state)
+        {
+            std::string path = WriteManyMeshObj(2000, 8);
+            NullRenderDevice device;
+            device.SetRecording(false);
+            ScopedDevice scopedDevice(&device);
+            ScopedJobSystem scopedJobs(numThreads);
+            state.SetItemsPerIteration(2000);
+            while (state.KeepRunning())
+            {
+                Model model(path);
+            }
+        });
+    }
+}
+
+////////////////// VERTEX PROCESSING /////////////////////////
+
+static void AddVertexScenarios(BenchHarness& harness)
+{
+    // A dense mesh on a tiny single threaded target, so transform and setup dominate the raster work
+    harness.Add("vertex/software_grid_256", [](BenchState& state)
+    {
+        std::string path = WriteGridObj(256);
+        SoftwareRenderDevice device(64, 64, 1);
+        ScopedDevice scopedDevice(&device);
+        Shader shader(AssetPath("Engine/src/Shaders/shader.vs").c_str(), AssetPath("Engine/src/Shaders/shader.fs").c_str());
+        Model model(path);
+
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.5f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        state.SetItemsPerIteration(256 * 256 * 2);
+        while (state.KeepRunning())
+        {
+            device.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            shader.Use();
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            shader.setMat4("model", glm::mat4(1.0f));
+            model.Draw(shader);
+            device.Flush();
+        }
+    });
+}
+
+////////////////// CULLING /////////////////////////
+
+static void AddCullingScenarios(BenchHarness& harness)
+{
+    // 100k boxes scattered around a camera looking into the middle of them, a fixed seed so the
+    // same ones pass every run. Times the plane tests a culling pass would make per object
+    harness.Add("cull/frustum", [](BenchState& state)
+    {
+        const unsigned int count = 100000;
+        std::mt19937 random(17);
+        std::uniform_real_distribution<float> spread(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> extent(0.25f, 5.0f);
+        std::vector<BoundsComponent> boxes(count);
+        for (BoundsComponent& box : boxes)
+        {
+            glm::vec3 centre(spread(random), spread(random) * 0.1f, spread(random));
+            glm::vec3 half(extent(random), extent(random), extent(random));
+            box = { centre - half, centre + half };
+        }
+
+        Camera camera(glm::vec3(0.0f, 20.0f, 150.0f));
+        camera.LookAt(glm::vec3(0.0f));
+        camera.SetPerspective(45.0f, 16.0f / 9.0f, 0.1f, 250.0f);
+        glm::vec4 planes[CAMERA_PLANE_COUNT];
+        camera.GetFrustumPlanes(planes);
+        glm::vec3 behind = camera.GetPosition() - camera.GetFront() * 10.0f;
+        if (!Camera::IsBoxVisible(planes, glm::vec3(-1.0f), glm::vec3(1.0f))
+            || Camera::IsBoxVisible(planes, behind - glm::vec3(1.0f), behind + glm::vec3(1.0f)))
+        {
+            state.Fail("the box being looked at was culled, or the one behind the camera wasn't");
+            return;
+        }
+
+        std::vector<unsigned char> visible(count);
+        state.SetItemsPerIteration(count);
+        while (state.KeepRunning())
+        {
+            camera.GetFrustumPlanes(planes);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                visible[i] = Camera::IsBoxVisible(planes, boxes[i].min, boxes[i].max);
+            }
+        }
+    });
+}
+
+////////////////// TILES /////////////////////////
+
+// Mostly filled map with a fixed seed, a few empty gaps so the rebuild has to skip cells
+static void FillTileMap(TileMap& tileMap)
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> tiles(0, 7);
+    for (unsigned int y = 0; y < tileMap.GetNumRows(); ++y)
+    {
+        for (unsigned int x = 0; x < tileMap.GetNumCols(); ++x)
+        {
+            tileMap.SetTile(x, y, (TileID)tiles(random));
+        }
+    }
+}
+
+static void AddTileScenarios(BenchHarness& harness)
+{
+    harness.Add("tiles/rebuild_all_256", [](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        TileMap tileMap(256, 256);
+        FillTileMap(tileMap);
+        TileRenderer renderer(&tileMap, glm::vec3(32.0f, 0.0f, 32.0f));
+
+        state.SetItemsPerIteration(256 * 256);
+        while (state.KeepRunning())
+        {
+            state.PauseTiming();
+            for (unsigned int i = 0; i < tileMap.GetNumChunks(); ++i)
+            {
+                tileMap.GetChunk(i).dirty = true;
+            }
+            state.ResumeTiming();
+            renderer.RebuildDirtyChunks();
+        }
+    });
+
+    // What a single brush stroke costs
+    harness.Add("tiles/rebuild_one_chunk", [](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        TileMap tileMap(256, 256);
+        FillTileMap(tileMap);
+        TileRenderer renderer(&tileMap, glm::vec3(32.0f, 0.0f, 32.0f));
+        renderer.RebuildDirtyChunks();
+
+        state.SetItemsPerIteration(TILE_CHUNK_CELLS);
+        while (state.KeepRunning())
+        {
+            tileMap.GetChunk(0).dirty = true;
+            renderer.RebuildDirtyChunks();
+        }
+    });
+
+    // Full rebuild again, meshing spread over a growing number of threads
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        harness.Add("tiles/rebuild_all_256_t" + std::to_string(numThreads), [numThreads](BenchState& state)
+        {
+            NullRenderDevice device;
+            device.SetRecording(false);
+            ScopedDevice scopedDevice(&device);
+            ScopedJobSystem scopedJobs(numThreads);
+            TileMap tileMap(256, 256);
+            FillTileMap(tileMap);
+            TileRenderer renderer(&tileMap, glm::vec3(32.0f, 0.0f, 32.0f));
+
+            state.SetItemsPerIteration(256 * 256);
+            while (state.KeepRunning())
+            {
+                state.PauseTiming();
+                for (unsigned int i = 0; i < tileMap.GetNumChunks(); ++i)
+                {
+                    tileMap.GetChunk(i).dirty = true;
+                }
+                state.ResumeTiming();
+                renderer.RebuildDirtyChunks();
+            }
+        });
+    }
+}
+
+////////////////// GOLDEN IMAGES /////////////////////////
+
+#define GOLDEN_SIZE 128
+#define GOLDEN_MAP_SIZE 32
+#define GOLDEN_MIP_LEVELS 7
+
+// A solid colour per mip level, so the pixels show which level was sampled
+static const uint32_t s_goldenMipColors[GOLDEN_MIP_LEVELS] =
+{
+    0xff0000ff, 0xff00ff00, 0xffff0000, 0xff00ffff, 0xffff00ff, 0xffffff00, 0xffffffff
+};
+
+static const char* s_goldenQuadVertex =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 2) in vec2 aTexCoord;\n"
+    "out vec2 TexCoord;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "void main()\n"
+    "{\n"
+    "    TexCoord = aTexCoord;\n"
+    "    gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+    "}\n";
+
+static const char* s_goldenQuadFragment =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "in vec2 TexCoord;\n"
+    "uniform sampler2D levels;\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = texture(levels, TexCoord);\n"
+    "}\n";
+
+// What the golden scenarios draw, on a software device of their own: the tile grid from straight
+// above with 4x4 pixel tiles, and a floor going off into the distance with a mipmapped texture
+struct GoldenScene
+{
+    SoftwareRenderDevice device;
+    ScopedDevice scopedDevice;
+    TileMap tileMap;
+    TileRenderer tiles;
+    Shader tileShader;
+    Shader quadShader;
+    unsigned int quadVAO = 0;
+    unsigned int quadVBO = 0;
+    unsigned int texture = 0;
+
+    explicit GoldenScene(unsigned int numThreads)
+        : device(GOLDEN_SIZE, GOLDEN_SIZE, numThreads), scopedDevice(&device), tileMap(GOLDEN_MAP_SIZE, GOLDEN_MAP_SIZE),
+        tiles(&tileMap, glm::vec3(1.0f, 0.0f, 1.0f)),
+        tileShader(AssetPath("TilemapEditor/Shaders/tile_shader.vs").c_str(), AssetPath("TilemapEditor/Shaders/tile_shader.fs").c_str())
+    {
+        FillTileMap(tileMap);
+        tiles.RebuildDirtyChunks();
+        quadShader.Build(s_goldenQuadVertex, s_goldenQuadFragment);
+
+        // Position, then texcoords in attribute 2 like shader.vs. Repeats every unit of floor
+        const float quad[] =
+        {
+            -4.0f, 0.0f, 0.0f, 0.0f, 0.0f,     4.0f, 0.0f, 0.0f, 8.0f, 0.0f,     4.0f, 0.0f, -60.0f, 8.0f, 60.0f,
+            -4.0f, 0.0f, 0.0f, 0.0f, 0.0f,     4.0f, 0.0f, -60.0f, 8.0f, 60.0f,  -4.0f, 0.0f, -60.0f, 0.0f, 60.0f
+        };
+        quadVAO = device.CreateVertexArray();
+        quadVBO = device.CreateBuffer();
+        device.BindVertexArray(quadVAO);
+        device.BindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        device.BufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        device.EnableVertexAttribArray(0);
+        device.VertexAttribPointer(0, 3, GL_FLOAT, false, 5 * sizeof(float), 0);
+        device.EnableVertexAttribArray(2);
+        device.VertexAttribPointer(2, 2, GL_FLOAT, false, 5 * sizeof(float), 3 * sizeof(float));
+
+        texture = device.CreateTexture();
+        device.BindTexture(GL_TEXTURE_2D, texture);
+        for (int level = 0; level < GOLDEN_MIP_LEVELS; ++level)
+        {
+            int size = 64 >> level;
+            std::vector<uint32_t> texels((size_t)size * size, s_goldenMipColors[level]);
+            device.TexImage2D(GL_TEXTURE_2D, level, GL_RGBA, size, size, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        }
+        device.TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        device.TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        device.ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    ~GoldenScene()
+    {
+        device.DeleteTexture(texture);
+        device.DeleteBuffer(quadVBO);
+        device.DeleteVertexArray(quadVAO);
+    }
+
+    static glm::mat4 GetTileViewProjection()
+    {
+        // x to the right and z down the screen, the map filling the target
+        return glm::ortho(0.0f, (float)GOLDEN_MAP_SIZE, -(float)GOLDEN_MAP_SIZE, 0.0f, 0.1f, 20.0f)
+            * glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    }
+
+    const std::vector<uint32_t>& DrawTiles()
+    {
+        device.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        tileShader.Use();
+        tileShader.setMat4("projection", GetTileViewProjection());
+        tileShader.setMat4("view", glm::mat4(1.0f));
+        tileShader.setMat4("model", glm::mat4(1.0f));
+        tiles.Draw();
+        return device.GetColorBuffer();
+    }
+
+    const std::vector<uint32_t>& DrawFloor()
+    {
+        device.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        quadShader.Use();
+        quadShader.setMat4("projection", glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f));
+        quadShader.setMat4("view", glm::lookAt(glm::vec3(0.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, -6.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        quadShader.setMat4("model", glm::mat4(1.0f));
+        quadShader.setInt("levels", 0);
+        device.ActiveTexture(0);
+        device.BindTexture(GL_TEXTURE_2D, texture);
+        device.BindVertexArray(quadVAO);
+        device.DrawArrays(GL_TRIANGLES, 0, 6);
+        return device.GetColorBuffer();
+    }
+};
+
+static bool ColorsClose(uint32_t a, uint32_t b)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int difference = (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff);
+        if (std::abs(difference) > 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The pixel in the middle of every tile against the tile's palette colour
+static std::string CheckGoldenTiles(const TileMap& tileMap, const std::vector<uint32_t>& pixels)
+{
+    char error[160];
+    const int tilePixels = GOLDEN_SIZE / GOLDEN_MAP_SIZE;
+    for (int y = 0; y < GOLDEN_MAP_SIZE; ++y)
+    {
+        for (int x = 0; x < GOLDEN_MAP_SIZE; ++x)
+        {
+            TileID id = tileMap.GetTile(x, y);
+            glm::vec3 color = id == EMPTY_TILE ? glm::vec3(0.0f) : TileRenderer::GetTileColor(id);
+            glm::uvec3 rgb = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint32_t expected = rgb.r | (rgb.g << 8) | (rgb.b << 16) | 0xff000000;
+            // Rows are bottom first, and row 0 of the map is at the top
+            int px = x * tilePixels + tilePixels / 2;
+            int py = GOLDEN_SIZE - 1 - (y * tilePixels + tilePixels / 2);
+            uint32_t got = pixels[(size_t)py * GOLDEN_SIZE + px];
+            if (!ColorsClose(got, expected))
+            {
+                std::snprintf(error, sizeof(error), "tile (%d, %d) came out %08x, expected %08x", x, y, got, expected);
+                return error;
+            }
+        }
+    }
+    return "";
+}
+
+// Up the middle column the floor recedes, so the level sampled should only ever go up, starting
+// at the full size one and getting well down the chain before the horizon
+static std::string CheckGoldenFloor(const std::vector<uint32_t>& pixels)
+{
+    char error[160];
+    int previous = -1;
+    int first = -1;
+    for (int y = 0; y < GOLDEN_SIZE; ++y)
+    {
+        uint32_t got = pixels[(size_t)y * GOLDEN_SIZE + GOLDEN_SIZE / 2];
+        if (got == 0xff000000)
+        {
+            continue;
+        }
+        const uint32_t* found = std::find(s_goldenMipColors, s_goldenMipColors + GOLDEN_MIP_LEVELS, got);
+        int level = (int)(found - s_goldenMipColors);
+        if (level == GOLDEN_MIP_LEVELS)
+        {
+            std::snprintf(error, sizeof(error), "row %d is %08x, which isn't any mip level's colour", y, got);
+            return error;
+        }
+        if (level < previous)
+        {
+            std::snprintf(error, sizeof(error), "row %d sampled level %d, below level %d on the row under it", y, level, previous);
+            return error;
+        }
+        if (first < 0)
+        {
+            first = level;
+        }
+        previous = level;
+    }
+    if (first != 0 || previous < 3)
+    {
+        std::snprintf(error, sizeof(error), "floor went from level %d to %d, expected 0 up to at least 3", first, previous);
+        return error;
+    }
+    return "";
+}
+
+static void AddGoldenScenarios(BenchHarness& harness)
+{
+    // Renders on one thread and on several, checks both against the reference colours and each
+    // other pixel for pixel, then times the pair of frames on several threads
+    harness.Add("golden/software", [](BenchState& state)
+    {
+        std::vector<uint32_t> tiles;
+        std::vector<uint32_t> floor;
+        {
+            GoldenScene scene(1);
+            tiles = scene.DrawTiles();
+            floor = scene.DrawFloor();
+            std::string error = CheckGoldenTiles(scene.tileMap, tiles);
+            if (error.empty())
+            {
+                error = CheckGoldenFloor(floor);
+            }
+            if (!error.empty())
+            {
+                state.Fail(error);
+                return;
+            }
+        }
+
+        GoldenScene scene(std::max(std::thread::hardware_concurrency(), 4u));
+        if (scene.DrawTiles() != tiles || scene.DrawFloor() != floor)
+        {
+            state.Fail("the image on " + std::to_string(scene.device.GetNumThreads()) + " threads differs from the one on 1");
+            return;
+        }
+
+        state.SetItemsPerIteration(2);
+        while (state.KeepRunning())
+        {
+            scene.DrawTiles();
+            scene.DrawFloor();
+        }
+    });
+}
+
+////////////////// FILLS /////////////////////////
+
+// Empty map with a wall of tile 7 every 64 columns, each open at the top or bottom in turn, so the
+// empty cells are one winding region that the fill has to follow back and forth
+static void FillSerpentine(TileMap& tileMap)
+{
+    for (unsigned int x = 63; x < tileMap.GetNumCols(); x += 64)
+    {
+        bool openAtTop = (x / 64) % 2 == 1;
+        for (unsigned int y = 0; y < tileMap.GetNumRows(); ++y)
+        {
+            bool gap = openAtTop ? y < 4 : y >= tileMap.GetNumRows() - 4;
+            if (!gap)
+            {
+                tileMap.SetTile(x, y, 7);
+            }
+        }
+    }
+}
+
+static void AddFillScenarios(BenchHarness& harness)
+{
+    // 4096 x 4096 = 16.7M cells, about 16.4M of them in the connected region. Each iteration fills
+    // the region with the other of two tiles, so every one changes all of it
+    const unsigned int size = 4096;
+    const unsigned long long regionCells = (unsigned long long)size * size - (size / 64) * (size - 4);
+
+    for (bool record : { false, true })
+    {
+        harness.Add(record ? "fill/flood_16m_history" : "fill/flood_16m", [=](BenchState& state)
+        {
+            NullRenderDevice device;
+            device.SetRecording(false);
+            ScopedDevice scopedDevice(&device);
+            TileMap tileMap(size, size);
+            FillSerpentine(tileMap);
+            EditHistory history;
+
+            state.SetItemsPerIteration(regionCells);
+            while (state.KeepRunning())
+            {
+                TileID id = tileMap.GetTile(0, 0) == 1 ? 2 : 1;
+                if (TileOperations::FloodFill(tileMap, glm::ivec2(0), id, record ? &history : nullptr) != regionCells)
+                {
+                    state.Fail("didn't fill the whole region");
+                    return;
+                }
+            }
+        });
+    }
+
+    // Recorded, like the editor's bucket tool, so compare these with fill/flood_16m_history
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        harness.Add("fill/parallel_flood_16m_t" + std::to_string(numThreads), [=](BenchState& state)
+        {
+            NullRenderDevice device;
+            device.SetRecording(false);
+            ScopedDevice scopedDevice(&device);
+            TileMap tileMap(size, size);
+            FillSerpentine(tileMap);
+            EditHistory history;
+
+            state.SetItemsPerIteration(regionCells);
+            while (state.KeepRunning())
+            {
+                TileID id = tileMap.GetTile(0, 0) == 1 ? 2 : 1;
+                if (TileOperations::ParallelFloodFill(tileMap, glm::ivec2(0), id, &history, numThreads) != regionCells)
+                {
+                    state.Fail("didn't fill the whole region");
+                    return;
+                }
+            }
+        });
+    }
+
+    // The whole map, a chunk at a time with no searching, so the most a fill can cost per cell
+    harness.Add("fill/rect_16m", [=](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        TileMap tileMap(size, size);
+        EditHistory history;
+
+        state.SetItemsPerIteration((unsigned long long)size * size);
+        TileID id = 1;
+        while (state.KeepRunning())
+        {
+            id = id == 1 ? 2 : 1;
+            TileOperations::FillRect(tileMap, glm::ivec2(0), glm::ivec2(size - 1), id, &history);
+        }
+    });
+
+    // A 3 x 3 pattern with holes over the whole map, every cell looks its tile up in the pattern
+    harness.Add("fill/stamp_16m", [=](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        TileMap tileMap(size, size);
+        EditHistory history;
+        std::vector<TileID> patterns[2] = { { 1, 2, 1, 2, EMPTY_TILE, 2, 1, 2, 1 }, { 3, 4, 3, 4, EMPTY_TILE, 4, 3, 4, 3 } };
+
+        state.SetItemsPerIteration((unsigned long long)size * size);
+        unsigned int next = 0;
+        while (state.KeepRunning())
+        {
+            TileOperations::StampPattern(tileMap, glm::ivec2(0), glm::ivec2(size - 1), patterns[next], glm::ivec2(3), &history);
+            next = 1 - next;
+        }
+    });
+}
+
+////////////////// EDIT HISTORY /////////////////////////
+
+// Every chunk's cells one after the other, for comparing whole maps
+static std::vector<TileID> CopyTiles(const TileMap& tileMap)
+{
+    std::vector<TileID> tiles;
+    tiles.reserve((size_t)tileMap.GetNumChunks() * TILE_CHUNK_CELLS);
+    for (unsigned int i = 0; i < tileMap.GetNumChunks(); ++i)
+    {
+        const TileMap::Chunk& chunk = tileMap.GetChunk(i);
+        tiles.insert(tiles.end(), chunk.cells, chunk.cells + TILE_CHUNK_CELLS);
+    }
+    return tiles;
+}
+
+static void RestoreTiles(TileMap& tileMap, const std::vector<TileID>& tiles)
+{
+    for (unsigned int i = 0; i < tileMap.GetNumChunks(); ++i)
+    {
+        std::copy(&tiles[(size_t)i * TILE_CHUNK_CELLS], &tiles[(size_t)(i + 1) * TILE_CHUNK_CELLS], tileMap.GetChunk(i).cells);
+    }
+}
+
+static void AddEditHistoryScenarios(BenchHarness& harness)
+{
+    // A long editing session replayed against the journal: short brush strokes with the odd big
+    // rectangle, all undone and redone again. Checks the map comes back exactly both ways, and that
+    // lowering the cap afterwards trims the oldest edits without breaking the ones left
+    harness.Add("undo/replay_100k_edits", [](BenchState& state)
+    {
+        const unsigned int numEdits = 100000;
+        TileMap tileMap(1024, 1024);
+        FillTileMap(tileMap);
+        std::vector<TileID> original = CopyTiles(tileMap);
+
+        struct Stroke
+        {
+            glm::ivec2 start;
+            glm::ivec2 step;
+            TileID id;
+        };
+        std::mt19937 random(99);
+        std::uniform_int_distribution<int> position(0, 1023);
+        std::uniform_int_distribution<int> direction(-1, 1);
+        std::uniform_int_distribution<int> tiles(0, 7);
+        std::vector<Stroke> strokes(numEdits);
+        for (Stroke& stroke : strokes)
+        {
+            stroke = { glm::ivec2(position(random), position(random)), glm::ivec2(direction(random), direction(random)),
+                (TileID)tiles(random) };
+        }
+
+        state.SetItemsPerIteration(numEdits);
+        while (state.KeepRunning())
+        {
+            EditHistory history(256 * 1024 * 1024);
+            for (unsigned int i = 0; i < numEdits; ++i)
+            {
+                const Stroke& stroke = strokes[i];
+                if (i % 1000 == 999)
+                {
+                    TileOperations::FillRect(tileMap, stroke.start, stroke.start + glm::ivec2(200), stroke.id, &history);
+                    continue;
+                }
+                history.BeginEdit(&tileMap);
+                for (int cell = 0; cell < 16; ++cell)
+                {
+                    glm::ivec2 at = stroke.start + stroke.step * cell;
+                    if (tileMap.InBounds(at.x, at.y))
+                    {
+                        tileMap.SetTile(at.x, at.y, stroke.id);
+                    }
+                }
+                history.EndEdit();
+            }
+
+            state.PauseTiming();
+            std::vector<TileID> edited = CopyTiles(tileMap);
+            size_t numRecorded = history.GetNumUndo();
+            state.ResumeTiming();
+
+            while (history.Undo())
+            {
+            }
+
+            state.PauseTiming();
+            if (CopyTiles(tileMap) != original)
+            {
+                state.Fail("undoing every edit didn't restore the original map");
+                return;
+            }
+            state.ResumeTiming();
+
+            while (history.Redo())
+            {
+            }
+
+            state.PauseTiming();
+            if (history.GetNumUndo() != numRecorded || CopyTiles(tileMap) != edited)
+            {
+                state.Fail("redoing every edit didn't get back to the edited map");
+                return;
+            }
+
+            // A quarter of the memory, the oldest three quarters or so have to go
+            size_t cap = history.GetMemoryUsage() / 4;
+            history.SetMemoryCap(cap);
+            size_t numKept = history.GetNumUndo();
+            if (history.GetMemoryUsage() > cap || numKept == 0 || numKept >= numRecorded)
+            {
+                state.Fail("lowering the memory cap didn't trim the oldest edits");
+                return;
+            }
+            while (history.Undo())
+            {
+            }
+            while (history.Redo())
+            {
+            }
+            if (history.GetNumUndo() != numKept || CopyTiles(tileMap) != edited)
+            {
+                state.Fail("the edits left after trimming don't undo and redo cleanly");
+                return;
+            }
+
+            RestoreTiles(tileMap, original);
+            state.ResumeTiming();
+        }
+    });
+}
+
+////////////////// PICKING /////////////////////////
+
+// The editor's view: its camera, iso matrix and orthographic zoom, with the grid panned by offset
+struct PickView
+{
+    PickView(glm::vec2 viewport, float zoom, glm::vec3 offset)
+        : viewport(viewport)
+        , camera(glm::vec3(-1.0f, 45.0f, 0.0f) * 5.0f)
+    {
+        camera.LookAt(glm::vec3(0.0f));
+        camera.SetOrthographic(-viewport.x / 2.0f * zoom, viewport.x / 2.0f * zoom,
+            viewport.y / 2.0f * zoom, -viewport.y / 2.0f * zoom, 1000.0f, -1000.0f);
+        glm::mat4 iso = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 1.0f, 1.0f));
+        iso = glm::rotate(iso, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        mvp = camera.GetViewProjectionMatrix() * Picking::GridModel(iso, offset);
+        invMvp = Picking::InverseGridMVP(camera.GetInverseViewProjectionMatrix(), glm::inverse(iso), offset);
+    }
+
+    glm::vec2 viewport;
+    Camera camera;
+    glm::mat4 mvp;
+    glm::mat4 invMvp;
+};
+
+// Screen -> grid -> screen over the window, and tile centres -> screen -> tile, from zoomed right
+// in to far out and panned thousands of tiles away. Returns what went wrong, empty if nothing did
+static std::string CheckPickRoundTrips(glm::vec2 viewport, glm::vec3 tileSize)
+{
+    char error[160];
+    for (float zoom : { 0.001f, 0.01f, 1.0f, 10.0f, 100.0f })
+    {
+        for (float pan : { 0.0f, 1000.0f, -10000.0f, 100000.0f, -100000.0f })
+        {
+            glm::vec3 offset(pan, 0.0f, -0.5f * pan);
+            PickView view(viewport, zoom, offset);
+
+            for (int i = 0; i <= 8; ++i)
+            {
+                for (int j = 0; j <= 8; ++j)
+                {
+                    glm::vec2 screen = viewport * glm::vec2(i / 8.0f, j / 8.0f);
+                    glm::vec3 gridPos = Picking::ScreenToGrid(view.invMvp, viewport, screen);
+                    glm::vec2 back = glm::vec2(Picking::Project(view.mvp, viewport, gridPos));
+                    // Grid positions are floats, so far out and zoomed in they can't land closer
+                    // than a few of their own rounding steps. zoom is grid units per pixel
+                    float magnitude = std::max(std::abs(gridPos.x), std::abs(gridPos.z));
+                    float epsilon = 0.01f + 8.0f * FLT_EPSILON * magnitude / zoom;
+                    float miss = glm::length(back - screen);
+                    if (!(miss <= epsilon))
+                    {
+                        std::snprintf(error, sizeof(error), "screen (%g, %g) came back %g px off at zoom %g, pan %g",
+                            screen.x, screen.y, miss, zoom, pan);
+                        return error;
+                    }
+                }
+            }
+
+            // The tiles around the middle of the screen, picked at their centres
+            glm::ivec2 middle = Picking::GridToTile(Picking::ScreenToGrid(view.invMvp, viewport, viewport * 0.5f), tileSize);
+            for (int dy = -2; dy <= 2; ++dy)
+            {
+                for (int dx = -2; dx <= 2; ++dx)
+                {
+                    glm::ivec2 tile = middle + glm::ivec2(dx, dy);
+                    glm::vec3 centre((tile.x + 0.5f) * tileSize.x, 0.0f, (tile.y + 0.5f) * tileSize.z);
+                    glm::vec2 screen = glm::vec2(Picking::Project(view.mvp, viewport, centre));
+                    glm::ivec2 picked = Picking::GridToTile(Picking::ScreenToGrid(view.invMvp, viewport, screen), tileSize);
+                    if (picked != tile)
+                    {
+                        std::snprintf(error, sizeof(error), "tile (%d, %d) picked as (%d, %d) at zoom %g, pan %g",
+                            tile.x, tile.y, picked.x, picked.y, zoom, pan);
+                        return error;
+                    }
+                }
+            }
+        }
+    }
+    return "";
+}
+
+static void AddPickingScenarios(BenchHarness& harness)
+{
+    // Checks the round trips first, then times the hover pick across the window
+    harness.Add("pick/round_trip", [](BenchState& state)
+    {
+        glm::vec2 viewport(1280.0f, 720.0f);
+        // The editor's default tile size
+        glm::vec3 tileSize(5.0f, 0.0f, 5.0f);
+        std::string error = CheckPickRoundTrips(viewport, tileSize);
+        if (!error.empty())
+        {
+            state.Fail(error);
+            return;
+        }
+
+        PickView view(viewport, 1.0f, glm::vec3(-2048.0f, 0.0f, -2048.0f));
+        std::vector<glm::ivec2> picked(64 * 64);
+        state.SetItemsPerIteration(64 * 64);
+        while (state.KeepRunning())
+        {
+            for (int i = 0; i < 64 * 64; ++i)
+            {
+                glm::vec2 screen = viewport * glm::vec2((i % 64) / 64.0f, (i / 64) / 64.0f);
+                picked[i] = Picking::GridToTile(Picking::ScreenToGrid(view.invMvp, viewport, screen), tileSize);
+            }
+        }
+    });
+}
+
+////////////////// MINIMAP /////////////////////////
+
+// What a texel should come out as over the given tiles, worked out separately from BuildImposter
+static uint32_t ExpectedImposterTexel(const std::vector<TileID>& tiles)
+{
+    glm::vec3 sum(0.0f);
+    unsigned int filled = 0;
+    for (TileID id : tiles)
+    {
+        if (id != EMPTY_TILE)
+        {
+            sum += TileRenderer::GetTileColor(id);
+            filled++;
+        }
+    }
+    if (filled == 0)
+    {
+        return 0;
+    }
+    glm::uvec3 rgb = glm::uvec3(sum / (float)filled * 255.0f + 0.5f);
+    uint32_t alpha = (uint32_t)std::lround(filled * 255.0 / tiles.size());
+    return rgb.r | (rgb.g << 8) | (rgb.b << 16) | (alpha << 24);
+}
+
+// Paints a few known tiles into a 2x2 chunk map and checks the pictures and how many chunks each
+// Update and Upload redoes. Empty if it all matches
+static std::string CheckImposters()
+{
+    char error[160];
+    NullRenderDevice device;
+    device.SetRecording(false);
+    ScopedDevice scopedDevice(&device);
+    TileMap tileMap(2 * TILE_CHUNK_SIZE, 2 * TILE_CHUNK_SIZE);
+    TileImposters imposters(&tileMap);
+    const unsigned int size = imposters.GetSize();
+    const unsigned int texels = size * size;
+
+    unsigned int rebuilt = imposters.Update();
+    unsigned int uploaded = imposters.Upload();
+    if (rebuilt != 4 || uploaded != 4)
+    {
+        std::snprintf(error, sizeof(error), "first update rebuilt %u and uploaded %u chunks, expected all 4", rebuilt, uploaded);
+        return error;
+    }
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        const uint32_t* picture = imposters.GetImposter(i);
+        if (std::find_if(picture, picture + texels, [](uint32_t texel) { return texel != 0; }) != picture + texels)
+        {
+            std::snprintf(error, sizeof(error), "empty chunk %u isn't transparent", i);
+            return error;
+        }
+    }
+
+    // Texel (0, 0) of chunk 0: two of its four tiles, in different colours. Texel (1, 0): all
+    // four in one colour. And one tile in the last chunk
+    tileMap.SetTile(0, 0, 1);
+    tileMap.SetTile(1, 1, 2);
+    for (int i = 0; i < 4; ++i)
+    {
+        tileMap.SetTile(2 + i % 2, i / 2, 3);
+    }
+    tileMap.SetTile(2 * TILE_CHUNK_SIZE - 1, 2 * TILE_CHUNK_SIZE - 1, 4);
+
+    rebuilt = imposters.Update();
+    uploaded = imposters.Upload();
+    if (rebuilt != 2 || uploaded != 2)
+    {
+        std::snprintf(error, sizeof(error), "painting 2 chunks rebuilt %u and uploaded %u", rebuilt, uploaded);
+        return error;
+    }
+    rebuilt = imposters.Update();
+    uploaded = imposters.Upload();
+    if (rebuilt != 0 || uploaded != 0)
+    {
+        std::snprintf(error, sizeof(error), "nothing changed but %u chunks were rebuilt and %u uploaded", rebuilt, uploaded);
+        return error;
+    }
+
+    // Every texel of every chunk against the tiles under it
+    const unsigned int block = TILE_CHUNK_SIZE / size;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        glm::ivec2 origin = tileMap.GetChunkOrigin(i);
+        const uint32_t* picture = imposters.GetImposter(i);
+        for (unsigned int t = 0; t < texels; ++t)
+        {
+            std::vector<TileID> tiles;
+            for (unsigned int y = 0; y < block; ++y)
+            {
+                for (unsigned int x = 0; x < block; ++x)
+                {
+                    tiles.push_back(tileMap.GetTile(origin.x + (t % size) * block + x, origin.y + (t / size) * block + y));
+                }
+            }
+            uint32_t expected = ExpectedImposterTexel(tiles);
+            if (picture[t] != expected)
+            {
+                std::snprintf(error, sizeof(error), "chunk %u texel (%u, %u) is %08x, expected %08x", i, t % size, t / size,
+                    picture[t], expected);
+                return error;
+            }
+        }
+    }
+    return "";
+}
+
+static void AddMinimapScenarios(BenchHarness& harness)
+{
+    // Checks what the pictures hold first, then times picturing one painted chunk
+    harness.Add("minimap/imposter_checks", [](BenchState& state)
+    {
+        std::string error = CheckImposters();
+        if (!error.empty())
+        {
+            state.Fail(error);
+            return;
+        }
+
+        TileMap tileMap(TILE_CHUNK_SIZE, TILE_CHUNK_SIZE);
+        FillTileMap(tileMap);
+        std::vector<uint32_t> picture(TILE_IMPOSTER_SIZE * TILE_IMPOSTER_SIZE);
+        state.SetItemsPerIteration(TILE_CHUNK_CELLS);
+        while (state.KeepRunning())
+        {
+            TileImposters::BuildImposter(tileMap, 0, TILE_IMPOSTER_SIZE, picture.data());
+        }
+    });
+
+    // Picturing every chunk, what a minimap would cost if it redrew the whole map each time.
+    // CPU only, no device
+    harness.Add("minimap/build_all_256", [](BenchState& state)
+    {
+        TileMap tileMap(256, 256);
+        FillTileMap(tileMap);
+        TileImposters imposters(&tileMap);
+        imposters.Update();
+
+        state.SetItemsPerIteration(256 * 256);
+        while (state.KeepRunning())
+        {
+            state.PauseTiming();
+            for (unsigned int i = 0; i < tileMap.GetNumChunks(); ++i)
+            {
+                tileMap.GetChunk(i).version++;
+            }
+            state.ResumeTiming();
+            imposters.Update();
+        }
+    });
+
+    // A brush stroke's worth, picturing and uploading the one chunk it touched
+    harness.Add("minimap/update_one_chunk", [](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        TileMap tileMap(256, 256);
+        FillTileMap(tileMap);
+        TileImposters imposters(&tileMap);
+        imposters.Update();
+        imposters.Upload();
+
+        state.SetItemsPerIteration(TILE_CHUNK_CELLS);
+        while (state.KeepRunning())
+        {
+            tileMap.GetChunk(0).version++;
+            imposters.Update();
+            imposters.Upload();
+        }
+    });
+}
+
+////////////////// JOBS /////////////////////////
+
+static void AddJobScenarios(BenchHarness& harness)
+{
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        std::string suffix = "_t" + std::to_string(numThreads);
+
+        // Enough math per item that scaling is about the cores, not the scheduler
+        harness.Add("jobs/parallel_for" + suffix, [numThreads](BenchState& state)
+        {
+            const unsigned int count = 1 << 20;
+            JobSystem jobs(numThreads);
+            std::vector<float> values(count);
+
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                jobs.ParallelFor(count, 4096, [&values](unsigned int begin, unsigned int end)
+                {
+                    for (unsigned int i = begin; i < end; ++i)
+                    {
+                        float x = i * 0.001f;
+                        values[i] = std::sin(x) * std::cos(x * 0.5f) + std::sqrt(x);
+                    }
+                });
+            }
+        });
+
+        // Nearly empty jobs, so this is the scheduler's own overhead
+        harness.Add("jobs/many_small" + suffix, [numThreads](BenchState& state)
+        {
+            const unsigned int count = 10000;
+            JobSystem jobs(numThreads);
+            std::atomic<unsigned int> total{ 0 };
+
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                JobCounter counter;
+                for (unsigned int i = 0; i < count; ++i)
+                {
+                    jobs.Run([&total] { total.fetch_add(1, std::memory_order_relaxed); }, &counter);
+                }
+                jobs.Wait(counter);
+            }
+        });
+    }
+}
+
+////////////////// TEXTURES /////////////////////////
+
+static void AddTextureScenarios(BenchHarness& harness)
+{
+    struct TextureCase
+    {
+        const char* name;
+        const char* path;
+    };
+    for (TextureCase texture : { TextureCase{ "texture/decode_jpg", "textures/texture.jpg" },
+        TextureCase{ "texture/decode_backpack_ao", "Models/backpack/ao.jpg" } })
+    {
+        harness.Add(texture.name, [texture](BenchState& state)
+        {
+            // Decoded from memory so disk speed stays out of it
+            std::string path = AssetPath(texture.path);
+            std::ifstream file(path, std::ios::binary);
+            std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            int width, height, components;
+            if (bytes.empty() || !stbi_info_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &components))
+            {
+                state.Skip(path + " not found");
+                return;
+            }
+
+            state.SetItemsPerIteration((unsigned long long)width * height);
+            while (state.KeepRunning())
+            {
+                unsigned char* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &components, 0);
+                stbi_image_free(data);
+            }
+        });
+    }
+}
+
+////////////////// UNIFORMS /////////////////////////
+
+static void AddUniformScenarios(BenchHarness& harness)
+{
+    harness.Add("uniforms/set_mat4_x100", [](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        Shader shader(AssetPath("Engine/src/Shaders/shader.vs").c_str(), AssetPath("Engine/src/Shaders/shader.fs").c_str());
+        shader.Use();
+
+        glm::mat4 model(1.0f);
+        state.SetItemsPerIteration(100);
+        while (state.KeepRunning())
+        {
+            for (int i = 0; i < 100; ++i)
+            {
+                model[3][0] = (float)i;
+                shader.setMat4("model", model);
+            }
+        }
+    });
+
+    // What the scene sets per draw: the three matrices and a color
+    harness.Add("uniforms/mixed_x100", [](BenchState& state)
+    {
+        NullRenderDevice device;
+        device.SetRecording(false);
+        ScopedDevice scopedDevice(&device);
+        Shader shader(AssetPath("Engine/src/Shaders/shader.vs").c_str(), AssetPath("Engine/src/Shaders/shader.fs").c_str());
+        shader.Use();
+
+        state.SetItemsPerIteration(100);
+        while (state.KeepRunning())
+        {
+            for (int i = 0; i < 25; ++i)
+            {
+                shader.setMat4("projection", glm::mat4(1.0f));
+                shader.setMat4("view", glm::mat4(1.0f));
+                shader.setMat4("model", glm::mat4(1.0f));
+                shader.setVec3("lineColor", glm::vec3((float)i, 0.0f, 0.0f));
+            }
+        }
+    });
+}
+
+////////////////// TRANSFORMS /////////////////////////
+
+// Random instances with a fixed seed, the same for every kernel
+static void FillTransforms(unsigned int count, TransformBatch& batch)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    batch.Reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        glm::vec3 position(unit(random) * 100.0f, unit(random) * 10.0f, unit(random) * 100.0f);
+        glm::quat rotation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+        glm::vec3 scale(1.0f + unit(random) * 0.5f);
+        batch.Add(position, rotation, scale);
+    }
+}
+
+// Every kernel the CPU runs against glm, at counts that leave a remainder after the groups of
+// eight and four. Empty if they all match to rounding
+static std::string CheckTransformKernels(const glm::mat4& viewProjection)
+{
+    char error[160];
+    for (unsigned int count : { 1u, 5u, 12u, 13u, 20u, 10003u })
+    {
+        TransformBatch batch;
+        FillTransforms(count, batch);
+        std::vector<glm::mat4> expectedWorld(count);
+        std::vector<glm::mat4> expectedClip(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            expectedWorld[i] = glm::translate(glm::mat4(1.0f), batch.GetPosition(i)) * glm::mat4_cast(batch.GetRotation(i))
+                * glm::scale(glm::mat4(1.0f), batch.GetScale(i));
+            expectedClip[i] = viewProjection * expectedWorld[i];
+        }
+
+        for (Transform_Kernel kernel : { TRANSFORM_KERNEL_SCALAR, TRANSFORM_KERNEL_SSE, TRANSFORM_KERNEL_AVX2 })
+        {
+            if (!TransformBatch::IsKernelSupported(kernel))
+            {
+                continue;
+            }
+            std::vector<glm::mat4> world(count);
+            std::vector<glm::mat4> clip(count);
+            TransformBatch::SetKernel(kernel);
+            batch.ComputeWorldClip(viewProjection, world.data(), clip.data());
+            TransformBatch::ResetKernel();
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                for (int k = 0; k < 16; ++k)
+                {
+                    float expected[2] = { expectedWorld[i][k / 4][k % 4], expectedClip[i][k / 4][k % 4] };
+                    float got[2] = { world[i][k / 4][k % 4], clip[i][k / 4][k % 4] };
+                    for (int m = 0; m < 2; ++m)
+                    {
+                        // Fused multiply-adds round differently, so relative to the value's size
+                        if (!(std::abs(got[m] - expected[m]) <= 1e-4f * (1.0f + std::abs(expected[m]))))
+                        {
+                            std::snprintf(error, sizeof(error), "%s kernel, %u instances: %s[%u][%d][%d] is %g, glm has %g",
+                                TransformBatch::GetKernelName(kernel), count, m == 0 ? "world" : "clip", i, k / 4, k % 4,
+                                got[m], expected[m]);
+                            return error;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return "";
+}
+
+static void AddTransformScenarios(BenchHarness& harness)
+{
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 500.0f)
+        * glm::lookAt(glm::vec3(0.0f, 50.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Checks every kernel first, then times the one the CPU picks on a count with a remainder
+    harness.Add("transforms/match_glm", [viewProjection](BenchState& state)
+    {
+        std::string error = CheckTransformKernels(viewProjection);
+        if (!error.empty())
+        {
+            state.Fail(error);
+            return;
+        }
+
+        unsigned int count = 10003;
+        TransformBatch batch;
+        FillTransforms(count, batch);
+        std::vector<glm::mat4> world(count);
+        std::vector<glm::mat4> clip(count);
+        state.SetItemsPerIteration(count);
+        while (state.KeepRunning())
+        {
+            batch.ComputeWorldClip(viewProjection, world.data(), clip.data());
+        }
+    });
+
+    for (unsigned int count : { 10000u, 100000u })
+    {
+        std::string suffix = "_" + std::to_string(count);
+
+        // One glm::mat4 at a time, how a per object loop would do it
+        harness.Add("transforms/glm" + suffix, [count, viewProjection](BenchState& state)
+        {
+            TransformBatch batch;
+            FillTransforms(count, batch);
+            std::vector<glm::mat4> world(count);
+            std::vector<glm::mat4> clip(count);
+
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                for (unsigned int i = 0; i < count; ++i)
+                {
+                    world[i] = glm::translate(glm::mat4(1.0f), batch.GetPosition(i)) * glm::mat4_cast(batch.GetRotation(i))
+                        * glm::scale(glm::mat4(1.0f), batch.GetScale(i));
+                    clip[i] = viewProjection * world[i];
+                }
+            }
+        });
+
+        for (Transform_Kernel kernel : { TRANSFORM_KERNEL_SCALAR, TRANSFORM_KERNEL_SSE, TRANSFORM_KERNEL_AVX2 })
+        {
+            harness.Add(std::string("transforms/") + TransformBatch::GetKernelName(kernel) + suffix,
+                [count, viewProjection, kernel](BenchState& state)
+            {
+                if (!TransformBatch::IsKernelSupported(kernel))
+                {
+                    state.Skip(std::string("this CPU can't run the ") + TransformBatch::GetKernelName(kernel) + " kernel");
+                    return;
+                }
+                TransformBatch batch;
+                FillTransforms(count, batch);
+                std::vector<glm::mat4> world(count);
+                std::vector<glm::mat4> clip(count);
+
+                TransformBatch::SetKernel(kernel);
+                state.SetItemsPerIteration(count);
+                while (state.KeepRunning())
+                {
+                    batch.ComputeWorldClip(viewProjection, world.data(), clip.data());
+                }
+                TransformBatch::ResetKernel();
+            });
+        }
+    }
+}
+
+////////////////// SCENE GRAPH /////////////////////////
+
+// count nodes under 16 roots, each under a random earlier node with a fixed seed. Wide and
+// shallow like a level (about ln(count) deep), with most nodes near the leaves
+static void BuildSceneGraph(unsigned int count, SceneGraph& graph, std::vector<SceneNode>& nodes)
+{
+    std::mt19937 random(11);
+    nodes.reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        SceneNode parent = SCENE_NODE_NONE;
+        if (i >= 16)
+        {
+            std::uniform_int_distribution<unsigned int> earlier(0, i - 1);
+            parent = nodes[earlier(random)];
+        }
+        nodes.push_back(graph.Create(parent, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.01f, 0.0f))));
+    }
+    graph.Update();
+}
+
+static void AddSceneGraphScenarios(BenchHarness& harness)
+{
+    const unsigned int count = 1000000;
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        std::string suffix = "_t" + std::to_string(numThreads);
+
+        // The same 1% of nodes move every frame, like the animated props in a big level. The
+        // first few thousand are left alone, moving those is a whole level chunk at once
+        harness.Add("scene/update_1m_1pct" + suffix, [numThreads, count](BenchState& state)
+        {
+            ScopedJobSystem scopedJobs(numThreads);
+            SceneGraph graph;
+            std::vector<SceneNode> nodes;
+            BuildSceneGraph(count, graph, nodes);
+            std::mt19937 random(13);
+            std::uniform_int_distribution<unsigned int> any(4096, count - 1);
+            std::vector<SceneNode> moving(count / 100);
+            for (SceneNode& node : moving)
+            {
+                node = nodes[any(random)];
+            }
+
+            float time = 0.0f;
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                time += 0.01f;
+                for (SceneNode node : moving)
+                {
+                    graph.SetLocal(node, glm::translate(glm::mat4(1.0f), glm::vec3(std::sin(time), 0.01f, 0.0f)));
+                }
+                graph.Update();
+            }
+        });
+
+        // Everything dirty, what recomputing the whole hierarchy every frame costs
+        harness.Add("scene/update_1m_all" + suffix, [numThreads, count](BenchState& state)
+        {
+            ScopedJobSystem scopedJobs(numThreads);
+            SceneGraph graph;
+            std::vector<SceneNode> nodes;
+            BuildSceneGraph(count, graph, nodes);
+
+            float time = 0.0f;
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                time += 0.01f;
+                for (unsigned int i = 0; i < 16; ++i)
+                {
+                    graph.SetLocal(nodes[i], glm::translate(glm::mat4(1.0f), glm::vec3(std::sin(time), 0.01f, 0.0f)));
+                }
+                graph.Update();
+            }
+        });
+    }
+}
+
+////////////////// ENTITIES /////////////////////////
+
+// count entities spread over four archetypes, all with transforms, some with bounds and
+// some renderable, so queries have to cover several
+static void FillEntities(unsigned int count, EntityStore& store)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        TransformComponent transform = { glm::vec3((float)i, 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) };
+        WorldTransformComponent world = { glm::mat4(1.0f) };
+        BoundsComponent bounds = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+        RenderableComponent renderable = { NULL, NULL };
+        switch (i % 4)
+        {
+        case 0: store.Create(transform, world); break;
+        case 1: store.Create(transform, world, bounds); break;
+        case 2: store.Create(transform, world, renderable); break;
+        default: store.Create(transform, world, bounds, renderable); break;
+        }
+    }
+}
+
+static void AddEntityScenarios(BenchHarness& harness)
+{
+    // Touches one component array per chunk, so this is about as fast as iterating gets
+    harness.Add("ecs/foreach_transform_4m", [](BenchState& state)
+    {
+        const unsigned int count = 4000000;
+        EntityStore store;
+        FillEntities(count, store);
+        state.SetItemsPerIteration(count);
+        while (state.KeepRunning())
+        {
+            store.ForEach<TransformComponent>([](Entity, TransformComponent& transform)
+            {
+                transform.position.y += 0.01f;
+            });
+        }
+    });
+
+    for (unsigned int numThreads : GetThreadCounts())
+    {
+        harness.Add("ecs/world_transforms_1m_t" + std::to_string(numThreads), [numThreads](BenchState& state)
+        {
+            const unsigned int count = 1000000;
+            ScopedJobSystem scopedJobs(numThreads);
+            EntityStore store;
+            FillEntities(count, store);
+            state.SetItemsPerIteration(count);
+            while (state.KeepRunning())
+            {
+                UpdateWorldTransforms(store);
+            }
+        });
+    }
+
+    // Adding and removing a component moves the entity between archetypes both ways
+    harness.Add("ecs/add_remove_100k", [](BenchState& state)
+    {
+        const unsigned int count = 100000;
+        EntityStore store;
+        FillEntities(count, store);
+        std::vector<Entity> entities;
+        store.ForEach<TransformComponent>([&entities](Entity entity, TransformComponent&) { entities.push_back(entity); });
+        state.SetItemsPerIteration(count * 2);
+        while (state.KeepRunning())
+        {
+            for (Entity entity : entities)
+            {
+                store.Add(entity, BoundsComponent{ glm::vec3(-1.0f), glm::vec3(1.0f) });
+            }
+            for (Entity entity : entities)
+            {
+                store.Remove<BoundsComponent>(entity);
+            }
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    // engine_bench [--filter text] [--out results.json] [--root repo]
+    std::string outPath = "engine_bench.json";
+    BenchHarness harness;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            harness.SetFilter(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (arg == "--root" && i + 1 < argc)
+        {
+            s_root = argv[++i];
+        }
+        else
+        {
+            std::cout << "Usage: engine_bench [--filter text] [--out results.json] [--root repo]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Scenarios that build programs would otherwise write the null device's binaries to
+    // shader_cache/ and load them on the next run, so results would depend on earlier runs
+    ShaderCache::Get().SetEnabled(false);
+
+    AddImportScenarios(harness);
+    AddVertexScenarios(harness);
+    AddCullingScenarios(harness);
+    AddTileScenarios(harness);
+    AddGoldenScenarios(harness);
+    AddFillScenarios(harness);
+    AddEditHistoryScenarios(harness);
+    AddPickingScenarios(harness);
+    AddMinimapScenarios(harness);
+    AddJobScenarios(harness);
+    AddTextureScenarios(harness);
+    AddUniformScenarios(harness);
+    AddTransformScenarios(harness);
+    AddSceneGraphScenarios(harness);
+    AddEntityScenarios(harness);
+    harness.RunAll();
+
+    if (!harness.WriteJSON(outPath))
+    {
+        std::cout << "Failed to write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << outPath << std::endl;
+    if (harness.GetNumFailed() > 0)
+    {
+        std::cout << harness.GetNumFailed() << " scenario(s) failed their checks" << std::endl;
+        return 1;
+    }
+    return 0;
+}
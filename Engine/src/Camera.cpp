@@ -2,19 +2,36 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cmath>
+
 #include <Camera.h>
 
+Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
+    : MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), m_position(position), m_front(0.0f, 0.0f, -1.0f),
+    m_worldUp(up), m_yaw(yaw), m_pitch(pitch), m_projectionType(CAMERA_PERSPECTIVE), m_fov(FOV), m_aspect(1.0f),
+    m_nearPlane(0.1f), m_farPlane(100.0f), m_left(-1.0f), m_rightEdge(1.0f), m_bottom(-1.0f), m_top(1.0f),
+    m_viewDirty(true), m_projectionDirty(true), m_version(0)
+{
+    updateCameraVectors();
+}
+
+Camera::Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch)
+    : Camera(glm::vec3(posX, posY, posZ), glm::vec3(upX, upY, upZ), yaw, pitch)
+{
+}
+
 void Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime)
 {
     float velocity = MovementSpeed * deltaTime;
     if (direction == FORWARD)
-        Position += Front * velocity;
+        m_position += m_front * velocity;
     if (direction == BACKWARD)
-        Position -= Front * velocity;
+        m_position -= m_front * velocity;
     if (direction == LEFT)
-        Position -= Right * velocity;
+        m_position -= m_right * velocity;
     if (direction == RIGHT)
-        Position += Right * velocity;
+        m_position += m_right * velocity;
+    MarkViewDirty();
 }
 
 void Camera::ProcessMouseMovement(float xOffset, float yOffset, GLboolean constrainPitch)
@@ -22,16 +39,16 @@ void Camera::ProcessMouseMovement(float xOffset, float yOffset, GLboolean constr
     xOffset *= MouseSensitivity;
     yOffset *= MouseSensitivity;
 
-    Yaw += xOffset;
-    Pitch += yOffset;
+    m_yaw += xOffset;
+    m_pitch += yOffset;
 
     // when pitch is out of bounds the screen shouldn't flip
     if (constrainPitch)
     {
-        if (Pitch > 89.0)
-            Pitch = 89.0;
-        if (Pitch < -89.0)
-            Pitch = -89.0;
+        if (m_pitch > 89.0f)
+            m_pitch = 89.0f;
+        if (m_pitch < -89.0f)
+            m_pitch = -89.0f;
     }
     // update Front, Right, and Up Vectors with updated Euler angles
     updateCameraVectors();
@@ -40,11 +57,268 @@ void Camera::ProcessMouseMovement(float xOffset, float yOffset, GLboolean constr
 void Camera::updateCameraVectors()
 {
     glm::vec3 front;
-    front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-    front.y = sin(glm::radians(Pitch));
-    front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-    Front = glm::normalize(front);
-
-    Right = glm::normalize(glm::cross(Front, WorldUp));
-    Up = glm::normalize(glm::cross(Right, Front));
-}
\ No newline at end of file
+    front.x = cos(glm::radians(m_yaw)) * cos(glm::radians(m_pitch));
+    front.y = sin(glm::radians(m_pitch));
+    front.z = sin(glm::radians(m_yaw)) * cos(glm::radians(m_pitch));
+    m_front = glm::normalize(front);
+
+    m_right = glm::normalize(glm::cross(m_front, m_worldUp));
+    m_up = glm::normalize(glm::cross(m_right, m_front));
+    MarkViewDirty();
+}
+
+////////////// PLACEMENT ///////////////
+
+void Camera::SetPosition(const glm::vec3& position)
+{
+    if (position != m_position)
+    {
+        m_position = position;
+        MarkViewDirty();
+    }
+}
+
+void Camera::SetRotation(float yaw, float pitch)
+{
+    if (yaw != m_yaw || pitch != m_pitch)
+    {
+        m_yaw = yaw;
+        m_pitch = pitch;
+        updateCameraVectors();
+    }
+}
+
+void Camera::LookAt(const glm::vec3& target)
+{
+    glm::vec3 direction = target - m_position;
+    if (glm::dot(direction, direction) <= 0.0f)
+    {
+        return;
+    }
+    // Front is set straight from the direction rather than going through the angles, so the
+    // view matches glm::lookAt exactly. The angles are kept in step for mouse look
+    m_front = glm::normalize(direction);
+    m_pitch = glm::degrees(std::asin(glm::clamp(m_front.y, -1.0f, 1.0f)));
+    m_yaw = glm::degrees(std::atan2(m_front.z, m_front.x));
+    m_right = glm::normalize(glm::cross(m_front, m_worldUp));
+    m_up = glm::normalize(glm::cross(m_right, m_front));
+    MarkViewDirty();
+}
+
+const glm::vec3& Camera::GetPosition() const
+{
+    return m_position;
+}
+
+const glm::vec3& Camera::GetFront() const
+{
+    return m_front;
+}
+
+const glm::vec3& Camera::GetRight() const
+{
+    return m_right;
+}
+
+const glm::vec3& Camera::GetUp() const
+{
+    return m_up;
+}
+
+float Camera::GetYaw() const
+{
+    return m_yaw;
+}
+
+float Camera::GetPitch() const
+{
+    return m_pitch;
+}
+
+////////////// PROJECTION ///////////////
+
+void Camera::SetPerspective(float fov, float aspect, float nearPlane, float farPlane)
+{
+    if (m_projectionType == CAMERA_PERSPECTIVE && fov == m_fov && aspect == m_aspect && nearPlane == m_nearPlane
+        && farPlane == m_farPlane)
+    {
+        return;
+    }
+    m_projectionType = CAMERA_PERSPECTIVE;
+    m_fov = fov;
+    m_aspect = aspect;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    MarkProjectionDirty();
+}
+
+void Camera::SetAspect(float aspect)
+{
+    SetPerspective(m_fov, aspect, m_nearPlane, m_farPlane);
+}
+
+void Camera::SetOrthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane)
+{
+    if (m_projectionType == CAMERA_ORTHOGRAPHIC && left == m_left && right == m_rightEdge && bottom == m_bottom
+        && top == m_top && nearPlane == m_nearPlane && farPlane == m_farPlane)
+    {
+        return;
+    }
+    m_projectionType = CAMERA_ORTHOGRAPHIC;
+    m_left = left;
+    m_rightEdge = right;
+    m_bottom = bottom;
+    m_top = top;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    MarkProjectionDirty();
+}
+
+Camera_Projection Camera::GetProjectionType() const
+{
+    return m_projectionType;
+}
+
+float Camera::GetFov() const
+{
+    return m_fov;
+}
+
+float Camera::GetAspect() const
+{
+    return m_aspect;
+}
+
+////////////// MATRICES ///////////////
+
+void Camera::MarkViewDirty()
+{
+    m_viewDirty = true;
+    m_version++;
+}
+
+void Camera::MarkProjectionDirty()
+{
+    m_projectionDirty = true;
+    m_version++;
+}
+
+void Camera::UpdateMatrices() const
+{
+    if (!m_viewDirty && !m_projectionDirty)
+    {
+        return;
+    }
+    if (m_viewDirty)
+    {
+        m_view = glm::lookAt(m_position, m_position + m_front, m_up);
+        m_inverseView = glm::inverse(m_view);
+    }
+    if (m_projectionDirty)
+    {
+        if (m_projectionType == CAMERA_PERSPECTIVE)
+        {
+            m_projection = glm::perspective(glm::radians(m_fov), m_aspect, m_nearPlane, m_farPlane);
+        }
+        else
+        {
+            m_projection = glm::ortho(m_left, m_rightEdge, m_bottom, m_top, m_nearPlane, m_farPlane);
+        }
+        m_inverseProjection = glm::inverse(m_projection);
+    }
+    m_viewProjection = m_projection * m_view;
+    m_inverseViewProjection = m_inverseView * m_inverseProjection;
+    m_viewDirty = false;
+    m_projectionDirty = false;
+}
+
+const glm::mat4& Camera::GetViewMatrix() const
+{
+    UpdateMatrices();
+    return m_view;
+}
+
+const glm::mat4& Camera::GetProjectionMatrix() const
+{
+    UpdateMatrices();
+    return m_projection;
+}
+
+const glm::mat4& Camera::GetViewProjectionMatrix() const
+{
+    UpdateMatrices();
+    return m_viewProjection;
+}
+
+const glm::mat4& Camera::GetInverseViewMatrix() const
+{
+    UpdateMatrices();
+    return m_inverseView;
+}
+
+const glm::mat4& Camera::GetInverseProjectionMatrix() const
+{
+    UpdateMatrices();
+    return m_inverseProjection;
+}
+
+const glm::mat4& Camera::GetInverseViewProjectionMatrix() const
+{
+    UpdateMatrices();
+    return m_inverseViewProjection;
+}
+
+unsigned int Camera::GetVersion() const
+{
+    return m_version;
+}
+
+////////////// CULLING AND PICKING ///////////////
+
+void Camera::GetFrustumPlanes(glm::vec4 planes[CAMERA_PLANE_COUNT]) const
+{
+    // Gribb and Hartmann: each plane is the last row of projection * view plus or minus one of
+    // the others. glm is column major, so rows are taken across the columns
+    const glm::mat4& m = GetViewProjectionMatrix();
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+    planes[CAMERA_PLANE_LEFT] = rows[3] + rows[0];
+    planes[CAMERA_PLANE_RIGHT] = rows[3] - rows[0];
+    planes[CAMERA_PLANE_BOTTOM] = rows[3] + rows[1];
+    planes[CAMERA_PLANE_TOP] = rows[3] - rows[1];
+    planes[CAMERA_PLANE_NEAR] = rows[3] + rows[2];
+    planes[CAMERA_PLANE_FAR] = rows[3] - rows[2];
+    for (int i = 0; i < CAMERA_PLANE_COUNT; ++i)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+bool Camera::IsBoxVisible(const glm::vec4 planes[CAMERA_PLANE_COUNT], const glm::vec3& min, const glm::vec3& max)
+{
+    for (int i = 0; i < CAMERA_PLANE_COUNT; ++i)
+    {
+        // The corner furthest along the plane's normal. If even that is outside, all of it is
+        glm::vec3 corner(
+            planes[i].x >= 0.0f ? max.x : min.x,
+            planes[i].y >= 0.0f ? max.y : min.y,
+            planes[i].z >= 0.0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(planes[i]), corner) + planes[i].w < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Camera::GetRay(const glm::vec2& ndc, glm::vec3& origin, glm::vec3& direction) const
+{
+    const glm::mat4& inverse = GetInverseViewProjectionMatrix();
+    glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
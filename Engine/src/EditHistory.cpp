@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <TileMap.h>
+#include <EditHistory.h>
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+EditHistory::EditHistory(size_t memoryCap)
+    : m_memoryCap(memoryCap)
+{
+}
+
+////////////// RECORDING ////////////////
+
+void EditHistory::BeginEdit(TileMap* map)
+{
+    if (m_recording)
+    {
+        std::cout << "EDIT HISTORY: BeginEdit called while already recording" << std::endl;
+        EndEdit();
+    }
+    m_map = map;
+    m_recording = true;
+    m_editStamp++;
+    m_map->SetRecorder(this);
+}
+
+void EditHistory::EndEdit()
+{
+    if (!m_recording)
+    {
+        return;
+    }
+    m_recording = false;
+    m_map->SetRecorder(nullptr);
+
+    Edit edit;
+    edit.chunks.reserve(m_snapshots.size());
+    for (Snapshot& snapshot : m_snapshots)
+    {
+        ChunkDelta delta;
+        delta.chunk = snapshot.chunk;
+        CompressChunk(snapshot.cells.get(), m_map->GetChunk(snapshot.chunk).cells, delta);
+        if (delta.runs.empty())
+        {
+            // Chunk was written but ended up back where it started
+            continue;
+        }
+        for (const Run& run : delta.runs)
+        {
+            edit.numCells += run.count;
+        }
+        edit.numBytes += sizeof(ChunkDelta) + delta.runs.size() * sizeof(Run);
+        delta.runs.shrink_to_fit();
+        edit.chunks.push_back(std::move(delta));
+    }
+    m_snapshots.clear();
+
+    if (edit.chunks.empty())
+    {
+        return;
+    }
+
+    // Keep chunk order stable so applying an edit walks memory front to back
+    std::sort(edit.chunks.begin(), edit.chunks.end(),
+        [](const ChunkDelta& a, const ChunkDelta& b) { return a.chunk < b.chunk; });
+    edit.numBytes += sizeof(Edit);
+
+    // New edit invalidates anything that was undone
+    for (const Edit& undone : m_redoStack)
+    {
+        m_memoryUsage -= undone.numBytes;
+    }
+    m_redoStack.clear();
+
+    m_memoryUsage += edit.numBytes;
+    m_undoStack.push_back(std::move(edit));
+    TrimToCap();
+}
+
+bool EditHistory::IsRecording() const
+{
+    return m_recording;
+}
+
+void EditHistory::OnChunkWrite(unsigned int index, TileMap::Chunk& chunk)
+{
+    if (chunk.editStamp == m_editStamp)
+    {
+        return;
+    }
+    // Only the thread that owns this chunk gets here, so the stamp itself needs no lock
+    chunk.editStamp = m_editStamp;
+
+    Snapshot snapshot;
+    snapshot.chunk = index;
+    snapshot.cells.reset(new TileID[TILE_CHUNK_CELLS]);
+    std::copy(chunk.cells, chunk.cells + TILE_CHUNK_CELLS, snapshot.cells.get());
+
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_snapshots.push_back(std::move(snapshot));
+}
+
+void EditHistory::CompressChunk(const TileID* before, const TileID* after, ChunkDelta& out)
+{
+    unsigned int i = 0;
+    while (i < TILE_CHUNK_CELLS)
+    {
+        if (before[i] == after[i])
+        {
+            i++;
+            continue;
+        }
+        // Extend the run while the cells changed the same way
+        Run run;
+        run.start = i;
+        run.before = before[i];
+        run.after = after[i];
+        unsigned int end = i + 1;
+        while (end < TILE_CHUNK_CELLS && before[end] == run.before && after[end] == run.after)
+        {
+            end++;
+        }
+        run.count = end - i;
+        out.runs.push_back(run);
+        i = end;
+    }
+}
+
+////////////// UNDO / REDO ////////////////
+
+bool EditHistory::Undo()
+{
+    if (m_recording || m_undoStack.empty())
+    {
+        return false;
+    }
+    ApplyEdit(m_undoStack.back(), false);
+    m_redoStack.push_back(std::move(m_undoStack.back()));
+    m_undoStack.pop_back();
+    return true;
+}
+
+bool EditHistory::Redo()
+{
+    if (m_recording || m_redoStack.empty())
+    {
+        return false;
+    }
+    ApplyEdit(m_redoStack.back(), true);
+    m_undoStack.push_back(std::move(m_redoStack.back()));
+    m_redoStack.pop_back();
+    return true;
+}
+
+void EditHistory::ApplyEdit(const Edit& edit, bool redo)
+{
+    // Only touches the runs, so cost is proportional to the cells that changed
+    for (const ChunkDelta& delta : edit.chunks)
+    {
+        for (const Run& run : delta.runs)
+        {
+            m_map->WriteChunkRun(delta.chunk, run.start, run.count, redo ? run.after : run.before);
+        }
+    }
+}
+
+bool EditHistory::CanUndo() const
+{
+    return !m_undoStack.empty();
+}
+
+bool EditHistory::CanRedo() const
+{
+    return !m_redoStack.empty();
+}
+
+void EditHistory::Clear()
+{
+    m_undoStack.clear();
+    m_redoStack.clear();
+    m_memoryUsage = 0;
+}
+
+////////////// MEMORY ////////////////
+
+void EditHistory::SetMemoryCap(size_t bytes)
+{
+    m_memoryCap = bytes;
+    TrimToCap();
+}
+
+void EditHistory::TrimToCap()
+{
+    // Oldest edits go first. The most recent one is always kept, even if it's over the cap by itself
+    while (m_memoryUsage > m_memoryCap && (m_undoStack.size() + m_redoStack.size()) > 1)
+    {
+        if (!m_undoStack.empty())
+        {
+            m_memoryUsage -= m_undoStack.front().numBytes;
+            m_undoStack.pop_front();
+        }
+        else
+        {
+            // Only redo entries left, the furthest one from the current state is the oldest
+            m_memoryUsage -= m_redoStack.front().numBytes;
+            m_redoStack.erase(m_redoStack.begin());
+        }
+    }
+}
+
+size_t EditHistory::GetMemoryCap() const
+{
+    return m_memoryCap;
+}
+
+size_t EditHistory::GetMemoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+size_t EditHistory::GetNumUndo() const
+{
+    return m_undoStack.size();
+}
+
+size_t EditHistory::GetNumRedo() const
+{
+    return m_redoStack.size();
+}
@@ -1,8 +1,11 @@
 #define GLFW_INCLUDE_NONE
+#include <algorithm>
 #include <complex>
 #include <iostream>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -15,6 +18,15 @@
 #include "Mesh.h"
 
 #include <SHADER.h>
+#include <ShaderCache.h>
+#include <ShaderLibrary.h>
+#include <EntityStore.h>
+#include <ModelLoader.h>
+#include <RenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <SceneComponents.h>
+#include <UploadThread.h>
 
 #include <Engine.h>
 
@@ -72,9 +84,16 @@ void Engine::SetupGLFW()
         std::cout << "Failed to initialize GLAD" << std::endl;
         // return -1;
     }
+    RenderDevice::Get()->InitContext();
 
     // Tell OpenGL the size of the window
-    glViewport(0, 0, winX, winY);
+    RenderDevice::Get()->Viewport(0, 0, winX, winY);
+
+    // Vsync on, instead of spinning as fast as the loop can go
+    pacer.Attach(window);
+
+    // Model buffers and textures get uploaded from a second context on their own thread
+    UploadThread::Get().Start(window);
 
     // REGISTER CALLBACK FUNCTIONS
     // Register a callback function
@@ -94,7 +113,14 @@ void Engine::SetupGLFW()
 void Engine::framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // Viewport adjusts to new size
-    glViewport(0, 0, width, height);
+    RenderDevice::Get()->Viewport(0, 0, width, height);
+    // Camera viewports are fractions of this
+    Engine* engine = static_cast<Engine*>(glfwGetWindowUserPointer(window));
+    if (engine && width > 0 && height > 0)
+    {
+        engine->winX = width;
+        engine->winY = height;
+    }
 }
 
 static void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
@@ -130,11 +156,20 @@ static void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
 void Engine::StartRenderLoop()
 // Called after SetupGLFW()
 {
+    RenderDevice* device = RenderDevice::Get();
+    Profiler& profiler = Profiler::Get();
+    profiler.SetThreadName("Main");
+    ProfileScope loadScope("Load");
+
     // Flip loaded textures on y-axis
     stbi_set_flip_vertically_on_load(true);
 
     // Compile shaders
-    Shader shader("../Engine/src/Shaders/shader.vs", "../Engine/src/Shaders/shader.fs");
+    ShaderLibrary& shaders = ShaderLibrary::Get();
+    shaders.Register("model", "../Engine/src/Shaders/shader.vs", "../Engine/src/Shaders/shader.fs");
+    Shader& shader = *shaders.GetShader("model");
+    // Saved shaders are swapped in without restarting (and reloading the model)
+    shaders.EnableHotReload([] { glfwPostEmptyEvent(); });
 
     // Sets camera variable values
     SetupCamera();
@@ -144,71 +179,50 @@ void Engine::StartRenderLoop()
 
     // Set the path to the model
     const string sPath = "../Models/backpack/backpack.obj";
-    // Load the model
-    Model aModel(sPath);
+    // Load the model in the background, a placeholder draws until it's ready
+    ModelLoader& modelLoader = ModelLoader::Get();
+    std::shared_ptr<Model> aModel = modelLoader.Load(sPath);
+    // The scene's objects. Just the backpack, at the center at its own size
+    EntityStore entities;
+    entities.Create(TransformComponent{ glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) },
+        WorldTransformComponent{ glm::mat4(1.0f) }, RenderableComponent{ aModel.get(), &shader });
+    entities.Create(CameraComponent{ camera, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), 0, true });
 
     // Enable depth
-    glEnable(GL_DEPTH_TEST);
+    device->Enable(GL_DEPTH_TEST);
+    loadScope.End();
 
     while (!glfwWindowShouldClose(window))
     {
         CalculateDeltaTime();
         // Keep running
 
-        // Input
-        ProcessInput(window);
-
-        // Color buffer
-        glClearColor(0.8f, 0.973f, 0.6f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // --------- RENDERING COMMANDS ---------
-
-        // enable shader
-        shader.Use();
-        if (camera)
-        {
-            projection = glm::perspective(glm::radians(camera->Zoom), (float)winX / (float)winY, 0.1f, 100.0f);
-            view = camera->GetViewMatrix();
-        }
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-
-        // Render the loaded model
-
-        // Create identity matrix (no transformations applied)
-        // Gets set back to identity matrix first in every iteration of the render loop
-        /*
-         * 1 0 0 0
-         * 0 1 0 0
-         * 0 0 1 0
-         * 0 0 0 1
-         **/
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // put at the center
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f)); // Scaling the model
-        shader.setMat4("model", model);
-        aModel.Draw(shader);
-
-        /* -- Unused but here for reference --
-        // Render
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // Rotate cube over time
-        model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0.5f, 1.0f, 0.0f));
-        */
-
-        glfwPollEvents();
+        pacer.BeginFrame();
+        profiler.BeginFrame();
         // Checks if any events are triggered like:
         //  - Keyboard input
         //  - Mouse Movement
         // Updates the window state
         // Calls corresponding functions
 
-        glfwSwapBuffers(window);
+        // Input
+        {
+            PROFILE_SCOPE("Update");
+            ProcessInput(window);
+            modelLoader.Update();
+            shaders.Update();
+        }
+
+        {
+            PROFILE_SCOPE("Submit");
+            PROFILE_GPU_SCOPE("Submit");
+            DrawScene(shader, entities);
+        }
+
+        {
+            PROFILE_SCOPE("Swap");
+            pacer.Present();
+        }
         // What is a color buffer??
         // -> Large 2D buffer that contains color values for each pixel in GLFW's window
         // What is a 'Double Buffer'?
@@ -217,14 +231,118 @@ void Engine::StartRenderLoop()
         // + Front Buffer: Final output image on the screen
         // + Back Buffer: Where rendering commands are drawn to.
         //      When rendering commands are finished -> Swap back to the front.
+        pacer.EndFrame(true);
+        profiler.EndFrame();
+        RenderStats::Get().EndFrame();
     }
 
+    std::cout << pacer.GetReport() << std::endl;
+    std::cout << profiler.GetReport() << std::endl;
+    std::cout << RenderStats::Get().GetReport() << std::endl;
+    std::cout << ShaderCache::Get().GetReport() << std::endl;
+
     // Cleanup when closing the window
+    shaders.Clear();
+    UploadThread::Get().Stop();
     DestroyWindow();
     glfwTerminate();
 
 }
 
+void Engine::DrawScene(Shader& shader, EntityStore& entities)
+// One frame of the scene, shared by the windowed and headless loops
+{
+    RenderDevice* device = RenderDevice::Get();
+
+    // Color buffer
+    device->ClearColor(0.8f, 0.973f, 0.6f, 1.0f);
+    device->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // --------- RENDERING COMMANDS ---------
+
+    // Render the scene's objects. Each one's world transform becomes its "model" matrix
+    UpdateWorldTransforms(entities);
+
+    // Once per active camera, each into its own part of the window
+    std::vector<CameraComponent> cameras;
+    GetActiveCameras(entities, cameras);
+    for (const CameraComponent& active : cameras)
+    {
+        int x = (int)(active.viewport.x * winX);
+        int y = (int)(active.viewport.y * winY);
+        int width = std::max((int)(active.viewport.z * winX), 1);
+        int height = std::max((int)(active.viewport.w * winY), 1);
+        device->Viewport(x, y, width, height);
+        if (active.camera->GetProjectionType() == CAMERA_PERSPECTIVE)
+        {
+            active.camera->SetAspect((float)width / (float)height);
+        }
+
+        // enable shader
+        shader.Use();
+        // Cached by the camera, only rebuilt when it moved or the window changed
+        projection = active.camera->GetProjectionMatrix();
+        view = active.camera->GetViewMatrix();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        DrawRenderables(entities);
+    }
+
+    /* -- Unused but here for reference --
+    // Render
+    device->BindVertexArray(VAO);
+    device->DrawArrays(GL_TRIANGLES, 0, 3);
+    device->DrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    device->DrawArrays(GL_TRIANGLES, 0, 36);
+
+    // Rotate cube over time
+    model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0.5f, 1.0f, 0.0f));
+    */
+}
+
+void Engine::RunHeadless(unsigned int numFrames)
+// Loads and draws the same scene as StartRenderLoop, with no window or context. A device that
+// doesn't need a context (NullRenderDevice) has to be set with RenderDevice::Set first
+{
+    RenderDevice* device = RenderDevice::Get();
+    if (device->NeedsContext())
+    {
+        std::cout << "RunHeadless needs a render device that works without a context, " << device->GetName()
+            << " doesn't" << std::endl;
+        return;
+    }
+
+    Profiler& profiler = Profiler::Get();
+    profiler.SetThreadName("Main");
+    ProfileScope loadScope("Load");
+
+    stbi_set_flip_vertically_on_load(true);
+    ShaderLibrary& shaders = ShaderLibrary::Get();
+    shaders.Register("model", "../Engine/src/Shaders/shader.vs", "../Engine/src/Shaders/shader.fs");
+    Shader& shader = *shaders.GetShader("model");
+    SetupCamera();
+    CreateMatrices(shader);
+    Model aModel("../Models/backpack/backpack.obj");
+    EntityStore entities;
+    entities.Create(TransformComponent{ glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) },
+        WorldTransformComponent{ glm::mat4(1.0f) }, RenderableComponent{ &aModel, &shader });
+    entities.Create(CameraComponent{ camera, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), 0, true });
+    device->Enable(GL_DEPTH_TEST);
+    loadScope.End();
+
+    for (unsigned int i = 0; i < numFrames; ++i)
+    {
+        profiler.BeginFrame();
+        {
+            PROFILE_SCOPE("Submit");
+            DrawScene(shader, entities);
+        }
+        profiler.EndFrame();
+        RenderStats::Get().EndFrame();
+    }
+    shaders.Clear();
+}
+
 void Engine::CreateWindow()
 // Create a window and context
 {
@@ -309,8 +427,9 @@ void Engine::ProcessInput(GLFWwindow *window)
 // COLOR BUFFER
 void Engine::SetBufferColor(float r, float g, float b, float a)
 {
-    glClearColor(r,g,b,a);
-    glClear(GL_COLOR_BUFFER_BIT);
+    RenderDevice* device = RenderDevice::Get();
+    device->ClearColor(r,g,b,a);
+    device->Clear(GL_COLOR_BUFFER_BIT);
 }
 
 void Engine::InitColors()
@@ -345,8 +464,9 @@ void Engine::ChangeColor()
 
 void Engine::SetupCamera()
 {
-    // Instantiate the camera
-    camera = new Camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    // Instantiate the camera, looking down -z at the model
+    camera = new Camera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f);
+    camera->SetPerspective(FOV, (float)winX / (float)winY, 0.1f, 100.0f);
 
 }
 
@@ -358,9 +478,10 @@ void Engine::SetCameraAngle(float xoff, float yoff)
     }
 }
 
-void Engine::CreateMatrices(Shader s)
+void Engine::CreateMatrices(Shader& s)
 {
     projection = glm::mat4(1.0f);
+    s.Use();
     s.setMat4("projection", projection);
 }
 
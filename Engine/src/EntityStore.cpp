@@ -0,0 +1,288 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <EntityStore.h>
+
+// Sizes and alignments of every registered component, by id
+struct ComponentInfo
+{
+    size_t size;
+    size_t alignment;
+};
+
+// Function statics so ids can be handed out from other statics' constructors too
+static std::vector<ComponentInfo>& GetComponentInfos()
+{
+    static std::vector<ComponentInfo> infos;
+    return infos;
+}
+
+static std::mutex& GetComponentMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static ComponentInfo GetComponentInfo(unsigned int id)
+{
+    std::lock_guard<std::mutex> lock(GetComponentMutex());
+    return GetComponentInfos()[id];
+}
+
+unsigned int EntityStore::RegisterComponent(size_t size, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(GetComponentMutex());
+    std::vector<ComponentInfo>& infos = GetComponentInfos();
+    if (infos.size() >= ENTITY_MAX_COMPONENTS)
+    {
+        std::cout << "ERROR::ENTITY_STORE::TOO_MANY_COMPONENTS limit is " << ENTITY_MAX_COMPONENTS << std::endl;
+        std::abort();
+    }
+    infos.push_back({ size, alignment });
+    return (unsigned int)infos.size() - 1;
+}
+
+EntityStore::EntityStore()
+{
+    // Entities with no components
+    GetArchetype(0);
+}
+
+////////////////// ENTITIES /////////////////////////
+
+Entity EntityStore::Allocate(Archetype* archetype)
+{
+    unsigned int index;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else
+    {
+        index = (unsigned int)m_records.size();
+        m_records.push_back(Record());
+    }
+    AddRow(archetype, index);
+    m_count++;
+
+    Entity entity;
+    entity.index = index;
+    entity.generation = m_records[index].generation;
+    return entity;
+}
+
+void EntityStore::Destroy(Entity entity)
+{
+    if (!IsAlive(entity))
+    {
+        return;
+    }
+    Record& record = m_records[entity.index];
+    RemoveRow(record.archetype, record.chunk, record.row);
+    record.archetype = NULL;
+    record.generation++;
+    m_freeIndices.push_back(entity.index);
+    m_count--;
+}
+
+bool EntityStore::IsAlive(Entity entity) const
+{
+    return entity.index < m_records.size() && m_records[entity.index].archetype
+        && m_records[entity.index].generation == entity.generation;
+}
+
+void EntityStore::Clear()
+{
+    // Archetypes and queries are kept, they'll likely be needed again
+    for (std::unique_ptr<Archetype>& archetype : m_archetypes)
+    {
+        archetype->chunks.clear();
+    }
+    for (unsigned int i = 0; i < m_records.size(); ++i)
+    {
+        if (m_records[i].archetype)
+        {
+            m_records[i].archetype = NULL;
+            m_records[i].generation++;
+            m_freeIndices.push_back(i);
+        }
+    }
+    m_count = 0;
+}
+
+unsigned int EntityStore::GetCount() const
+{
+    return m_count;
+}
+
+unsigned int EntityStore::GetNumArchetypes() const
+{
+    return (unsigned int)m_archetypes.size();
+}
+
+void* EntityStore::GetComponent(Entity entity, unsigned int id)
+{
+    Record& record = m_records[entity.index];
+    Archetype& archetype = *record.archetype;
+    unsigned char* bytes = archetype.chunks[record.chunk].memory->bytes;
+    return bytes + archetype.offsets[id] + (size_t)record.row * archetype.sizes[id];
+}
+
+////////////////// ARCHETYPES /////////////////////////
+
+EntityStore::Archetype* EntityStore::GetArchetype(ComponentMask mask)
+{
+    std::unordered_map<ComponentMask, Archetype*>::iterator found = m_archetypesByMask.find(mask);
+    if (found != m_archetypesByMask.end())
+    {
+        return found->second;
+    }
+
+    std::unique_ptr<Archetype> archetype(new Archetype());
+    archetype->mask = mask;
+    size_t entityBytes = sizeof(Entity);
+    for (unsigned int id = 0; id < ENTITY_MAX_COMPONENTS; ++id)
+    {
+        archetype->offsets[id] = 0;
+        archetype->sizes[id] = 0;
+        if (mask & Bit(id))
+        {
+            archetype->components.push_back(id);
+            archetype->sizes[id] = (unsigned int)GetComponentInfo(id).size;
+            entityBytes += archetype->sizes[id];
+        }
+    }
+
+    // As many as fit, less one if aligning the arrays pushes the last one past the end
+    unsigned int capacity = (unsigned int)(ENTITY_CHUNK_BYTES / entityBytes);
+    while (capacity > 0)
+    {
+        size_t offset = sizeof(Entity) * capacity;
+        for (unsigned int id : archetype->components)
+        {
+            ComponentInfo info = GetComponentInfo(id);
+            offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+            archetype->offsets[id] = (unsigned int)offset;
+            offset += info.size * capacity;
+        }
+        if (offset <= ENTITY_CHUNK_BYTES)
+        {
+            break;
+        }
+        capacity--;
+    }
+    if (capacity == 0)
+    {
+        std::cout << "ERROR::ENTITY_STORE::ARCHETYPE_TOO_BIG one entity needs " << entityBytes
+            << " bytes, a chunk has " << ENTITY_CHUNK_BYTES << std::endl;
+        std::abort();
+    }
+    archetype->capacity = capacity;
+
+    Archetype* result = archetype.get();
+    m_archetypes.push_back(std::move(archetype));
+    m_archetypesByMask[mask] = result;
+    return result;
+}
+
+EntityStore::Archetype* EntityStore::GetTransition(Archetype* from, unsigned int id, bool add)
+{
+    std::unordered_map<unsigned int, Archetype*>& edges = add ? from->added : from->removed;
+    std::unordered_map<unsigned int, Archetype*>::iterator found = edges.find(id);
+    if (found != edges.end())
+    {
+        return found->second;
+    }
+    Archetype* to = GetArchetype(add ? from->mask | Bit(id) : from->mask & ~Bit(id));
+    edges[id] = to;
+    return to;
+}
+
+const std::vector<EntityStore::Archetype*>& EntityStore::GetQuery(ComponentMask mask)
+{
+    Query& query = m_queries[mask];
+    for (; query.numChecked < m_archetypes.size(); ++query.numChecked)
+    {
+        Archetype* archetype = m_archetypes[query.numChecked].get();
+        if ((archetype->mask & mask) == mask)
+        {
+            query.archetypes.push_back(archetype);
+        }
+    }
+    return query.archetypes;
+}
+
+////////////////// ROWS /////////////////////////
+
+void EntityStore::AddRow(Archetype* archetype, unsigned int index)
+{
+    if (archetype->chunks.empty() || archetype->chunks.back().count == archetype->capacity)
+    {
+        archetype->chunks.emplace_back();
+        archetype->chunks.back().memory.reset(new ChunkMemory());
+    }
+    Chunk& chunk = archetype->chunks.back();
+    Record& record = m_records[index];
+    record.archetype = archetype;
+    record.chunk = (unsigned int)archetype->chunks.size() - 1;
+    record.row = chunk.count++;
+
+    Entity& entity = ((Entity*)chunk.memory->bytes)[record.row];
+    entity.index = index;
+    entity.generation = record.generation;
+}
+
+void EntityStore::RemoveRow(Archetype* archetype, unsigned int chunkIndex, unsigned int row)
+{
+    Chunk& last = archetype->chunks.back();
+    unsigned int lastRow = last.count - 1;
+    Chunk& chunk = archetype->chunks[chunkIndex];
+
+    if (&chunk != &last || row != lastRow)
+    {
+        unsigned char* to = chunk.memory->bytes;
+        unsigned char* from = last.memory->bytes;
+        Entity moved = ((Entity*)from)[lastRow];
+        ((Entity*)to)[row] = moved;
+        for (unsigned int id : archetype->components)
+        {
+            size_t size = archetype->sizes[id];
+            std::memcpy(to + archetype->offsets[id] + row * size, from + archetype->offsets[id] + lastRow * size, size);
+        }
+        m_records[moved.index].chunk = chunkIndex;
+        m_records[moved.index].row = row;
+    }
+
+    last.count--;
+    if (last.count == 0)
+    {
+        archetype->chunks.pop_back();
+    }
+}
+
+void EntityStore::Move(Entity entity, Archetype* to)
+{
+    Record& record = m_records[entity.index];
+    Archetype* from = record.archetype;
+    unsigned int fromChunk = record.chunk;
+    unsigned int fromRow = record.row;
+
+    // New row first, while the old one is still where the record said
+    AddRow(to, entity.index);
+    const unsigned char* fromBytes = from->chunks[fromChunk].memory->bytes;
+    for (unsigned int id : from->components)
+    {
+        if (to->mask & Bit(id))
+        {
+            size_t size = from->sizes[id];
+            std::memcpy(GetComponent(entity, id), fromBytes + from->offsets[id] + fromRow * size, size);
+        }
+    }
+    RemoveRow(from, fromChunk, fromRow);
+}
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <Profiler.h>
+
+#include <FileWatcher.h>
+
+FileWatcher::FileWatcher(std::function<void()> onChange)
+    : m_onChange(onChange)
+{
+#ifdef __linux__
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    m_thread = std::thread(&FileWatcher::ThreadLoop, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_thread.join();
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        close(m_inotify);
+    }
+#endif
+}
+
+std::string FileWatcher::Normalize(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::path normalized = std::filesystem::weakly_canonical(path, error);
+    return error ? path : normalized.string();
+}
+
+bool FileWatcher::Watch(const std::string& path)
+{
+    std::string file = Normalize(path);
+    std::error_code error;
+    std::filesystem::file_time_type written = std::filesystem::last_write_time(file, error);
+    if (error)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_files.count(file) != 0)
+    {
+        return true;
+    }
+    m_files[file] = written;
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        std::string directory = std::filesystem::path(file).parent_path().string();
+        // Watching the same directory again hands back the same descriptor
+        int watch = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch >= 0)
+        {
+            m_directories[watch] = directory;
+        }
+    }
+#endif
+    return true;
+}
+
+void FileWatcher::TakeChanges(std::vector<std::string>& changed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    changed.insert(changed.end(), m_changed.begin(), m_changed.end());
+    m_changed.clear();
+}
+
+void FileWatcher::AddChange(const std::string& path)
+{
+    m_changed.insert(path);
+}
+
+void FileWatcher::ThreadLoop()
+{
+    Profiler::Get().SetThreadName("FileWatcher");
+    int timeoutMs = (int)(FILE_WATCH_POLL_SECONDS * 1000.0);
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_quit)
+            {
+                return;
+            }
+        }
+
+        size_t numChanged = 0;
+#ifdef __linux__
+        if (m_inotify >= 0)
+        {
+            pollfd descriptor = { m_inotify, POLLIN, 0 };
+            if (poll(&descriptor, 1, timeoutMs) > 0)
+            {
+                ReadEvents();
+            }
+        }
+        else
+#endif
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            PollModifiedTimes();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            numChanged = m_changed.size();
+        }
+        if (numChanged > 0 && m_onChange)
+        {
+            m_onChange();
+        }
+    }
+}
+
+void FileWatcher::PollModifiedTimes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& file : m_files)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type written = std::filesystem::last_write_time(file.first, error);
+        // Mid save (removed before the new one is moved in), it'll be back next time
+        if (!error && written != file.second)
+        {
+            file.second = written;
+            AddChange(file.first);
+        }
+    }
+}
+
+#ifdef __linux__
+void FileWatcher::ReadEvents()
+{
+    // Aligned like the kernel's struct, events are packed back to back
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (char* at = buffer; at < buffer + length;)
+        {
+            const inotify_event* event = (const inotify_event*)at;
+            at += sizeof(inotify_event) + event->len;
+
+            auto directory = m_directories.find(event->wd);
+            if (directory == m_directories.end() || event->len == 0)
+            {
+                continue;
+            }
+            // Everything else in the directory is ignored
+            std::string file = (std::filesystem::path(directory->second) / event->name).string();
+            if (m_files.count(file) != 0)
+            {
+                AddChange(file);
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,258 @@
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <FramePacer.h>
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+FramePacer::FramePacer(Pacing_Mode mode, double targetFrameRate, double fixedStep)
+    : m_mode(mode)
+    , m_targetFrameTime(1.0 / targetFrameRate)
+    , m_fixedStep(fixedStep)
+{
+}
+
+void FramePacer::Attach(GLFWwindow* window)
+{
+    m_window = window;
+    UpdateSwapInterval();
+    ResetStats();
+}
+
+void FramePacer::SetMode(Pacing_Mode mode)
+{
+    m_mode = mode;
+    m_dirtyFrames = std::max(m_dirtyFrames, 1);
+    UpdateSwapInterval();
+}
+
+Pacing_Mode FramePacer::GetMode() const
+{
+    return m_mode;
+}
+
+void FramePacer::SetTargetFrameRate(double frameRate)
+{
+    m_targetFrameTime = 1.0 / frameRate;
+}
+
+void FramePacer::SetFixedStep(double step)
+{
+    m_fixedStep = step;
+}
+
+double FramePacer::GetFixedStep() const
+{
+    return m_fixedStep;
+}
+
+void FramePacer::SetIdleTimeout(double seconds)
+{
+    m_idleTimeout = seconds;
+}
+
+void FramePacer::SetHandlesEvents(bool handles)
+{
+    m_handlesEvents = handles;
+}
+
+void FramePacer::AddIdleTime(double seconds)
+{
+    m_stats.idleSeconds += seconds;
+}
+
+void FramePacer::SetVBlankSync(bool sync)
+{
+    m_vblankSync = sync;
+    UpdateSwapInterval();
+}
+
+void FramePacer::UpdateSwapInterval()
+{
+    if (!m_window || glfwGetCurrentContext() != m_window)
+    {
+        return;
+    }
+    // Capped mode does its own limiting, the others let the driver wait for vblank
+    glfwSwapInterval(m_mode == PACING_CAPPED || !m_vblankSync ? 0 : 1);
+}
+
+////////////////// PER FRAME /////////////////////////
+
+int FramePacer::BeginFrame()
+{
+    double now = glfwGetTime();
+    if (m_lastTime < 0.0)
+    {
+        m_lastTime = now;
+        m_nextFrameTime = now;
+    }
+
+    if (!m_handlesEvents)
+    {
+        // Already handled for this pass of the loop
+    }
+    else if (m_mode == PACING_EVENT_DRIVEN && m_dirtyFrames <= 0)
+    {
+        // Nothing to draw, so block until input shows up (or the timeout, so fixed updates still happen)
+        double waitStart = glfwGetTime();
+        glfwWaitEventsTimeout(m_idleTimeout);
+        m_stats.idleSeconds += glfwGetTime() - waitStart;
+    }
+    else
+    {
+        glfwPollEvents();
+    }
+
+    now = glfwGetTime();
+    m_accumulator = std::min(m_accumulator + (now - m_lastTime), m_maxAccumulated);
+    m_lastTime = now;
+
+    int numTicks = 0;
+    while (m_accumulator >= m_fixedStep)
+    {
+        m_accumulator -= m_fixedStep;
+        numTicks++;
+    }
+    m_stats.fixedUpdates += numTicks;
+    m_stats.loops++;
+    m_workStart = now;
+    return numTicks;
+}
+
+bool FramePacer::ShouldRender() const
+{
+    return m_mode != PACING_EVENT_DRIVEN || m_dirtyFrames > 0;
+}
+
+void FramePacer::Present()
+{
+    double swapStart = glfwGetTime();
+    double workMs = (swapStart - m_workStart) * 1000.0;
+    unsigned long long n = ++m_stats.workSamples;
+    m_stats.avgWorkMs += (workMs - m_stats.avgWorkMs) / (double)n;
+    m_stats.maxWorkMs = (n == 1) ? workMs : std::max(m_stats.maxWorkMs, workMs);
+
+    glfwSwapBuffers(m_window);
+    if (m_mode != PACING_CAPPED)
+    {
+        m_stats.idleSeconds += glfwGetTime() - swapStart;
+    }
+}
+
+void FramePacer::EndFrame(bool rendered)
+{
+    double now = glfwGetTime();
+
+    if (rendered)
+    {
+        if (m_dirtyFrames > 0)
+        {
+            m_dirtyFrames--;
+        }
+
+        // Frame time is measured render to render, so it includes vsync and limiter waits
+        if (m_lastRenderTime >= 0.0)
+        {
+            double frameMs = (now - m_lastRenderTime) * 1000.0;
+            unsigned long long n = ++m_stats.frameSamples;
+            m_stats.avgFrameMs += (frameMs - m_stats.avgFrameMs) / (double)n;
+            m_stats.minFrameMs = (n == 1) ? frameMs : std::min(m_stats.minFrameMs, frameMs);
+            m_stats.maxFrameMs = (n == 1) ? frameMs : std::max(m_stats.maxFrameMs, frameMs);
+        }
+        m_lastRenderTime = now;
+        m_stats.framesRendered++;
+    }
+
+    if (m_mode == PACING_CAPPED)
+    {
+        m_nextFrameTime += m_targetFrameTime;
+        // Fell too far behind, don't try to make the missed frames up
+        if (m_nextFrameTime < now)
+        {
+            m_nextFrameTime = now;
+        }
+        TimedWait(m_nextFrameTime - now);
+    }
+
+    m_stats.totalSeconds = glfwGetTime() - m_statsStart;
+    if (m_stats.totalSeconds > 0.0)
+    {
+        m_stats.busyFraction = 1.0 - std::min(1.0, m_stats.idleSeconds / m_stats.totalSeconds);
+    }
+}
+
+void FramePacer::TimedWait(double seconds)
+{
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+    double start = glfwGetTime();
+    double end = start + seconds;
+
+    // Sleep is only accurate to a millisecond or two, so sleep most of the way and yield the rest
+    double sleepFor = seconds - 0.002;
+    if (sleepFor > 0.0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(sleepFor));
+    }
+    while (glfwGetTime() < end)
+    {
+        std::this_thread::yield();
+    }
+    m_stats.idleSeconds += glfwGetTime() - start;
+}
+
+void FramePacer::MarkDirty(int numFrames)
+{
+    m_dirtyFrames = std::max(m_dirtyFrames, numFrames);
+}
+
+bool FramePacer::IsDirty() const
+{
+    return m_dirtyFrames > 0;
+}
+
+double FramePacer::GetInterpolationAlpha() const
+{
+    return m_accumulator / m_fixedStep;
+}
+
+////////////////// STATS /////////////////////////
+
+const FramePacer::Stats& FramePacer::GetStats() const
+{
+    return m_stats;
+}
+
+void FramePacer::ResetStats()
+{
+    m_stats = Stats();
+    m_statsStart = glfwGetTime();
+    m_lastRenderTime = -1.0;
+}
+
+std::string FramePacer::GetReport() const
+{
+    const char* modeNames[] = { "vsync", "capped", "event driven" };
+    std::ostringstream report;
+    report << "Frame pacing (" << modeNames[m_mode] << ")\n"
+        << "  loops:          " << m_stats.loops << "\n"
+        << "  frames drawn:   " << m_stats.framesRendered << "\n"
+        << "  fixed updates:  " << m_stats.fixedUpdates << "\n"
+        << "  frame time ms:  avg " << m_stats.avgFrameMs
+        << " / min " << m_stats.minFrameMs
+        << " / max " << m_stats.maxFrameMs << "\n"
+        << "  work ms:        avg " << m_stats.avgWorkMs
+        << " / max " << m_stats.maxWorkMs << "\n"
+        << "  idle:           " << m_stats.idleSeconds << "s of " << m_stats.totalSeconds << "s\n"
+        << "  busy:           " << (m_stats.busyFraction * 100.0) << "%";
+    return report.str();
+}
@@ -0,0 +1,548 @@
+#define GLFW_INCLUDE_NONE
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <GLRenderDevice.h>
+
+////////////////// EXTENSIONS /////////////////////////
+
+// GL 4.1 / ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+// KHR_parallel_shader_compile (or the ARB version, same values)
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length,
+    GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+// Same for every context, like GLAD's own pointers
+static GetProgramBinaryProc s_getProgramBinary = NULL;
+static ProgramBinaryProc s_programBinary = NULL;
+static ProgramParameteriProc s_programParameteri = NULL;
+static MaxShaderCompilerThreadsProc s_maxShaderCompilerThreads = NULL;
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool HasVersion(int wantMajor, int wantMinor)
+{
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > wantMajor || (major == wantMajor && minor >= wantMinor);
+}
+
+void GLRenderDevice::LoadExtensions()
+{
+    std::call_once(m_extensionsLoaded, [this]
+    {
+        if (HasVersion(4, 1) || HasExtension("GL_ARB_get_program_binary"))
+        {
+            s_getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+            s_programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+            s_programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+            // Some drivers have the entry points but no formats to save in
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            m_programBinaries = s_getProgramBinary && s_programBinary && s_programParameteri && formats > 0;
+        }
+
+        if (HasExtension("GL_KHR_parallel_shader_compile"))
+        {
+            s_maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        }
+        else if (HasExtension("GL_ARB_parallel_shader_compile"))
+        {
+            s_maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+        }
+        m_parallelCompile = s_maxShaderCompilerThreads != NULL;
+    });
+}
+
+////////////////// DEVICE /////////////////////////
+
+const char* GLRenderDevice::GetName() const
+{
+    return "OpenGL";
+}
+
+bool GLRenderDevice::NeedsContext() const
+{
+    return true;
+}
+
+std::string GLRenderDevice::GetDriverString()
+{
+    const char* vendor = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version = (const char*)glGetString(GL_VERSION);
+    return std::string(vendor ? vendor : "") + " | " + (renderer ? renderer : "") + " | " + (version ? version : "");
+}
+
+void GLRenderDevice::InitContext()
+{
+    LoadExtensions();
+    if (s_maxShaderCompilerThreads)
+    {
+        // Per context. Lets the driver pick how many threads to compile on
+        s_maxShaderCompilerThreads(0xFFFFFFFF);
+    }
+}
+
+////////////////// BUFFERS /////////////////////////
+
+unsigned int GLRenderDevice::CreateVertexArray()
+{
+    GLuint vertexArray = 0;
+    glGenVertexArrays(1, &vertexArray);
+    return vertexArray;
+}
+
+void GLRenderDevice::DeleteVertexArray(unsigned int vertexArray)
+{
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLRenderDevice::BindVertexArray(unsigned int vertexArray)
+{
+    glBindVertexArray(vertexArray);
+}
+
+unsigned int GLRenderDevice::CreateBuffer()
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void GLRenderDevice::DeleteBuffer(unsigned int buffer)
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLRenderDevice::BindBuffer(GLenum target, unsigned int buffer)
+{
+    glBindBuffer(target, buffer);
+}
+
+void GLRenderDevice::BufferData(GLenum target, size_t size, const void* data, GLenum usage)
+{
+    glBufferData(target, (GLsizeiptr)size, data, usage);
+}
+
+void GLRenderDevice::BufferSubData(GLenum target, size_t offset, size_t size, const void* data)
+{
+    glBufferSubData(target, (GLintptr)offset, (GLsizeiptr)size, data);
+}
+
+void GLRenderDevice::EnableVertexAttribArray(unsigned int index)
+{
+    glEnableVertexAttribArray(index);
+}
+
+void GLRenderDevice::VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+    size_t offset)
+{
+    glVertexAttribPointer(index, size, type, normalized ? GL_TRUE : GL_FALSE, stride, (void*)offset);
+}
+
+void GLRenderDevice::VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset)
+{
+    glVertexAttribIPointer(index, size, type, stride, (void*)offset);
+}
+
+////////////////// TEXTURES /////////////////////////
+
+unsigned int GLRenderDevice::CreateTexture()
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    return texture;
+}
+
+void GLRenderDevice::DeleteTexture(unsigned int texture)
+{
+    glDeleteTextures(1, &texture);
+}
+
+void GLRenderDevice::ActiveTexture(unsigned int unit)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLRenderDevice::BindTexture(GLenum target, unsigned int texture)
+{
+    glBindTexture(target, texture);
+}
+
+void GLRenderDevice::TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    glTexImage2D(target, level, internalFormat, width, height, 0, format, type, data);
+}
+
+void GLRenderDevice::TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    glTexSubImage2D(target, level, x, y, width, height, format, type, data);
+}
+
+void GLRenderDevice::GenerateMipmap(GLenum target)
+{
+    glGenerateMipmap(target);
+}
+
+void GLRenderDevice::TexParameter(GLenum target, GLenum name, int value)
+{
+    glTexParameteri(target, name, value);
+}
+
+////////////////// SHADERS /////////////////////////
+
+unsigned int GLRenderDevice::CreateShader(GLenum stage)
+{
+    return glCreateShader(stage);
+}
+
+void GLRenderDevice::ShaderSource(unsigned int shader, const char* source)
+{
+    glShaderSource(shader, 1, &source, NULL);
+}
+
+void GLRenderDevice::CompileShader(unsigned int shader)
+{
+    glCompileShader(shader);
+}
+
+bool GLRenderDevice::GetShaderStatus(unsigned int shader, std::string& log)
+{
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        log = infoLog;
+    }
+    return success != 0;
+}
+
+void GLRenderDevice::DeleteShader(unsigned int shader)
+{
+    glDeleteShader(shader);
+}
+
+unsigned int GLRenderDevice::CreateProgram()
+{
+    return glCreateProgram();
+}
+
+void GLRenderDevice::AttachShader(unsigned int program, unsigned int shader)
+{
+    glAttachShader(program, shader);
+}
+
+void GLRenderDevice::LinkProgram(unsigned int program)
+{
+    LoadExtensions();
+    // Has to be set before linking, or some drivers won't keep the binary around
+    if (m_programBinaries)
+    {
+        s_programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+}
+
+bool GLRenderDevice::IsProgramReady(unsigned int program)
+{
+    LoadExtensions();
+    if (!m_parallelCompile)
+    {
+        return true;
+    }
+    GLint done = 0;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != 0;
+}
+
+bool GLRenderDevice::GetProgramStatus(unsigned int program, std::string& log)
+{
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        log = infoLog;
+    }
+    return success != 0;
+}
+
+void GLRenderDevice::DeleteProgram(unsigned int program)
+{
+    glDeleteProgram(program);
+}
+
+void GLRenderDevice::UseProgram(unsigned int program)
+{
+    glUseProgram(program);
+}
+
+bool GLRenderDevice::GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format)
+{
+    LoadExtensions();
+    if (!m_programBinaries)
+    {
+        return false;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return false;
+    }
+    binary.resize(length);
+    GLsizei written = 0;
+    s_getProgramBinary(program, length, &written, &format, binary.data());
+    binary.resize(written);
+    return written > 0;
+}
+
+bool GLRenderDevice::ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size)
+{
+    LoadExtensions();
+    if (!m_programBinaries)
+    {
+        return false;
+    }
+    s_programBinary(program, format, binary, (GLsizei)size);
+    // A binary the driver doesn't like just leaves the program unlinked
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+int GLRenderDevice::GetUniformLocation(unsigned int program, const char* name)
+{
+    return glGetUniformLocation(program, name);
+}
+
+void GLRenderDevice::Uniform1i(int location, int value)
+{
+    glUniform1i(location, value);
+}
+
+void GLRenderDevice::Uniform1f(int location, float value)
+{
+    glUniform1f(location, value);
+}
+
+void GLRenderDevice::Uniform2f(int location, float x, float y)
+{
+    glUniform2f(location, x, y);
+}
+
+void GLRenderDevice::Uniform3f(int location, float x, float y, float z)
+{
+    glUniform3f(location, x, y, z);
+}
+
+void GLRenderDevice::Uniform4f(int location, float x, float y, float z, float w)
+{
+    glUniform4f(location, x, y, z, w);
+}
+
+void GLRenderDevice::Uniform2fv(int location, int count, const float* value)
+{
+    glUniform2fv(location, count, value);
+}
+
+void GLRenderDevice::Uniform3fv(int location, int count, const float* value)
+{
+    glUniform3fv(location, count, value);
+}
+
+void GLRenderDevice::Uniform4fv(int location, int count, const float* value)
+{
+    glUniform4fv(location, count, value);
+}
+
+void GLRenderDevice::UniformMatrix2fv(int location, int count, bool transpose, const float* value)
+{
+    glUniformMatrix2fv(location, count, transpose ? GL_TRUE : GL_FALSE, value);
+}
+
+void GLRenderDevice::UniformMatrix3fv(int location, int count, bool transpose, const float* value)
+{
+    glUniformMatrix3fv(location, count, transpose ? GL_TRUE : GL_FALSE, value);
+}
+
+void GLRenderDevice::UniformMatrix4fv(int location, int count, bool transpose, const float* value)
+{
+    glUniformMatrix4fv(location, count, transpose ? GL_TRUE : GL_FALSE, value);
+}
+
+////////////////// QUERIES /////////////////////////
+
+unsigned int GLRenderDevice::CreateQuery()
+{
+    unsigned int query;
+    glGenQueries(1, &query);
+    return query;
+}
+
+void GLRenderDevice::DeleteQuery(unsigned int query)
+{
+    glDeleteQueries(1, &query);
+}
+
+void GLRenderDevice::BeginQuery(GLenum target, unsigned int query)
+{
+    glBeginQuery(target, query);
+}
+
+void GLRenderDevice::EndQuery(GLenum target)
+{
+    glEndQuery(target);
+}
+
+bool GLRenderDevice::GetQueryResult(unsigned int query, unsigned long long& result)
+{
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        return false;
+    }
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+    result = value;
+    return true;
+}
+
+////////////////// FENCES /////////////////////////
+
+unsigned int GLRenderDevice::CreateFence()
+{
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Without a flush the fence may never reach the GPU if nothing else is issued on this context
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(m_fenceMutex);
+    for (size_t i = 0; i < m_fences.size(); ++i)
+    {
+        if (!m_fences[i])
+        {
+            m_fences[i] = sync;
+            return (unsigned int)i + 1;
+        }
+    }
+    m_fences.push_back(sync);
+    return (unsigned int)m_fences.size();
+}
+
+Fence_Status GLRenderDevice::WaitFence(unsigned int fence, unsigned long long timeoutNs)
+{
+    GLsync sync;
+    {
+        std::lock_guard<std::mutex> lock(m_fenceMutex);
+        if (fence == 0 || fence > m_fences.size() || !m_fences[fence - 1])
+        {
+            return FENCE_SIGNALED;
+        }
+        sync = m_fences[fence - 1];
+    }
+    switch (glClientWaitSync(sync, 0, timeoutNs))
+    {
+    case GL_ALREADY_SIGNALED:
+    case GL_CONDITION_SATISFIED:
+        return FENCE_SIGNALED;
+    case GL_TIMEOUT_EXPIRED:
+        return FENCE_TIMEOUT;
+    default:
+        // GL_WAIT_FAILED
+        return FENCE_FAILED;
+    }
+}
+
+void GLRenderDevice::DeleteFence(unsigned int fence)
+{
+    std::lock_guard<std::mutex> lock(m_fenceMutex);
+    if (fence == 0 || fence > m_fences.size() || !m_fences[fence - 1])
+    {
+        return;
+    }
+    glDeleteSync(m_fences[fence - 1]);
+    m_fences[fence - 1] = NULL;
+}
+
+////////////////// STATE AND DRAWING /////////////////////////
+
+void GLRenderDevice::Enable(GLenum capability)
+{
+    glEnable(capability);
+}
+
+void GLRenderDevice::Disable(GLenum capability)
+{
+    glDisable(capability);
+}
+
+void GLRenderDevice::Viewport(int x, int y, int width, int height)
+{
+    glViewport(x, y, width, height);
+}
+
+void GLRenderDevice::Scissor(int x, int y, int width, int height)
+{
+    glScissor(x, y, width, height);
+}
+
+void GLRenderDevice::LineWidth(float width)
+{
+    glLineWidth(width);
+}
+
+void GLRenderDevice::ClearColor(float r, float g, float b, float a)
+{
+    glClearColor(r, g, b, a);
+}
+
+void GLRenderDevice::Clear(GLbitfield mask)
+{
+    glClear(mask);
+}
+
+void GLRenderDevice::DrawArrays(GLenum mode, int first, int count)
+{
+    glDrawArrays(mode, first, count);
+}
+
+void GLRenderDevice::DrawElements(GLenum mode, int count, GLenum type, size_t offset)
+{
+    glDrawElements(mode, count, type, (void*)offset);
+}
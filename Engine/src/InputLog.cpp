@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <InputLog.h>
+
+// Header: magic, u16 version, u16 width, u16 height, u32 event count
+#define INPUT_LOG_HEADER_SIZE 14
+// Type, time and the three bytes of a button, the smallest event
+#define INPUT_LOG_MIN_EVENT_SIZE 8
+
+////////////////// ENCODING /////////////////////////
+
+// Little endian regardless of the machine, so logs move between platforms
+static void PutU8(std::vector<uint8_t>& data, uint32_t value)
+{
+    data.push_back((uint8_t)value);
+}
+
+static void PutU16(std::vector<uint8_t>& data, uint32_t value)
+{
+    data.push_back((uint8_t)value);
+    data.push_back((uint8_t)(value >> 8));
+}
+
+static void PutU32(std::vector<uint8_t>& data, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        data.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+static void PutF32(std::vector<uint8_t>& data, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutU32(data, bits);
+}
+
+// Reads past the end return 0 and set the failed flag instead of reading out of bounds
+struct LogReader
+{
+    const std::vector<uint8_t>& data;
+    size_t offset;
+    bool failed;
+
+    uint32_t Get(int numBytes)
+    {
+        if (offset + numBytes > data.size())
+        {
+            failed = true;
+            return 0;
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < numBytes; ++i)
+        {
+            value |= (uint32_t)data[offset + i] << (i * 8);
+        }
+        offset += numBytes;
+        return value;
+    }
+
+    float GetF32()
+    {
+        uint32_t bits = Get(4);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+////////////////// RECORDER /////////////////////////
+
+void InputRecorder::Start(const std::string& path, int width, int height)
+{
+    m_path = path;
+    m_data.clear();
+    m_data.insert(m_data.end(), INPUT_LOG_MAGIC, INPUT_LOG_MAGIC + 4);
+    PutU16(m_data, INPUT_LOG_VERSION);
+    PutU16(m_data, width);
+    PutU16(m_data, height);
+    // Event count, filled in by Stop
+    PutU32(m_data, 0);
+    m_numEvents = 0;
+    m_lastTime = 0;
+    m_recording = true;
+}
+
+bool InputRecorder::IsRecording() const
+{
+    return m_recording;
+}
+
+void InputRecorder::Record(const InputEvent& event)
+{
+    if (!m_recording)
+    {
+        return;
+    }
+
+    // Out of order events are replayed at the same time as the one before
+    uint64_t time = std::max((uint64_t)std::llround(std::max(event.time, 0.0) * 1000000.0), m_lastTime);
+    PutU8(m_data, event.type);
+    PutU32(m_data, (uint32_t)std::min(time - m_lastTime, (uint64_t)UINT32_MAX));
+    m_lastTime = time;
+    switch (event.type)
+    {
+        case INPUT_EVENT_CURSOR:
+        case INPUT_EVENT_SCROLL:
+            PutF32(m_data, (float)event.x);
+            PutF32(m_data, (float)event.y);
+            break;
+        case INPUT_EVENT_BUTTON:
+            PutU8(m_data, event.code);
+            PutU8(m_data, event.action);
+            PutU8(m_data, event.mods);
+            break;
+        case INPUT_EVENT_KEY:
+            PutU16(m_data, (uint16_t)event.code);
+            PutU16(m_data, (uint16_t)event.scancode);
+            PutU8(m_data, event.action);
+            PutU8(m_data, event.mods);
+            break;
+        case INPUT_EVENT_CHAR:
+            PutU32(m_data, event.code);
+            break;
+        case INPUT_EVENT_RESIZE:
+            PutU16(m_data, (uint32_t)event.x);
+            PutU16(m_data, (uint32_t)event.y);
+            break;
+    }
+    m_numEvents++;
+}
+
+bool InputRecorder::Stop()
+{
+    if (!m_recording)
+    {
+        return false;
+    }
+    m_recording = false;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        m_data[INPUT_LOG_HEADER_SIZE - 4 + i] = (uint8_t)(m_numEvents >> (i * 8));
+    }
+
+    FILE* file = std::fopen(m_path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "Failed to write input log " << m_path << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(m_data.data(), 1, m_data.size(), file) == m_data.size();
+    written = std::fclose(file) == 0 && written;
+    if (written)
+    {
+        std::cout << "Recorded " << m_numEvents << " input events (" << m_data.size() << " bytes) to "
+            << m_path << std::endl;
+    }
+    return written;
+}
+
+size_t InputRecorder::GetNumEvents() const
+{
+    return m_numEvents;
+}
+
+////////////////// REPLAY /////////////////////////
+
+bool InputReplay::Load(const std::string& path)
+{
+    m_events.clear();
+    m_next = 0;
+    m_loaded = false;
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        std::cout << "Failed to open input log " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t numRead;
+    while ((numRead = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + numRead);
+    }
+    std::fclose(file);
+
+    if (data.size() < INPUT_LOG_HEADER_SIZE || std::memcmp(data.data(), INPUT_LOG_MAGIC, 4) != 0)
+    {
+        std::cout << path << " isn't an input log" << std::endl;
+        return false;
+    }
+    LogReader reader{ data, 4, false };
+    uint32_t version = reader.Get(2);
+    if (version != INPUT_LOG_VERSION)
+    {
+        std::cout << path << " is input log version " << version << ", expected " << INPUT_LOG_VERSION << std::endl;
+        return false;
+    }
+    m_width = reader.Get(2);
+    m_height = reader.Get(2);
+    uint32_t numEvents = reader.Get(4);
+
+    // A corrupt count can't ask for more than the file could hold
+    m_events.reserve(std::min((size_t)numEvents, (data.size() - INPUT_LOG_HEADER_SIZE) / INPUT_LOG_MIN_EVENT_SIZE));
+    uint64_t time = 0;
+    for (uint32_t i = 0; i < numEvents && !reader.failed; ++i)
+    {
+        InputEvent event;
+        event.type = (Input_Event_Type)reader.Get(1);
+        time += reader.Get(4);
+        event.time = time / 1000000.0;
+        switch (event.type)
+        {
+            case INPUT_EVENT_CURSOR:
+            case INPUT_EVENT_SCROLL:
+                event.x = reader.GetF32();
+                event.y = reader.GetF32();
+                break;
+            case INPUT_EVENT_BUTTON:
+                event.code = reader.Get(1);
+                event.action = reader.Get(1);
+                event.mods = reader.Get(1);
+                break;
+            case INPUT_EVENT_KEY:
+                event.code = (int16_t)reader.Get(2);
+                event.scancode = (int16_t)reader.Get(2);
+                event.action = reader.Get(1);
+                event.mods = reader.Get(1);
+                break;
+            case INPUT_EVENT_CHAR:
+                event.code = reader.Get(4);
+                break;
+            case INPUT_EVENT_RESIZE:
+                event.x = reader.Get(2);
+                event.y = reader.Get(2);
+                break;
+            default:
+                reader.failed = true;
+                break;
+        }
+        if (!reader.failed)
+        {
+            m_events.push_back(event);
+        }
+    }
+
+    if (reader.failed)
+    {
+        std::cout << path << " is truncated or corrupt, replaying the first " << m_events.size() << " of "
+            << numEvents << " events" << std::endl;
+    }
+    m_loaded = true;
+    return true;
+}
+
+bool InputReplay::IsLoaded() const
+{
+    return m_loaded;
+}
+
+bool InputReplay::Next(double time, InputEvent& event)
+{
+    if (m_next >= m_events.size() || m_events[m_next].time > time)
+    {
+        return false;
+    }
+    event = m_events[m_next++];
+    return true;
+}
+
+bool InputReplay::IsFinished() const
+{
+    return m_next >= m_events.size();
+}
+
+void InputReplay::Rewind()
+{
+    m_next = 0;
+}
+
+size_t InputReplay::GetNumEvents() const
+{
+    return m_events.size();
+}
+
+double InputReplay::GetDuration() const
+{
+    return m_events.empty() ? 0.0 : m_events.back().time;
+}
+
+int InputReplay::GetWidth() const
+{
+    return m_width;
+}
+
+int InputReplay::GetHeight() const
+{
+    return m_height;
+}
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <JobSystem.h>
+
+// Which system's worker the current thread is, if any
+struct WorkerIdentity
+{
+    const JobSystem* system = NULL;
+    unsigned int index = 0;
+};
+static thread_local WorkerIdentity t_worker;
+
+static unsigned int ResolveNumThreads(unsigned int numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    return std::max(numThreads, 1u);
+}
+
+bool JobCounter::IsDone() const
+{
+    return m_pending.load(std::memory_order_acquire) <= 0;
+}
+
+////////////////// SETUP /////////////////////////
+
+JobSystem::JobSystem(unsigned int numThreads)
+    : m_queues(ResolveNumThreads(numThreads))
+{
+    // The last queue is the shared one, each other queue gets a worker
+    for (unsigned int i = 0; i + 1 < m_queues.size(); ++i)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+// Function statics so it's usable from other statics' constructors too
+static JobSystem& GetDefaultJobSystem()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+static JobSystem*& GetActiveJobSystem()
+{
+    static JobSystem* jobSystem = NULL;
+    return jobSystem;
+}
+
+JobSystem& JobSystem::Get()
+{
+    JobSystem* active = GetActiveJobSystem();
+    return active ? *active : GetDefaultJobSystem();
+}
+
+void JobSystem::Set(JobSystem* jobSystem)
+{
+    GetActiveJobSystem() = jobSystem;
+}
+
+unsigned int JobSystem::GetNumThreads() const
+{
+    return (unsigned int)m_queues.size();
+}
+
+////////////////// SUBMITTING /////////////////////////
+
+void JobSystem::Run(std::function<void()> job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    Push({ std::move(job), counter });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter)
+{
+    // Counted now, so waiting on counter also waits for a continuation that isn't queued yet
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (!dependency.IsDone())
+        {
+            dependency.m_continuations.push_back({ std::move(job), counter });
+            return;
+        }
+    }
+    Push({ std::move(job), counter });
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+    // The last job hits zero while it still holds the lock, so once this gets it nothing touches
+    // the counter any more and the caller is free to destroy it
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int batchSize,
+    const std::function<void(unsigned int begin, unsigned int end)>& body)
+{
+    batchSize = std::max(batchSize, 1u);
+    unsigned int numBatches = (count + batchSize - 1) / batchSize;
+    if (numBatches <= 1 || m_workers.empty())
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    JobCounter counter;
+    for (unsigned int begin = 0; begin < count; begin += batchSize)
+    {
+        unsigned int end = std::min(begin + batchSize, count);
+        Run([&body, begin, end] { body(begin, end); }, &counter);
+    }
+    Wait(counter);
+}
+
+unsigned long long JobSystem::GetNumJobsRun() const
+{
+    return m_numJobsRun.load(std::memory_order_relaxed);
+}
+
+unsigned long long JobSystem::GetNumSteals() const
+{
+    return m_numSteals.load(std::memory_order_relaxed);
+}
+
+////////////////// SCHEDULING /////////////////////////
+
+unsigned int JobSystem::GetQueueIndex() const
+{
+    if (t_worker.system == this)
+    {
+        return t_worker.index;
+    }
+    return (unsigned int)m_queues.size() - 1;
+}
+
+void JobSystem::Push(Job job)
+{
+    // Nothing would ever take it off the queue unless someone waits, so fire and forget jobs
+    // (like async loads) would never start
+    if (m_workers.empty())
+    {
+        Execute(job);
+        return;
+    }
+
+    Queue& queue = m_queues[GetQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    m_numQueued.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock means a worker can't miss this between checking the count and sleeping
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_one();
+}
+
+bool JobSystem::TryRunOne()
+{
+    unsigned int numQueues = (unsigned int)m_queues.size();
+    unsigned int own = GetQueueIndex();
+    Job job;
+    bool found = false;
+
+    {
+        Queue& queue = m_queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    for (unsigned int i = 1; i < numQueues && !found; ++i)
+    {
+        Queue& queue = m_queues[(own + i) % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+            m_numSteals.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+    m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+    Execute(job);
+    return true;
+}
+
+void JobSystem::Execute(Job& job)
+{
+    job.function();
+    m_numJobsRun.fetch_add(1, std::memory_order_relaxed);
+    if (job.counter)
+    {
+        Finish(job.counter);
+    }
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+    // Only jobs still holding a count decrement it, so whoever sees 1 here is the last one
+    int pending = counter->m_pending.load(std::memory_order_acquire);
+    while (pending > 1)
+    {
+        if (counter->m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel))
+        {
+            return;
+        }
+    }
+
+    // Last job of the group, queue whatever was waiting on it. Zeroed under the lock so RunAfter
+    // can't add a continuation after they've been taken
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        continuations.swap(counter->m_continuations);
+        counter->m_pending.store(0, std::memory_order_release);
+    }
+    for (JobCounter::Continuation& continuation : continuations)
+    {
+        Push({ std::move(continuation.function), continuation.counter });
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+    t_worker.system = this;
+    t_worker.index = index;
+
+    while (true)
+    {
+        if (TryRunOne())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_quit || m_numQueued.load(std::memory_order_acquire) > 0; });
+        if (m_quit)
+        {
+            return;
+        }
+    }
+}
@@ -3,66 +3,109 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <SHADER.h>
+#include <RenderDevice.h>
+#include <RenderStats.h>
 
 #include <string>
 #include <vector>
 
 #include <Mesh.h>
 
-Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool upload)
 {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+    this->vertices = std::move(vertices);
+    this->indices = std::move(indices);
+    this->textures = std::move(textures);
 
-    SetupMesh();
+    if (upload)
+    {
+        SetupMesh();
+    }
 }
 
-void Mesh::SetupMesh()
+void Mesh::Upload()
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    if (!uploaded)
+    {
+        SetupMesh();
+    }
+}
+
+void Mesh::UploadBuffers()
+{
+    if (buffersUploaded)
+    {
+        return;
+    }
+    RenderDevice* device = RenderDevice::Get();
+    VBO = device->CreateBuffer();
+    EBO = device->CreateBuffer();
+
+    // Both through GL_ARRAY_BUFFER, an element buffer binding needs a vertex array to belong to
+    device->BindBuffer(GL_ARRAY_BUFFER, VBO);
+    device->BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    device->BindBuffer(GL_ARRAY_BUFFER, EBO);
+    device->BufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    device->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    RenderStats& stats = RenderStats::Get();
+    stats.Add(RENDER_STAT_BUFFER_UPLOADS, 2);
+    stats.Add(RENDER_STAT_BUFFER_BYTES, vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
+    buffersUploaded = true;
+}
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+bool Mesh::IsUploaded() const
+{
+    return uploaded;
+}
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+void Mesh::SetupMesh()
+{
+    UploadBuffers();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    RenderDevice* device = RenderDevice::Get();
+    VAO = device->CreateVertexArray();
+    device->BindVertexArray(VAO);
+    device->BindBuffer(GL_ARRAY_BUFFER, VBO);
+    device->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 
     // vertex positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    device->EnableVertexAttribArray(0);
+    device->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), 0);
 
     // vertex normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    device->EnableVertexAttribArray(1);
+    device->VertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, Normal));
 
     // Texture coordinates
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2,2,GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    device->EnableVertexAttribArray(2);
+    device->VertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, TexCoords));
 
     // Tangent
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+    device->EnableVertexAttribArray(3);
+    device->VertexAttribPointer(3, 3, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, Tangent));
 
     // Bitangent
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    device->EnableVertexAttribArray(4);
+    device->VertexAttribPointer(4, 3, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, Bitangent));
     // IDs
-    glEnableVertexAttribArray(5);
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+    device->EnableVertexAttribArray(5);
+    device->VertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), offsetof(Vertex, m_BoneIDs));
     // Weights
-    glEnableVertexAttribArray(6);
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+    device->EnableVertexAttribArray(6);
+    device->VertexAttribPointer(6, 4, GL_FLOAT, false, sizeof(Vertex), offsetof(Vertex, m_Weights));
 
-    glBindVertexArray(0);
+    device->BindVertexArray(0);
+    uploaded = true;
 }
 
 void Mesh::Draw(Shader &shader)
 {
+    if (!uploaded)
+    {
+        return;
+    }
+    RenderDevice* device = RenderDevice::Get();
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
     unsigned int normalNr = 1;
@@ -70,7 +113,7 @@ void Mesh::Draw(Shader &shader)
 
     for (unsigned int i = 0; i < textures.size(); i++)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
+        device->ActiveTexture(i);
 
         string number;
         string name = textures[i].type;
@@ -94,14 +137,19 @@ void Mesh::Draw(Shader &shader)
         //std::string uniformName = name + number;
         //glUniform1i(glGetUniformLocation(shader.ID, uniformName.c_str()), i);
         shader.setInt(("material." + name + number).c_str(), i); // Concatenate to texture's type string
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        device->BindTexture(GL_TEXTURE_2D, textures[i].id);
     }
 
     // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    device->BindVertexArray(VAO);
+    device->DrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+    device->BindVertexArray(0);
+
+    // A texture bind for each texture, and the vertex array bound and unbound
+    RenderStats& stats = RenderStats::Get();
+    stats.Add(RENDER_STAT_STATE_CHANGES, textures.size() + 2);
+    stats.AddDraw(GL_TRIANGLES, static_cast<unsigned int>(indices.size()));
 
     // Set everything back to default
-    glActiveTexture(GL_TEXTURE0);
+    device->ActiveTexture(0);
 }
\ No newline at end of file
@@ -11,7 +11,13 @@
 
 #include <Mesh.h>
 #include <SHADER.h>
+#include <JobSystem.h>
+#include <RenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
 
+#include <chrono>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -21,16 +27,67 @@
 
 #include <Model.h>
 
-void Model::Draw(Shader &shader)
+// Meshes converted per job. Small, since scenes with many meshes tend to have small ones
+#define MODEL_MESH_BATCH_SIZE 8
+
+// Unit cube drawn in place of models that are still loading. Shared by all of them and made
+// on first use, since it needs the render thread
+static Mesh& GetPlaceholderMesh()
 {
+    static Mesh* placeholder = NULL;
+    if (!placeholder)
+    {
+        vector<Vertex> vertices;
+        for (int i = 0; i < 8; i++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+            vertex.Normal = glm::normalize(vertex.Position);
+            vertices.push_back(vertex);
+        }
+        vector<unsigned int> indices =
+        {
+            0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+            0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+            0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5,
+        };
+        placeholder = new Mesh(vertices, indices, vector<Texture>());
+    }
+    return *placeholder;
+}
+
+void Model::Draw(Shader &shader, const glm::mat4 &transform)
+{
+    Model_Load_State state = GetState();
+    if (state != MODEL_READY)
+    {
+        if (state != MODEL_FAILED)
+        {
+            shader.setMat4("model", transform);
+            GetPlaceholderMesh().Draw(shader);
+        }
+        return;
+    }
     for (unsigned int i = 0; i < meshes.size(); i++)
     {
+        shader.setMat4("model", transform * m_nodes.GetWorld(m_meshNodes[i]));
         meshes[i].Draw(shader);
     }
 }
 
-void Model::LoadModel(std::string path)
+Model_Load_State Model::GetState() const
+{
+    return (Model_Load_State)m_state.load(std::memory_order_acquire);
+}
+
+bool Model::IsReady() const
+{
+    return GetState() == MODEL_READY;
+}
+
+bool Model::LoadModel(std::string path)
 {
+    PROFILE_SCOPE("LoadModel");
     // Delcare an Importer object
     Assimp::Importer import;
     // Call ReadFile
@@ -58,35 +115,121 @@ void Model::LoadModel(std::string path)
     // Check one of its flags to see if the returned data is incomplete
     {
         cout << "ERROR::ASSIMP::" << import.GetErrorString() << endl; // Importer's GetErrorString
-        return;
+        return false;
     }
     directory = path.substr(0, path.find_last_of('/')); // Gets directory path of the given file path
     cout << directory << endl;
 
-    // Recursive function, processing the node in question, and then all the node's children.
-    ProcessNode(scene->mRootNode, scene);
+    // Recursive function, collecting the meshes of the node in question, and then all the node's children.
+    vector<aiMesh*> sceneMeshes;
+    ProcessNode(scene->mRootNode, SCENE_NODE_NONE, scene, sceneMeshes);
+    // Static from here on, so the world transforms only need working out once
+    m_nodes.Update();
+    ProcessMeshes(sceneMeshes, scene);
+    return true;
 }
 
-void Model::ProcessNode(aiNode *node, const aiScene *scene)
+void Model::ProcessNode(aiNode *node, SceneNode parent, const aiScene *scene, vector<aiMesh*> &sceneMeshes)
 {
-    // Process all the meshes (if any) in a node
+    // Assimp's matrices are row major, glm's column major
+    const aiMatrix4x4 &m = node->mTransformation;
+    glm::mat4 local(m.a1, m.b1, m.c1, m.d1,
+                    m.a2, m.b2, m.c2, m.d2,
+                    m.a3, m.b3, m.c3, m.d3,
+                    m.a4, m.b4, m.c4, m.d4);
+    SceneNode sceneNode = m_nodes.Create(parent, local);
+
+    // Collect all the meshes (if any) in a node
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
     {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(ProcessMesh(mesh, scene));
+        sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+        m_meshNodes.push_back(sceneNode);
     }
     // Repeat on its children
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(node->mChildren[i], scene);
+        ProcessNode(node->mChildren[i], sceneNode, scene, sceneMeshes);
     }
 }
 
-Mesh Model::ProcessMesh(aiMesh *mesh, const aiScene *scene)
+void Model::ProcessMeshes(const vector<aiMesh*> &sceneMeshes, const aiScene *scene)
 {
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
+    PROFILE_SCOPE("ProcessMeshes");
+    JobSystem& jobs = JobSystem::Get();
+
+    // Materials first, one at a time, so a texture is only decoded once however many meshes share it
+    vector<vector<Texture>> materialTextures(scene->mNumMaterials);
+    vector<bool> resolved(scene->mNumMaterials, false);
+    size_t firstNewTexture = m_pendingTextures.size();
+    for (aiMesh *mesh : sceneMeshes)
+    {
+        unsigned int index = mesh->mMaterialIndex;
+        if (index >= scene->mNumMaterials || resolved[index])
+        {
+            continue;
+        }
+        resolved[index] = true;
+        // Gett he aiMaterial object from the scene
+        aiMaterial *material = scene->mMaterials[index];
+        vector<Texture>& textures = materialTextures[index];
+        // Load diffuse textures
+        vector<Texture> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        // Load specular textures
+        vector<Texture> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        // Load normal maps
+        vector<Texture> normalMaps = LoadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal");
+        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        // Load height maps
+        vector<Texture> heightMaps = LoadMaterialTextures(material, aiTextureType_HEIGHT, "texture_height");
+        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+    }
+
+    // Then the new textures decode in parallel with each other
+    jobs.ParallelFor(m_pendingTextures.size() - firstNewTexture, 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            DecodeTexture(m_pendingTextures[firstNewTexture + i], directory);
+        }
+    });
+
+    // and the meshes in parallel with each other. Each only writes its own slot
+    vector<vector<Vertex>> vertices(sceneMeshes.size());
+    vector<vector<unsigned int>> indices(sceneMeshes.size());
+    jobs.ParallelFor(sceneMeshes.size(), MODEL_MESH_BATCH_SIZE, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            ProcessMesh(sceneMeshes[i], vertices[i], indices[i]);
+        }
+    });
+
+    // Put together in node order, so the result doesn't depend on which job finished first
+    meshes.reserve(meshes.size() + sceneMeshes.size());
+    for (size_t i = 0; i < sceneMeshes.size(); i++)
+    {
+        unsigned int material = sceneMeshes[i]->mMaterialIndex;
+        vector<Texture> textures = material < scene->mNumMaterials ? materialTextures[material] : vector<Texture>();
+        meshes.push_back(Mesh(std::move(vertices[i]), std::move(indices[i]), std::move(textures), !m_deferUpload));
+    }
+
+    if (!m_deferUpload)
+    {
+        while (m_nextTexture < m_pendingTextures.size())
+        {
+            UploadNextTexture();
+        }
+        m_pendingTextures.clear();
+        m_nextTexture = 0;
+    }
+}
+
+void Model::ProcessMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices)
+{
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(mesh->mNumFaces * 3);
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     // Loops for as many vertices there are in the mesh (that's what mesh->mNumVertices does)
@@ -94,7 +237,7 @@ Mesh Model::ProcessMesh(aiMesh *mesh, const aiScene *scene)
         // process vertex positions, normals, and texture coordinates
 
         // Define a new Vertex struct & add it to the vertices array after each loop
-        Vertex vertex;
+        Vertex vertex = {};
         glm::vec3 vector; // Temporary vector for storing data from Assimp
         // Process Vertex data
         vector.x = mesh->mVertices[i].x; // mVertices = Assimp's name for vertex position array
@@ -124,34 +267,23 @@ Mesh Model::ProcessMesh(aiMesh *mesh, const aiScene *scene)
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);
         }
 
+        // Tangent space, only there when the importer was asked for it or the file has it
+        if (mesh->mTangents && mesh->mBitangents)
+        {
+            vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
+
         vertices.push_back(vertex);
     }
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
+        const aiFace &face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++)
         {
             indices.push_back(face.mIndices[j]);
         }
     }
-    if (mesh->mMaterialIndex >= 0)
-    {
-        // Gett he aiMaterial object from the scene
-        aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-        // Load diffuse textures
-        vector<Texture> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        // Load specular textures
-        vector<Texture> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-        // Load normal maps
-        vector<Texture> normalMaps = LoadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-        // Load height maps
-        vector<Texture> heightMaps = LoadMaterialTextures(material, aiTextureType_HEIGHT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-    }
-    return Mesh(vertices, indices, textures);
 }
 
 vector<Texture> Model::LoadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
@@ -173,61 +305,135 @@ vector<Texture> Model::LoadMaterialTextures(aiMaterial *mat, aiTextureType type,
             }
         }
         if (!skip)
-        { // If the texture isn't already loaded, load it
+        { // If the texture isn't already loaded, queue it to be decoded. The id is filled in once it's uploaded
             Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
+            texture.id = 0;
             texture.type = typeName;
             texture.path = str;
+            textures.push_back(texture);
             textures_loaded.push_back(texture);
+
+            PendingTexture pending;
+            pending.path = str.C_Str();
+            m_pendingTextures.push_back(pending);
         }
 
     }
     return textures;
 }
 
-unsigned int Model::TextureFromFile(const char *path, const string &directory)
+void Model::DecodeTexture(PendingTexture &texture, const string &directory)
 {
-    string filename = string(path);
-    filename = directory + '/' + filename;
+    string filename = directory + '/' + texture.path;
     cout << filename.c_str() << endl;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    texture.data = stbi_load(filename.c_str(), &texture.width, &texture.height, &texture.components, 0);
+    if (!texture.data)
+    {
+        std::cout << "Texture failed to load at path: " << texture.path << std::endl;
+    }
+}
+
+unsigned int Model::UploadTexture(PendingTexture &texture)
+{
+    RenderDevice* device = RenderDevice::Get();
+    unsigned int textureID = device->CreateTexture();
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    if (texture.data)
     {
         GLenum format;
-        if (nrComponents == 1)
+        if (texture.components == 1)
         {
             format = GL_RED;
         }
-        else if (nrComponents == 3)
+        else if (texture.components == 3)
         {
             format = GL_RGB;
         }
-        else if (nrComponents == 4)
+        else if (texture.components == 4)
         {
             format = GL_RGBA;
         }
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        device->BindTexture(GL_TEXTURE_2D, textureID);
+        device->TexImage2D(GL_TEXTURE_2D, 0, format, texture.width, texture.height, format, GL_UNSIGNED_BYTE, texture.data);
+        device->GenerateMipmap(GL_TEXTURE_2D);
+        // Base level only, the mips are made on the GPU
+        RenderStats::Get().Add(RENDER_STAT_TEXTURE_UPLOADS);
+        RenderStats::Get().Add(RENDER_STAT_TEXTURE_BYTES, (unsigned long long)texture.width * texture.height * texture.components);
+
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        stbi_image_free(texture.data);
+        texture.data = NULL;
+    }
+    return textureID;
+}
+
+bool Model::UploadPending(double budgetSeconds)
+{
+    PROFILE_SCOPE("UploadModel");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool first = true;
+    while (m_nextTexture < m_pendingTextures.size() || m_nextMesh < meshes.size())
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!first && elapsed >= budgetSeconds)
+        {
+            return false;
+        }
+        first = false;
+
+        if (m_nextTexture < m_pendingTextures.size())
+        {
+            UploadNextTexture();
+        }
+        else
+        {
+            meshes[m_nextMesh++].Upload();
+        }
+    }
+    m_pendingTextures.clear();
+    return true;
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+void Model::UploadBuffers()
+{
+    PROFILE_SCOPE("UploadModelBuffers");
+    while (m_nextTexture < m_pendingTextures.size())
+    {
+        UploadNextTexture();
+    }
+    for (Mesh& mesh : meshes)
+    {
+        mesh.UploadBuffers();
+    }
+}
 
-        stbi_image_free(data);
+void Model::UploadNextTexture()
+{
+    // Meshes got copies of the Texture before it had an id, so patch those too
+    PendingTexture& texture = m_pendingTextures[m_nextTexture++];
+    unsigned int id = UploadTexture(texture);
+    for (Texture& loaded : textures_loaded)
+    {
+        if (texture.path == loaded.path.C_Str())
+        {
+            loaded.id = id;
+        }
     }
-    else
+    for (Mesh& mesh : meshes)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        for (Texture& meshTexture : mesh.textures)
+        {
+            if (texture.path == meshTexture.path.C_Str())
+            {
+                meshTexture.id = id;
+            }
+        }
     }
-    return textureID;
 }
 
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <JobSystem.h>
+#include <Model.h>
+#include <Profiler.h>
+#include <UploadThread.h>
+
+#include <ModelLoader.h>
+
+ModelLoader& ModelLoader::Get()
+{
+    static ModelLoader loader;
+    return loader;
+}
+
+std::shared_ptr<Model> ModelLoader::Load(const std::string& path, Callback onLoaded, bool gamma)
+{
+    std::shared_ptr<Model> model(new Model(Model::Deferred(), gamma));
+    m_requests.push_back({ model, onLoaded, path, std::chrono::steady_clock::now() });
+
+    // The job keeps its own reference, so dropping the model early doesn't pull it out from under the import
+    JobSystem::Get().Run([model, path]
+    {
+        bool loaded = model->LoadModel(path);
+        // Stays MODEL_LOADING until the loader thread's fence has passed
+        if (loaded && UploadThread::Get().Submit([model] { model->UploadBuffers(); },
+            [model] { model->m_state.store(MODEL_UPLOADING, std::memory_order_release); }))
+        {
+            return;
+        }
+        model->m_state.store(loaded ? MODEL_UPLOADING : MODEL_FAILED, std::memory_order_release);
+    });
+    return model;
+}
+
+void ModelLoader::Update(double budgetMs)
+{
+    if (m_requests.empty())
+    {
+        return;
+    }
+    PROFILE_SCOPE("ModelLoader");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool uploaded = false;
+    for (size_t i = 0; i < m_requests.size();)
+    {
+        Request& request = m_requests[i];
+        Model& model = *request.model;
+        Model_Load_State state = model.GetState();
+        if (state == MODEL_UPLOADING)
+        {
+            // Something always gets uploaded, so even a tiny budget finishes eventually
+            double remaining = budgetMs / 1000.0 - std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (uploaded && remaining <= 0.0)
+            {
+                // Out of time, carries over to next frame
+                i++;
+                continue;
+            }
+            uploaded = true;
+            if (!model.UploadPending(std::max(remaining, 0.0)))
+            {
+                i++;
+                continue;
+            }
+            model.m_state.store(MODEL_READY, std::memory_order_release);
+            state = MODEL_READY;
+        }
+        if (state == MODEL_LOADING)
+        {
+            i++;
+            continue;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - request.start).count();
+        std::cout << (state == MODEL_READY ? "Loaded " : "Failed to load ") << request.path << " in "
+            << seconds * 1000.0 << " ms" << std::endl;
+        // Taken out first, a callback is free to start another load
+        Request finished = request;
+        m_requests.erase(m_requests.begin() + i);
+        if (finished.onLoaded)
+        {
+            finished.onLoaded(*finished.model, state == MODEL_READY);
+        }
+    }
+}
+
+unsigned int ModelLoader::GetNumPending() const
+{
+    return (unsigned int)m_requests.size();
+}
@@ -0,0 +1,864 @@
+#include <glad/glad.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <NullRenderDevice.h>
+
+#define NULL_PROGRAM_BINARY "NullRenderDevice program"
+// Not a format any real driver uses
+#define NULL_PROGRAM_BINARY_FORMAT 0x4E554C4C
+
+static size_t GetComponentCount(GLenum format)
+{
+    switch (format)
+    {
+        case GL_RED: return 1;
+        case GL_RG: return 2;
+        case GL_RGB: return 3;
+        case GL_RGBA: return 4;
+        case GL_DEPTH_COMPONENT: return 1;
+        default: return 4;
+    }
+}
+
+static size_t GetTypeSize(GLenum type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE: return 1;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
+    }
+}
+
+static unsigned long long CountTriangles(GLenum mode, int count)
+{
+    switch (mode)
+    {
+        case GL_TRIANGLES: return count / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN: return count > 2 ? count - 2 : 0;
+        default: return 0;
+    }
+}
+
+const char* NullRenderDevice::GetName() const
+{
+    return "Null";
+}
+
+bool NullRenderDevice::NeedsContext() const
+{
+    return false;
+}
+
+std::string NullRenderDevice::GetDriverString()
+{
+    return "Null";
+}
+
+void NullRenderDevice::InitContext()
+{
+}
+
+////////////////// BUFFERS /////////////////////////
+
+unsigned int NullRenderDevice::CreateVertexArray()
+{
+    unsigned int vertexArray = m_nextHandle++;
+    m_vertexArrays.insert(vertexArray);
+    Record("CreateVertexArray", vertexArray);
+    return vertexArray;
+}
+
+void NullRenderDevice::DeleteVertexArray(unsigned int vertexArray)
+{
+    Record("DeleteVertexArray", vertexArray);
+    // Deleting 0 or something already gone is silently ignored by GL, so it is here too
+    m_vertexArrays.erase(vertexArray);
+    m_elementBuffers.erase(vertexArray);
+    if (m_vertexArray == vertexArray)
+    {
+        m_vertexArray = 0;
+    }
+}
+
+void NullRenderDevice::BindVertexArray(unsigned int vertexArray)
+{
+    Record("BindVertexArray", vertexArray);
+    if (vertexArray != 0 && m_vertexArrays.count(vertexArray) == 0)
+    {
+        Invalid("BindVertexArray", "not a live vertex array");
+        return;
+    }
+    StateChange(m_vertexArray != vertexArray);
+    m_vertexArray = vertexArray;
+}
+
+unsigned int NullRenderDevice::CreateBuffer()
+{
+    unsigned int buffer = m_nextHandle++;
+    m_buffers[buffer] = 0;
+    Record("CreateBuffer", buffer);
+    return buffer;
+}
+
+void NullRenderDevice::DeleteBuffer(unsigned int buffer)
+{
+    Record("DeleteBuffer", buffer);
+    m_buffers.erase(buffer);
+    if (m_arrayBuffer == buffer)
+    {
+        m_arrayBuffer = 0;
+    }
+    for (auto& binding : m_elementBuffers)
+    {
+        if (binding.second == buffer)
+        {
+            binding.second = 0;
+        }
+    }
+}
+
+void NullRenderDevice::BindBuffer(GLenum target, unsigned int buffer)
+{
+    Record("BindBuffer", buffer);
+    unsigned int* binding = GetBinding(target);
+    if (!binding)
+    {
+        Invalid("BindBuffer", "unsupported target");
+        return;
+    }
+    if (buffer != 0 && m_buffers.count(buffer) == 0)
+    {
+        Invalid("BindBuffer", "not a live buffer");
+        return;
+    }
+    StateChange(*binding != buffer);
+    *binding = buffer;
+}
+
+void NullRenderDevice::BufferData(GLenum target, size_t size, const void* data, GLenum usage)
+{
+    Record("BufferData", target, size);
+    unsigned int* binding = GetBinding(target);
+    if (!binding || *binding == 0)
+    {
+        Invalid("BufferData", "no buffer bound");
+        return;
+    }
+    m_buffers[*binding] = size;
+    m_stats.bufferUploads++;
+    // A NULL data pointer only allocates
+    if (data)
+    {
+        m_stats.bufferBytesUploaded += size;
+    }
+}
+
+void NullRenderDevice::BufferSubData(GLenum target, size_t offset, size_t size, const void* data)
+{
+    Record("BufferSubData", target, size);
+    unsigned int* binding = GetBinding(target);
+    if (!binding || *binding == 0)
+    {
+        Invalid("BufferSubData", "no buffer bound");
+        return;
+    }
+    if (offset + size > m_buffers[*binding])
+    {
+        Invalid("BufferSubData", "range is past the end of the buffer");
+        return;
+    }
+    m_stats.bufferUploads++;
+    m_stats.bufferBytesUploaded += size;
+}
+
+void NullRenderDevice::EnableVertexAttribArray(unsigned int index)
+{
+    Record("EnableVertexAttribArray", index);
+    if (m_vertexArray == 0)
+    {
+        Invalid("EnableVertexAttribArray", "no vertex array bound");
+    }
+}
+
+void NullRenderDevice::VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+    size_t offset)
+{
+    Record("VertexAttribPointer", index);
+    if (m_vertexArray == 0 || m_arrayBuffer == 0)
+    {
+        Invalid("VertexAttribPointer", "needs a vertex array and an array buffer bound");
+    }
+}
+
+void NullRenderDevice::VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset)
+{
+    Record("VertexAttribIPointer", index);
+    if (m_vertexArray == 0 || m_arrayBuffer == 0)
+    {
+        Invalid("VertexAttribIPointer", "needs a vertex array and an array buffer bound");
+    }
+}
+
+////////////////// TEXTURES /////////////////////////
+
+unsigned int NullRenderDevice::CreateTexture()
+{
+    unsigned int texture = m_nextHandle++;
+    m_textures[texture] = TextureInfo();
+    Record("CreateTexture", texture);
+    return texture;
+}
+
+void NullRenderDevice::DeleteTexture(unsigned int texture)
+{
+    Record("DeleteTexture", texture);
+    m_textures.erase(texture);
+    for (auto& binding : m_boundTextures)
+    {
+        if (binding.second == texture)
+        {
+            binding.second = 0;
+        }
+    }
+}
+
+void NullRenderDevice::ActiveTexture(unsigned int unit)
+{
+    Record("ActiveTexture", unit);
+    StateChange(m_activeUnit != unit);
+    m_activeUnit = unit;
+}
+
+void NullRenderDevice::BindTexture(GLenum target, unsigned int texture)
+{
+    Record("BindTexture", texture);
+    if (texture != 0 && m_textures.count(texture) == 0)
+    {
+        Invalid("BindTexture", "not a live texture");
+        return;
+    }
+    StateChange(GetBoundTexture() != texture);
+    m_boundTextures[m_activeUnit] = texture;
+}
+
+void NullRenderDevice::TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    size_t bytes = (size_t)width * (size_t)height * GetComponentCount(format) * GetTypeSize(type);
+    Record("TexImage2D", GetBoundTexture(), bytes);
+    unsigned int texture = GetBoundTexture();
+    if (texture == 0)
+    {
+        Invalid("TexImage2D", "no texture bound");
+        return;
+    }
+    // Only the base level is tracked, explicit mip uploads are counted but not sized
+    if (level == 0)
+    {
+        m_textures[texture].baseBytes = bytes;
+    }
+    m_stats.textureUploads++;
+    if (data)
+    {
+        m_stats.textureBytesUploaded += bytes;
+    }
+}
+
+void NullRenderDevice::TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    size_t bytes = (size_t)width * (size_t)height * GetComponentCount(format) * GetTypeSize(type);
+    Record("TexSubImage2D", GetBoundTexture(), bytes);
+    unsigned int texture = GetBoundTexture();
+    if (texture == 0)
+    {
+        Invalid("TexSubImage2D", "no texture bound");
+        return;
+    }
+    if (!data)
+    {
+        Invalid("TexSubImage2D", "no data");
+        return;
+    }
+    if (level == 0 && m_textures[texture].baseBytes == 0)
+    {
+        Invalid("TexSubImage2D", "texture has no storage yet");
+        return;
+    }
+    m_stats.textureUploads++;
+    m_stats.textureBytesUploaded += bytes;
+}
+
+void NullRenderDevice::GenerateMipmap(GLenum target)
+{
+    Record("GenerateMipmap", GetBoundTexture());
+    unsigned int texture = GetBoundTexture();
+    if (texture == 0)
+    {
+        Invalid("GenerateMipmap", "no texture bound");
+        return;
+    }
+    m_textures[texture].mipmapped = true;
+}
+
+void NullRenderDevice::TexParameter(GLenum target, GLenum name, int value)
+{
+    Record("TexParameter", name);
+    if (GetBoundTexture() == 0)
+    {
+        Invalid("TexParameter", "no texture bound");
+    }
+}
+
+////////////////// SHADERS /////////////////////////
+
+unsigned int NullRenderDevice::CreateShader(GLenum stage)
+{
+    unsigned int shader = m_nextHandle++;
+    m_shaders.insert(shader);
+    Record("CreateShader", shader);
+    return shader;
+}
+
+void NullRenderDevice::ShaderSource(unsigned int shader, const char* source)
+{
+    Record("ShaderSource", shader, source ? std::char_traits<char>::length(source) : 0);
+    if (m_shaders.count(shader) == 0)
+    {
+        Invalid("ShaderSource", "not a live shader");
+    }
+}
+
+void NullRenderDevice::CompileShader(unsigned int shader)
+{
+    Record("CompileShader", shader);
+    if (m_shaders.count(shader) == 0)
+    {
+        Invalid("CompileShader", "not a live shader");
+        return;
+    }
+    m_stats.shaderCompiles++;
+}
+
+bool NullRenderDevice::GetShaderStatus(unsigned int shader, std::string& log)
+{
+    // There's no compiler, so every live shader "compiles"
+    return m_shaders.count(shader) != 0;
+}
+
+void NullRenderDevice::DeleteShader(unsigned int shader)
+{
+    Record("DeleteShader", shader);
+    m_shaders.erase(shader);
+}
+
+unsigned int NullRenderDevice::CreateProgram()
+{
+    unsigned int program = m_nextHandle++;
+    m_programs[program];
+    Record("CreateProgram", program);
+    return program;
+}
+
+void NullRenderDevice::AttachShader(unsigned int program, unsigned int shader)
+{
+    Record("AttachShader", shader);
+    if (m_programs.count(program) == 0 || m_shaders.count(shader) == 0)
+    {
+        Invalid("AttachShader", "not a live program or shader");
+    }
+}
+
+void NullRenderDevice::LinkProgram(unsigned int program)
+{
+    Record("LinkProgram", program);
+    if (m_programs.count(program) == 0)
+    {
+        Invalid("LinkProgram", "not a live program");
+        return;
+    }
+    m_stats.programLinks++;
+}
+
+bool NullRenderDevice::IsProgramReady(unsigned int program)
+{
+    return true;
+}
+
+bool NullRenderDevice::GetProgramStatus(unsigned int program, std::string& log)
+{
+    return m_programs.count(program) != 0;
+}
+
+void NullRenderDevice::DeleteProgram(unsigned int program)
+{
+    Record("DeleteProgram", program);
+    m_programs.erase(program);
+    if (m_program == program)
+    {
+        m_program = 0;
+    }
+}
+
+void NullRenderDevice::UseProgram(unsigned int program)
+{
+    Record("UseProgram", program);
+    if (program != 0 && m_programs.count(program) == 0)
+    {
+        Invalid("UseProgram", "not a live program");
+        return;
+    }
+    StateChange(m_program != program);
+    m_program = program;
+}
+
+// There's nothing to compile, so every program's binary is the same token. Enough for headless
+// runs to go through the cache the same way the GL device does
+bool NullRenderDevice::GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format)
+{
+    Record("GetProgramBinary", program);
+    if (m_programs.count(program) == 0)
+    {
+        Invalid("GetProgramBinary", "not a live program");
+        return false;
+    }
+    binary.assign(NULL_PROGRAM_BINARY, NULL_PROGRAM_BINARY + sizeof(NULL_PROGRAM_BINARY) - 1);
+    format = NULL_PROGRAM_BINARY_FORMAT;
+    return true;
+}
+
+bool NullRenderDevice::ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size)
+{
+    Record("ProgramBinary", program, size);
+    if (m_programs.count(program) == 0)
+    {
+        Invalid("ProgramBinary", "not a live program");
+        return false;
+    }
+    // Rejected like a driver rejects another driver's binaries
+    if (format != NULL_PROGRAM_BINARY_FORMAT || size != sizeof(NULL_PROGRAM_BINARY) - 1 ||
+        memcmp(binary, NULL_PROGRAM_BINARY, size) != 0)
+    {
+        return false;
+    }
+    m_stats.programBinaryLoads++;
+    return true;
+}
+
+int NullRenderDevice::GetUniformLocation(unsigned int program, const char* name)
+{
+    auto found = m_programs.find(program);
+    if (found == m_programs.end())
+    {
+        Invalid("GetUniformLocation", "not a live program");
+        return -1;
+    }
+    // Hand out locations in the order names are first asked for, so they stay stable per program
+    std::unordered_map<std::string, int>& locations = found->second;
+    auto location = locations.find(name);
+    if (location == locations.end())
+    {
+        location = locations.emplace(name, (int)locations.size()).first;
+    }
+    return location->second;
+}
+
+bool NullRenderDevice::CanUploadUniform(const char* name, int location)
+{
+    Record(name, m_program);
+    if (m_program == 0)
+    {
+        Invalid(name, "no program in use");
+        return false;
+    }
+    // Location -1 is how GL says "optimized out", the call is legal and does nothing
+    if (location < 0)
+    {
+        return false;
+    }
+    m_stats.uniformUploads++;
+    return true;
+}
+
+void NullRenderDevice::Uniform1i(int location, int value)
+{
+    CanUploadUniform("Uniform1i", location);
+}
+
+void NullRenderDevice::Uniform1f(int location, float value)
+{
+    CanUploadUniform("Uniform1f", location);
+}
+
+void NullRenderDevice::Uniform2f(int location, float x, float y)
+{
+    CanUploadUniform("Uniform2f", location);
+}
+
+void NullRenderDevice::Uniform3f(int location, float x, float y, float z)
+{
+    CanUploadUniform("Uniform3f", location);
+}
+
+void NullRenderDevice::Uniform4f(int location, float x, float y, float z, float w)
+{
+    CanUploadUniform("Uniform4f", location);
+}
+
+void NullRenderDevice::Uniform2fv(int location, int count, const float* value)
+{
+    CanUploadUniform("Uniform2fv", location);
+}
+
+void NullRenderDevice::Uniform3fv(int location, int count, const float* value)
+{
+    CanUploadUniform("Uniform3fv", location);
+}
+
+void NullRenderDevice::Uniform4fv(int location, int count, const float* value)
+{
+    CanUploadUniform("Uniform4fv", location);
+}
+
+void NullRenderDevice::UniformMatrix2fv(int location, int count, bool transpose, const float* value)
+{
+    CanUploadUniform("UniformMatrix2fv", location);
+}
+
+void NullRenderDevice::UniformMatrix3fv(int location, int count, bool transpose, const float* value)
+{
+    CanUploadUniform("UniformMatrix3fv", location);
+}
+
+void NullRenderDevice::UniformMatrix4fv(int location, int count, bool transpose, const float* value)
+{
+    CanUploadUniform("UniformMatrix4fv", location);
+}
+
+////////////////// QUERIES /////////////////////////
+
+unsigned int NullRenderDevice::CreateQuery()
+{
+    unsigned int query = m_nextHandle++;
+    m_queries.insert(query);
+    Record("CreateQuery", query);
+    return query;
+}
+
+void NullRenderDevice::DeleteQuery(unsigned int query)
+{
+    Record("DeleteQuery", query);
+    m_queries.erase(query);
+    for (auto& active : m_activeQueries)
+    {
+        if (active.second == query)
+        {
+            active.second = 0;
+        }
+    }
+}
+
+void NullRenderDevice::BeginQuery(GLenum target, unsigned int query)
+{
+    Record("BeginQuery", query);
+    if (m_queries.count(query) == 0)
+    {
+        Invalid("BeginQuery", "not a live query");
+        return;
+    }
+    if (m_activeQueries[target] != 0)
+    {
+        Invalid("BeginQuery", "a query is already active on this target");
+        return;
+    }
+    m_activeQueries[target] = query;
+}
+
+void NullRenderDevice::EndQuery(GLenum target)
+{
+    Record("EndQuery", target);
+    if (m_activeQueries[target] == 0)
+    {
+        Invalid("EndQuery", "no query active on this target");
+        return;
+    }
+    m_activeQueries[target] = 0;
+}
+
+bool NullRenderDevice::GetQueryResult(unsigned int query, unsigned long long& result)
+{
+    Record("GetQueryResult", query);
+    if (m_queries.count(query) == 0)
+    {
+        Invalid("GetQueryResult", "not a live query");
+        return false;
+    }
+    // Nothing ran, so nothing took any time
+    result = 0;
+    return true;
+}
+
+////////////////// FENCES /////////////////////////
+
+unsigned int NullRenderDevice::CreateFence()
+{
+    unsigned int fence = m_nextHandle++;
+    m_fences.insert(fence);
+    Record("CreateFence", fence);
+    return fence;
+}
+
+Fence_Status NullRenderDevice::WaitFence(unsigned int fence, unsigned long long timeoutNs)
+{
+    Record("WaitFence", fence);
+    if (m_fences.count(fence) == 0)
+    {
+        Invalid("WaitFence", "not a live fence");
+    }
+    // There's never any outstanding work
+    return FENCE_SIGNALED;
+}
+
+void NullRenderDevice::DeleteFence(unsigned int fence)
+{
+    Record("DeleteFence", fence);
+    m_fences.erase(fence);
+}
+
+////////////////// STATE AND DRAWING /////////////////////////
+
+void NullRenderDevice::Enable(GLenum capability)
+{
+    Record("Enable", capability);
+    StateChange(m_enabled.insert(capability).second);
+}
+
+void NullRenderDevice::Disable(GLenum capability)
+{
+    Record("Disable", capability);
+    StateChange(m_enabled.erase(capability) != 0);
+}
+
+void NullRenderDevice::Viewport(int x, int y, int width, int height)
+{
+    Record("Viewport");
+    bool changed = m_viewport[0] != x || m_viewport[1] != y || m_viewport[2] != width || m_viewport[3] != height;
+    StateChange(changed);
+    m_viewport[0] = x;
+    m_viewport[1] = y;
+    m_viewport[2] = width;
+    m_viewport[3] = height;
+}
+
+void NullRenderDevice::Scissor(int x, int y, int width, int height)
+{
+    Record("Scissor");
+    bool changed = m_scissor[0] != x || m_scissor[1] != y || m_scissor[2] != width || m_scissor[3] != height;
+    StateChange(changed);
+    m_scissor[0] = x;
+    m_scissor[1] = y;
+    m_scissor[2] = width;
+    m_scissor[3] = height;
+}
+
+void NullRenderDevice::LineWidth(float width)
+{
+    Record("LineWidth");
+    StateChange(m_lineWidth != width);
+    m_lineWidth = width;
+}
+
+void NullRenderDevice::ClearColor(float r, float g, float b, float a)
+{
+    Record("ClearColor");
+    bool changed = m_clearColor[0] != r || m_clearColor[1] != g || m_clearColor[2] != b || m_clearColor[3] != a;
+    StateChange(changed);
+    m_clearColor[0] = r;
+    m_clearColor[1] = g;
+    m_clearColor[2] = b;
+    m_clearColor[3] = a;
+}
+
+void NullRenderDevice::Clear(GLbitfield mask)
+{
+    Record("Clear", mask);
+}
+
+void NullRenderDevice::DrawArrays(GLenum mode, int first, int count)
+{
+    Record("DrawArrays", mode, count);
+    if (m_vertexArray == 0 || m_program == 0)
+    {
+        Invalid("DrawArrays", "needs a vertex array and a program");
+        return;
+    }
+    m_stats.drawCalls++;
+    m_stats.verticesSubmitted += count;
+    m_stats.triangles += CountTriangles(mode, count);
+}
+
+void NullRenderDevice::DrawElements(GLenum mode, int count, GLenum type, size_t offset)
+{
+    Record("DrawElements", mode, count);
+    if (m_vertexArray == 0 || m_program == 0)
+    {
+        Invalid("DrawElements", "needs a vertex array and a program");
+        return;
+    }
+    unsigned int elementBuffer = m_elementBuffers[m_vertexArray];
+    if (elementBuffer == 0)
+    {
+        Invalid("DrawElements", "no element buffer on the vertex array");
+        return;
+    }
+    if (offset + (size_t)count * GetTypeSize(type) > m_buffers[elementBuffer])
+    {
+        Invalid("DrawElements", "indices run past the end of the element buffer");
+        return;
+    }
+    m_stats.drawCalls++;
+    m_stats.verticesSubmitted += count;
+    m_stats.triangles += CountTriangles(mode, count);
+}
+
+////////////////// RECORDING /////////////////////////
+
+void NullRenderDevice::Record(const char* name, unsigned int object, size_t amount)
+{
+    m_stats.commands++;
+    if (m_recording)
+    {
+        m_commands.push_back({ name, object, amount });
+    }
+}
+
+void NullRenderDevice::Invalid(const char* name, const char* reason)
+{
+    m_stats.invalidCalls++;
+    m_lastError = std::string(name) + ": " + reason;
+}
+
+void NullRenderDevice::StateChange(bool changed)
+{
+    if (changed)
+    {
+        m_stats.stateChanges++;
+    }
+    else
+    {
+        m_stats.redundantStateChanges++;
+    }
+}
+
+unsigned int* NullRenderDevice::GetBinding(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER: return &m_arrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return &m_elementBuffers[m_vertexArray];
+        default: return NULL;
+    }
+}
+
+unsigned int NullRenderDevice::GetBoundTexture() const
+{
+    auto found = m_boundTextures.find(m_activeUnit);
+    return found != m_boundTextures.end() ? found->second : 0;
+}
+
+void NullRenderDevice::SetRecording(bool recording)
+{
+    m_recording = recording;
+}
+
+const std::vector<NullRenderDevice::Command>& NullRenderDevice::GetCommands() const
+{
+    return m_commands;
+}
+
+void NullRenderDevice::ClearCommands()
+{
+    m_commands.clear();
+}
+
+const NullRenderDevice::Stats& NullRenderDevice::GetStats() const
+{
+    return m_stats;
+}
+
+void NullRenderDevice::ResetStats()
+{
+    m_stats = Stats();
+    m_lastError.clear();
+}
+
+const std::string& NullRenderDevice::GetLastError() const
+{
+    return m_lastError;
+}
+
+size_t NullRenderDevice::GetBufferSize(unsigned int buffer) const
+{
+    auto found = m_buffers.find(buffer);
+    return found != m_buffers.end() ? found->second : 0;
+}
+
+size_t NullRenderDevice::GetBufferMemory() const
+{
+    size_t total = 0;
+    for (const auto& buffer : m_buffers)
+    {
+        total += buffer.second;
+    }
+    return total;
+}
+
+size_t NullRenderDevice::GetTextureMemory() const
+{
+    size_t total = 0;
+    for (const auto& texture : m_textures)
+    {
+        // A full mip chain adds about a third on top of the base level
+        size_t bytes = texture.second.baseBytes;
+        total += texture.second.mipmapped ? bytes + bytes / 3 : bytes;
+    }
+    return total;
+}
+
+size_t NullRenderDevice::GetNumLiveObjects() const
+{
+    return m_vertexArrays.size() + m_buffers.size() + m_textures.size() + m_shaders.size() + m_programs.size()
+        + m_queries.size() + m_fences.size();
+}
+
+std::string NullRenderDevice::GetReport() const
+{
+    std::ostringstream report;
+    report << "Null render device\n"
+        << "  commands:       " << m_stats.commands << "\n"
+        << "  draw calls:     " << m_stats.drawCalls << " (" << m_stats.triangles << " triangles, "
+        << m_stats.verticesSubmitted << " vertices)\n"
+        << "  state changes:  " << m_stats.stateChanges << " (+" << m_stats.redundantStateChanges << " redundant)\n"
+        << "  uniforms:       " << m_stats.uniformUploads << "\n"
+        << "  buffer uploads: " << m_stats.bufferUploads << " (" << m_stats.bufferBytesUploaded << " bytes)\n"
+        << "  tex uploads:    " << m_stats.textureUploads << " (" << m_stats.textureBytesUploaded << " bytes)\n"
+        << "  shaders:        " << m_stats.shaderCompiles << " compiled, " << m_stats.programLinks << " linked, "
+        << m_stats.programBinaryLoads << " from binaries\n"
+        << "  memory:         " << GetBufferMemory() << " buffer bytes, " << GetTextureMemory() << " texture bytes in "
+        << GetNumLiveObjects() << " objects\n"
+        << "  invalid calls:  " << m_stats.invalidCalls;
+    if (!m_lastError.empty())
+    {
+        report << " (last: " << m_lastError << ")";
+    }
+    return report.str();
+}
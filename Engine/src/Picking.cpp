@@ -0,0 +1,66 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+#include <Picking.h>
+
+namespace Picking
+{
+    glm::mat4 GridModel(const glm::mat4& isoMatrix, glm::vec3 gridOffset)
+    {
+        return glm::translate(isoMatrix, gridOffset);
+    }
+
+    glm::mat4 InverseGridMVP(const glm::mat4& inverseViewProjection, const glm::mat4& invIsoMatrix, glm::vec3 gridOffset)
+    {
+        return glm::translate(glm::mat4(1.0f), -gridOffset) * invIsoMatrix * inverseViewProjection;
+    }
+
+    glm::vec3 UnProject(const glm::mat4& invMvp, glm::vec2 viewport, glm::vec3 screen)
+    {
+        glm::vec4 ndc(
+            2.0f * screen.x / viewport.x - 1.0f,
+            1.0f - 2.0f * screen.y / viewport.y,
+            2.0f * screen.z - 1.0f,
+            1.0f);
+        glm::vec4 gridPos = invMvp * ndc;
+        return glm::vec3(gridPos) / gridPos.w;
+    }
+
+    glm::vec3 Project(const glm::mat4& mvp, glm::vec2 viewport, glm::vec3 gridPos)
+    {
+        glm::vec4 clip = mvp * glm::vec4(gridPos, 1.0f);
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3(
+            (ndc.x + 1.0f) * 0.5f * viewport.x,
+            (1.0f - ndc.y) * 0.5f * viewport.y,
+            (ndc.z + 1.0f) * 0.5f);
+    }
+
+    glm::vec3 ScreenToGrid(const glm::mat4& invMvp, glm::vec2 viewport, glm::vec2 screen)
+    {
+        // Ray from the near plane to the far plane through the cursor, then find where it
+        // crosses the grid
+        glm::vec3 nearPoint = UnProject(invMvp, viewport, glm::vec3(screen, 0.0f));
+        glm::vec3 farPoint = UnProject(invMvp, viewport, glm::vec3(screen, 1.0f));
+        glm::vec3 dir = farPoint - nearPoint;
+
+        glm::vec3 hit = nearPoint;
+        if (std::abs(dir.y) > 1e-6f)
+        {
+            hit = nearPoint + dir * (-nearPoint.y / dir.y);
+        }
+        hit.y = 0.0f;
+        return hit;
+    }
+
+    glm::ivec2 GridToTile(glm::vec3 gridPos, glm::vec3 tileSize)
+    {
+        if (tileSize.x <= 0.0f || tileSize.z <= 0.0f)
+        {
+            return glm::ivec2(0);
+        }
+        return glm::ivec2(glm::floor(glm::vec2(gridPos.x / tileSize.x, gridPos.z / tileSize.z)));
+    }
+}
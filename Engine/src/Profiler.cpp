@@ -0,0 +1,742 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+#include <Profiler.h>
+#include <RenderDevice.h>
+
+// Weight of the newest frame in the running averages
+#define PROFILER_AVERAGE_WEIGHT 0.05
+// Scopes that haven't run for this many frames drop out of the panel
+#define PROFILER_STALE_FRAMES 120
+// Trace thread id used for the GPU timeline
+#define PROFILER_GPU_THREAD PROFILER_MAX_THREADS
+
+////////////////// THREAD BUFFERS /////////////////////////
+
+// Single producer (the owning thread), single consumer (the main thread in EndFrame) ring.
+// head is only written by the producer and tail only by the consumer
+struct Profiler::ThreadBuffer
+{
+    Event events[PROFILER_THREAD_BUFFER_SIZE];
+    std::atomic<uint32_t> head{ 0 };
+    std::atomic<uint32_t> tail{ 0 };
+    std::atomic<unsigned long long> dropped{ 0 };
+    // Owner only
+    unsigned int depth = 0;
+    uint16_t index = 0;
+    // Guarded by m_namesMutex
+    std::string name;
+};
+
+static double ToMs(int64_t nanoseconds)
+{
+    return nanoseconds / 1000000.0;
+}
+
+static int64_t SteadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+Profiler& Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler()
+{
+    m_epoch = SteadyNow();
+    for (std::atomic<ThreadBuffer*>& slot : m_threads)
+    {
+        slot.store(NULL);
+    }
+}
+
+Profiler::~Profiler()
+{
+    // Only runs at exit, after any other threads are gone. Queries are left to the context
+    for (std::atomic<ThreadBuffer*>& slot : m_threads)
+    {
+        delete slot.load();
+    }
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool Profiler::IsEnabled() const
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_namesMutex);
+        buffer->name = name;
+    }
+}
+
+std::string Profiler::GetThreadName(unsigned int thread) const
+{
+    if (thread == PROFILER_GPU_THREAD)
+    {
+        return "GPU";
+    }
+    ThreadBuffer* buffer = thread < PROFILER_MAX_THREADS ? m_threads[thread].load(std::memory_order_acquire) : NULL;
+    if (!buffer)
+    {
+        return "Thread " + std::to_string(thread);
+    }
+    std::lock_guard<std::mutex> lock(m_namesMutex);
+    return buffer->name;
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    static thread_local bool t_registered = false;
+    static thread_local ThreadBuffer* t_buffer = NULL;
+    if (!t_registered)
+    {
+        t_registered = true;
+        unsigned int index = m_numThreads.fetch_add(1);
+        if (index >= PROFILER_MAX_THREADS)
+        {
+            // Out of slots, this thread just doesn't get profiled
+            return NULL;
+        }
+        ThreadBuffer* buffer = new ThreadBuffer();
+        buffer->index = (uint16_t)index;
+        buffer->name = "Thread " + std::to_string(index);
+        m_threads[index].store(buffer, std::memory_order_release);
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+////////////////// RECORDING /////////////////////////
+
+int64_t Profiler::Now() const
+{
+    return SteadyNow() - m_epoch;
+}
+
+unsigned int Profiler::PushScope()
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    return buffer ? buffer->depth++ : 0;
+}
+
+void Profiler::PopScope(const char* name, int64_t start, unsigned int depth)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+    {
+        return;
+    }
+    buffer->depth = depth;
+
+    uint32_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >= PROFILER_THREAD_BUFFER_SIZE)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Event& event = buffer->events[head % PROFILER_THREAD_BUFFER_SIZE];
+    event.name = name;
+    event.start = start;
+    event.end = Now();
+    event.depth = (uint16_t)std::min(depth, 0xFFFFu);
+    event.thread = buffer->index;
+    // Publishes the event to the collector
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::Collect(std::vector<Event>& out)
+{
+    unsigned int numThreads = std::min(m_numThreads.load(std::memory_order_acquire), (unsigned int)PROFILER_MAX_THREADS);
+    for (unsigned int i = 0; i < numThreads; ++i)
+    {
+        ThreadBuffer* buffer = m_threads[i].load(std::memory_order_acquire);
+        if (!buffer)
+        {
+            // Registered but not published yet, its events will be picked up next frame
+            continue;
+        }
+        uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint32_t head = buffer->head.load(std::memory_order_acquire);
+        for (uint32_t j = tail; j != head; ++j)
+        {
+            out.push_back(buffer->events[j % PROFILER_THREAD_BUFFER_SIZE]);
+        }
+        // Hands the slots back to the producer
+        buffer->tail.store(head, std::memory_order_release);
+    }
+}
+
+bool Profiler::BeginGpuScope(const char* name)
+{
+    RenderDevice* device = RenderDevice::Get();
+    if (!IsEnabled() || m_gpuScopeOpen || !device->NeedsContext())
+    {
+        return false;
+    }
+
+    GpuQuerySet& set = m_gpuQueries[glfwGetCurrentContext()];
+    unsigned int slot = (unsigned int)(m_frameIndex % PROFILER_GPU_LATENCY);
+    if (set.frames[slot] != m_frameIndex)
+    {
+        // Left from PROFILER_GPU_LATENCY or more frames ago. Read now, while the context they
+        // were made on is current, which in a multi window frame is only while its window draws
+        ResolveGpuQueries(set, slot, m_current);
+        set.frames[slot] = m_frameIndex;
+    }
+
+    unsigned int query;
+    if (set.freeQueries.empty())
+    {
+        query = device->CreateQuery();
+    }
+    else
+    {
+        query = set.freeQueries.back();
+        set.freeQueries.pop_back();
+    }
+    device->BeginQuery(GL_TIME_ELAPSED, query);
+    set.pending[slot].push_back({ name, query, Now() });
+    m_gpuScopeOpen = true;
+    return true;
+}
+
+void Profiler::EndGpuScope()
+{
+    if (m_gpuScopeOpen)
+    {
+        RenderDevice::Get()->EndQuery(GL_TIME_ELAPSED);
+        m_gpuScopeOpen = false;
+    }
+}
+
+void Profiler::ReleaseGpuQueries()
+{
+    auto found = m_gpuQueries.find(glfwGetCurrentContext());
+    if (found == m_gpuQueries.end())
+    {
+        return;
+    }
+    EndGpuScope();
+    RenderDevice* device = RenderDevice::Get();
+    GpuQuerySet& set = found->second;
+    for (std::vector<PendingQuery>& queries : set.pending)
+    {
+        for (const PendingQuery& pending : queries)
+        {
+            device->DeleteQuery(pending.query);
+        }
+    }
+    for (unsigned int query : set.freeQueries)
+    {
+        device->DeleteQuery(query);
+    }
+    m_gpuQueries.erase(found);
+}
+
+void Profiler::ResolveGpuQueries(GpuQuerySet& set, unsigned int slot, Frame& frame)
+{
+    RenderDevice* device = RenderDevice::Get();
+    std::vector<PendingQuery>& queries = set.pending[slot];
+    for (const PendingQuery& pending : queries)
+    {
+        unsigned long long elapsed = 0;
+        if (!device->GetQueryResult(pending.query, elapsed))
+        {
+            // Still not done after PROFILER_GPU_LATENCY frames. Dropping it beats stalling on it
+            m_droppedGpuResults++;
+        }
+        else
+        {
+            // Placed at the CPU time the work was issued, the GPU runs it some time after that
+            frame.gpuEvents.push_back({ pending.name, pending.cpuStart, pending.cpuStart + (int64_t)elapsed, 0,
+                (uint16_t)PROFILER_GPU_THREAD });
+
+            double ms = ToMs((int64_t)elapsed);
+            auto found = std::find_if(m_gpuStats.begin(), m_gpuStats.end(),
+                [&](const GpuStats& stats) { return stats.name == pending.name; });
+            if (found == m_gpuStats.end())
+            {
+                GpuStats stats;
+                stats.name = pending.name;
+                stats.avgMs = ms;
+                m_gpuStats.push_back(stats);
+                found = m_gpuStats.end() - 1;
+            }
+            found->lastMs = ms;
+            found->avgMs += (ms - found->avgMs) * PROFILER_AVERAGE_WEIGHT;
+            found->maxMs = std::max(found->maxMs, ms);
+        }
+        set.freeQueries.push_back(pending.query);
+    }
+    queries.clear();
+}
+
+////////////////// PER FRAME /////////////////////////
+
+void Profiler::BeginFrame()
+{
+    if (m_inFrame)
+    {
+        EndFrame();
+    }
+    m_inFrame = true;
+    m_frameDepth = PushScope();
+    m_frameStart = Now();
+    m_current.index = m_frameIndex;
+    m_current.start = m_frameStart;
+}
+
+void Profiler::EndFrame()
+{
+    if (!m_inFrame)
+    {
+        return;
+    }
+    m_inFrame = false;
+    EndGpuScope();
+    PopScope("Frame", m_frameStart, m_frameDepth);
+    m_current.end = Now();
+
+    Collect(m_current.events);
+    UpdateScopeStats(m_current);
+
+    m_lastFrameMs = ToMs(m_current.end - m_current.start);
+    m_avgFrameMs = (m_frameIndex == 0) ? m_lastFrameMs
+        : m_avgFrameMs + (m_lastFrameMs - m_avgFrameMs) * PROFILER_AVERAGE_WEIGHT;
+
+    m_history.push_back(std::move(m_current));
+    while (m_history.size() > PROFILER_HISTORY_FRAMES)
+    {
+        m_history.pop_front();
+    }
+    m_current = Frame();
+    m_frameIndex++;
+}
+
+void Profiler::UpdateScopeStats(const Frame& frame)
+{
+    // Rebuild each thread's tree from start times and depths. Parents start first, and on ties
+    // (a zero length parent) the shallower one comes first
+    std::vector<Event> events = frame.events;
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+    {
+        if (a.thread != b.thread)
+        {
+            return a.thread < b.thread;
+        }
+        return (a.start != b.start) ? a.start < b.start : a.depth < b.depth;
+    });
+
+    std::vector<size_t> order;
+    std::vector<bool> added(m_scopes.size(), false);
+    std::vector<double> frameMs(m_scopes.size(), 0.0);
+    std::vector<unsigned int> frameCalls(m_scopes.size(), 0);
+    std::vector<std::string> stack;
+    unsigned int currentThread = 0xFFFFFFFF;
+    std::string threadName;
+    for (const Event& event : events)
+    {
+        if (event.thread != currentThread)
+        {
+            currentThread = event.thread;
+            threadName = GetThreadName(event.thread);
+            stack.clear();
+        }
+        // A parent that's still open (or was collected in an earlier frame) isn't here, so the
+        // scope hangs off the thread instead
+        if (stack.size() > event.depth)
+        {
+            stack.resize(event.depth);
+        }
+        std::string path = (stack.empty() ? threadName : stack.back()) + "/" + event.name;
+        stack.push_back(path);
+
+        auto found = m_scopeIndex.find(path);
+        size_t index;
+        if (found == m_scopeIndex.end())
+        {
+            index = m_scopes.size();
+            m_scopeIndex[path] = index;
+            ScopeStats stats;
+            stats.path = path;
+            stats.name = event.name;
+            stats.thread = event.thread;
+            stats.depth = (unsigned int)(stack.size() - 1);
+            m_scopes.push_back(stats);
+            added.push_back(true);
+            frameMs.push_back(0.0);
+            frameCalls.push_back(0);
+        }
+        else
+        {
+            index = found->second;
+        }
+        if (frameCalls[index] == 0)
+        {
+            order.push_back(index);
+        }
+        frameMs[index] += ToMs(event.end - event.start);
+        frameCalls[index]++;
+    }
+
+    for (size_t index : order)
+    {
+        ScopeStats& stats = m_scopes[index];
+        stats.lastMs = frameMs[index];
+        stats.calls = frameCalls[index];
+        stats.avgMs = added[index] ? stats.lastMs : stats.avgMs + (stats.lastMs - stats.avgMs) * PROFILER_AVERAGE_WEIGHT;
+        stats.maxMs = std::max(stats.maxMs, stats.lastMs);
+        stats.lastFrame = frame.index;
+    }
+
+    // Put this frame's scopes first, in the order they ran, so the list reads as a tree
+    std::vector<ScopeStats> sorted;
+    sorted.reserve(m_scopes.size());
+    std::vector<bool> used(m_scopes.size(), false);
+    for (size_t index : order)
+    {
+        sorted.push_back(m_scopes[index]);
+        used[index] = true;
+    }
+    for (size_t i = 0; i < m_scopes.size(); ++i)
+    {
+        if (!used[i])
+        {
+            m_scopes[i].calls = 0;
+            sorted.push_back(m_scopes[i]);
+        }
+    }
+    m_scopes.swap(sorted);
+    m_scopeIndex.clear();
+    for (size_t i = 0; i < m_scopes.size(); ++i)
+    {
+        m_scopeIndex[m_scopes[i].path] = i;
+    }
+}
+
+////////////////// RESULTS /////////////////////////
+
+unsigned long long Profiler::GetFrameIndex() const
+{
+    return m_frameIndex;
+}
+
+double Profiler::GetLastFrameMs() const
+{
+    return m_lastFrameMs;
+}
+
+double Profiler::GetAvgFrameMs() const
+{
+    return m_avgFrameMs;
+}
+
+const std::vector<Profiler::ScopeStats>& Profiler::GetScopeStats() const
+{
+    return m_scopes;
+}
+
+const std::vector<Profiler::GpuStats>& Profiler::GetGpuStats() const
+{
+    return m_gpuStats;
+}
+
+unsigned long long Profiler::GetNumDroppedEvents() const
+{
+    unsigned long long dropped = 0;
+    unsigned int numThreads = std::min(m_numThreads.load(std::memory_order_acquire), (unsigned int)PROFILER_MAX_THREADS);
+    for (unsigned int i = 0; i < numThreads; ++i)
+    {
+        ThreadBuffer* buffer = m_threads[i].load(std::memory_order_acquire);
+        if (buffer)
+        {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return dropped;
+}
+
+void Profiler::ResetStats()
+{
+    m_scopes.clear();
+    m_scopeIndex.clear();
+    m_gpuStats.clear();
+    m_history.clear();
+    m_avgFrameMs = m_lastFrameMs;
+}
+
+void Profiler::DrawPanel(bool* open)
+{
+    if (!ImGui::Begin("Profiler", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        ResetStats();
+    }
+    ImGui::SameLine();
+    static std::string s_saveResult;
+    if (ImGui::Button("Save trace"))
+    {
+        const char* path = "profile_trace.json";
+        s_saveResult = WriteChromeTrace(path) ? std::string("Saved ") + path : std::string("Failed to write ") + path;
+    }
+    if (!s_saveResult.empty())
+    {
+        ImGui::TextUnformatted(s_saveResult.c_str());
+    }
+
+    ImGui::Text("Frame: %.2f ms (avg %.2f)", m_lastFrameMs, m_avgFrameMs);
+    float frameTimes[PROFILER_HISTORY_FRAMES];
+    int numFrameTimes = 0;
+    for (const Frame& frame : m_history)
+    {
+        frameTimes[numFrameTimes++] = (float)ToMs(frame.end - frame.start);
+    }
+    ImGui::PlotLines("##frametimes", frameTimes, numFrameTimes, 0, NULL, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp;
+    ImGui::SeparatorText("CPU");
+    if (ImGui::BeginTable("cpu", 5, flags))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("avg");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableSetupColumn("calls");
+        ImGui::TableHeadersRow();
+        unsigned int currentThread = 0xFFFFFFFF;
+        for (const ScopeStats& stats : m_scopes)
+        {
+            if (m_frameIndex > stats.lastFrame + PROFILER_STALE_FRAMES)
+            {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (stats.thread != currentThread)
+            {
+                currentThread = stats.thread;
+                ImGui::TextDisabled("%s", GetThreadName(stats.thread).c_str());
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+            }
+            ImGui::Indent(stats.depth * 10.0f + 10.0f);
+            ImGui::TextUnformatted(stats.name);
+            ImGui::Unindent(stats.depth * 10.0f + 10.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.calls);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("GPU");
+    if (!RenderDevice::Get()->NeedsContext())
+    {
+        ImGui::TextDisabled("No context, GPU timings are off");
+    }
+    else if (ImGui::BeginTable("gpu", 4, flags))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("avg");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+        for (const GpuStats& stats : m_gpuStats)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(stats.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    unsigned long long dropped = GetNumDroppedEvents();
+    if (dropped > 0 || m_droppedGpuResults > 0)
+    {
+        ImGui::TextDisabled("Dropped %llu events, %llu GPU results", dropped, m_droppedGpuResults);
+    }
+    ImGui::End();
+}
+
+static void WriteJsonString(FILE* file, const std::string& value)
+{
+    std::fputc('"', file);
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            std::fputc('\\', file);
+            std::fputc(c, file);
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            std::fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            std::fputc(c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto writeEvent = [&](const Event& event, const char* category)
+    {
+        std::fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        WriteJsonString(file, event.name);
+        // Microseconds, which is what the format wants
+        std::fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            category, (unsigned int)event.thread, event.start / 1000.0, (event.end - event.start) / 1000.0);
+        first = false;
+    };
+
+    std::vector<unsigned int> threads;
+    for (const Frame& frame : m_history)
+    {
+        for (const Event& event : frame.events)
+        {
+            writeEvent(event, "cpu");
+            if (std::find(threads.begin(), threads.end(), event.thread) == threads.end())
+            {
+                threads.push_back(event.thread);
+            }
+        }
+        for (const Event& event : frame.gpuEvents)
+        {
+            writeEvent(event, "gpu");
+            if (std::find(threads.begin(), threads.end(), event.thread) == threads.end())
+            {
+                threads.push_back(event.thread);
+            }
+        }
+    }
+    for (unsigned int thread : threads)
+    {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",\n", thread);
+        WriteJsonString(file, GetThreadName(thread));
+        std::fprintf(file, "}}");
+        first = false;
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+std::string Profiler::GetReport() const
+{
+    std::ostringstream report;
+    report.setf(std::ios::fixed);
+    report.precision(3);
+    report << "Profiler: " << m_frameIndex << " frames, avg " << m_avgFrameMs << " ms\n";
+    for (const ScopeStats& stats : m_scopes)
+    {
+        // Roots keep the thread name so scopes from different threads can be told apart
+        std::string name = stats.depth == 0 ? stats.path : stats.path.substr(stats.path.rfind('/') + 1);
+        report << "  " << std::string(stats.depth * 2, ' ') << name << ": " << stats.avgMs << " ms avg, " << stats.maxMs << " max\n";
+    }
+    for (const GpuStats& stats : m_gpuStats)
+    {
+        report << "  GPU " << stats.name << ": " << stats.avgMs << " ms avg, " << stats.maxMs << " max\n";
+    }
+    report << "  dropped: " << GetNumDroppedEvents() << " events, " << m_droppedGpuResults << " GPU results";
+    return report.str();
+}
+
+////////////////// SCOPES /////////////////////////
+
+ProfileScope::ProfileScope(const char* name)
+    : m_name(name)
+{
+    Profiler& profiler = Profiler::Get();
+    m_open = profiler.IsEnabled();
+    if (m_open)
+    {
+        m_depth = profiler.PushScope();
+        m_start = profiler.Now();
+    }
+}
+
+ProfileScope::~ProfileScope()
+{
+    End();
+}
+
+void ProfileScope::End()
+{
+    if (m_open)
+    {
+        Profiler::Get().PopScope(m_name, m_start, m_depth);
+        m_open = false;
+    }
+}
+
+GpuProfileScope::GpuProfileScope(const char* name)
+{
+    m_open = Profiler::Get().BeginGpuScope(name);
+}
+
+GpuProfileScope::~GpuProfileScope()
+{
+    if (m_open)
+    {
+        Profiler::Get().EndGpuScope();
+    }
+}
@@ -0,0 +1,25 @@
+#include <RenderDevice.h>
+#include <GLRenderDevice.h>
+
+// Function statics so the device is usable from other statics' constructors too
+static GLRenderDevice& GetGLDevice()
+{
+    static GLRenderDevice device;
+    return device;
+}
+
+static RenderDevice*& GetActiveDevice()
+{
+    static RenderDevice* device = &GetGLDevice();
+    return device;
+}
+
+RenderDevice* RenderDevice::Get()
+{
+    return GetActiveDevice();
+}
+
+void RenderDevice::Set(RenderDevice* device)
+{
+    GetActiveDevice() = device ? device : &GetGLDevice();
+}
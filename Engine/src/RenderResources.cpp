@@ -0,0 +1,219 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <RenderDevice.h>
+#include <RenderStats.h>
+#include <ShaderLibrary.h>
+#include <TileImposters.h>
+#include <TileMap.h>
+#include <TileRenderer.h>
+#include <UploadThread.h>
+
+#include <RenderResources.h>
+
+RenderResources& RenderResources::Get()
+{
+    static RenderResources resources;
+    return resources;
+}
+
+////////////////// CONTEXTS /////////////////////////
+
+GLFWwindow* RenderResources::GetShareContext() const
+{
+    return m_contexts.empty() ? NULL : m_contexts.front();
+}
+
+void RenderResources::AddContext(GLFWwindow* context)
+{
+    if (std::find(m_contexts.begin(), m_contexts.end(), context) == m_contexts.end())
+    {
+        m_contexts.push_back(context);
+    }
+}
+
+void RenderResources::RemoveContext(GLFWwindow* context)
+{
+    std::vector<GLFWwindow*>::iterator found = std::find(m_contexts.begin(), m_contexts.end(), context);
+    if (found == m_contexts.end())
+    {
+        return;
+    }
+    m_contexts.erase(found);
+    if (m_contexts.empty())
+    {
+        FreeAll();
+    }
+}
+
+unsigned int RenderResources::GetNumContexts() const
+{
+    return (unsigned int)m_contexts.size();
+}
+
+void RenderResources::FreeAll()
+{
+    // Anything still held belongs to a window that didn't release it, the objects only live as
+    // long as the last context does anyway
+    RenderDevice* device = RenderDevice::Get();
+    for (auto& named : m_buffers)
+    {
+        device->DeleteBuffer(named.second.buffer);
+    }
+    m_buffers.clear();
+    for (auto& shared : m_tileRenderers)
+    {
+        delete shared.second.renderer;
+    }
+    m_tileRenderers.clear();
+    for (auto& shared : m_tileImposters)
+    {
+        delete shared.second.imposters;
+    }
+    m_tileImposters.clear();
+
+    // Deleted by ImGui along with the last context
+    m_fontAtlas = NULL;
+    m_imguiFrame = 0;
+
+    // Its context shares with the windows'
+    UploadThread::Get().Stop();
+}
+
+////////////////// SHARED OBJECTS /////////////////////////
+
+unsigned int RenderResources::AcquireBuffer(const std::string& name, const void* data, size_t size)
+{
+    SharedBuffer& shared = m_buffers[name];
+    if (shared.refCount++ > 0)
+    {
+        return shared.buffer;
+    }
+
+    RenderDevice* device = RenderDevice::Get();
+    shared.buffer = device->CreateBuffer();
+    device->BindBuffer(GL_ARRAY_BUFFER, shared.buffer);
+    device->BufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+    RenderStats::Get().Add(RENDER_STAT_BUFFER_UPLOADS);
+    RenderStats::Get().Add(RENDER_STAT_BUFFER_BYTES, size);
+    return shared.buffer;
+}
+
+void RenderResources::ReleaseBuffer(const std::string& name)
+{
+    std::unordered_map<std::string, SharedBuffer>::iterator found = m_buffers.find(name);
+    if (found == m_buffers.end())
+    {
+        return;
+    }
+    if (--found->second.refCount == 0)
+    {
+        RenderDevice::Get()->DeleteBuffer(found->second.buffer);
+        m_buffers.erase(found);
+    }
+}
+
+TileRenderer* RenderResources::AcquireTileRenderer(TileMap* tileMap, glm::vec3 tileSize, unsigned int& view)
+{
+    SharedTileRenderer& shared = m_tileRenderers[tileMap];
+    if (shared.refCount++ == 0)
+    {
+        // Comes with a view for the context making it
+        shared.renderer = new TileRenderer(tileMap, tileSize);
+        view = 0;
+    }
+    else
+    {
+        view = shared.renderer->CreateView();
+    }
+    return shared.renderer;
+}
+
+void RenderResources::ReleaseTileRenderer(TileMap* tileMap, unsigned int view)
+{
+    std::unordered_map<TileMap*, SharedTileRenderer>::iterator found = m_tileRenderers.find(tileMap);
+    if (found == m_tileRenderers.end())
+    {
+        return;
+    }
+    found->second.renderer->DestroyView(view);
+    if (--found->second.refCount == 0)
+    {
+        delete found->second.renderer;
+        m_tileRenderers.erase(found);
+    }
+}
+
+TileImposters* RenderResources::AcquireTileImposters(TileMap* tileMap)
+{
+    SharedTileImposters& shared = m_tileImposters[tileMap];
+    if (shared.refCount++ == 0)
+    {
+        shared.imposters = new TileImposters(tileMap);
+    }
+    return shared.imposters;
+}
+
+void RenderResources::ReleaseTileImposters(TileMap* tileMap)
+{
+    std::unordered_map<TileMap*, SharedTileImposters>::iterator found = m_tileImposters.find(tileMap);
+    if (found == m_tileImposters.end())
+    {
+        return;
+    }
+    if (--found->second.refCount == 0)
+    {
+        delete found->second.imposters;
+        m_tileImposters.erase(found);
+    }
+}
+
+ImFontAtlas* RenderResources::GetFontAtlas()
+{
+    if (!m_fontAtlas)
+    {
+        // ImGui deletes it with IM_DELETE, so it has to come from IM_NEW
+        m_fontAtlas = IM_NEW(ImFontAtlas)();
+    }
+    return m_fontAtlas;
+}
+
+void RenderResources::BeginImGuiFrame()
+{
+    if (!m_fontAtlas)
+    {
+        return;
+    }
+    bool rendererHasTextures = (ImGui::GetIO().BackendFlags & ImGuiBackendFlags_RendererHasTextures) != 0;
+    // Counts every window's frames, it only has to keep going up
+    ImFontAtlasUpdateNewFrame(m_fontAtlas, ++m_imguiFrame, rendererHasTextures);
+}
+
+////////////////// CHANGES /////////////////////////
+
+unsigned int RenderResources::Update()
+{
+    unsigned int swapped = ShaderLibrary::Get().Update();
+    if (swapped > 0)
+    {
+        MarkChanged();
+    }
+    return swapped;
+}
+
+void RenderResources::MarkChanged()
+{
+    m_version++;
+}
+
+unsigned int RenderResources::GetVersion() const
+{
+    return m_version;
+}
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "imgui.h"
+
+#include <RenderStats.h>
+
+static const char* s_statNames[RENDER_STAT_COUNT] =
+{
+    "draw_calls",
+    "triangles",
+    "vertices",
+    "state_changes",
+    "uniform_uploads",
+    "buffer_uploads",
+    "buffer_bytes",
+    "texture_uploads",
+    "texture_bytes",
+};
+
+RenderStats& RenderStats::Get()
+{
+    static RenderStats stats;
+    return stats;
+}
+
+void RenderStats::AddDraw(GLenum mode, unsigned int count)
+{
+    Add(RENDER_STAT_DRAW_CALLS);
+    Add(RENDER_STAT_VERTICES, count);
+
+    unsigned long long triangles = 0;
+    if (mode == GL_TRIANGLES)
+    {
+        triangles = count / 3;
+    }
+    else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+    {
+        triangles = count - 2;
+    }
+    if (triangles > 0)
+    {
+        Add(RENDER_STAT_TRIANGLES, triangles);
+    }
+}
+
+void RenderStats::EndFrame()
+{
+    unsigned int slot = (unsigned int)(m_frameIndex % RENDER_STATS_HISTORY_FRAMES);
+    for (unsigned int stat = 0; stat < RENDER_STAT_COUNT; ++stat)
+    {
+        unsigned long long value = m_current[stat].exchange(0, std::memory_order_relaxed);
+        // The slot being overwritten drops out of the window
+        if (m_numHistory == RENDER_STATS_HISTORY_FRAMES)
+        {
+            m_historySum[stat] -= m_history[slot][stat];
+        }
+        m_history[slot][stat] = value;
+        m_historySum[stat] += value;
+        m_total[stat] += value;
+    }
+    m_numHistory = std::min(m_numHistory + 1, (unsigned int)RENDER_STATS_HISTORY_FRAMES);
+    ++m_frameIndex;
+}
+
+////////////////// RESULTS /////////////////////////
+
+const char* RenderStats::GetName(RenderStat stat)
+{
+    return stat < RENDER_STAT_COUNT ? s_statNames[stat] : "unknown";
+}
+
+unsigned long long RenderStats::GetFrameIndex() const
+{
+    return m_frameIndex;
+}
+
+unsigned long long RenderStats::GetLast(RenderStat stat) const
+{
+    if (m_numHistory == 0)
+    {
+        return 0;
+    }
+    return m_history[(m_frameIndex - 1) % RENDER_STATS_HISTORY_FRAMES][stat];
+}
+
+double RenderStats::GetAverage(RenderStat stat) const
+{
+    if (m_numHistory == 0)
+    {
+        return 0.0;
+    }
+    return (double)m_historySum[stat] / m_numHistory;
+}
+
+unsigned long long RenderStats::GetMax(RenderStat stat) const
+{
+    unsigned long long max = 0;
+    for (unsigned int i = 1; i <= m_numHistory; ++i)
+    {
+        max = std::max(max, m_history[(m_frameIndex - i) % RENDER_STATS_HISTORY_FRAMES][stat]);
+    }
+    return max;
+}
+
+unsigned long long RenderStats::GetTotal(RenderStat stat) const
+{
+    return m_total[stat];
+}
+
+void RenderStats::Reset()
+{
+    for (unsigned int stat = 0; stat < RENDER_STAT_COUNT; ++stat)
+    {
+        m_historySum[stat] = 0;
+        m_total[stat] = 0;
+    }
+    m_numHistory = 0;
+}
+
+////////////////// OUTPUT /////////////////////////
+
+void RenderStats::DrawOverlay(bool* open)
+{
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    if (!ImGui::Begin("Render Stats", open, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::Button("Reset"))
+    {
+        Reset();
+    }
+    ImGui::SameLine();
+    static std::string s_saveResult;
+    if (ImGui::Button("Save CSV"))
+    {
+        const char* path = "render_stats.csv";
+        s_saveResult = WriteCSV(path) ? std::string("Saved ") + path : std::string("Failed to write ") + path;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save JSON"))
+    {
+        const char* path = "render_stats.json";
+        s_saveResult = WriteJSON(path) ? std::string("Saved ") + path : std::string("Failed to write ") + path;
+    }
+    if (!s_saveResult.empty())
+    {
+        ImGui::TextUnformatted(s_saveResult.c_str());
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("renderstats", 4, flags))
+    {
+        ImGui::TableSetupColumn("Counter");
+        ImGui::TableSetupColumn("frame");
+        ImGui::TableSetupColumn("avg");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+        for (unsigned int i = 0; i < RENDER_STAT_COUNT; ++i)
+        {
+            RenderStat stat = (RenderStat)i;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(GetName(stat));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", GetLast(stat));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", GetAverage(stat));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", GetMax(stat));
+        }
+        ImGui::EndTable();
+    }
+
+    // Draw calls over the history, oldest first
+    float drawCalls[RENDER_STATS_HISTORY_FRAMES];
+    for (unsigned int i = 0; i < m_numHistory; ++i)
+    {
+        unsigned long long frame = m_frameIndex - m_numHistory + i;
+        drawCalls[i] = (float)m_history[frame % RENDER_STATS_HISTORY_FRAMES][RENDER_STAT_DRAW_CALLS];
+    }
+    ImGui::PlotLines("draw calls", drawCalls, m_numHistory, 0, NULL, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+
+    ImGui::End();
+}
+
+bool RenderStats::WriteCSV(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::fprintf(file, "frame");
+    for (unsigned int stat = 0; stat < RENDER_STAT_COUNT; ++stat)
+    {
+        std::fprintf(file, ",%s", s_statNames[stat]);
+    }
+    std::fprintf(file, "\n");
+
+    for (unsigned int i = 0; i < m_numHistory; ++i)
+    {
+        unsigned long long frame = m_frameIndex - m_numHistory + i;
+        const unsigned long long* values = m_history[frame % RENDER_STATS_HISTORY_FRAMES];
+        std::fprintf(file, "%llu", frame);
+        for (unsigned int stat = 0; stat < RENDER_STAT_COUNT; ++stat)
+        {
+            std::fprintf(file, ",%llu", values[stat]);
+        }
+        std::fprintf(file, "\n");
+    }
+    return std::fclose(file) == 0;
+}
+
+bool RenderStats::WriteJSON(const std::string& path) const
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::fprintf(file, "{\n  \"frames\": %llu,\n  \"window\": %u,\n  \"counters\": {\n", m_frameIndex, m_numHistory);
+    for (unsigned int i = 0; i < RENDER_STAT_COUNT; ++i)
+    {
+        RenderStat stat = (RenderStat)i;
+        std::fprintf(file, "    \"%s\": {\"last\": %llu, \"avg\": %.3f, \"max\": %llu, \"total\": %llu}%s\n",
+            s_statNames[i], GetLast(stat), GetAverage(stat), GetMax(stat), GetTotal(stat),
+            i + 1 < RENDER_STAT_COUNT ? "," : "");
+    }
+    std::fprintf(file, "  }\n}\n");
+    return std::fclose(file) == 0;
+}
+
+std::string RenderStats::GetReport() const
+{
+    std::ostringstream report;
+    report.setf(std::ios::fixed);
+    report.precision(1);
+    report << "Render stats: " << m_frameIndex << " frames, average of the last " << m_numHistory;
+    for (unsigned int i = 0; i < RENDER_STAT_COUNT; ++i)
+    {
+        RenderStat stat = (RenderStat)i;
+        report << "\n  " << s_statNames[i] << ": " << GetAverage(stat) << " avg, " << GetMax(stat) << " max";
+    }
+    return report.str();
+}
@@ -0,0 +1,76 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <EntityStore.h>
+#include <Model.h>
+#include <Profiler.h>
+#include <SHADER.h>
+#include <TileRenderer.h>
+
+#include <SceneComponents.h>
+
+void UpdateWorldTransforms(EntityStore& store)
+{
+    PROFILE_SCOPE("UpdateWorldTransforms");
+    store.ParallelForEachChunk<TransformComponent, WorldTransformComponent>([](unsigned int count, const Entity*,
+        TransformComponent* transforms, WorldTransformComponent* worlds)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const TransformComponent& transform = transforms[i];
+            glm::mat4 world = glm::mat4_cast(transform.rotation);
+            world[0] *= transform.scale.x;
+            world[1] *= transform.scale.y;
+            world[2] *= transform.scale.z;
+            world[3] = glm::vec4(transform.position, 1.0f);
+            worlds[i].world = world;
+        }
+    });
+}
+
+void GetActiveCameras(EntityStore& store, std::vector<CameraComponent>& cameras)
+{
+    cameras.clear();
+    store.ForEach<CameraComponent>([&cameras](Entity, CameraComponent& camera)
+    {
+        if (camera.active && camera.camera)
+        {
+            cameras.push_back(camera);
+        }
+    });
+    std::stable_sort(cameras.begin(), cameras.end(), [](const CameraComponent& a, const CameraComponent& b)
+    {
+        return a.order < b.order;
+    });
+}
+
+void DrawRenderables(EntityStore& store)
+{
+    PROFILE_SCOPE("DrawRenderables");
+    Shader* current = NULL;
+    store.ForEach<RenderableComponent, WorldTransformComponent>([&current](Entity, RenderableComponent& renderable,
+        WorldTransformComponent& world)
+    {
+        if (renderable.shader != current)
+        {
+            current = renderable.shader;
+            current->Use();
+        }
+        renderable.model->Draw(*renderable.shader, world.world);
+    });
+}
+
+void DrawTileLayers(EntityStore& store)
+{
+    PROFILE_SCOPE("DrawTileLayers");
+    store.ForEach<TileLayerComponent>([](Entity, TileLayerComponent& layer)
+    {
+        // Only chunks that were edited get their buffers rebuilt
+        layer.renderer->RebuildDirtyChunks();
+        layer.shader->Use();
+        layer.renderer->Draw();
+    });
+}
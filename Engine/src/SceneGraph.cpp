@@ -0,0 +1,351 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <JobSystem.h>
+#include <Profiler.h>
+
+#include <SceneGraph.h>
+
+////////////////// NODES /////////////////////////
+
+SceneNode SceneGraph::Create(SceneNode parent, const glm::mat4& local)
+{
+    unsigned int parentIndex = SCENE_NODE_NONE;
+    if (parent != SCENE_NODE_NONE)
+    {
+        if (!IsValid(parent))
+        {
+            std::cout << "ERROR::SCENE_GRAPH::INVALID_PARENT " << parent << std::endl;
+            return SCENE_NODE_NONE;
+        }
+        parentIndex = m_index[parent];
+    }
+
+    SceneNode node;
+    if (!m_freeNodes.empty())
+    {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else
+    {
+        node = (SceneNode)m_index.size();
+        m_index.push_back(SCENE_NODE_NONE);
+    }
+
+    // Appended, which keeps parents first but not subtrees together, so it's sorted before the next update
+    unsigned int index = (unsigned int)m_node.size();
+    m_index[node] = index;
+    m_local.push_back(local);
+    m_world.push_back(local);
+    m_parent.push_back(parentIndex);
+    m_subtreeSize.push_back(1);
+    m_node.push_back(node);
+    m_isDirty.push_back(0);
+    MarkDirty(index);
+    m_count++;
+    m_sorted = false;
+    return node;
+}
+
+void SceneGraph::Destroy(SceneNode node)
+{
+    if (!IsValid(node))
+    {
+        return;
+    }
+    // Needs the subtree in one piece
+    if (!m_sorted)
+    {
+        Sort();
+    }
+    unsigned int begin = m_index[node];
+    unsigned int end = begin + m_subtreeSize[begin];
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        m_index[m_node[i]] = SCENE_NODE_NONE;
+        m_freeNodes.push_back(m_node[i]);
+        m_node[i] = SCENE_NODE_NONE;
+    }
+    m_count -= end - begin;
+    // The arrays are compacted by the next sort
+    m_sorted = false;
+}
+
+bool SceneGraph::IsValid(SceneNode node) const
+{
+    return node < m_index.size() && m_index[node] != SCENE_NODE_NONE;
+}
+
+void SceneGraph::Clear()
+{
+    m_local.clear();
+    m_world.clear();
+    m_parent.clear();
+    m_subtreeSize.clear();
+    m_node.clear();
+    m_isDirty.clear();
+    m_dirty.clear();
+    m_index.clear();
+    m_freeNodes.clear();
+    m_count = 0;
+    m_sorted = true;
+}
+
+bool SceneGraph::SetParent(SceneNode node, SceneNode parent)
+{
+    if (!IsValid(node) || (parent != SCENE_NODE_NONE && !IsValid(parent)))
+    {
+        return false;
+    }
+    unsigned int index = m_index[node];
+    unsigned int parentIndex = parent == SCENE_NODE_NONE ? SCENE_NODE_NONE : m_index[parent];
+    for (unsigned int ancestor = parentIndex; ancestor != SCENE_NODE_NONE; ancestor = m_parent[ancestor])
+    {
+        if (ancestor == index)
+        {
+            std::cout << "ERROR::SCENE_GRAPH::CYCLE " << parent << " is under " << node << std::endl;
+            return false;
+        }
+    }
+    if (m_parent[index] == parentIndex)
+    {
+        return true;
+    }
+    m_parent[index] = parentIndex;
+    MarkDirty(index);
+    m_sorted = false;
+    return true;
+}
+
+SceneNode SceneGraph::GetParent(SceneNode node) const
+{
+    unsigned int parentIndex = m_parent[m_index[node]];
+    return parentIndex == SCENE_NODE_NONE ? SCENE_NODE_NONE : m_node[parentIndex];
+}
+
+void SceneGraph::SetLocal(SceneNode node, const glm::mat4& local)
+{
+    unsigned int index = m_index[node];
+    m_local[index] = local;
+    MarkDirty(index);
+}
+
+const glm::mat4& SceneGraph::GetLocal(SceneNode node) const
+{
+    return m_local[m_index[node]];
+}
+
+const glm::mat4& SceneGraph::GetWorld(SceneNode node) const
+{
+    return m_world[m_index[node]];
+}
+
+unsigned int SceneGraph::GetCount() const
+{
+    return m_count;
+}
+
+void SceneGraph::MarkDirty(unsigned int index)
+{
+    if (!m_isDirty[index])
+    {
+        m_isDirty[index] = 1;
+        m_dirty.push_back(index);
+    }
+}
+
+////////////////// ORDERING /////////////////////////
+
+void SceneGraph::Sort()
+{
+    PROFILE_SCOPE("SceneGraphSort");
+    unsigned int size = (unsigned int)m_node.size();
+
+    // Children of each node, in their current order, packed into one array
+    std::vector<unsigned int> firstChild(size + 1, 0);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (m_node[i] != SCENE_NODE_NONE && m_parent[i] != SCENE_NODE_NONE)
+        {
+            firstChild[m_parent[i] + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        firstChild[i + 1] += firstChild[i];
+    }
+    std::vector<unsigned int> children(firstChild[size]);
+    std::vector<unsigned int> filled(firstChild.begin(), firstChild.end() - 1);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (m_node[i] != SCENE_NODE_NONE && m_parent[i] != SCENE_NODE_NONE)
+        {
+            children[filled[m_parent[i]]++] = i;
+        }
+    }
+
+    // Depth first from each root. Children go on the stack backwards so they come off in order
+    std::vector<unsigned int> order;
+    order.reserve(m_count);
+    std::vector<unsigned int> stack;
+    for (unsigned int root = 0; root < size; ++root)
+    {
+        if (m_node[root] == SCENE_NODE_NONE || m_parent[root] != SCENE_NODE_NONE)
+        {
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            unsigned int i = stack.back();
+            stack.pop_back();
+            order.push_back(i);
+            for (unsigned int c = firstChild[i + 1]; c > firstChild[i]; --c)
+            {
+                stack.push_back(children[c - 1]);
+            }
+        }
+    }
+
+    std::vector<unsigned int> newIndex(size, SCENE_NODE_NONE);
+    for (unsigned int i = 0; i < (unsigned int)order.size(); ++i)
+    {
+        newIndex[order[i]] = i;
+    }
+    std::vector<glm::mat4> local(order.size());
+    std::vector<glm::mat4> world(order.size());
+    std::vector<unsigned int> parent(order.size());
+    std::vector<SceneNode> node(order.size());
+    std::vector<unsigned char> isDirty(order.size());
+    for (unsigned int i = 0; i < (unsigned int)order.size(); ++i)
+    {
+        unsigned int old = order[i];
+        local[i] = m_local[old];
+        world[i] = m_world[old];
+        parent[i] = m_parent[old] == SCENE_NODE_NONE ? SCENE_NODE_NONE : newIndex[m_parent[old]];
+        node[i] = m_node[old];
+        isDirty[i] = m_isDirty[old];
+        m_index[node[i]] = i;
+    }
+    m_local.swap(local);
+    m_world.swap(world);
+    m_parent.swap(parent);
+    m_node.swap(node);
+    m_isDirty.swap(isDirty);
+
+    // Children come after their parents, so walking backwards adds each finished subtree to its parent
+    m_subtreeSize.assign(order.size(), 1);
+    for (unsigned int i = (unsigned int)order.size(); i-- > 0;)
+    {
+        if (m_parent[i] != SCENE_NODE_NONE)
+        {
+            m_subtreeSize[m_parent[i]] += m_subtreeSize[i];
+        }
+    }
+
+    m_dirty.clear();
+    for (unsigned int i = 0; i < (unsigned int)order.size(); ++i)
+    {
+        if (m_isDirty[i])
+        {
+            m_dirty.push_back(i);
+        }
+    }
+    m_sorted = true;
+}
+
+////////////////// UPDATE /////////////////////////
+
+void SceneGraph::UpdateRange(unsigned int begin, unsigned int end)
+{
+    // begin's parent is outside the range and already up to date, the rest have theirs earlier in it
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        unsigned int parent = m_parent[i];
+        m_world[i] = parent == SCENE_NODE_NONE ? m_local[i] : m_world[parent] * m_local[i];
+    }
+}
+
+unsigned int SceneGraph::Update()
+{
+    if (!m_sorted)
+    {
+        Sort();
+    }
+    if (m_dirty.empty())
+    {
+        return 0;
+    }
+    PROFILE_SCOPE("SceneGraphUpdate");
+
+    // In index order a dirty node under another one falls inside its range, so only the
+    // topmost dirty nodes are kept
+    std::sort(m_dirty.begin(), m_dirty.end());
+    std::vector<unsigned int> roots;
+    unsigned int coveredEnd = 0;
+    for (unsigned int index : m_dirty)
+    {
+        m_isDirty[index] = 0;
+        if (index >= coveredEnd)
+        {
+            roots.push_back(index);
+            coveredEnd = index + m_subtreeSize[index];
+        }
+    }
+    m_dirty.clear();
+
+    // Big subtrees do their root here and hand each child's subtree on as a separate piece
+    std::vector<unsigned int> pieces;
+    unsigned int numUpdated = 0;
+    while (!roots.empty())
+    {
+        unsigned int root = roots.back();
+        roots.pop_back();
+        if (m_subtreeSize[root] <= SCENE_GRAPH_SPLIT_SIZE)
+        {
+            pieces.push_back(root);
+            numUpdated += m_subtreeSize[root];
+            continue;
+        }
+        UpdateRange(root, root + 1);
+        numUpdated++;
+        for (unsigned int child = root + 1; child < root + m_subtreeSize[root]; child += m_subtreeSize[child])
+        {
+            roots.push_back(child);
+        }
+    }
+
+    // Pieces grouped into jobs of about the same number of nodes
+    std::vector<unsigned int> jobStart(1, 0);
+    unsigned int jobNodes = 0;
+    for (unsigned int i = 0; i < (unsigned int)pieces.size(); ++i)
+    {
+        jobNodes += m_subtreeSize[pieces[i]];
+        if (jobNodes >= SCENE_GRAPH_JOB_NODES)
+        {
+            jobStart.push_back(i + 1);
+            jobNodes = 0;
+        }
+    }
+    if (jobStart.back() != pieces.size())
+    {
+        jobStart.push_back((unsigned int)pieces.size());
+    }
+
+    JobSystem::Get().ParallelFor((unsigned int)jobStart.size() - 1, 1, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int job = begin; job < end; ++job)
+        {
+            for (unsigned int i = jobStart[job]; i < jobStart[job + 1]; ++i)
+            {
+                unsigned int root = pieces[i];
+                UpdateRange(root, root + m_subtreeSize[root]);
+            }
+        }
+    });
+    return numUpdated;
+}
@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <RenderDevice.h>
+
+#include <ShaderCache.h>
+
+#define SHADER_CACHE_MAGIC "SBIN"
+
+// What's written before the binary itself
+struct ShaderCacheHeader
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long key;
+    unsigned int format;
+    unsigned int size;
+};
+
+ShaderCache& ShaderCache::Get()
+{
+    static ShaderCache cache;
+    return cache;
+}
+
+void ShaderCache::SetDirectory(const std::string& directory)
+{
+    m_directory = directory;
+}
+
+const std::string& ShaderCache::GetDirectory() const
+{
+    return m_directory;
+}
+
+void ShaderCache::SetEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool ShaderCache::IsEnabled() const
+{
+    return m_enabled;
+}
+
+////////////////// KEYS /////////////////////////
+
+static void HashBytes(unsigned long long& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+unsigned long long ShaderCache::MakeKey(const std::vector<std::string>& sources)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (const std::string& source : sources)
+    {
+        HashBytes(hash, source.data(), source.size());
+        // Separates the parts, so moving text from one source to the next changes the key
+        unsigned long long length = source.size();
+        HashBytes(hash, &length, sizeof(length));
+    }
+    std::string driver = RenderDevice::Get()->GetDriverString();
+    HashBytes(hash, driver.data(), driver.size());
+    return hash;
+}
+
+std::string ShaderCache::GetPath(unsigned long long key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return m_directory + "/" + name;
+}
+
+////////////////// LOADING AND SAVING /////////////////////////
+
+bool ShaderCache::Load(unsigned long long key, unsigned int program)
+{
+    if (!m_enabled)
+    {
+        return false;
+    }
+    FILE* file = fopen(GetPath(key).c_str(), "rb");
+    if (!file)
+    {
+        m_stats.misses++;
+        return false;
+    }
+
+    ShaderCacheHeader header;
+    std::vector<unsigned char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, SHADER_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == SHADER_CACHE_VERSION && header.key == key && header.size > 0;
+    if (valid)
+    {
+        binary.resize(header.size);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        // Cut short or from another version, it gets overwritten once the program is rebuilt
+        m_stats.misses++;
+        return false;
+    }
+    if (!RenderDevice::Get()->ProgramBinary(program, header.format, binary.data(), binary.size()))
+    {
+        m_stats.rejected++;
+        return false;
+    }
+    m_stats.hits++;
+    return true;
+}
+
+void ShaderCache::Store(unsigned long long key, unsigned int program)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    std::vector<unsigned char> binary;
+    GLenum format = 0;
+    if (!RenderDevice::Get()->GetProgramBinary(program, binary, format) || binary.empty())
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    // Written next to it and moved into place, so another instance starting up never reads half a file
+    std::string path = GetPath(key);
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "Couldn't write the shader cache to " << m_directory << std::endl;
+        return;
+    }
+
+    ShaderCacheHeader header;
+    memcpy(header.magic, SHADER_CACHE_MAGIC, sizeof(header.magic));
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.size = (unsigned int)binary.size();
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+    written = fclose(file) == 0 && written;
+
+    if (written)
+    {
+        std::filesystem::rename(tempPath, path, error);
+        written = !error;
+    }
+    if (!written)
+    {
+        std::filesystem::remove(tempPath, error);
+        std::cout << "Couldn't write the shader cache to " << m_directory << std::endl;
+        return;
+    }
+    m_stats.stores++;
+}
+
+////////////////// STATS /////////////////////////
+
+void ShaderCache::AddTime(bool fromCache, double ms)
+{
+    if (fromCache)
+    {
+        m_stats.loadMs += ms;
+    }
+    else
+    {
+        m_stats.compiled++;
+        m_stats.compileMs += ms;
+    }
+}
+
+const ShaderCache::Stats& ShaderCache::GetStats() const
+{
+    return m_stats;
+}
+
+std::string ShaderCache::GetReport() const
+{
+    std::ostringstream report;
+    report << "Shaders: " << m_stats.hits << " from cache in " << m_stats.loadMs << " ms, "
+        << m_stats.compiled << " compiled in " << m_stats.compileMs << " ms";
+    if (m_stats.rejected > 0)
+    {
+        report << " (" << m_stats.rejected << " rejected by the driver)";
+    }
+    if (!m_enabled)
+    {
+        report << " (cache off)";
+    }
+    return report.str();
+}
@@ -0,0 +1,552 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <FileWatcher.h>
+#include <Profiler.h>
+#include <RenderDevice.h>
+#include <SHADER.h>
+#include <ShaderCache.h>
+#include <UploadThread.h>
+
+#include <ShaderLibrary.h>
+
+ShaderLibrary& ShaderLibrary::Get()
+{
+    static ShaderLibrary library;
+    return library;
+}
+
+////////////////// REGISTRY /////////////////////////
+
+void ShaderLibrary::Register(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+    const std::string& geometryPath)
+{
+    Entry entry;
+    entry.vertexPath = vertexPath;
+    entry.fragmentPath = fragmentPath;
+    entry.geometryPath = geometryPath;
+    m_entries[name] = entry;
+
+    // Built programs stay, another name may be sharing them
+    std::string prefix = name + "#";
+    for (auto it = m_permutations.begin(); it != m_permutations.end();)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) == 0)
+        {
+            it = m_permutations.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool ShaderLibrary::IsRegistered(const std::string& name) const
+{
+    return m_entries.count(name) != 0;
+}
+
+Shader* ShaderLibrary::GetShader(const std::string& name, unsigned int features)
+{
+    auto found = m_entries.find(name);
+    if (found == m_entries.end())
+    {
+        std::cout << "ERROR::SHADER_LIBRARY::NOT_REGISTERED " << name << std::endl;
+        return NULL;
+    }
+    Entry& entry = found->second;
+    if (!entry.expanded)
+    {
+        // Still builds on failure, like a Shader with a missing file, so callers always get a program
+        Expand(entry);
+    }
+
+    features &= entry.usedFeatures;
+    std::string permutation = name + "#" + std::to_string(features);
+    auto known = m_permutations.find(permutation);
+    if (known != m_permutations.end())
+    {
+        return known->second;
+    }
+
+    std::string defines = GetDefines(features);
+    std::string vertex = InsertDefines(entry.vertexSource, defines);
+    std::string fragment = InsertDefines(entry.fragmentSource, defines);
+    std::string geometry = entry.geometryPath.empty() ? "" : InsertDefines(entry.geometrySource, defines);
+
+    std::unique_ptr<Shader>& program = m_programs[MakeProgramKey(vertex, fragment, geometry)];
+    if (!program)
+    {
+        program.reset(new Shader());
+        program->Build(vertex, fragment, geometry);
+    }
+    m_permutations[permutation] = program.get();
+    return program.get();
+}
+
+unsigned int ShaderLibrary::Poll()
+{
+    unsigned int compiling = 0;
+    for (auto& program : m_programs)
+    {
+        Shader& shader = *program.second;
+        if (!shader.IsPending())
+        {
+            continue;
+        }
+        if (shader.IsReady())
+        {
+            shader.Finish();
+        }
+        else
+        {
+            compiling++;
+        }
+    }
+    return compiling;
+}
+
+void ShaderLibrary::FinishAll()
+{
+    for (auto& program : m_programs)
+    {
+        program.second->Finish();
+    }
+}
+
+void ShaderLibrary::Clear()
+{
+    // Reloads still on the loader thread are for shaders about to be deleted
+    m_generation++;
+    RenderDevice* device = RenderDevice::Get();
+    for (auto& program : m_programs)
+    {
+        // Also deletes the stages of programs that were never used
+        program.second->Finish();
+        device->DeleteProgram(program.second->ID);
+    }
+    m_programs.clear();
+    m_permutations.clear();
+    for (auto& entry : m_entries)
+    {
+        Entry& cleared = entry.second;
+        cleared.expanded = false;
+        cleared.vertexSource.clear();
+        cleared.fragmentSource.clear();
+        cleared.geometrySource.clear();
+        cleared.usedFeatures = 0;
+        cleared.files.clear();
+    }
+}
+
+unsigned int ShaderLibrary::GetNumPrograms() const
+{
+    return (unsigned int)m_programs.size();
+}
+
+unsigned int ShaderLibrary::GetNumPermutations() const
+{
+    return (unsigned int)m_permutations.size();
+}
+
+std::string ShaderLibrary::MakeProgramKey(const std::string& vertex, const std::string& fragment,
+    const std::string& geometry)
+{
+    return vertex + '\0' + fragment + '\0' + geometry;
+}
+
+////////////////// HOT RELOAD /////////////////////////
+
+void ShaderLibrary::EnableHotReload(std::function<void()> wake)
+{
+    m_wake = wake;
+    if (!m_watcher)
+    {
+        m_watcher.reset(new FileWatcher(wake));
+    }
+    for (auto& named : m_entries)
+    {
+        for (const std::string& file : named.second.files)
+        {
+            m_watcher->Watch(file);
+        }
+    }
+}
+
+bool ShaderLibrary::IsHotReloadEnabled() const
+{
+    return m_watcher != NULL;
+}
+
+unsigned int ShaderLibrary::Update()
+{
+    if (!m_watcher)
+    {
+        return 0;
+    }
+
+    std::vector<std::string> changed;
+    m_watcher->TakeChanges(changed);
+    if (!changed.empty())
+    {
+        PROFILE_SCOPE("ShaderReload");
+        for (auto& named : m_entries)
+        {
+            Entry& entry = named.second;
+            // Nothing built from it yet, the next GetShader reads the new files anyway
+            if (!entry.expanded)
+            {
+                continue;
+            }
+            for (const std::string& file : changed)
+            {
+                if (std::find(entry.files.begin(), entry.files.end(), file) != entry.files.end())
+                {
+                    StartReload(named.first, entry);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<Reload> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_reloadMutex);
+        finished.swap(m_reloaded);
+    }
+    unsigned int swapped = 0;
+    for (Reload& reload : finished)
+    {
+        if (FinishReload(reload))
+        {
+            swapped++;
+        }
+    }
+    return swapped;
+}
+
+void ShaderLibrary::StartReload(const std::string& name, Entry& entry)
+{
+    // Reread from scratch, the edit may have added or dropped an include
+    Expand(entry);
+
+    // One per permutation, even where names share a program. Their sources can differ after the
+    // edit, and FinishReload sorts out which Shader each one ends up in
+    std::string prefix = name + "#";
+    for (auto& permutation : m_permutations)
+    {
+        if (permutation.first.compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        unsigned int features = (unsigned int)std::stoul(permutation.first.substr(prefix.size())) & entry.usedFeatures;
+        std::string defines = GetDefines(features);
+
+        std::shared_ptr<Reload> reload(new Reload());
+        reload->name = permutation.first;
+        reload->vertex = InsertDefines(entry.vertexSource, defines);
+        reload->fragment = InsertDefines(entry.fragmentSource, defines);
+        reload->geometry = entry.geometryPath.empty() ? "" : InsertDefines(entry.geometrySource, defines);
+        reload->generation = m_generation;
+        reload->start = std::chrono::steady_clock::now();
+
+        // Waiting on the driver is fine on the loader thread, the render thread never does
+        std::function<void()> build = [reload]
+        {
+            reload->program = Shader::CompileNow(reload->vertex, reload->fragment, reload->geometry, reload->log);
+        };
+        std::function<void()> built = [this, reload]
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_reloadMutex);
+                m_reloaded.push_back(*reload);
+            }
+            if (m_wake)
+            {
+                m_wake();
+            }
+        };
+        // No loader thread, it stalls this frame instead
+        if (!UploadThread::Get().Submit(build, built))
+        {
+            build();
+            built();
+        }
+    }
+}
+
+bool ShaderLibrary::FinishReload(Reload& reload)
+{
+    RenderDevice* device = RenderDevice::Get();
+    if (reload.generation != m_generation)
+    {
+        if (reload.program)
+        {
+            device->DeleteProgram(reload.program);
+        }
+        return false;
+    }
+    if (!reload.program)
+    {
+        std::cout << "ERROR::SHADER_HOT_RELOAD " << reload.name << " failed, keeping the old program\n"
+            << reload.log << std::endl;
+        return false;
+    }
+
+    // Registered again since
+    auto permutation = m_permutations.find(reload.name);
+    if (permutation == m_permutations.end())
+    {
+        device->DeleteProgram(reload.program);
+        return false;
+    }
+    // Whatever it resolves to now, an earlier reload may have moved it
+    Shader* shader = permutation->second;
+
+    // Every program in m_programs has to match the sources it's filed under, so the reload only
+    // goes into the same Shader if that Shader isn't also standing in for something else
+    bool shared = false;
+    for (auto& other : m_permutations)
+    {
+        if (other.second == shader && other.first != reload.name)
+        {
+            shared = true;
+            break;
+        }
+    }
+    std::string key = MakeProgramKey(reload.vertex, reload.fragment, reload.geometry);
+    std::unique_ptr<Shader>& filed = m_programs[key];
+    if (filed && filed.get() != shader)
+    {
+        // Now the same as a program that's already built, which nobody else has to give up
+        device->DeleteProgram(reload.program);
+        permutation->second = filed.get();
+    }
+    else if (shared && !filed)
+    {
+        // The other names keep the old program in the old Shader
+        filed.reset(new Shader());
+        filed->Replace(reload.program);
+        permutation->second = filed.get();
+        ShaderCache::Get().Store(ShaderCache::MakeKey({ reload.vertex, reload.fragment, reload.geometry }), reload.program);
+    }
+    else
+    {
+        // Only this permutation uses it, or the sources didn't change. Swapped in place, and
+        // refiled under the new sources if they did change
+        device->DeleteProgram(shader->Replace(reload.program));
+        if (!filed)
+        {
+            for (auto it = m_programs.begin(); it != m_programs.end(); ++it)
+            {
+                if (it->second.get() == shader)
+                {
+                    filed = std::move(it->second);
+                    m_programs.erase(it);
+                    break;
+                }
+            }
+        }
+        ShaderCache::Get().Store(ShaderCache::MakeKey({ reload.vertex, reload.fragment, reload.geometry }), reload.program);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reload.start).count();
+    std::cout << "Reloaded shader " << reload.name << " in " << ms << " ms" << std::endl;
+    return true;
+}
+
+////////////////// FEATURES /////////////////////////
+
+const char* ShaderLibrary::GetFeatureName(Shader_Feature feature)
+{
+    switch (feature)
+    {
+    case SHADER_SKINNED:
+        return "SKINNED";
+    case SHADER_INSTANCED:
+        return "INSTANCED";
+    case SHADER_NORMAL_MAP:
+        return "NORMAL_MAP";
+    case SHADER_ALPHA_TEST:
+        return "ALPHA_TEST";
+    }
+    return "";
+}
+
+std::string ShaderLibrary::GetDefines(unsigned int features)
+{
+    std::string defines;
+    for (unsigned int i = 0; i < SHADER_FEATURE_COUNT; ++i)
+    {
+        if (features & (1u << i))
+        {
+            defines += "#define ";
+            defines += GetFeatureName((Shader_Feature)(1u << i));
+            defines += "\n";
+        }
+    }
+    return defines;
+}
+
+static bool IsIdentifierChar(char c)
+{
+    return std::isalnum((unsigned char)c) || c == '_';
+}
+
+// Whole words only, so NORMAL_MAP doesn't count as using a NORMAL feature
+static bool ContainsWord(const std::string& source, const std::string& word)
+{
+    for (size_t at = source.find(word); at != std::string::npos; at = source.find(word, at + 1))
+    {
+        bool startsWord = at == 0 || !IsIdentifierChar(source[at - 1]);
+        size_t end = at + word.size();
+        bool endsWord = end == source.size() || !IsIdentifierChar(source[end]);
+        if (startsWord && endsWord)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int ShaderLibrary::FindFeatures(const std::string& source)
+{
+    unsigned int features = 0;
+    for (unsigned int i = 0; i < SHADER_FEATURE_COUNT; ++i)
+    {
+        if (ContainsWord(source, GetFeatureName((Shader_Feature)(1u << i))))
+        {
+            features |= 1u << i;
+        }
+    }
+    return features;
+}
+
+////////////////// PREPROCESSING /////////////////////////
+
+bool ShaderLibrary::Expand(Entry& entry)
+{
+    bool loaded = true;
+    std::unordered_set<std::string> files;
+    std::unordered_set<std::string> included;
+    entry.vertexSource.clear();
+    entry.fragmentSource.clear();
+    entry.geometrySource.clear();
+    loaded = Preprocess(entry.vertexPath, included, entry.vertexSource) && loaded;
+    files.insert(included.begin(), included.end());
+    included.clear();
+    loaded = Preprocess(entry.fragmentPath, included, entry.fragmentSource) && loaded;
+    files.insert(included.begin(), included.end());
+    if (!entry.geometryPath.empty())
+    {
+        included.clear();
+        loaded = Preprocess(entry.geometryPath, included, entry.geometrySource) && loaded;
+        files.insert(included.begin(), included.end());
+    }
+    entry.usedFeatures = FindFeatures(entry.vertexSource) | FindFeatures(entry.fragmentSource) |
+        FindFeatures(entry.geometrySource);
+    entry.files.assign(files.begin(), files.end());
+    entry.expanded = true;
+
+    if (m_watcher)
+    {
+        for (const std::string& file : entry.files)
+        {
+            m_watcher->Watch(file);
+        }
+    }
+    return loaded;
+}
+
+bool ShaderLibrary::Preprocess(const std::string& path, std::unordered_set<std::string>& included, std::string& out)
+{
+    // The same file reached through different relative paths still only goes in once
+    if (!included.insert(FileWatcher::Normalize(path)).second)
+    {
+        return true;
+    }
+
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string source = stream.str();
+    // Saved with a BOM, #version wouldn't be at the very start of the source
+    if (source.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    {
+        source.erase(0, 3);
+    }
+
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    bool loaded = true;
+    size_t lineStart = 0;
+    while (lineStart < source.size())
+    {
+        size_t lineEnd = source.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+
+        size_t first = source.find_first_not_of(" \t", lineStart);
+        if (first < lineEnd && source.compare(first, 8, "#include") == 0)
+        {
+            size_t open = source.find('"', first);
+            size_t close = open < lineEnd ? source.find('"', open + 1) : std::string::npos;
+            if (close >= lineEnd)
+            {
+                std::cout << "ERROR::SHADER::BAD_INCLUDE in " << path << ": "
+                    << source.substr(first, lineEnd - first) << std::endl;
+                loaded = false;
+            }
+            else
+            {
+                std::string includePath = (directory / source.substr(open + 1, close - open - 1)).string();
+                loaded = Preprocess(includePath, included, out) && loaded;
+                if (!out.empty() && out.back() != '\n')
+                {
+                    out += '\n';
+                }
+            }
+        }
+        else
+        {
+            out.append(source, lineStart, lineEnd - lineStart);
+        }
+        lineStart = lineEnd;
+    }
+    return loaded;
+}
+
+std::string ShaderLibrary::InsertDefines(const std::string& source, const std::string& defines)
+{
+    if (defines.empty())
+    {
+        return source;
+    }
+    // #version has to stay the first thing in the source
+    size_t version = source.find("#version");
+    if (version == std::string::npos)
+    {
+        return defines + source;
+    }
+    size_t lineEnd = source.find('\n', version);
+    if (lineEnd == std::string::npos)
+    {
+        return source + "\n" + defines;
+    }
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
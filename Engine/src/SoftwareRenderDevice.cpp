@@ -0,0 +1,1897 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SOFTWARE_USE_SSE2
+#endif
+
+#include <SoftwareRenderDevice.h>
+#include <Profiler.h>
+
+// Vertices and primitives are handed to workers in batches this big
+#define TRANSFORM_BATCH_SIZE 1024
+#define SETUP_BATCH_SIZE 1024
+// Any edge function value past this has the same sign over a whole tile, see RasterizeTriangle
+#define EDGE_CLAMP (1 << 30)
+
+////////////////// WORKERS /////////////////////////
+
+// Threads that sleep between ParallelFor calls. The calling thread works too, so a pool for
+// n threads only starts n - 1
+struct SoftwareRenderDevice::WorkerPool
+{
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = NULL;
+    size_t jobCount = 0;
+    std::atomic<size_t> next{ 0 };
+    unsigned int generation = 0;
+    unsigned int busy = 0;
+    bool quit = false;
+
+    void RunJob()
+    {
+        for (size_t i = next++; i < jobCount; i = next++)
+        {
+            (*job)(i);
+        }
+    }
+
+    void WorkerLoop()
+    {
+        unsigned int seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit)
+            {
+                return;
+            }
+            seen = generation;
+            lock.unlock();
+            RunJob();
+            lock.lock();
+            if (--busy == 0)
+            {
+                done.notify_all();
+            }
+        }
+    }
+};
+
+void SoftwareRenderDevice::ParallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (m_pool->threads.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_pool->mutex);
+        m_pool->job = &job;
+        m_pool->jobCount = count;
+        m_pool->next = 0;
+        m_pool->busy = (unsigned int)m_pool->threads.size();
+        m_pool->generation++;
+    }
+    m_pool->wake.notify_all();
+    m_pool->RunJob();
+
+    // Every worker has to check in before the next call can reuse the job fields
+    std::unique_lock<std::mutex> lock(m_pool->mutex);
+    m_pool->done.wait(lock, [&] { return m_pool->busy == 0; });
+}
+
+////////////////// HELPERS /////////////////////////
+
+// An attribute with its buffer already looked up, so the per vertex reads don't hash anything
+struct ResolvedAttrib
+{
+    const uint8_t* data = NULL;
+    size_t size = 0;
+    size_t stride = 0;
+    size_t offset = 0;
+    int components = 0;
+    GLenum type = GL_FLOAT;
+    bool normalized = false;
+};
+
+static size_t GetTypeSize(GLenum type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE: return 1;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
+    }
+}
+
+static float ReadComponent(const uint8_t* p, GLenum type, bool normalized)
+{
+    switch (type)
+    {
+        case GL_FLOAT: { float v; std::memcpy(&v, p, 4); return v; }
+        case GL_INT: { int32_t v; std::memcpy(&v, p, 4); return (float)v; }
+        case GL_UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p, 4); return (float)v; }
+        case GL_SHORT: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+        case GL_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : v; }
+        case GL_BYTE: { int8_t v = (int8_t)*p; return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+        case GL_UNSIGNED_BYTE: return normalized ? *p / 255.0f : *p;
+        default: return 0.0f;
+    }
+}
+
+// Missing components get GL's defaults, (0, 0, 0, 1)
+static void ReadAttrib(const ResolvedAttrib& attrib, uint32_t index, float* out, int numComponents)
+{
+    for (int i = 0; i < numComponents; ++i)
+    {
+        out[i] = (i == 3) ? 1.0f : 0.0f;
+    }
+    if (!attrib.data)
+    {
+        return;
+    }
+    size_t typeSize = GetTypeSize(attrib.type);
+    size_t start = attrib.offset + (size_t)index * attrib.stride;
+    int count = std::min(numComponents, attrib.components);
+    if (start + count * typeSize > attrib.size)
+    {
+        return;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = ReadComponent(attrib.data + start + i * typeSize, attrib.type, attrib.normalized);
+    }
+}
+
+// Name of the first "uniform <type> <name>;" in a shader, empty if there isn't one
+static std::string FindUniformName(const std::string& source, const std::string& type)
+{
+    std::string pattern = "uniform " + type + " ";
+    size_t found = source.find(pattern);
+    if (found == std::string::npos)
+    {
+        return "";
+    }
+    size_t start = found + pattern.size();
+    size_t end = start;
+    while (end < source.size() && (std::isalnum((unsigned char)source[end]) || source[end] == '_'))
+    {
+        end++;
+    }
+    return source.substr(start, end - start);
+}
+
+// Signed distance to each clip plane: -x, +x, -y, +y, near, far. Inside when >= 0
+static float ClipDistance(const glm::vec4& p, int plane)
+{
+    switch (plane)
+    {
+        case 0: return p.w + p.x;
+        case 1: return p.w - p.x;
+        case 2: return p.w + p.y;
+        case 3: return p.w - p.y;
+        case 4: return p.w + p.z;
+        default: return p.w - p.z;
+    }
+}
+
+template <typename T>
+static T LerpVertex(const T& a, const T& b, float t)
+{
+    T result;
+    result.position = a.position + (b.position - a.position) * t;
+    for (int i = 0; i < SOFTWARE_MAX_VARYINGS; ++i)
+    {
+        result.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t;
+    }
+    return result;
+}
+
+// Floor division by the subpixel scale that also works for negative positions
+static int SubpixelToPixel(int v)
+{
+    return (v >= 0) ? v / SOFTWARE_SUBPIXEL_SCALE : -((-v + SOFTWARE_SUBPIXEL_SCALE - 1) / SOFTWARE_SUBPIXEL_SCALE);
+}
+
+static uint32_t PackColor(const glm::vec4& color)
+{
+    glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return (uint32_t)c.r | ((uint32_t)c.g << 8) | ((uint32_t)c.b << 16) | ((uint32_t)c.a << 24);
+}
+
+// a + (b - a) * weight / 256 on all four channels at once, two channels per 32 bit multiply
+static uint32_t LerpTexel(uint32_t a, uint32_t b, uint32_t weight)
+{
+    uint32_t inverse = 256 - weight;
+    uint32_t rb = (((a & 0x00ff00ff) * inverse + (b & 0x00ff00ff) * weight) >> 8) & 0x00ff00ff;
+    uint32_t ga = (((a >> 8) & 0x00ff00ff) * inverse + ((b >> 8) & 0x00ff00ff) * weight) & 0xff00ff00;
+    return rb | ga;
+}
+
+// Truncation rounds toward zero, this rounds down like std::floor without the libm call
+static int FastFloor(float f)
+{
+    int i = (int)f;
+    return (f < i) ? i - 1 : i;
+}
+
+static int MipChainLength(int width, int height)
+{
+    int length = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+    {
+        length++;
+    }
+    return length;
+}
+
+static int WrapCoord(int i, int size, GLenum wrap)
+{
+    // Most lookups land inside the texture already
+    if ((unsigned int)i < (unsigned int)size)
+    {
+        return i;
+    }
+    switch (wrap)
+    {
+        case GL_REPEAT:
+            i %= size;
+            return i < 0 ? i + size : i;
+        case GL_MIRRORED_REPEAT:
+        {
+            int period = size * 2;
+            i %= period;
+            if (i < 0)
+            {
+                i += period;
+            }
+            return i < size ? i : period - 1 - i;
+        }
+        default:
+            return std::min(std::max(i, 0), size - 1);
+    }
+}
+
+// 8 bit texels of any of the GL formats, to the packed RGBA the rasterizer samples
+static void UnpackTexels(const void* data, GLenum format, int width, int height, uint32_t* out, int outStride)
+{
+    int components = (format == GL_RED) ? 1 : (format == GL_RG) ? 2 : (format == GL_RGB) ? 3 : 4;
+    // GL_UNPACK_ALIGNMENT is never changed, so source rows are padded to 4 bytes like GL reads them
+    size_t rowBytes = ((size_t)width * components + 3) & ~(size_t)3;
+    const uint8_t* src = (const uint8_t*)data;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = src + y * rowBytes;
+        for (int x = 0; x < width; ++x)
+        {
+            const uint8_t* p = row + x * components;
+            uint32_t r = p[0];
+            uint32_t g = components > 1 ? p[1] : 0;
+            uint32_t b = components > 2 ? p[2] : 0;
+            uint32_t a = components > 3 ? p[3] : 255;
+            out[(size_t)y * outStride + x] = r | (g << 8) | (b << 16) | (a << 24);
+        }
+    }
+}
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+SoftwareRenderDevice::SoftwareRenderDevice(int width, int height, unsigned int numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_pool = new WorkerPool();
+    for (unsigned int i = 1; i < numThreads; ++i)
+    {
+        m_pool->threads.emplace_back(&WorkerPool::WorkerLoop, m_pool);
+    }
+
+    // Vertex array 0 exists so element buffer bindings made without one still have somewhere to go
+    m_vertexArrays[0];
+    Resize(width, height);
+}
+
+SoftwareRenderDevice::~SoftwareRenderDevice()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pool->mutex);
+        m_pool->quit = true;
+    }
+    m_pool->wake.notify_all();
+    for (std::thread& thread : m_pool->threads)
+    {
+        thread.join();
+    }
+    delete m_pool;
+}
+
+const char* SoftwareRenderDevice::GetName() const
+{
+    return "Software";
+}
+
+bool SoftwareRenderDevice::NeedsContext() const
+{
+    return false;
+}
+
+std::string SoftwareRenderDevice::GetDriverString()
+{
+    return "Software";
+}
+
+void SoftwareRenderDevice::InitContext()
+{
+}
+
+////////////////// BUFFERS /////////////////////////
+
+unsigned int SoftwareRenderDevice::CreateVertexArray()
+{
+    unsigned int vertexArray = m_nextHandle++;
+    m_vertexArrays[vertexArray];
+    return vertexArray;
+}
+
+void SoftwareRenderDevice::DeleteVertexArray(unsigned int vertexArray)
+{
+    if (vertexArray == 0)
+    {
+        return;
+    }
+    m_vertexArrays.erase(vertexArray);
+    if (m_vertexArray == vertexArray)
+    {
+        m_vertexArray = 0;
+    }
+}
+
+void SoftwareRenderDevice::BindVertexArray(unsigned int vertexArray)
+{
+    if (m_vertexArrays.count(vertexArray))
+    {
+        m_vertexArray = vertexArray;
+    }
+}
+
+unsigned int SoftwareRenderDevice::CreateBuffer()
+{
+    unsigned int buffer = m_nextHandle++;
+    m_buffers[buffer];
+    return buffer;
+}
+
+void SoftwareRenderDevice::DeleteBuffer(unsigned int buffer)
+{
+    // Queued primitives are already transformed, so nothing pending reads buffers
+    m_buffers.erase(buffer);
+    if (m_arrayBuffer == buffer)
+    {
+        m_arrayBuffer = 0;
+    }
+}
+
+void SoftwareRenderDevice::BindBuffer(GLenum target, unsigned int buffer)
+{
+    if (target == GL_ARRAY_BUFFER)
+    {
+        m_arrayBuffer = buffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        m_vertexArrays[m_vertexArray].elementBuffer = buffer;
+    }
+}
+
+std::vector<uint8_t>* SoftwareRenderDevice::GetBoundBuffer(GLenum target)
+{
+    unsigned int buffer = 0;
+    if (target == GL_ARRAY_BUFFER)
+    {
+        buffer = m_arrayBuffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        buffer = m_vertexArrays[m_vertexArray].elementBuffer;
+    }
+    auto found = m_buffers.find(buffer);
+    return (buffer != 0 && found != m_buffers.end()) ? &found->second : NULL;
+}
+
+void SoftwareRenderDevice::BufferData(GLenum target, size_t size, const void* data, GLenum usage)
+{
+    std::vector<uint8_t>* buffer = GetBoundBuffer(target);
+    if (!buffer)
+    {
+        return;
+    }
+    buffer->assign(size, 0);
+    if (data)
+    {
+        std::memcpy(buffer->data(), data, size);
+    }
+}
+
+void SoftwareRenderDevice::BufferSubData(GLenum target, size_t offset, size_t size, const void* data)
+{
+    std::vector<uint8_t>* buffer = GetBoundBuffer(target);
+    if (!buffer || offset + size > buffer->size())
+    {
+        return;
+    }
+    std::memcpy(buffer->data() + offset, data, size);
+}
+
+void SoftwareRenderDevice::EnableVertexAttribArray(unsigned int index)
+{
+    if (index < SOFTWARE_MAX_ATTRIBS)
+    {
+        m_vertexArrays[m_vertexArray].attribs[index].enabled = true;
+    }
+}
+
+void SoftwareRenderDevice::VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized,
+    int stride, size_t offset)
+{
+    if (index >= SOFTWARE_MAX_ATTRIBS)
+    {
+        return;
+    }
+    Attrib& attrib = m_vertexArrays[m_vertexArray].attribs[index];
+    attrib.size = size;
+    attrib.type = type;
+    attrib.normalized = normalized;
+    attrib.stride = stride;
+    attrib.offset = offset;
+    attrib.buffer = m_arrayBuffer;
+}
+
+void SoftwareRenderDevice::VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride,
+    size_t offset)
+{
+    VertexAttribPointer(index, size, type, false, stride, offset);
+}
+
+////////////////// TEXTURES /////////////////////////
+
+unsigned int SoftwareRenderDevice::CreateTexture()
+{
+    unsigned int texture = m_nextHandle++;
+    m_textures[texture];
+    return texture;
+}
+
+void SoftwareRenderDevice::DeleteTexture(unsigned int texture)
+{
+    // Queued draws point straight at texture data
+    Flush();
+    m_textures.erase(texture);
+    for (unsigned int& bound : m_boundTextures)
+    {
+        if (bound == texture)
+        {
+            bound = 0;
+        }
+    }
+}
+
+void SoftwareRenderDevice::ActiveTexture(unsigned int unit)
+{
+    m_activeUnit = std::min(unit, (unsigned int)SOFTWARE_MAX_TEXTURE_UNITS - 1);
+}
+
+void SoftwareRenderDevice::BindTexture(GLenum target, unsigned int texture)
+{
+    m_boundTextures[m_activeUnit] = texture;
+}
+
+unsigned int SoftwareRenderDevice::GetBoundTexture() const
+{
+    return m_boundTextures[m_activeUnit];
+}
+
+void SoftwareRenderDevice::TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    auto found = m_textures.find(GetBoundTexture());
+    if (found == m_textures.end() || level < 0 || width <= 0 || height <= 0)
+    {
+        return;
+    }
+    Flush();
+
+    TextureData& texture = found->second;
+    if ((int)texture.levels.size() <= level)
+    {
+        texture.levels.resize(level + 1);
+    }
+    MipLevel& mip = texture.levels[level];
+    mip.width = width;
+    mip.height = height;
+    mip.texels.assign((size_t)width * height, 0xff000000);
+    texture.fullChain = texture.levels[0].width > 0
+        && (int)texture.levels.size() >= MipChainLength(texture.levels[0].width, texture.levels[0].height);
+
+    // Only 8 bit formats are read, anything else stays black like an unfilled texture
+    if (!data || type != GL_UNSIGNED_BYTE)
+    {
+        return;
+    }
+    UnpackTexels(data, format, width, height, mip.texels.data(), width);
+}
+
+void SoftwareRenderDevice::TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+    GLenum format, GLenum type, const void* data)
+{
+    auto found = m_textures.find(GetBoundTexture());
+    if (found == m_textures.end() || level < 0 || level >= (int)found->second.levels.size()
+        || !data || type != GL_UNSIGNED_BYTE)
+    {
+        return;
+    }
+    MipLevel& mip = found->second.levels[level];
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > mip.width || y + height > mip.height)
+    {
+        return;
+    }
+    Flush();
+    UnpackTexels(data, format, width, height, &mip.texels[(size_t)y * mip.width + x], mip.width);
+}
+
+void SoftwareRenderDevice::GenerateMipmap(GLenum target)
+{
+    auto found = m_textures.find(GetBoundTexture());
+    if (found == m_textures.end() || found->second.levels.empty() || found->second.levels[0].texels.empty())
+    {
+        return;
+    }
+    Flush();
+
+    // 2x2 box filter down to 1x1, odd edges reuse their last row/column
+    std::vector<MipLevel>& levels = found->second.levels;
+    levels.resize(1);
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        const MipLevel& src = levels.back();
+        MipLevel dst;
+        dst.width = std::max(1, src.width / 2);
+        dst.height = std::max(1, src.height / 2);
+        dst.texels.resize((size_t)dst.width * dst.height);
+        for (int y = 0; y < dst.height; ++y)
+        {
+            int y0 = std::min(y * 2, src.height - 1);
+            int y1 = std::min(y * 2 + 1, src.height - 1);
+            for (int x = 0; x < dst.width; ++x)
+            {
+                int x0 = std::min(x * 2, src.width - 1);
+                int x1 = std::min(x * 2 + 1, src.width - 1);
+                uint32_t a = src.texels[(size_t)y0 * src.width + x0];
+                uint32_t b = src.texels[(size_t)y0 * src.width + x1];
+                uint32_t c = src.texels[(size_t)y1 * src.width + x0];
+                uint32_t d = src.texels[(size_t)y1 * src.width + x1];
+                uint32_t result = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff)
+                        + ((d >> shift) & 0xff);
+                    result |= ((sum + 2) / 4) << shift;
+                }
+                dst.texels[(size_t)y * dst.width + x] = result;
+            }
+        }
+        levels.push_back(std::move(dst));
+    }
+    found->second.fullChain = true;
+}
+
+void SoftwareRenderDevice::TexParameter(GLenum target, GLenum name, int value)
+{
+    auto found = m_textures.find(GetBoundTexture());
+    if (found == m_textures.end())
+    {
+        return;
+    }
+    Flush();
+    TextureData& texture = found->second;
+    switch (name)
+    {
+        case GL_TEXTURE_MIN_FILTER: texture.minFilter = value; break;
+        case GL_TEXTURE_MAG_FILTER: texture.magFilter = value; break;
+        case GL_TEXTURE_WRAP_S: texture.wrapS = value; break;
+        case GL_TEXTURE_WRAP_T: texture.wrapT = value; break;
+        default: break;
+    }
+}
+
+////////////////// SHADERS /////////////////////////
+
+unsigned int SoftwareRenderDevice::CreateShader(GLenum stage)
+{
+    unsigned int shader = m_nextHandle++;
+    m_shaders[shader].stage = stage;
+    return shader;
+}
+
+void SoftwareRenderDevice::ShaderSource(unsigned int shader, const char* source)
+{
+    auto found = m_shaders.find(shader);
+    if (found != m_shaders.end() && source)
+    {
+        found->second.source = source;
+    }
+}
+
+void SoftwareRenderDevice::CompileShader(unsigned int shader)
+{
+}
+
+bool SoftwareRenderDevice::GetShaderStatus(unsigned int shader, std::string& log)
+{
+    return m_shaders.count(shader) != 0;
+}
+
+void SoftwareRenderDevice::DeleteShader(unsigned int shader)
+{
+    // Programs copy what they need out of the source when they link
+    m_shaders.erase(shader);
+}
+
+unsigned int SoftwareRenderDevice::CreateProgram()
+{
+    unsigned int program = m_nextHandle++;
+    m_programs[program];
+    return program;
+}
+
+void SoftwareRenderDevice::AttachShader(unsigned int program, unsigned int shader)
+{
+    auto found = m_programs.find(program);
+    if (found != m_programs.end())
+    {
+        found->second.shaders.push_back(shader);
+    }
+}
+
+void SoftwareRenderDevice::LinkProgram(unsigned int program)
+{
+    auto found = m_programs.find(program);
+    if (found == m_programs.end())
+    {
+        return;
+    }
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    for (unsigned int shader : found->second.shaders)
+    {
+        auto source = m_shaders.find(shader);
+        if (source == m_shaders.end())
+        {
+            continue;
+        }
+        if (source->second.stage == GL_VERTEX_SHADER)
+        {
+            vertexSource += source->second.source;
+        }
+        else if (source->second.stage == GL_FRAGMENT_SHADER)
+        {
+            fragmentSource += source->second.source;
+        }
+    }
+
+    // Pick the fixed pipeline that matches what the shader does, see the class comment
+    ProgramData& data = found->second;
+    if (fragmentSource.find("texture(") != std::string::npos)
+    {
+        data.shading = SHADING_TEXTURED;
+        data.samplerUniform = FindUniformName(fragmentSource, "sampler2D");
+    }
+    else if (vertexSource.find("aColor") != std::string::npos)
+    {
+        data.shading = SHADING_VERTEX_COLOR;
+    }
+    else
+    {
+        data.shading = SHADING_FLAT;
+        data.colorUniform = FindUniformName(fragmentSource, "vec3");
+    }
+}
+
+// Linking is done by the time LinkProgram returns
+bool SoftwareRenderDevice::IsProgramReady(unsigned int program)
+{
+    return true;
+}
+
+bool SoftwareRenderDevice::GetProgramStatus(unsigned int program, std::string& log)
+{
+    return m_programs.count(program) != 0;
+}
+
+void SoftwareRenderDevice::DeleteProgram(unsigned int program)
+{
+    m_programs.erase(program);
+    if (m_program == program)
+    {
+        m_program = 0;
+    }
+}
+
+void SoftwareRenderDevice::UseProgram(unsigned int program)
+{
+    m_program = program;
+}
+
+// Programs are interpreted from their source, so there's no binary to save
+bool SoftwareRenderDevice::GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format)
+{
+    return false;
+}
+
+bool SoftwareRenderDevice::ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size)
+{
+    return false;
+}
+
+int SoftwareRenderDevice::GetUniformLocation(unsigned int program, const char* name)
+{
+    auto found = m_programs.find(program);
+    if (found == m_programs.end())
+    {
+        return -1;
+    }
+    ProgramData& data = found->second;
+    auto location = data.locations.find(name);
+    if (location == data.locations.end())
+    {
+        location = data.locations.emplace(name, (int)data.values.size()).first;
+        data.values.emplace_back();
+    }
+    return location->second;
+}
+
+SoftwareRenderDevice::UniformValue* SoftwareRenderDevice::GetUniform(int location)
+{
+    auto found = m_programs.find(m_program);
+    if (found == m_programs.end() || location < 0 || location >= (int)found->second.values.size())
+    {
+        return NULL;
+    }
+    return &found->second.values[location];
+}
+
+void SoftwareRenderDevice::UploadUniform(int location, const float* values, int count)
+{
+    UniformValue* uniform = GetUniform(location);
+    if (!uniform)
+    {
+        return;
+    }
+    std::memcpy(uniform->f, values, std::min(count, 16) * sizeof(float));
+    uniform->i = (int)values[0];
+    uniform->set = true;
+}
+
+void SoftwareRenderDevice::Uniform1i(int location, int value)
+{
+    UniformValue* uniform = GetUniform(location);
+    if (uniform)
+    {
+        uniform->i = value;
+        uniform->f[0] = (float)value;
+        uniform->set = true;
+    }
+}
+
+void SoftwareRenderDevice::Uniform1f(int location, float value)
+{
+    UploadUniform(location, &value, 1);
+}
+
+void SoftwareRenderDevice::Uniform2f(int location, float x, float y)
+{
+    float values[] = { x, y };
+    UploadUniform(location, values, 2);
+}
+
+void SoftwareRenderDevice::Uniform3f(int location, float x, float y, float z)
+{
+    float values[] = { x, y, z };
+    UploadUniform(location, values, 3);
+}
+
+void SoftwareRenderDevice::Uniform4f(int location, float x, float y, float z, float w)
+{
+    float values[] = { x, y, z, w };
+    UploadUniform(location, values, 4);
+}
+
+// Arrays only keep their first element, nothing the fixed pipelines read is an array
+void SoftwareRenderDevice::Uniform2fv(int location, int count, const float* value)
+{
+    UploadUniform(location, value, 2);
+}
+
+void SoftwareRenderDevice::Uniform3fv(int location, int count, const float* value)
+{
+    UploadUniform(location, value, 3);
+}
+
+void SoftwareRenderDevice::Uniform4fv(int location, int count, const float* value)
+{
+    UploadUniform(location, value, 4);
+}
+
+void SoftwareRenderDevice::UniformMatrix2fv(int location, int count, bool transpose, const float* value)
+{
+    glm::mat2 m;
+    std::memcpy(&m[0][0], value, sizeof(m));
+    if (transpose)
+    {
+        m = glm::transpose(m);
+    }
+    UploadUniform(location, &m[0][0], 4);
+}
+
+void SoftwareRenderDevice::UniformMatrix3fv(int location, int count, bool transpose, const float* value)
+{
+    glm::mat3 m;
+    std::memcpy(&m[0][0], value, sizeof(m));
+    if (transpose)
+    {
+        m = glm::transpose(m);
+    }
+    UploadUniform(location, &m[0][0], 9);
+}
+
+void SoftwareRenderDevice::UniformMatrix4fv(int location, int count, bool transpose, const float* value)
+{
+    glm::mat4 m;
+    std::memcpy(&m[0][0], value, sizeof(m));
+    if (transpose)
+    {
+        m = glm::transpose(m);
+    }
+    UploadUniform(location, &m[0][0], 16);
+}
+
+////////////////// QUERIES /////////////////////////
+
+// Queries only exist so code written against GL runs unchanged, they always report 0
+unsigned int SoftwareRenderDevice::CreateQuery()
+{
+    return m_nextHandle++;
+}
+
+void SoftwareRenderDevice::DeleteQuery(unsigned int query)
+{
+}
+
+void SoftwareRenderDevice::BeginQuery(GLenum target, unsigned int query)
+{
+}
+
+void SoftwareRenderDevice::EndQuery(GLenum target)
+{
+}
+
+bool SoftwareRenderDevice::GetQueryResult(unsigned int query, unsigned long long& result)
+{
+    result = 0;
+    return true;
+}
+
+////////////////// FENCES /////////////////////////
+
+// Uploads are done by the time the call returns, so every fence is already signaled
+unsigned int SoftwareRenderDevice::CreateFence()
+{
+    return m_nextHandle++;
+}
+
+Fence_Status SoftwareRenderDevice::WaitFence(unsigned int fence, unsigned long long timeoutNs)
+{
+    return FENCE_SIGNALED;
+}
+
+void SoftwareRenderDevice::DeleteFence(unsigned int fence)
+{
+}
+
+////////////////// STATE /////////////////////////
+
+// State is copied into each primitive when it's drawn, so none of this has to flush
+void SoftwareRenderDevice::Enable(GLenum capability)
+{
+    if (capability == GL_DEPTH_TEST)
+    {
+        m_depthTest = true;
+    }
+    else if (capability == GL_SCISSOR_TEST)
+    {
+        m_scissorTest = true;
+    }
+}
+
+void SoftwareRenderDevice::Disable(GLenum capability)
+{
+    if (capability == GL_DEPTH_TEST)
+    {
+        m_depthTest = false;
+    }
+    else if (capability == GL_SCISSOR_TEST)
+    {
+        m_scissorTest = false;
+    }
+}
+
+void SoftwareRenderDevice::Viewport(int x, int y, int width, int height)
+{
+    m_viewport[0] = x;
+    m_viewport[1] = y;
+    m_viewport[2] = width;
+    m_viewport[3] = height;
+}
+
+void SoftwareRenderDevice::Scissor(int x, int y, int width, int height)
+{
+    m_scissor[0] = x;
+    m_scissor[1] = y;
+    m_scissor[2] = width;
+    m_scissor[3] = height;
+}
+
+void SoftwareRenderDevice::LineWidth(float width)
+{
+}
+
+void SoftwareRenderDevice::ClearColor(float r, float g, float b, float a)
+{
+    m_clearColor = glm::vec4(r, g, b, a);
+}
+
+void SoftwareRenderDevice::Clear(GLbitfield mask)
+{
+    Flush();
+
+    // Clears ignore the viewport but respect the scissor, same as GL
+    int minX = 0;
+    int minY = 0;
+    int maxX = m_width - 1;
+    int maxY = m_height - 1;
+    if (m_scissorTest)
+    {
+        minX = std::max(minX, m_scissor[0]);
+        minY = std::max(minY, m_scissor[1]);
+        maxX = std::min(maxX, m_scissor[0] + m_scissor[2] - 1);
+        maxY = std::min(maxY, m_scissor[1] + m_scissor[3] - 1);
+    }
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    uint32_t color = PackColor(m_clearColor);
+    ParallelFor(maxY - minY + 1, [&](size_t row)
+    {
+        size_t start = (size_t)(minY + row) * m_width + minX;
+        size_t count = maxX - minX + 1;
+        if (mask & GL_COLOR_BUFFER_BIT)
+        {
+            std::fill_n(m_color.begin() + start, count, color);
+        }
+        if (mask & GL_DEPTH_BUFFER_BIT)
+        {
+            std::fill_n(m_depth.begin() + start, count, 1.0f);
+        }
+    });
+}
+
+void SoftwareRenderDevice::GetClipRect(int& minX, int& minY, int& maxX, int& maxY) const
+{
+    minX = std::max(0, m_viewport[0]);
+    minY = std::max(0, m_viewport[1]);
+    maxX = std::min(m_width - 1, m_viewport[0] + m_viewport[2] - 1);
+    maxY = std::min(m_height - 1, m_viewport[1] + m_viewport[3] - 1);
+    if (m_scissorTest)
+    {
+        minX = std::max(minX, m_scissor[0]);
+        minY = std::max(minY, m_scissor[1]);
+        maxX = std::min(maxX, m_scissor[0] + m_scissor[2] - 1);
+        maxY = std::min(maxY, m_scissor[1] + m_scissor[3] - 1);
+    }
+}
+
+////////////////// DRAWING /////////////////////////
+
+void SoftwareRenderDevice::DrawArrays(GLenum mode, int first, int count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    std::vector<uint32_t> indices(count);
+    for (int i = 0; i < count; ++i)
+    {
+        indices[i] = first + i;
+    }
+    Draw(mode, indices);
+}
+
+void SoftwareRenderDevice::DrawElements(GLenum mode, int count, GLenum type, size_t offset)
+{
+    std::vector<uint8_t>* buffer = GetBoundBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    size_t typeSize = GetTypeSize(type);
+    if (!buffer || count <= 0 || offset + (size_t)count * typeSize > buffer->size())
+    {
+        return;
+    }
+
+    std::vector<uint32_t> indices(count);
+    const uint8_t* src = buffer->data() + offset;
+    for (int i = 0; i < count; ++i)
+    {
+        if (type == GL_UNSIGNED_INT)
+        {
+            std::memcpy(&indices[i], src + i * 4, 4);
+        }
+        else if (type == GL_UNSIGNED_SHORT)
+        {
+            uint16_t index;
+            std::memcpy(&index, src + i * 2, 2);
+            indices[i] = index;
+        }
+        else
+        {
+            indices[i] = src[i];
+        }
+    }
+    Draw(mode, indices);
+}
+
+void SoftwareRenderDevice::Draw(GLenum mode, const std::vector<uint32_t>& indices)
+{
+    auto program = m_programs.find(m_program);
+    if (program == m_programs.end())
+    {
+        return;
+    }
+    ProgramData& programData = program->second;
+    const VertexArrayData& vertexArray = m_vertexArrays[m_vertexArray];
+
+    // Uniforms the fixed pipeline reads. Unset matrices are identity
+    auto findUniform = [&](const std::string& name) -> const UniformValue*
+    {
+        auto location = programData.locations.find(name);
+        if (name.empty() || location == programData.locations.end() || !programData.values[location->second].set)
+        {
+            return NULL;
+        }
+        return &programData.values[location->second];
+    };
+    glm::mat4 matrices[3] = { glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) };
+    const char* matrixNames[3] = { "projection", "view", "model" };
+    for (int i = 0; i < 3; ++i)
+    {
+        if (const UniformValue* value = findUniform(matrixNames[i]))
+        {
+            std::memcpy(&matrices[i][0][0], value->f, sizeof(glm::mat4));
+        }
+    }
+    glm::mat4 mvp = matrices[0] * matrices[1] * matrices[2];
+
+    DrawState state;
+    state.shading = programData.shading;
+    state.color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    state.texture = NULL;
+    state.depthTest = m_depthTest;
+    if (const UniformValue* color = findUniform(programData.colorUniform))
+    {
+        state.color = glm::vec4(color->f[0], color->f[1], color->f[2], 1.0f);
+    }
+    state.packedColor = PackColor(state.color);
+    if (state.shading == SHADING_TEXTURED)
+    {
+        // Mesh sets samplers inside a "material" struct, so try that name too
+        const UniformValue* sampler = findUniform(programData.samplerUniform);
+        if (!sampler && !programData.samplerUniform.empty())
+        {
+            sampler = findUniform("material." + programData.samplerUniform);
+        }
+        int unit = sampler ? std::min(std::max(sampler->i, 0), SOFTWARE_MAX_TEXTURE_UNITS - 1) : 0;
+        auto texture = m_textures.find(m_boundTextures[unit]);
+        state.texture = (texture != m_textures.end()) ? &texture->second : NULL;
+    }
+    int numVaryings = (state.shading == SHADING_VERTEX_COLOR) ? 3 : (state.shading == SHADING_TEXTURED) ? 2 : 0;
+
+    // Attribute 0 is the position, 1 the color or 2 the texcoords depending on the pipeline
+    auto resolve = [&](int index)
+    {
+        ResolvedAttrib resolved;
+        const Attrib& attrib = vertexArray.attribs[index];
+        auto buffer = m_buffers.find(attrib.buffer);
+        if (attrib.enabled && buffer != m_buffers.end())
+        {
+            resolved.data = buffer->second.data();
+            resolved.size = buffer->second.size();
+            resolved.components = attrib.size;
+            resolved.type = attrib.type;
+            resolved.normalized = attrib.normalized;
+            resolved.offset = attrib.offset;
+            resolved.stride = attrib.stride ? attrib.stride : attrib.size * GetTypeSize(attrib.type);
+        }
+        return resolved;
+    };
+    ResolvedAttrib position = resolve(0);
+    ResolvedAttrib varying = resolve(state.shading == SHADING_TEXTURED ? 2 : 1);
+
+    ////// VERTEX TRANSFORM //////
+
+    uint32_t maxIndex = 0;
+    for (uint32_t index : indices)
+    {
+        maxIndex = std::max(maxIndex, index);
+    }
+    size_t numVertices = (size_t)maxIndex + 1;
+    std::vector<ClipVertex> vertices(numVertices);
+    ParallelFor((numVertices + TRANSFORM_BATCH_SIZE - 1) / TRANSFORM_BATCH_SIZE, [&](size_t batch)
+    {
+        size_t end = std::min(numVertices, (batch + 1) * TRANSFORM_BATCH_SIZE);
+        for (size_t v = batch * TRANSFORM_BATCH_SIZE; v < end; ++v)
+        {
+            float p[4];
+            ReadAttrib(position, (uint32_t)v, p, 4);
+            ClipVertex& out = vertices[v];
+            out.position = mvp * glm::vec4(p[0], p[1], p[2], p[3]);
+            ReadAttrib(varying, (uint32_t)v, out.varyings, SOFTWARE_MAX_VARYINGS);
+        }
+    });
+
+    ////// PRIMITIVE ASSEMBLY //////
+
+    std::vector<uint32_t> primitives;
+    int verticesPerPrimitive = 3;
+    size_t n = indices.size();
+    switch (mode)
+    {
+        case GL_TRIANGLES:
+            primitives.assign(indices.begin(), indices.begin() + (n / 3) * 3);
+            break;
+        case GL_TRIANGLE_STRIP:
+            for (size_t i = 0; i + 2 < n; ++i)
+            {
+                // Every other triangle flips to keep the winding consistent
+                bool odd = (i & 1) != 0;
+                primitives.push_back(indices[odd ? i + 1 : i]);
+                primitives.push_back(indices[odd ? i : i + 1]);
+                primitives.push_back(indices[i + 2]);
+            }
+            break;
+        case GL_TRIANGLE_FAN:
+            for (size_t i = 1; i + 1 < n; ++i)
+            {
+                primitives.push_back(indices[0]);
+                primitives.push_back(indices[i]);
+                primitives.push_back(indices[i + 1]);
+            }
+            break;
+        case GL_LINES:
+            verticesPerPrimitive = 2;
+            primitives.assign(indices.begin(), indices.begin() + (n / 2) * 2);
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            verticesPerPrimitive = 2;
+            for (size_t i = 0; i + 1 < n; ++i)
+            {
+                primitives.push_back(indices[i]);
+                primitives.push_back(indices[i + 1]);
+            }
+            if (mode == GL_LINE_LOOP && n > 2)
+            {
+                primitives.push_back(indices[n - 1]);
+                primitives.push_back(indices[0]);
+            }
+            break;
+        default:
+            // Points aren't used anywhere
+            return;
+    }
+
+    ////// SETUP AND BINNING //////
+
+    unsigned int stateIndex = (unsigned int)m_states.size();
+    m_states.push_back(state);
+
+    size_t numPrimitives = primitives.size() / verticesPerPrimitive;
+    size_t numBatches = (numPrimitives + SETUP_BATCH_SIZE - 1) / SETUP_BATCH_SIZE;
+    std::vector<std::vector<Triangle>> triangleBatches(numBatches);
+    std::vector<std::vector<Line>> lineBatches(numBatches);
+    ParallelFor(numBatches, [&](size_t batch)
+    {
+        size_t end = std::min(numPrimitives, (batch + 1) * SETUP_BATCH_SIZE);
+        for (size_t p = batch * SETUP_BATCH_SIZE; p < end; ++p)
+        {
+            const uint32_t* prim = &primitives[p * verticesPerPrimitive];
+            if (verticesPerPrimitive == 3)
+            {
+                ClipVertex corners[3] = { vertices[prim[0]], vertices[prim[1]], vertices[prim[2]] };
+                SetupTriangle(corners, state, stateIndex, numVaryings, triangleBatches[batch]);
+            }
+            else
+            {
+                SetupLine(vertices[prim[0]], vertices[prim[1]], stateIndex, numVaryings, lineBatches[batch]);
+            }
+        }
+    });
+
+    // Binning stays on this thread so every tile sees primitives in submission order
+    for (size_t batch = 0; batch < numBatches; ++batch)
+    {
+        for (const Triangle& tri : triangleBatches[batch])
+        {
+            uint32_t id = (uint32_t)m_triangles.size() << 1;
+            m_triangles.push_back(tri);
+            for (int ty = tri.minY / SOFTWARE_TILE_SIZE; ty <= tri.maxY / SOFTWARE_TILE_SIZE; ++ty)
+            {
+                for (int tx = tri.minX / SOFTWARE_TILE_SIZE; tx <= tri.maxX / SOFTWARE_TILE_SIZE; ++tx)
+                {
+                    m_bins[ty * m_tilesX + tx].push_back(id);
+                }
+            }
+        }
+        for (const Line& line : lineBatches[batch])
+        {
+            uint32_t id = ((uint32_t)m_lines.size() << 1) | 1;
+            m_lines.push_back(line);
+            for (int ty = line.minY / SOFTWARE_TILE_SIZE; ty <= line.maxY / SOFTWARE_TILE_SIZE; ++ty)
+            {
+                for (int tx = line.minX / SOFTWARE_TILE_SIZE; tx <= line.maxX / SOFTWARE_TILE_SIZE; ++tx)
+                {
+                    m_bins[ty * m_tilesX + tx].push_back(id);
+                }
+            }
+        }
+        m_numTriangles += triangleBatches[batch].size();
+        m_numLines += lineBatches[batch].size();
+    }
+}
+
+glm::vec3 SoftwareRenderDevice::ToWindow(const glm::vec4& clip) const
+{
+    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    return glm::vec3(
+        m_viewport[0] + (ndc.x + 1.0f) * 0.5f * m_viewport[2],
+        m_viewport[1] + (ndc.y + 1.0f) * 0.5f * m_viewport[3],
+        ndc.z * 0.5f + 0.5f);
+}
+
+void SoftwareRenderDevice::SetupTriangle(const ClipVertex* vertices, const DrawState& state, unsigned int stateIndex,
+    int numVaryings, std::vector<Triangle>& out) const
+{
+    // Clip against the whole view volume, so window positions always fit the fixed point range
+    ClipVertex polygon[2][9];
+    int count = 3;
+    int src = 0;
+    bool inside = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        polygon[0][i] = vertices[i];
+        for (int plane = 0; plane < 6 && inside; ++plane)
+        {
+            inside = ClipDistance(vertices[i].position, plane) >= 0.0f;
+        }
+    }
+    if (!inside)
+    {
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            int dst = src ^ 1;
+            int outCount = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                const ClipVertex& a = polygon[src][i];
+                const ClipVertex& b = polygon[src][(i + 1) % count];
+                float da = ClipDistance(a.position, plane);
+                float db = ClipDistance(b.position, plane);
+                if (da >= 0.0f)
+                {
+                    polygon[dst][outCount++] = a;
+                }
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    polygon[dst][outCount++] = LerpVertex(a, b, da / (da - db));
+                }
+            }
+            count = outCount;
+            src = dst;
+            if (count < 3)
+            {
+                return;
+            }
+        }
+    }
+
+    int clipMinX, clipMinY, clipMaxX, clipMaxY;
+    GetClipRect(clipMinX, clipMinY, clipMaxX, clipMaxY);
+
+    glm::vec3 window[9];
+    for (int i = 0; i < count; ++i)
+    {
+        window[i] = ToWindow(polygon[src][i].position);
+    }
+
+    // The clipped polygon is convex, so a fan covers it
+    for (int i = 1; i + 1 < count; ++i)
+    {
+        int corner[3] = { 0, i, i + 1 };
+        Triangle tri;
+        for (int j = 0; j < 3; ++j)
+        {
+            tri.x[j] = (int)std::lround(window[corner[j]].x * SOFTWARE_SUBPIXEL_SCALE);
+            tri.y[j] = (int)std::lround(window[corner[j]].y * SOFTWARE_SUBPIXEL_SCALE);
+        }
+        long long area = (long long)(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0])
+            - (long long)(tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+        if (area == 0)
+        {
+            continue;
+        }
+        // Faces aren't culled, clockwise ones are just turned around
+        if (area < 0)
+        {
+            std::swap(corner[1], corner[2]);
+            std::swap(tri.x[1], tri.x[2]);
+            std::swap(tri.y[1], tri.y[2]);
+        }
+
+        tri.minX = std::max(clipMinX, SubpixelToPixel(std::min({ tri.x[0], tri.x[1], tri.x[2] })));
+        tri.minY = std::max(clipMinY, SubpixelToPixel(std::min({ tri.y[0], tri.y[1], tri.y[2] })));
+        tri.maxX = std::min(clipMaxX, SubpixelToPixel(std::max({ tri.x[0], tri.x[1], tri.x[2] })));
+        tri.maxY = std::min(clipMaxY, SubpixelToPixel(std::max({ tri.y[0], tri.y[1], tri.y[2] })));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+        {
+            continue;
+        }
+
+        // Interpolation planes use the snapped positions so they agree with coverage
+        float px[3], py[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            px[j] = tri.x[j] / (float)SOFTWARE_SUBPIXEL_SCALE;
+            py[j] = tri.y[j] / (float)SOFTWARE_SUBPIXEL_SCALE;
+        }
+        float e1x = px[1] - px[0], e1y = py[1] - py[0];
+        float e2x = px[2] - px[0], e2y = py[2] - py[0];
+        float invArea = 1.0f / (e1x * e2y - e2x * e1y);
+        auto makePlane = [&](float f0, float f1, float f2)
+        {
+            Plane plane;
+            plane.base = f0;
+            plane.dx = ((f1 - f0) * e2y - (f2 - f0) * e1y) * invArea;
+            plane.dy = ((f2 - f0) * e1x - (f1 - f0) * e2x) * invArea;
+            return plane;
+        };
+
+        const ClipVertex* v[3] = { &polygon[src][corner[0]], &polygon[src][corner[1]], &polygon[src][corner[2]] };
+        float invW[3] = { 1.0f / v[0]->position.w, 1.0f / v[1]->position.w, 1.0f / v[2]->position.w };
+        tri.originX = px[0];
+        tri.originY = py[0];
+        tri.depth = makePlane(window[corner[0]].z, window[corner[1]].z, window[corner[2]].z);
+        tri.invW = makePlane(invW[0], invW[1], invW[2]);
+        for (int k = 0; k < numVaryings; ++k)
+        {
+            tri.varyings[k] = makePlane(v[0]->varyings[k] * invW[0], v[1]->varyings[k] * invW[1],
+                v[2]->varyings[k] * invW[2]);
+        }
+        tri.state = stateIndex;
+        out.push_back(tri);
+    }
+}
+
+void SoftwareRenderDevice::SetupLine(ClipVertex a, ClipVertex b, unsigned int stateIndex, int numVaryings,
+    std::vector<Line>& out) const
+{
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        float da = ClipDistance(a.position, plane);
+        float db = ClipDistance(b.position, plane);
+        if (da < 0.0f && db < 0.0f)
+        {
+            return;
+        }
+        if (da < 0.0f)
+        {
+            a = LerpVertex(a, b, da / (da - db));
+        }
+        else if (db < 0.0f)
+        {
+            b = LerpVertex(b, a, db / (db - da));
+        }
+    }
+
+    int clipMinX, clipMinY, clipMaxX, clipMaxY;
+    GetClipRect(clipMinX, clipMinY, clipMaxX, clipMaxY);
+
+    glm::vec3 wa = ToWindow(a.position);
+    glm::vec3 wb = ToWindow(b.position);
+    Line line;
+    line.x0 = wa.x; line.y0 = wa.y; line.z0 = wa.z;
+    line.x1 = wb.x; line.y1 = wb.y; line.z1 = wb.z;
+    for (int k = 0; k < SOFTWARE_MAX_VARYINGS; ++k)
+    {
+        line.varyings0[k] = k < numVaryings ? a.varyings[k] : 0.0f;
+        line.varyings1[k] = k < numVaryings ? b.varyings[k] : 0.0f;
+    }
+    line.minX = std::max(clipMinX, (int)std::floor(std::min(wa.x, wb.x)));
+    line.minY = std::max(clipMinY, (int)std::floor(std::min(wa.y, wb.y)));
+    line.maxX = std::min(clipMaxX, (int)std::floor(std::max(wa.x, wb.x)));
+    line.maxY = std::min(clipMaxY, (int)std::floor(std::max(wa.y, wb.y)));
+    if (line.minX > line.maxX || line.minY > line.maxY)
+    {
+        return;
+    }
+    line.state = stateIndex;
+    out.push_back(line);
+}
+
+////////////////// RASTERIZING /////////////////////////
+
+void SoftwareRenderDevice::Flush()
+{
+    PROFILE_SCOPE("Rasterize");
+    if (m_triangles.empty() && m_lines.empty())
+    {
+        return;
+    }
+    ParallelFor(m_bins.size(), [&](size_t tile) { RasterizeTile((unsigned int)tile); });
+
+    m_states.clear();
+    m_triangles.clear();
+    m_lines.clear();
+    for (std::vector<uint32_t>& bin : m_bins)
+    {
+        bin.clear();
+    }
+}
+
+void SoftwareRenderDevice::RasterizeTile(unsigned int tile)
+{
+    int minX = (tile % m_tilesX) * SOFTWARE_TILE_SIZE;
+    int minY = (tile / m_tilesX) * SOFTWARE_TILE_SIZE;
+    int maxX = std::min(m_width, minX + SOFTWARE_TILE_SIZE) - 1;
+    int maxY = std::min(m_height, minY + SOFTWARE_TILE_SIZE) - 1;
+    for (uint32_t id : m_bins[tile])
+    {
+        if (id & 1)
+        {
+            RasterizeLine(m_lines[id >> 1], minX, minY, maxX, maxY);
+        }
+        else
+        {
+            RasterizeTriangle(m_triangles[id >> 1], minX, minY, maxX, maxY);
+        }
+    }
+}
+
+void SoftwareRenderDevice::RasterizeTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX,
+    int tileMaxY)
+{
+    int minX = std::max(tri.minX, tileMinX);
+    int minY = std::max(tri.minY, tileMinY);
+    int maxX = std::min(tri.maxX, tileMaxX);
+    int maxY = std::min(tri.maxY, tileMaxY);
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+    // Walk 2x2 quads, which start on even pixels (tiles do too, so this stays inside the tile)
+    int quadMinX = minX & ~1;
+    int quadMinY = minY & ~1;
+
+    // Edge k is opposite vertex k, positive inside since the triangle is counter-clockwise.
+    // E(x, y) = A * x + B * y + C at pixel centers, in subpixel units squared
+    const int scale = SOFTWARE_SUBPIXEL_SCALE;
+    int stepX[3], stepY[3], bias[3];
+    long long start[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        int a = (k + 1) % 3;
+        int b = (k + 2) % 3;
+        int A = tri.y[a] - tri.y[b];
+        int B = tri.x[b] - tri.x[a];
+        long long C = -(long long)A * tri.x[a] - (long long)B * tri.y[a];
+        // Top-left fill rule, pixels exactly on a right or bottom edge belong to the neighbour
+        bool topLeft = (A > 0) || (A == 0 && B < 0);
+        bias[k] = topLeft ? 0 : 1;
+        stepX[k] = A * scale;
+        stepY[k] = B * scale;
+        long long e = (long long)A * (quadMinX * scale + scale / 2) + (long long)B * (quadMinY * scale + scale / 2) + C;
+        // Positions fit in 17 bits, so E changes by less than 2^29 across a tile. Past EDGE_CLAMP
+        // the sign can't change inside the tile, and clamping keeps the SIMD math in 32 bits
+        if (e < -EDGE_CLAMP)
+        {
+            return;
+        }
+        start[k] = std::min(e, (long long)EDGE_CLAMP);
+    }
+
+    const DrawState& state = m_states[tri.state];
+    int numVaryings = (state.shading == SHADING_VERTEX_COLOR) ? 3 : (state.shading == SHADING_TEXTURED) ? 2 : 0;
+    bool needsLod = state.shading == SHADING_TEXTURED && state.texture && !state.texture->levels.empty();
+
+#ifdef SOFTWARE_USE_SSE2
+    // Lanes are the quad's pixels: (0,0) (1,0) (0,1) (1,1)
+    __m128i edgeRow[3], quadStepX[3], quadStepY[3], threshold[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        edgeRow[k] = _mm_add_epi32(_mm_set1_epi32((int)start[k]),
+            _mm_set_epi32(stepX[k] + stepY[k], stepY[k], stepX[k], 0));
+        quadStepX[k] = _mm_set1_epi32(stepX[k] * 2);
+        quadStepY[k] = _mm_set1_epi32(stepY[k] * 2);
+        // inside when E - bias >= 0, i.e. E > bias - 1
+        threshold[k] = _mm_set1_epi32(bias[k] - 1);
+    }
+#else
+    int edgeRow[3][4];
+    for (int k = 0; k < 3; ++k)
+    {
+        edgeRow[k][0] = (int)start[k];
+        edgeRow[k][1] = (int)start[k] + stepX[k];
+        edgeRow[k][2] = (int)start[k] + stepY[k];
+        edgeRow[k][3] = (int)start[k] + stepX[k] + stepY[k];
+    }
+#endif
+
+    for (int y = quadMinY; y <= maxY; y += 2)
+    {
+#ifdef SOFTWARE_USE_SSE2
+        __m128i edge[3] = { edgeRow[0], edgeRow[1], edgeRow[2] };
+#else
+        int edge[3][4];
+        std::memcpy(edge, edgeRow, sizeof(edge));
+#endif
+        for (int x = quadMinX; x <= maxX; x += 2)
+        {
+#ifdef SOFTWARE_USE_SSE2
+            __m128i inside = _mm_and_si128(
+                _mm_and_si128(_mm_cmpgt_epi32(edge[0], threshold[0]), _mm_cmpgt_epi32(edge[1], threshold[1])),
+                _mm_cmpgt_epi32(edge[2], threshold[2]));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+            for (int k = 0; k < 3; ++k)
+            {
+                edge[k] = _mm_add_epi32(edge[k], quadStepX[k]);
+            }
+#else
+            int mask = 0;
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                bool in = edge[0][lane] >= bias[0] && edge[1][lane] >= bias[1] && edge[2][lane] >= bias[2];
+                mask |= in ? (1 << lane) : 0;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    edge[k][lane] += stepX[k] * 2;
+                }
+            }
+#endif
+            if (mask == 0)
+            {
+                continue;
+            }
+
+            // Interpolate every lane, covered or not, so the quad gives screen space derivatives
+            float laneVaryings[4][SOFTWARE_MAX_VARYINGS];
+            float laneDepth[4];
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                float px = x + (lane & 1) + 0.5f - tri.originX;
+                float py = y + (lane >> 1) + 0.5f - tri.originY;
+                laneDepth[lane] = tri.depth.base + tri.depth.dx * px + tri.depth.dy * py;
+                float w = 1.0f / (tri.invW.base + tri.invW.dx * px + tri.invW.dy * py);
+                for (int k = 0; k < numVaryings; ++k)
+                {
+                    const Plane& plane = tri.varyings[k];
+                    laneVaryings[lane][k] = (plane.base + plane.dx * px + plane.dy * py) * w;
+                }
+            }
+
+            float lod = 0.0f;
+            if (needsLod)
+            {
+                const MipLevel& base = state.texture->levels[0];
+                float dudx = (laneVaryings[1][0] - laneVaryings[0][0]) * base.width;
+                float dvdx = (laneVaryings[1][1] - laneVaryings[0][1]) * base.height;
+                float dudy = (laneVaryings[2][0] - laneVaryings[0][0]) * base.width;
+                float dvdy = (laneVaryings[2][1] - laneVaryings[0][1]) * base.height;
+                float rho = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+                lod = rho > 0.0f ? 0.5f * std::log2(rho) : 0.0f;
+            }
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                int px = x + (lane & 1);
+                int py = y + (lane >> 1);
+                if ((mask & (1 << lane)) && px >= minX && px <= maxX && py >= minY && py <= maxY)
+                {
+                    ShadePixel(state, px, py, laneDepth[lane], laneVaryings[lane], lod);
+                }
+            }
+        }
+#ifdef SOFTWARE_USE_SSE2
+        for (int k = 0; k < 3; ++k)
+        {
+            edgeRow[k] = _mm_add_epi32(edgeRow[k], quadStepY[k]);
+        }
+#else
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                edgeRow[k][lane] += stepY[k] * 2;
+            }
+        }
+#endif
+    }
+}
+
+void SoftwareRenderDevice::RasterizeLine(const Line& line, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+    int minX = std::max(line.minX, tileMinX);
+    int minY = std::max(line.minY, tileMinY);
+    int maxX = std::min(line.maxX, tileMaxX);
+    int maxY = std::min(line.maxY, tileMaxY);
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    // One pixel per column (or row, for steep lines) whose center the line passes, like a DDA but
+    // solved per pixel so it stays exact and only walks the part inside this tile
+    float dx = line.x1 - line.x0;
+    float dy = line.y1 - line.y0;
+    bool xMajor = std::fabs(dx) >= std::fabs(dy);
+    float majorStart = xMajor ? line.x0 : line.y0;
+    float majorDelta = xMajor ? dx : dy;
+    float minorStart = xMajor ? line.y0 : line.x0;
+    float minorDelta = xMajor ? dy : dx;
+    if (majorDelta == 0.0f)
+    {
+        return;
+    }
+    int first = (int)std::ceil(std::min(majorStart, majorStart + majorDelta) - 0.5f);
+    int last = (int)std::ceil(std::max(majorStart, majorStart + majorDelta) - 0.5f) - 1;
+    first = std::max(first, xMajor ? minX : minY);
+    last = std::min(last, xMajor ? maxX : maxY);
+
+    const DrawState& state = m_states[line.state];
+    for (int major = first; major <= last; ++major)
+    {
+        float t = (major + 0.5f - majorStart) / majorDelta;
+        int minor = FastFloor(minorStart + minorDelta * t);
+        int px = xMajor ? major : minor;
+        int py = xMajor ? minor : major;
+        if (px < minX || px > maxX || py < minY || py > maxY)
+        {
+            continue;
+        }
+        float varyings[SOFTWARE_MAX_VARYINGS];
+        for (int k = 0; k < SOFTWARE_MAX_VARYINGS; ++k)
+        {
+            varyings[k] = line.varyings0[k] + (line.varyings1[k] - line.varyings0[k]) * t;
+        }
+        ShadePixel(state, px, py, line.z0 + (line.z1 - line.z0) * t, varyings, 0.0f);
+    }
+}
+
+void SoftwareRenderDevice::ShadePixel(const DrawState& state, int x, int y, float z, const float* varyings, float lod)
+{
+    size_t index = (size_t)y * m_width + x;
+    if (state.depthTest)
+    {
+        if (!(z < m_depth[index]))
+        {
+            return;
+        }
+        m_depth[index] = z;
+    }
+
+    switch (state.shading)
+    {
+        case SHADING_VERTEX_COLOR:
+            m_color[index] = PackColor(glm::vec4(varyings[0], varyings[1], varyings[2], 1.0f));
+            break;
+        case SHADING_TEXTURED:
+            // Sampling with nothing bound gives black, like GL
+            m_color[index] = state.texture ? Sample(*state.texture, varyings[0], varyings[1], lod) : 0xff000000;
+            break;
+        default:
+            m_color[index] = state.packedColor;
+            break;
+    }
+}
+
+uint32_t SoftwareRenderDevice::Sample(const TextureData& texture, float u, float v, float lod) const
+{
+    const uint32_t black = 0xff000000;
+    if (texture.levels.empty() || texture.levels[0].texels.empty())
+    {
+        return black;
+    }
+
+    bool magnify = lod <= 0.0f;
+    GLenum filter = magnify ? texture.magFilter : texture.minFilter;
+    bool usesMips = !magnify && filter != GL_NEAREST && filter != GL_LINEAR;
+    // A mipmapped filter without a full chain is an incomplete texture, which samples black in GL
+    if (usesMips && !texture.fullChain)
+    {
+        return black;
+    }
+
+    bool linear = filter == GL_LINEAR || filter == GL_LINEAR_MIPMAP_NEAREST || filter == GL_LINEAR_MIPMAP_LINEAR;
+    auto sampleLevel = [&](int level)
+    {
+        const MipLevel& mip = texture.levels[level];
+        if (!linear)
+        {
+            int tx = WrapCoord(FastFloor(u * mip.width), mip.width, texture.wrapS);
+            int ty = WrapCoord(FastFloor(v * mip.height), mip.height, texture.wrapT);
+            return mip.texels[(size_t)ty * mip.width + tx];
+        }
+        // Weights in 1/256ths, plenty for 8 bit texels
+        int fx = (int)(u * mip.width * 256.0f) - 128;
+        int fy = (int)(v * mip.height * 256.0f) - 128;
+        int x0 = fx >> 8;
+        int y0 = fy >> 8;
+        int xa = WrapCoord(x0, mip.width, texture.wrapS);
+        int xb = WrapCoord(x0 + 1, mip.width, texture.wrapS);
+        const uint32_t* rowA = &mip.texels[(size_t)WrapCoord(y0, mip.height, texture.wrapT) * mip.width];
+        const uint32_t* rowB = &mip.texels[(size_t)WrapCoord(y0 + 1, mip.height, texture.wrapT) * mip.width];
+        uint32_t top = LerpTexel(rowA[xa], rowA[xb], fx & 0xff);
+        uint32_t bottom = LerpTexel(rowB[xa], rowB[xb], fx & 0xff);
+        return LerpTexel(top, bottom, fy & 0xff);
+    };
+
+    if (!usesMips)
+    {
+        return sampleLevel(0);
+    }
+    int maxLevel = (int)texture.levels.size() - 1;
+    if (filter == GL_NEAREST_MIPMAP_NEAREST || filter == GL_LINEAR_MIPMAP_NEAREST)
+    {
+        return sampleLevel(std::min(maxLevel, (int)(lod + 0.5f)));
+    }
+    int level0 = std::min(maxLevel, (int)lod);
+    if (level0 == maxLevel)
+    {
+        return sampleLevel(level0);
+    }
+    return LerpTexel(sampleLevel(level0), sampleLevel(level0 + 1), (uint32_t)((lod - (int)lod) * 256.0f));
+}
+
+////////////////// FRAMEBUFFER /////////////////////////
+
+void SoftwareRenderDevice::Resize(int width, int height)
+{
+    // Anything queued was binned for the old size
+    Flush();
+    m_width = std::min(std::max(width, 1), SOFTWARE_MAX_FRAMEBUFFER_SIZE);
+    m_height = std::min(std::max(height, 1), SOFTWARE_MAX_FRAMEBUFFER_SIZE);
+    m_tilesX = (m_width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    m_tilesY = (m_height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    m_bins.assign((size_t)m_tilesX * m_tilesY, std::vector<uint32_t>());
+    m_color.assign((size_t)m_width * m_height, 0);
+    m_depth.assign((size_t)m_width * m_height, 1.0f);
+    Viewport(0, 0, m_width, m_height);
+}
+
+int SoftwareRenderDevice::GetWidth() const
+{
+    return m_width;
+}
+
+int SoftwareRenderDevice::GetHeight() const
+{
+    return m_height;
+}
+
+unsigned int SoftwareRenderDevice::GetNumThreads() const
+{
+    return (unsigned int)m_pool->threads.size() + 1;
+}
+
+const std::vector<uint32_t>& SoftwareRenderDevice::GetColorBuffer()
+{
+    Flush();
+    return m_color;
+}
+
+const std::vector<float>& SoftwareRenderDevice::GetDepthBuffer()
+{
+    Flush();
+    return m_depth;
+}
+
+uint32_t SoftwareRenderDevice::ReadPixel(int x, int y)
+{
+    Flush();
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return 0;
+    }
+    return m_color[(size_t)y * m_width + x];
+}
+
+bool SoftwareRenderDevice::SaveImage(const std::string& path)
+{
+    Flush();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", m_width, m_height);
+    std::vector<uint8_t> row((size_t)m_width * 3);
+    for (int y = m_height - 1; y >= 0; --y)
+    {
+        const uint32_t* src = &m_color[(size_t)y * m_width];
+        for (int x = 0; x < m_width; ++x)
+        {
+            row[x * 3 + 0] = src[x] & 0xff;
+            row[x * 3 + 1] = (src[x] >> 8) & 0xff;
+            row[x * 3 + 2] = (src[x] >> 16) & 0xff;
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+unsigned long long SoftwareRenderDevice::GetNumTriangles() const
+{
+    return m_numTriangles;
+}
+
+unsigned long long SoftwareRenderDevice::GetNumLines() const
+{
+    return m_numLines;
+}
+
+void SoftwareRenderDevice::ResetCounters()
+{
+    m_numTriangles = 0;
+    m_numLines = 0;
+}
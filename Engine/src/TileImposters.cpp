@@ -0,0 +1,187 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <JobSystem.h>
+#include <Profiler.h>
+#include <RenderDevice.h>
+#include <RenderStats.h>
+#include <TileMap.h>
+#include <TileRenderer.h>
+
+#include <TileImposters.h>
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+TileImposters::TileImposters(TileMap* tileMap, unsigned int size)
+    : m_tileMap(tileMap)
+    , m_size(std::max(size, 1u))
+{
+    unsigned int numChunks = m_tileMap->GetNumChunks();
+    m_texels.resize((size_t)numChunks * m_size * m_size);
+    m_versions.resize(numChunks);
+    m_bPending.resize(numChunks, 0);
+}
+
+TileImposters::~TileImposters()
+{
+    RenderDevice* device = RenderDevice::Get();
+    if (m_texture && device)
+    {
+        device->DeleteTexture(m_texture);
+    }
+}
+
+////////////////// BUILDING /////////////////////////
+
+unsigned int TileImposters::Update()
+{
+    PROFILE_SCOPE("BuildImposters");
+    m_dirty.clear();
+    for (unsigned int i = 0; i < m_versions.size(); ++i)
+    {
+        uint32_t version = m_tileMap->GetChunk(i).version;
+        if (!m_bBuilt || version != m_versions[i])
+        {
+            m_versions[i] = version;
+            m_dirty.push_back(i);
+        }
+    }
+    m_bBuilt = true;
+
+    // Each picture only reads its own chunk and writes its own texels
+    unsigned int texelsPerChunk = m_size * m_size;
+    JobSystem::Get().ParallelFor(m_dirty.size(), 4, [this, texelsPerChunk](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            BuildImposter(*m_tileMap, m_dirty[i], m_size, &m_texels[(size_t)m_dirty[i] * texelsPerChunk]);
+        }
+    });
+
+    for (unsigned int index : m_dirty)
+    {
+        if (!m_bPending[index])
+        {
+            m_bPending[index] = 1;
+            m_pending.push_back(index);
+        }
+    }
+    return m_dirty.size();
+}
+
+void TileImposters::BuildImposter(const TileMap& tileMap, unsigned int index, unsigned int size, uint32_t* out)
+{
+    const TileMap::Chunk& chunk = tileMap.GetChunk(index);
+    for (unsigned int ty = 0; ty < size; ++ty)
+    {
+        // Tiles under this row of texels. Bigger pictures than the chunk repeat tiles instead
+        unsigned int y0 = ty * TILE_CHUNK_SIZE / size;
+        unsigned int y1 = std::max((ty + 1) * TILE_CHUNK_SIZE / size, y0 + 1);
+        for (unsigned int tx = 0; tx < size; ++tx)
+        {
+            unsigned int x0 = tx * TILE_CHUNK_SIZE / size;
+            unsigned int x1 = std::max((tx + 1) * TILE_CHUNK_SIZE / size, x0 + 1);
+
+            glm::vec3 sum(0.0f);
+            unsigned int filled = 0;
+            for (unsigned int y = y0; y < y1; ++y)
+            {
+                for (unsigned int x = x0; x < x1; ++x)
+                {
+                    TileID id = chunk.cells[y * TILE_CHUNK_SIZE + x];
+                    if (id != EMPTY_TILE)
+                    {
+                        sum += TileRenderer::GetTileColor(id);
+                        filled++;
+                    }
+                }
+            }
+
+            uint32_t texel = 0;
+            if (filled > 0)
+            {
+                glm::uvec3 rgb = glm::uvec3(glm::clamp(sum / (float)filled, 0.0f, 1.0f) * 255.0f + 0.5f);
+                uint32_t alpha = (filled * 255 + (x1 - x0) * (y1 - y0) / 2) / ((x1 - x0) * (y1 - y0));
+                texel = rgb.r | (rgb.g << 8) | (rgb.b << 16) | (alpha << 24);
+            }
+            out[ty * size + tx] = texel;
+        }
+    }
+}
+
+////////////////// UPLOADING /////////////////////////
+
+unsigned int TileImposters::Upload()
+{
+    RenderDevice* device = RenderDevice::Get();
+    if (!m_texture)
+    {
+        // Storage only, the chunks fill it in below
+        m_texture = device->CreateTexture();
+        device->BindTexture(GL_TEXTURE_2D, m_texture);
+        device->TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GetWidth(), GetHeight(), GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        // A texel is a block of tiles, blending them with the next chunk over would smear the edges
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        device->TexParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    if (m_pending.empty())
+    {
+        return 0;
+    }
+
+    PROFILE_SCOPE("UploadImposters");
+    device->BindTexture(GL_TEXTURE_2D, m_texture);
+    unsigned int texelsPerChunk = m_size * m_size;
+    for (unsigned int index : m_pending)
+    {
+        glm::ivec2 origin = m_tileMap->GetChunkOrigin(index) / (int)TILE_CHUNK_SIZE * (int)m_size;
+        device->TexSubImage2D(GL_TEXTURE_2D, 0, origin.x, origin.y, m_size, m_size, GL_RGBA, GL_UNSIGNED_BYTE,
+            &m_texels[(size_t)index * texelsPerChunk]);
+        m_bPending[index] = 0;
+    }
+    RenderStats::Get().Add(RENDER_STAT_TEXTURE_UPLOADS, m_pending.size());
+    RenderStats::Get().Add(RENDER_STAT_TEXTURE_BYTES, m_pending.size() * texelsPerChunk * sizeof(uint32_t));
+
+    unsigned int numUploaded = m_pending.size();
+    m_pending.clear();
+    return numUploaded;
+}
+
+////////////////// ACCESS /////////////////////////
+
+unsigned int TileImposters::GetTexture() const
+{
+    return m_texture;
+}
+
+unsigned int TileImposters::GetSize() const
+{
+    return m_size;
+}
+
+unsigned int TileImposters::GetWidth() const
+{
+    return m_tileMap->GetChunkCols() * m_size;
+}
+
+unsigned int TileImposters::GetHeight() const
+{
+    return m_tileMap->GetChunkRows() * m_size;
+}
+
+const uint32_t* TileImposters::GetImposter(unsigned int index) const
+{
+    return &m_texels[(size_t)index * m_size * m_size];
+}
+
+glm::vec2 TileImposters::GetCoveredSize(glm::vec3 tileSize) const
+{
+    return glm::vec2(m_tileMap->GetChunkCols() * TILE_CHUNK_SIZE * tileSize.x,
+        m_tileMap->GetChunkRows() * TILE_CHUNK_SIZE * tileSize.z);
+}
@@ -0,0 +1,151 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <EditHistory.h>
+#include <TileMap.h>
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+TileMap::TileMap(unsigned int numCols, unsigned int numRows)
+    : m_numCols(numCols)
+    , m_numRows(numRows)
+{
+    // Round up so partial chunks at the edges still get storage
+    m_chunkCols = (numCols + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    m_chunkRows = (numRows + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    m_chunks.resize(m_chunkCols * m_chunkRows);
+    Clear();
+}
+
+////////////// TILE ACCESS ////////////////
+
+bool TileMap::InBounds(int x, int y) const
+{
+    return x >= 0 && y >= 0 && x < (int)m_numCols && y < (int)m_numRows;
+}
+
+TileID TileMap::GetTile(int x, int y) const
+{
+    if (!InBounds(x, y))
+    {
+        return EMPTY_TILE;
+    }
+    const Chunk& chunk = m_chunks[GetChunkIndex(x, y)];
+    return chunk.cells[(y % TILE_CHUNK_SIZE) * TILE_CHUNK_SIZE + (x % TILE_CHUNK_SIZE)];
+}
+
+void TileMap::SetTile(int x, int y, TileID id)
+{
+    if (!InBounds(x, y))
+    {
+        return;
+    }
+    unsigned int index = GetChunkIndex(x, y);
+    Chunk& chunk = m_chunks[index];
+    TileID& cell = chunk.cells[(y % TILE_CHUNK_SIZE) * TILE_CHUNK_SIZE + (x % TILE_CHUNK_SIZE)];
+    if (cell == id)
+    {
+        return;
+    }
+
+    // The recorder copies the chunk the first time it's touched in an edit
+    if (m_recorder)
+    {
+        m_recorder->OnChunkWrite(index, chunk);
+    }
+
+    cell = id;
+    chunk.version++;
+    chunk.dirty = true;
+}
+
+void TileMap::Clear()
+{
+    for (Chunk& chunk : m_chunks)
+    {
+        std::fill(chunk.cells, chunk.cells + TILE_CHUNK_CELLS, (TileID)EMPTY_TILE);
+        chunk.version++;
+        chunk.dirty = true;
+    }
+}
+
+////////////// CHUNK ACCESS ////////////////
+
+unsigned int TileMap::GetChunkIndex(int x, int y) const
+{
+    return (y / TILE_CHUNK_SIZE) * m_chunkCols + (x / TILE_CHUNK_SIZE);
+}
+
+glm::ivec2 TileMap::GetChunkOrigin(unsigned int index) const
+{
+    return glm::ivec2((index % m_chunkCols) * TILE_CHUNK_SIZE, (index / m_chunkCols) * TILE_CHUNK_SIZE);
+}
+
+TileMap::Chunk& TileMap::GetChunk(unsigned int index)
+{
+    return m_chunks[index];
+}
+
+const TileMap::Chunk& TileMap::GetChunk(unsigned int index) const
+{
+    return m_chunks[index];
+}
+
+TileID* TileMap::BeginChunkWrite(unsigned int index)
+{
+    Chunk& chunk = m_chunks[index];
+    if (m_recorder)
+    {
+        m_recorder->OnChunkWrite(index, chunk);
+    }
+    chunk.version++;
+    chunk.dirty = true;
+    return chunk.cells;
+}
+
+void TileMap::WriteChunkRun(unsigned int index, unsigned int start, unsigned int count, TileID id)
+{
+    Chunk& chunk = m_chunks[index];
+    std::fill(chunk.cells + start, chunk.cells + start + count, id);
+    chunk.version++;
+    chunk.dirty = true;
+}
+
+unsigned int TileMap::GetNumChunks() const
+{
+    return m_chunks.size();
+}
+
+unsigned int TileMap::GetChunkCols() const
+{
+    return m_chunkCols;
+}
+
+unsigned int TileMap::GetChunkRows() const
+{
+    return m_chunkRows;
+}
+
+unsigned int TileMap::GetNumCols() const
+{
+    return m_numCols;
+}
+
+unsigned int TileMap::GetNumRows() const
+{
+    return m_numRows;
+}
+
+////////////// EDIT RECORDING ////////////////
+
+void TileMap::SetRecorder(EditHistory* history)
+{
+    m_recorder = history;
+}
+
+EditHistory* TileMap::GetRecorder() const
+{
+    return m_recorder;
+}
@@ -0,0 +1,349 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <TileMap.h>
+#include <EditHistory.h>
+#include <TileOperations.h>
+
+namespace TileOperations
+{
+    // A run of cells in one row that still needs checking: x0 to x1 inclusive
+    struct Span
+    {
+        int x0;
+        int x1;
+        int y;
+    };
+
+    ////////////// HELPERS ////////////////
+
+        // Wraps an operation in BeginEdit/EndEdit when there is a history to record into
+    struct ScopedEdit
+    {
+        ScopedEdit(TileMap& map, EditHistory* history) : m_history(history)
+        {
+            if (m_history) { m_history->BeginEdit(&map); }
+        }
+        ~ScopedEdit()
+        {
+            if (m_history) { m_history->EndEdit(); }
+        }
+        EditHistory* m_history;
+    };
+
+        // Writes the part of the chunk covered by [min, max] using the tile 'pick' returns for each cell.
+        // With skipEmpty, EMPTY_TILE means "leave this cell alone" instead of "erase it"
+    template <typename PickTile>
+    static size_t WriteChunkArea(TileMap& map, unsigned int index, glm::ivec2 min, glm::ivec2 max,
+        bool skipEmpty, PickTile pick)
+    {
+        glm::ivec2 origin = map.GetChunkOrigin(index);
+        glm::ivec2 lo = glm::max(min, origin);
+        glm::ivec2 hi = glm::min(max, origin + glm::ivec2(TILE_CHUNK_SIZE - 1));
+
+        // Check first so untouched chunks don't get snapshotted or marked dirty
+        const TileID* read = map.GetChunk(index).cells;
+        bool changes = false;
+        for (int y = lo.y; y <= hi.y && !changes; ++y)
+        {
+            for (int x = lo.x; x <= hi.x; ++x)
+            {
+                TileID id = pick(x, y);
+                TileID current = read[(y - origin.y) * TILE_CHUNK_SIZE + (x - origin.x)];
+                if (id != current && !(skipEmpty && id == EMPTY_TILE))
+                {
+                    changes = true;
+                    break;
+                }
+            }
+        }
+        if (!changes)
+        {
+            return 0;
+        }
+
+        size_t numChanged = 0;
+        TileID* cells = map.BeginChunkWrite(index);
+        for (int y = lo.y; y <= hi.y; ++y)
+        {
+            TileID* row = cells + (y - origin.y) * TILE_CHUNK_SIZE;
+            for (int x = lo.x; x <= hi.x; ++x)
+            {
+                TileID id = pick(x, y);
+                TileID& cell = row[x - origin.x];
+                if (cell != id && !(skipEmpty && id == EMPTY_TILE))
+                {
+                    cell = id;
+                    numChanged++;
+                }
+            }
+        }
+        return numChanged;
+    }
+
+    template <typename PickTile>
+    static size_t WriteArea(TileMap& map, glm::ivec2 min, glm::ivec2 max, EditHistory* history,
+        bool skipEmpty, PickTile pick)
+    {
+        min = glm::max(min, glm::ivec2(0));
+        max = glm::min(max, glm::ivec2(map.GetNumCols() - 1, map.GetNumRows() - 1));
+        if (min.x > max.x || min.y > max.y)
+        {
+            return 0;
+        }
+
+        ScopedEdit edit(map, history);
+        size_t numChanged = 0;
+        for (int cy = min.y / TILE_CHUNK_SIZE; cy <= max.y / TILE_CHUNK_SIZE; ++cy)
+        {
+            for (int cx = min.x / TILE_CHUNK_SIZE; cx <= max.x / TILE_CHUNK_SIZE; ++cx)
+            {
+                unsigned int index = cy * map.GetChunkCols() + cx;
+                numChanged += WriteChunkArea(map, index, min, max, skipEmpty, pick);
+            }
+        }
+        return numChanged;
+    }
+
+    ////////////// RECTANGLE & PATTERN ////////////////
+
+    size_t FillRect(TileMap& map, glm::ivec2 min, glm::ivec2 max, TileID id, EditHistory* history)
+    {
+        return WriteArea(map, min, max, history, false, [id](int, int) { return id; });
+    }
+
+    size_t StampPattern(TileMap& map, glm::ivec2 min, glm::ivec2 max,
+        const std::vector<TileID>& pattern, glm::ivec2 patternSize, EditHistory* history)
+    {
+        if (patternSize.x <= 0 || patternSize.y <= 0 || pattern.size() < (size_t)(patternSize.x * patternSize.y))
+        {
+            return 0;
+        }
+        // Pattern is anchored at min so it lines up the same no matter where the area gets clamped
+        glm::ivec2 anchor = min;
+        return WriteArea(map, min, max, history, true, [&](int x, int y)
+        {
+            int px = (x - anchor.x) % patternSize.x;
+            int py = (y - anchor.y) % patternSize.y;
+            return pattern[py * patternSize.x + px];
+        });
+    }
+
+    ////////////// FLOOD FILL ////////////////
+
+    size_t FloodFill(TileMap& map, glm::ivec2 seed, TileID id, EditHistory* history)
+    {
+        if (!map.InBounds(seed.x, seed.y))
+        {
+            return 0;
+        }
+        TileID target = map.GetTile(seed.x, seed.y);
+        if (target == id)
+        {
+            return 0;
+        }
+
+        ScopedEdit edit(map, history);
+        const int numCols = map.GetNumCols();
+        const int numRows = map.GetNumRows();
+        size_t numChanged = 0;
+
+        std::vector<Span> stack;
+        stack.push_back({ seed.x, seed.x, seed.y });
+        while (!stack.empty())
+        {
+            Span span = stack.back();
+            stack.pop_back();
+
+            int x = span.x0;
+            while (x <= span.x1)
+            {
+                if (map.GetTile(x, span.y) != target)
+                {
+                    x++;
+                    continue;
+                }
+                // Grow the run both ways, then fill it
+                int left = x;
+                while (left > 0 && map.GetTile(left - 1, span.y) == target) { left--; }
+                int right = x;
+                while (right < numCols - 1 && map.GetTile(right + 1, span.y) == target) { right++; }
+
+                for (int fx = left; fx <= right; ++fx)
+                {
+                    map.SetTile(fx, span.y, id);
+                }
+                numChanged += right - left + 1;
+
+                // Rows above and below get checked over the same range
+                if (span.y > 0) { stack.push_back({ left, right, span.y - 1 }); }
+                if (span.y < numRows - 1) { stack.push_back({ left, right, span.y + 1 }); }
+                x = right + 1;
+            }
+        }
+        return numChanged;
+    }
+
+        // Span fill restricted to one chunk. Anything that leaves the chunk goes to 'escaped'
+        // so it can be handed to the neighbouring chunk in the next wave
+    static size_t FillChunk(TileMap& map, unsigned int index, std::vector<Span>& stack,
+        TileID target, TileID id, std::vector<Span>& escaped)
+    {
+        glm::ivec2 origin = map.GetChunkOrigin(index);
+        int width = std::min(TILE_CHUNK_SIZE, (int)map.GetNumCols() - origin.x);
+        int height = std::min(TILE_CHUNK_SIZE, (int)map.GetNumRows() - origin.y);
+        const TileID* read = map.GetChunk(index).cells;
+        TileID* cells = nullptr;
+        size_t numChanged = 0;
+
+        while (!stack.empty())
+        {
+            Span span = stack.back();
+            stack.pop_back();
+
+            int ly = span.y - origin.y;
+            const TileID* row = read + ly * TILE_CHUNK_SIZE;
+            int x = span.x0 - origin.x;
+            int x1 = span.x1 - origin.x;
+            while (x <= x1)
+            {
+                if (row[x] != target)
+                {
+                    x++;
+                    continue;
+                }
+                int left = x;
+                while (left > 0 && row[left - 1] == target) { left--; }
+                int right = x;
+                while (right < width - 1 && row[right + 1] == target) { right++; }
+
+                // Only snapshot the chunk once something in it actually changes
+                if (!cells)
+                {
+                    cells = map.BeginChunkWrite(index);
+                }
+                std::fill(cells + ly * TILE_CHUNK_SIZE + left, cells + ly * TILE_CHUNK_SIZE + right + 1, id);
+                numChanged += right - left + 1;
+
+                int gLeft = origin.x + left;
+                int gRight = origin.x + right;
+                if (left == 0 && origin.x > 0) { escaped.push_back({ gLeft - 1, gLeft - 1, span.y }); }
+                if (right == width - 1 && origin.x + width < (int)map.GetNumCols()) { escaped.push_back({ gRight + 1, gRight + 1, span.y }); }
+
+                if (ly > 0) { stack.push_back({ gLeft, gRight, span.y - 1 }); }
+                else if (span.y > 0) { escaped.push_back({ gLeft, gRight, span.y - 1 }); }
+
+                if (ly < height - 1) { stack.push_back({ gLeft, gRight, span.y + 1 }); }
+                else if (span.y < (int)map.GetNumRows() - 1) { escaped.push_back({ gLeft, gRight, span.y + 1 }); }
+
+                x = right + 1;
+            }
+        }
+        return numChanged;
+    }
+
+    size_t ParallelFloodFill(TileMap& map, glm::ivec2 seed, TileID id, EditHistory* history, unsigned int numThreads)
+    {
+        if (!map.InBounds(seed.x, seed.y))
+        {
+            return 0;
+        }
+        TileID target = map.GetTile(seed.x, seed.y);
+        if (target == id)
+        {
+            return 0;
+        }
+        if (numThreads == 0)
+        {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        ScopedEdit edit(map, history);
+
+        // The fill runs in waves. Every chunk with pending spans is filled by exactly one
+        // worker, spans that cross into other chunks are collected and become the next wave.
+        struct ChunkWork
+        {
+            unsigned int chunk;
+            std::vector<Span> spans;
+        };
+        std::vector<ChunkWork> wave;
+        wave.push_back({ map.GetChunkIndex(seed.x, seed.y), { { seed.x, seed.x, seed.y } } });
+
+        std::vector<std::vector<Span>> escaped(numThreads);
+        std::atomic<size_t> numChanged(0);
+        std::unordered_map<unsigned int, size_t> nextIndex;
+
+        while (!wave.empty())
+        {
+            std::atomic<size_t> nextWork(0);
+            auto worker = [&](unsigned int thread)
+            {
+                size_t changed = 0;
+                size_t i;
+                while ((i = nextWork.fetch_add(1)) < wave.size())
+                {
+                    changed += FillChunk(map, wave[i].chunk, wave[i].spans, target, id, escaped[thread]);
+                }
+                numChanged += changed;
+            };
+
+            unsigned int waveThreads = std::min<size_t>(numThreads, wave.size());
+            if (waveThreads <= 1)
+            {
+                worker(0);
+            }
+            else
+            {
+                std::vector<std::thread> threads;
+                for (unsigned int t = 1; t < waveThreads; ++t)
+                {
+                    threads.emplace_back(worker, t);
+                }
+                worker(0);
+                for (std::thread& thread : threads)
+                {
+                    thread.join();
+                }
+            }
+
+            // Group escaped spans by chunk. Nothing is writing now, so spans over cells that
+            // were already filled can be dropped here
+            wave.clear();
+            nextIndex.clear();
+            for (std::vector<Span>& spans : escaped)
+            {
+                for (const Span& span : spans)
+                {
+                    bool hasTarget = false;
+                    for (int x = span.x0; x <= span.x1 && !hasTarget; ++x)
+                    {
+                        hasTarget = map.GetTile(x, span.y) == target;
+                    }
+                    if (!hasTarget)
+                    {
+                        continue;
+                    }
+                    unsigned int chunk = map.GetChunkIndex(span.x0, span.y);
+                    auto found = nextIndex.find(chunk);
+                    if (found == nextIndex.end())
+                    {
+                        nextIndex[chunk] = wave.size();
+                        wave.push_back({ chunk, { span } });
+                    }
+                    else
+                    {
+                        wave[found->second].spans.push_back(span);
+                    }
+                }
+                spans.clear();
+            }
+        }
+        return numChanged;
+    }
+}
@@ -0,0 +1,207 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include <JobSystem.h>
+#include <RenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <TileMap.h>
+#include <TileRenderer.h>
+
+/////////////// CONSTRUCTOR /////////////////////////
+
+TileRenderer::TileRenderer(TileMap* tileMap, glm::vec3 tileSize)
+    : m_tileMap(tileMap)
+    , m_tileSize(tileSize)
+{
+    RenderDevice* device = RenderDevice::Get();
+    m_chunks.resize(m_tileMap->GetNumChunks());
+    for (unsigned int i = 0; i < m_chunks.size(); ++i)
+    {
+        m_chunks[i].VBO = device->CreateBuffer();
+        // Everything starts dirty so the first rebuild fills every chunk
+        m_tileMap->GetChunk(i).dirty = true;
+    }
+    CreateView();
+}
+
+TileRenderer::~TileRenderer()
+{
+    RenderDevice* device = RenderDevice::Get();
+    for (unsigned int view = 0; view < m_views.size(); ++view)
+    {
+        DestroyView(view);
+    }
+    for (ChunkBuffers& chunk : m_chunks)
+    {
+        device->DeleteBuffer(chunk.VBO);
+    }
+}
+
+////////////////// VIEWS /////////////////////////
+
+unsigned int TileRenderer::CreateView()
+{
+    unsigned int view = 0;
+    while (view < m_views.size() && !m_views[view].empty())
+    {
+        view++;
+    }
+    if (view == m_views.size())
+    {
+        m_views.emplace_back();
+    }
+
+    RenderDevice* device = RenderDevice::Get();
+    std::vector<unsigned int>& vertexArrays = m_views[view];
+    vertexArrays.resize(m_chunks.size());
+    for (unsigned int i = 0; i < m_chunks.size(); ++i)
+    {
+        vertexArrays[i] = device->CreateVertexArray();
+        device->BindVertexArray(vertexArrays[i]);
+        device->BindBuffer(GL_ARRAY_BUFFER, m_chunks[i].VBO);
+
+        device->EnableVertexAttribArray(0);
+        device->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(TileVertex), 0);
+        device->EnableVertexAttribArray(1);
+        device->VertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(TileVertex), offsetof(TileVertex, Color));
+    }
+    device->BindVertexArray(0);
+    return view;
+}
+
+void TileRenderer::DestroyView(unsigned int view)
+{
+    if (view >= m_views.size())
+    {
+        return;
+    }
+    RenderDevice* device = RenderDevice::Get();
+    for (unsigned int vertexArray : m_views[view])
+    {
+        device->DeleteVertexArray(vertexArray);
+    }
+    m_views[view].clear();
+}
+
+////////////////// REBUILDING /////////////////////////
+
+unsigned int TileRenderer::RebuildDirtyChunks()
+{
+    PROFILE_SCOPE("RebuildChunks");
+    m_dirty.clear();
+    for (unsigned int i = 0; i < m_chunks.size(); ++i)
+    {
+        TileMap::Chunk& chunk = m_tileMap->GetChunk(i);
+        if (chunk.dirty)
+        {
+            chunk.dirty = false;
+            m_dirty.push_back(i);
+        }
+    }
+    if (m_scratch.size() < m_dirty.size())
+    {
+        m_scratch.resize(m_dirty.size());
+    }
+
+    // Chunks only read their own cells, so they mesh independently. Single chunk edits (the
+    // common case while painting) skip the scheduler entirely
+    JobSystem::Get().ParallelFor(m_dirty.size(), 4, [this](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            m_scratch[i].clear();
+            BuildChunkVertices(*m_tileMap, m_dirty[i], m_tileSize, m_scratch[i]);
+        }
+    });
+
+    // GL calls have to come from the thread that owns the context
+    RenderDevice* device = RenderDevice::Get();
+    for (unsigned int i = 0; i < m_dirty.size(); ++i)
+    {
+        const std::vector<TileVertex>& vertices = m_scratch[i];
+        ChunkBuffers& buffers = m_chunks[m_dirty[i]];
+        buffers.numVertices = vertices.size();
+        device->BindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+        device->BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TileVertex), vertices.data(), GL_DYNAMIC_DRAW);
+        RenderStats::Get().Add(RENDER_STAT_BUFFER_UPLOADS);
+        RenderStats::Get().Add(RENDER_STAT_BUFFER_BYTES, vertices.size() * sizeof(TileVertex));
+    }
+    return m_dirty.size();
+}
+
+void TileRenderer::BuildChunkVertices(const TileMap& tileMap, unsigned int index, glm::vec3 tileSize,
+    std::vector<TileVertex>& out)
+{
+    const TileMap::Chunk& chunk = tileMap.GetChunk(index);
+    glm::ivec2 origin = tileMap.GetChunkOrigin(index);
+
+    for (unsigned int y = 0; y < TILE_CHUNK_SIZE; ++y)
+    {
+        for (unsigned int x = 0; x < TILE_CHUNK_SIZE; ++x)
+        {
+            TileID id = chunk.cells[y * TILE_CHUNK_SIZE + x];
+            if (id == EMPTY_TILE)
+            {
+                continue;
+            }
+            glm::vec3 color = GetTileColor(id);
+            // Tiles sit on the grid plane, x across and z down like the grid lines
+            glm::vec3 corner((origin.x + x) * tileSize.x, 0.0f, (origin.y + y) * tileSize.z);
+            glm::vec3 right(tileSize.x, 0.0f, 0.0f);
+            glm::vec3 down(0.0f, 0.0f, tileSize.z);
+
+            out.push_back({ corner, color });
+            out.push_back({ corner + right, color });
+            out.push_back({ corner + right + down, color });
+
+            out.push_back({ corner, color });
+            out.push_back({ corner + right + down, color });
+            out.push_back({ corner + down, color });
+        }
+    }
+}
+
+glm::vec3 TileRenderer::GetTileColor(TileID id)
+{
+    // Placeholder palette until tiles have real textures
+    static const glm::vec3 palette[] =
+    {
+        glm::vec3(0.184f, 0.525f, 0.537f),
+        glm::vec3(0.573f, 0.078f, 0.047f),
+        glm::vec3(1.0f, 0.702f, 0.816f),
+        glm::vec3(0.118f, 0.118f, 0.141f),
+        glm::vec3(0.984f, 0.749f, 0.141f),
+        glm::vec3(0.345f, 0.580f, 0.259f),
+        glm::vec3(0.447f, 0.318f, 0.651f),
+        glm::vec3(1.0f, 0.973f, 0.941f),
+    };
+    return palette[(id - 1) % (sizeof(palette) / sizeof(palette[0]))];
+}
+
+////////////////// DRAWING /////////////////////////
+
+void TileRenderer::Draw(unsigned int view)
+{
+    if (view >= m_views.size() || m_views[view].empty())
+    {
+        return;
+    }
+    RenderDevice* device = RenderDevice::Get();
+    RenderStats& stats = RenderStats::Get();
+    const std::vector<unsigned int>& vertexArrays = m_views[view];
+    for (unsigned int i = 0; i < m_chunks.size(); ++i)
+    {
+        const ChunkBuffers& chunk = m_chunks[i];
+        if (chunk.numVertices == 0)
+        {
+            continue;
+        }
+        device->BindVertexArray(vertexArrays[i]);
+        device->DrawArrays(GL_TRIANGLES, 0, chunk.numVertices);
+        stats.Add(RENDER_STAT_STATE_CHANGES);
+        stats.AddDraw(GL_TRIANGLES, chunk.numVertices);
+    }
+}
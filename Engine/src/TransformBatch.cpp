@@ -0,0 +1,473 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC lets any function use AVX intrinsics
+#define TRANSFORM_TARGET_AVX2
+#else
+#define TRANSFORM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+#include <TransformBatch.h>
+
+// The parts of a batch the kernels read
+struct TransformStreams
+{
+    const float* positionX;
+    const float* positionY;
+    const float* positionZ;
+    const float* rotationX;
+    const float* rotationY;
+    const float* rotationZ;
+    const float* rotationW;
+    const float* scaleX;
+    const float* scaleY;
+    const float* scaleZ;
+};
+
+////////////////// INSTANCES /////////////////////////
+
+unsigned int TransformBatch::Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    unsigned int index = GetCount();
+    m_positionX.push_back(0.0f);
+    m_positionY.push_back(0.0f);
+    m_positionZ.push_back(0.0f);
+    m_rotationX.push_back(0.0f);
+    m_rotationY.push_back(0.0f);
+    m_rotationZ.push_back(0.0f);
+    m_rotationW.push_back(1.0f);
+    m_scaleX.push_back(1.0f);
+    m_scaleY.push_back(1.0f);
+    m_scaleZ.push_back(1.0f);
+    Set(index, position, rotation, scale);
+    return index;
+}
+
+void TransformBatch::Set(unsigned int index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    SetPosition(index, position);
+    SetRotation(index, rotation);
+    SetScale(index, scale);
+}
+
+void TransformBatch::SetPosition(unsigned int index, const glm::vec3& position)
+{
+    m_positionX[index] = position.x;
+    m_positionY[index] = position.y;
+    m_positionZ[index] = position.z;
+}
+
+void TransformBatch::SetRotation(unsigned int index, const glm::quat& rotation)
+{
+    m_rotationX[index] = rotation.x;
+    m_rotationY[index] = rotation.y;
+    m_rotationZ[index] = rotation.z;
+    m_rotationW[index] = rotation.w;
+}
+
+void TransformBatch::SetScale(unsigned int index, const glm::vec3& scale)
+{
+    m_scaleX[index] = scale.x;
+    m_scaleY[index] = scale.y;
+    m_scaleZ[index] = scale.z;
+}
+
+glm::vec3 TransformBatch::GetPosition(unsigned int index) const
+{
+    return glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]);
+}
+
+glm::quat TransformBatch::GetRotation(unsigned int index) const
+{
+    return glm::quat(m_rotationW[index], m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+}
+
+glm::vec3 TransformBatch::GetScale(unsigned int index) const
+{
+    return glm::vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]);
+}
+
+unsigned int TransformBatch::GetCount() const
+{
+    return (unsigned int)m_positionX.size();
+}
+
+void TransformBatch::Reserve(unsigned int count)
+{
+    for (std::vector<float>* stream : { &m_positionX, &m_positionY, &m_positionZ, &m_rotationX, &m_rotationY,
+        &m_rotationZ, &m_rotationW, &m_scaleX, &m_scaleY, &m_scaleZ })
+    {
+        stream->reserve(count);
+    }
+}
+
+void TransformBatch::Clear()
+{
+    for (std::vector<float>* stream : { &m_positionX, &m_positionY, &m_positionZ, &m_rotationX, &m_rotationY,
+        &m_rotationZ, &m_rotationW, &m_scaleX, &m_scaleY, &m_scaleZ })
+    {
+        stream->clear();
+    }
+}
+
+////////////////// KERNELS /////////////////////////
+
+// Every kernel builds the rotation the way glm::mat3_cast does, with each column scaled, so the
+// results match glm's to rounding
+
+static void ComputeScalar(const TransformStreams& in, unsigned int begin, unsigned int end,
+    const float* viewProjection, glm::mat4* world, glm::mat4* clip)
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        float x = in.rotationX[i];
+        float y = in.rotationY[i];
+        float z = in.rotationZ[i];
+        float w = in.rotationW[i];
+        float xx = 2.0f * x * x, yy = 2.0f * y * y, zz = 2.0f * z * z;
+        float xy = 2.0f * x * y, xz = 2.0f * x * z, yz = 2.0f * y * z;
+        float wx = 2.0f * w * x, wy = 2.0f * w * y, wz = 2.0f * w * z;
+
+        glm::mat4 m;
+        m[0] = glm::vec4(1.0f - yy - zz, xy + wz, xz - wy, 0.0f) * in.scaleX[i];
+        m[1] = glm::vec4(xy - wz, 1.0f - xx - zz, yz + wx, 0.0f) * in.scaleY[i];
+        m[2] = glm::vec4(xz + wy, yz - wx, 1.0f - xx - yy, 0.0f) * in.scaleZ[i];
+        m[3] = glm::vec4(in.positionX[i], in.positionY[i], in.positionZ[i], 1.0f);
+        if (world)
+        {
+            world[i] = m;
+        }
+        if (clip)
+        {
+            const glm::mat4& vp = *(const glm::mat4*)viewProjection;
+            clip[i] = vp * m;
+        }
+    }
+}
+
+#ifdef TRANSFORM_X86
+
+// Turns one column of four instances (x's in one register, y's in the next, ...) into that
+// column of each instance's matrix
+static inline void StoreColumnSSE(float* out, unsigned int column, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(out + 0 * 16 + column * 4, x);
+    _mm_storeu_ps(out + 1 * 16 + column * 4, y);
+    _mm_storeu_ps(out + 2 * 16 + column * 4, z);
+    _mm_storeu_ps(out + 3 * 16 + column * 4, w);
+}
+
+// Instances begin to end, like ComputeScalar. Returns the first one it didn't get to, the rest of
+// a group of four
+static unsigned int ComputeSSE(const TransformStreams& in, unsigned int begin, unsigned int end,
+    const float* viewProjection, glm::mat4* world, glm::mat4* clip)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 vp[16];
+    if (clip)
+    {
+        for (unsigned int k = 0; k < 16; ++k)
+        {
+            vp[k] = _mm_set1_ps(viewProjection[k]);
+        }
+    }
+
+    unsigned int i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(in.rotationX + i);
+        __m128 y = _mm_loadu_ps(in.rotationY + i);
+        __m128 z = _mm_loadu_ps(in.rotationZ + i);
+        __m128 w = _mm_loadu_ps(in.rotationW + i);
+        __m128 x2 = _mm_mul_ps(x, two);
+        __m128 y2 = _mm_mul_ps(y, two);
+        __m128 z2 = _mm_mul_ps(z, two);
+        __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+        __m128 sx = _mm_loadu_ps(in.scaleX + i);
+        __m128 sy = _mm_loadu_ps(in.scaleY + i);
+        __m128 sz = _mm_loadu_ps(in.scaleZ + i);
+        // m[column][row]
+        __m128 m[4][4];
+        m[0][0] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy), zz), sx);
+        m[0][1] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        m[0][2] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        m[1][0] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        m[1][1] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), zz), sy);
+        m[1][2] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        m[2][0] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        m[2][1] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        m[2][2] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), yy), sz);
+        m[3][0] = _mm_loadu_ps(in.positionX + i);
+        m[3][1] = _mm_loadu_ps(in.positionY + i);
+        m[3][2] = _mm_loadu_ps(in.positionZ + i);
+
+        if (world)
+        {
+            float* out = (float*)(world + i);
+            StoreColumnSSE(out, 0, m[0][0], m[0][1], m[0][2], zero);
+            StoreColumnSSE(out, 1, m[1][0], m[1][1], m[1][2], zero);
+            StoreColumnSSE(out, 2, m[2][0], m[2][1], m[2][2], zero);
+            StoreColumnSSE(out, 3, m[3][0], m[3][1], m[3][2], one);
+        }
+        if (clip)
+        {
+            float* out = (float*)(clip + i);
+            for (unsigned int column = 0; column < 4; ++column)
+            {
+                __m128 result[4];
+                for (unsigned int row = 0; row < 4; ++row)
+                {
+                    // vp[k * 4 + row] is viewProjection[k][row]. Only the translation column has a w
+                    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vp[row], m[column][0]),
+                        _mm_mul_ps(vp[4 + row], m[column][1])), _mm_mul_ps(vp[8 + row], m[column][2]));
+                    result[row] = column == 3 ? _mm_add_ps(sum, vp[12 + row]) : sum;
+                }
+                StoreColumnSSE(out, column, result[0], result[1], result[2], result[3]);
+            }
+        }
+    }
+    return i;
+}
+
+// Same as the SSE one for eight instances, each 128 bit half transposed on its own
+TRANSFORM_TARGET_AVX2
+static inline void StoreColumnAVX2(float* out, unsigned int column, __m256 x, __m256 y, __m256 z, __m256 w)
+{
+    __m256 xy0 = _mm256_unpacklo_ps(x, y);
+    __m256 xy1 = _mm256_unpackhi_ps(x, y);
+    __m256 zw0 = _mm256_unpacklo_ps(z, w);
+    __m256 zw1 = _mm256_unpackhi_ps(z, w);
+    // Instances 0 to 3 in the low halves, 4 to 7 in the high ones
+    __m256 instance[4];
+    instance[0] = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+    instance[1] = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+    instance[2] = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+    instance[3] = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        _mm_storeu_ps(out + i * 16 + column * 4, _mm256_castps256_ps128(instance[i]));
+        _mm_storeu_ps(out + (i + 4) * 16 + column * 4, _mm256_extractf128_ps(instance[i], 1));
+    }
+}
+
+TRANSFORM_TARGET_AVX2
+static unsigned int ComputeAVX2(const TransformStreams& in, unsigned int begin, unsigned int end,
+    const float* viewProjection, glm::mat4* world, glm::mat4* clip)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 vp[16];
+    if (clip)
+    {
+        for (unsigned int k = 0; k < 16; ++k)
+        {
+            vp[k] = _mm256_set1_ps(viewProjection[k]);
+        }
+    }
+
+    unsigned int i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(in.rotationX + i);
+        __m256 y = _mm256_loadu_ps(in.rotationY + i);
+        __m256 z = _mm256_loadu_ps(in.rotationZ + i);
+        __m256 w = _mm256_loadu_ps(in.rotationW + i);
+        __m256 x2 = _mm256_mul_ps(x, two);
+        __m256 y2 = _mm256_mul_ps(y, two);
+        __m256 z2 = _mm256_mul_ps(z, two);
+        __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+        __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+        __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+        __m256 sx = _mm256_loadu_ps(in.scaleX + i);
+        __m256 sy = _mm256_loadu_ps(in.scaleY + i);
+        __m256 sz = _mm256_loadu_ps(in.scaleZ + i);
+        __m256 m[4][4];
+        m[0][0] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, yy), zz), sx);
+        m[0][1] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+        m[0][2] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+        m[1][0] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+        m[1][1] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, xx), zz), sy);
+        m[1][2] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+        m[2][0] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+        m[2][1] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+        m[2][2] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, xx), yy), sz);
+        m[3][0] = _mm256_loadu_ps(in.positionX + i);
+        m[3][1] = _mm256_loadu_ps(in.positionY + i);
+        m[3][2] = _mm256_loadu_ps(in.positionZ + i);
+
+        if (world)
+        {
+            float* out = (float*)(world + i);
+            StoreColumnAVX2(out, 0, m[0][0], m[0][1], m[0][2], zero);
+            StoreColumnAVX2(out, 1, m[1][0], m[1][1], m[1][2], zero);
+            StoreColumnAVX2(out, 2, m[2][0], m[2][1], m[2][2], zero);
+            StoreColumnAVX2(out, 3, m[3][0], m[3][1], m[3][2], one);
+        }
+        if (clip)
+        {
+            float* out = (float*)(clip + i);
+            for (unsigned int column = 0; column < 4; ++column)
+            {
+                __m256 result[4];
+                for (unsigned int row = 0; row < 4; ++row)
+                {
+                    __m256 sum = column == 3 ? vp[12 + row] : zero;
+                    sum = _mm256_fmadd_ps(vp[row], m[column][0], sum);
+                    sum = _mm256_fmadd_ps(vp[4 + row], m[column][1], sum);
+                    result[row] = _mm256_fmadd_ps(vp[8 + row], m[column][2], sum);
+                }
+                StoreColumnAVX2(out, column, result[0], result[1], result[2], result[3]);
+            }
+        }
+    }
+    return i;
+}
+
+static bool CpuHasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osSavesAVX = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // The OS has to save the wide registers too
+    if (!fma || !osSavesAVX || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+////////////////// DISPATCH /////////////////////////
+
+// Function static so it's usable from other statics' constructors too. -1 means no override
+static int& GetKernelOverride()
+{
+    static int kernel = -1;
+    return kernel;
+}
+
+bool TransformBatch::IsKernelSupported(Transform_Kernel kernel)
+{
+    switch (kernel)
+    {
+    case TRANSFORM_KERNEL_SCALAR:
+        return true;
+#ifdef TRANSFORM_X86
+    case TRANSFORM_KERNEL_SSE:
+        return true;
+    case TRANSFORM_KERNEL_AVX2:
+    {
+        static bool hasAVX2 = CpuHasAVX2();
+        return hasAVX2;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+Transform_Kernel TransformBatch::GetKernel()
+{
+    int kernel = GetKernelOverride();
+    if (kernel >= 0 && IsKernelSupported((Transform_Kernel)kernel))
+    {
+        return (Transform_Kernel)kernel;
+    }
+    if (IsKernelSupported(TRANSFORM_KERNEL_AVX2))
+    {
+        return TRANSFORM_KERNEL_AVX2;
+    }
+    if (IsKernelSupported(TRANSFORM_KERNEL_SSE))
+    {
+        return TRANSFORM_KERNEL_SSE;
+    }
+    return TRANSFORM_KERNEL_SCALAR;
+}
+
+void TransformBatch::SetKernel(Transform_Kernel kernel)
+{
+    GetKernelOverride() = (int)kernel;
+}
+
+void TransformBatch::ResetKernel()
+{
+    GetKernelOverride() = -1;
+}
+
+const char* TransformBatch::GetKernelName(Transform_Kernel kernel)
+{
+    switch (kernel)
+    {
+    case TRANSFORM_KERNEL_SCALAR:
+        return "scalar";
+    case TRANSFORM_KERNEL_SSE:
+        return "sse";
+    case TRANSFORM_KERNEL_AVX2:
+        return "avx2";
+    }
+    return "";
+}
+
+void TransformBatch::ComputeWorld(glm::mat4* world) const
+{
+    Compute(NULL, world, NULL);
+}
+
+void TransformBatch::ComputeWorldClip(const glm::mat4& viewProjection, glm::mat4* world, glm::mat4* clip) const
+{
+    Compute(&viewProjection[0][0], world, clip);
+}
+
+void TransformBatch::Compute(const float* viewProjection, glm::mat4* world, glm::mat4* clip) const
+{
+    TransformStreams in = { m_positionX.data(), m_positionY.data(), m_positionZ.data(), m_rotationX.data(),
+        m_rotationY.data(), m_rotationZ.data(), m_rotationW.data(), m_scaleX.data(), m_scaleY.data(), m_scaleZ.data() };
+    unsigned int count = GetCount();
+    unsigned int done = 0;
+#ifdef TRANSFORM_X86
+    switch (GetKernel())
+    {
+    case TRANSFORM_KERNEL_AVX2:
+        done = ComputeAVX2(in, 0, count, viewProjection, world, clip);
+        // What's left over might still fill a group of four
+        done = ComputeSSE(in, done, count, viewProjection, world, clip);
+        break;
+    case TRANSFORM_KERNEL_SSE:
+        done = ComputeSSE(in, 0, count, viewProjection, world, clip);
+        break;
+    default:
+        break;
+    }
+#endif
+    ComputeScalar(in, done, count, viewProjection, world, clip);
+}
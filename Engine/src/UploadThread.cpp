@@ -0,0 +1,161 @@
+#define GLFW_INCLUDE_NONE
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Profiler.h>
+#include <RenderDevice.h>
+
+#include <UploadThread.h>
+
+UploadThread& UploadThread::Get()
+{
+    static UploadThread uploadThread;
+    return uploadThread;
+}
+
+bool UploadThread::Start(GLFWwindow* shareWith)
+{
+    if (IsRunning())
+    {
+        return true;
+    }
+    if (!shareWith || !RenderDevice::Get()->NeedsContext())
+    {
+        std::cout << "No context to share, uploading on the render thread" << std::endl;
+        return false;
+    }
+
+    // Same version hints as the window it shares with, which are still set from creating it.
+    // GLFW can't report a hint, but a window that hasn't been shown or hidden yet still has the
+    // visibility it was made with, so that's what the hint goes back to for the next window
+    int visible = glfwGetWindowAttrib(shareWith, GLFW_VISIBLE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_context = glfwCreateWindow(1, 1, "Upload", NULL, shareWith);
+    glfwWindowHint(GLFW_VISIBLE, visible);
+    if (!m_context)
+    {
+        std::cout << "Failed to create a shared upload context, uploading on the render thread" << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = true;
+        m_quit = false;
+        m_failed = false;
+    }
+    m_thread = std::thread(&UploadThread::ThreadLoop, this);
+    return true;
+}
+
+void UploadThread::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+        {
+            return;
+        }
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+    glfwDestroyWindow(m_context);
+    m_context = NULL;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+}
+
+bool UploadThread::IsRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+bool UploadThread::Submit(std::function<void()> upload, std::function<void()> onDone)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || m_quit || m_failed)
+        {
+            return false;
+        }
+        m_tasks.push_back({ std::move(upload), std::move(onDone) });
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void UploadThread::ThreadLoop()
+{
+    glfwMakeContextCurrent(m_context);
+    Profiler::Get().SetThreadName("Upload");
+    RenderDevice* device = RenderDevice::Get();
+    device->InitContext();
+
+    std::vector<Task> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_quit || !m_tasks.empty(); });
+            if (m_tasks.empty())
+            {
+                break;
+            }
+            // Everything queued so far goes behind one fence
+            batch.assign(m_tasks.begin(), m_tasks.end());
+            m_tasks.clear();
+        }
+
+        {
+            PROFILE_SCOPE("Upload");
+            for (Task& task : batch)
+            {
+                task.upload();
+            }
+        }
+
+        {
+            PROFILE_SCOPE("UploadFence");
+            unsigned int fence = device->CreateFence();
+            Fence_Status status;
+            do
+            {
+                status = device->WaitFence(fence, UPLOAD_FENCE_WAIT_NS);
+            }
+            while (status == FENCE_TIMEOUT);
+            device->DeleteFence(fence);
+
+            if (status == FENCE_FAILED)
+            {
+                // The fence will never signal, most likely the context is gone. This batch still
+                // finishes so nobody waits on it forever, and new work goes back to the render thread
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_failed)
+                {
+                    std::cout << "Upload fence failed, uploading on the render thread from now on" << std::endl;
+                    m_failed = true;
+                }
+            }
+        }
+
+        for (Task& task : batch)
+        {
+            if (task.onDone)
+            {
+                task.onDone();
+            }
+        }
+        batch.clear();
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
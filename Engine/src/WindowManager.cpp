@@ -1,6 +1,7 @@
 ﻿#define GLFW_INCLUDE_NONE
 #include <complex>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <filesystem>
 #include <glad/glad.h>
@@ -9,6 +10,14 @@
 #include <glm/glm.hpp>
 
 #include <WindowManager.h>
+#include <Picking.h>
+#include <RenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <ShaderCache.h>
+#include <RenderResources.h>
+#include <ShaderLibrary.h>
+#include <UploadThread.h>
 
 #include "Engine.h"
 
@@ -22,7 +31,6 @@ namespace WindowManager
 
     bool m_bMouseWheelPressed = false;
     Window* currentWindow;
-    bool m_bUICaptureMouse = false;
     bool firstMouse = true;
     float yaw = -90.0f;
     float pitch = 0.0f;
@@ -34,16 +42,41 @@ namespace WindowManager
 
     static void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
     static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+    static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void char_callback(GLFWwindow* window, unsigned int codepoint);
+
+    // Input goes to the window it happened in, which isn't always the focused one (hovering
+    // another window, or a replay into a hidden one)
+    static Window* GetTargetWindow(GLFWwindow* window)
+    {
+        Window* target = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        return target ? target : currentWindow;
+    }
+
+    // Recording and replay see every event here first
+    static bool AcceptInput(Window* target, const InputEvent& event)
+    {
+        return !target || target->FilterInput(event);
+    }
 
     ////////////// GLOBAL CALLBACK FUNCTIONS //////////////////////
 
     void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     {
-        // Viewport adjusts to new size
-        glViewport(0, 0, width, height);
-        if (currentWindow)
+        InputEvent event;
+        event.type = INPUT_EVENT_RESIZE;
+        event.x = width;
+        event.y = height;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
         {
-            currentWindow->SetFramebufferValues(width, height);
+            return;
+        }
+
+        // The viewport follows on the window's next frame, its context may not be current here
+        if (target)
+        {
+            target->SetFramebufferValues(width, height);
         }
     }
 
@@ -65,6 +98,22 @@ namespace WindowManager
 
     static void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     {
+        InputEvent event;
+        event.type = INPUT_EVENT_CURSOR;
+        event.x = xposIn;
+        event.y = yposIn;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
+        {
+            return;
+        }
+
+        if (target)
+        {
+            // Hover and painting, only marks the tiles under the cursor for redraw
+            target->OnCursorMoved(xposIn, yposIn);
+        }
+
         if (m_bMouseWheelPressed)
         {
             //std::cout << xposIn << " " << yposIn << std::endl;
@@ -85,11 +134,11 @@ namespace WindowManager
             //std::cout << xoffset << " " << yoffset << std::endl;
             lastX = xpos;
             lastY = ypos;
-            if (currentWindow)
+            if (target)
             {
-                //std::cout << currentWindow->GetTitle() << " x: " << xoffset << std::endl;
-                //std::cout << currentWindow->GetTitle() << " y: " << yoffset << std::endl;
-                currentWindow->TransformScreen(xoffset, yoffset);
+                //std::cout << target->GetTitle() << " x: " << xoffset << std::endl;
+                //std::cout << target->GetTitle() << " y: " << yoffset << std::endl;
+                target->TransformScreen(xoffset, yoffset);
             }
             else
             {
@@ -100,12 +149,43 @@ namespace WindowManager
 
     static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     {
+        InputEvent event;
+        event.type = INPUT_EVENT_BUTTON;
+        event.code = button;
+        event.action = action;
+        event.mods = mods;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
+        {
+            return;
+        }
+
         ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods);
 
-        if (!m_bUICaptureMouse)
+        // Strokes always end on release, even if the cursor ended up over the UI
+        if (target && action == GLFW_RELEASE
+            && (button == GLFW_MOUSE_BUTTON_LEFT || button == GLFW_MOUSE_BUTTON_RIGHT))
+        {
+            target->EndStroke();
+        }
+
+        if (target && target->IsUICapturingMouse())
         {
-            if (currentWindow)
+            // ImGui needs a couple of frames to show the click
+            target->MarkDirty(2);
+        }
+        else
+        {
+            if (target)
             {
+                if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+                {
+                    target->BeginStroke(false);
+                }
+                if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
+                {
+                    target->BeginStroke(true);
+                }
                 if (button == GLFW_MOUSE_BUTTON_MIDDLE && action == GLFW_PRESS)
                 {
                     //std::cout << "MIDDLE MOUSE PRESSED" << std::endl;
@@ -116,7 +196,7 @@ namespace WindowManager
                     // std::cout << "MIDDLE MOUSE RELEASED" << std::endl;
                     m_bMouseWheelPressed = false;
                     firstMouse = true;
-                    currentWindow->TransformScreen(0.0f, 0.0f);
+                    target->TransformScreen(0.0f, 0.0f);
                 }
             }
         }
@@ -124,16 +204,89 @@ namespace WindowManager
 
     static void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     {
-        if (!m_bUICaptureMouse)
+        InputEvent event;
+        event.type = INPUT_EVENT_SCROLL;
+        event.x = xoffset;
+        event.y = yoffset;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
+        {
+            return;
+        }
+        if (!target)
         {
-            if (currentWindow)
+            return;
+        }
+
+        if (!target->IsUICapturingMouse())
+        {
+            float zoom = static_cast<float>(yoffset);
+            target->ZoomScreen(zoom);
+        }
+        else
+        {
+            target->MarkDirty(2);
+        }
+    }
+
+    static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+    {
+        InputEvent event;
+        event.type = INPUT_EVENT_KEY;
+        event.code = key;
+        event.scancode = scancode;
+        event.action = action;
+        event.mods = mods;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
+        {
+            return;
+        }
+
+        ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods);
+
+        if (!target)
+        {
+            return;
+        }
+        target->MarkDirty(2);
+
+        // Undo/redo shortcuts, unless ImGui is using the keyboard for a text field
+        if (action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL) && !target->IsUICapturingKeyboard())
+        {
+            if (key == GLFW_KEY_Z && (mods & GLFW_MOD_SHIFT))
+            {
+                target->Redo();
+            }
+            else if (key == GLFW_KEY_Z)
+            {
+                target->Undo();
+            }
+            else if (key == GLFW_KEY_Y)
             {
-                float zoom = static_cast<float>(yoffset);
-                currentWindow->ZoomScreen(zoom);
+                target->Redo();
             }
         }
     }
 
+    static void char_callback(GLFWwindow* window, unsigned int codepoint)
+    {
+        InputEvent event;
+        event.type = INPUT_EVENT_CHAR;
+        event.code = (int)codepoint;
+        Window* target = GetTargetWindow(window);
+        if (!AcceptInput(target, event))
+        {
+            return;
+        }
+
+        ImGui_ImplGlfw_CharCallback(window, codepoint);
+        if (target)
+        {
+            target->MarkDirty(2);
+        }
+    }
+
     /////////////// CONSTRUCTOR /////////////////////////
 
     Window::Window(unsigned int width, unsigned int height, const char* title, GLFWwindow* winContext)
@@ -153,27 +306,61 @@ namespace WindowManager
     }
 
     void Window::TransformScreen(float x, float z)
-        // z value is either 1 or -1
+        // x and z are how far the cursor moved in pixels
     {
-        z = -z;
-        float ndcX = 2.0f * x / m_winWidth;
-        float ndcY = 2.0f * z / m_winHeight;
-        float scale = m_zoom * 5.0f;
-
-        glm::vec3 screenDelta(ndcX * scale * 50.0f, 0.0f, ndcY * scale * 50.0f);
+        // Drag the grid along with the cursor, so the grid point under the cursor stays under it.
+        // The projection is orthographic, so the delta is the same wherever it's measured
+        glm::vec3 from = ScreenToGrid(m_winWidth / 2.0, m_winHeight / 2.0);
+        glm::vec3 to = ScreenToGrid(m_winWidth / 2.0 + x, m_winHeight / 2.0 + z);
 
-        glm::vec3 gridDelta = glm::vec3(m_invIsoMatrix * glm::vec4(screenDelta, 0.0f));
-
-        m_gridOffset -= gridDelta;
+        m_gridOffset += to - from;
+        MarkDirty();
 
     }
 
     void Window::ZoomScreen(float zoom)
     {
         m_zoom += -0.02f * zoom;
+        MarkDirty();
         // std::cout << m_zoom << std::endl;
     }
 
+    void Window::FitToMap()
+    {
+        if (!m_camera || m_winWidth == 0 || m_winHeight == 0)
+        {
+            return;
+        }
+        // Center of the grid at the origin, where the camera looks
+        glm::vec3 size(m_numCols * m_singleTileSize.x, 0.0f, m_numRows * m_singleTileSize.z);
+        m_gridOffset = -size * 0.5f;
+
+        // How far the corners reach on screen at a zoom of 1. The projection is orthographic, so
+        // the zoom just scales that
+        glm::mat4 viewIso = m_camera->GetViewMatrix() * m_isoMatrix;
+        glm::vec2 extent(0.0f);
+        for (int i = 0; i < 4; ++i)
+        {
+            glm::vec3 corner(((i & 1) ? 0.5f : -0.5f) * size.x, 0.0f, ((i & 2) ? 0.5f : -0.5f) * size.z);
+            extent = glm::max(extent, glm::abs(glm::vec2(viewIso * glm::vec4(corner, 1.0f))));
+        }
+        // A little margin around the edges
+        m_zoom = 1.1f * glm::max(2.0f * extent.x / m_winWidth, 2.0f * extent.y / m_winHeight);
+        MarkDirty();
+    }
+
+    void Window::MakeCurrent()
+    {
+        if (glfwGetCurrentContext() != m_window)
+        {
+            glfwMakeContextCurrent(m_window);
+        }
+        if (m_imguiContext)
+        {
+            ImGui::SetCurrentContext(m_imguiContext);
+        }
+    }
+
     //////////////// INITIALIZING FUNCTIONS ///////////////////////////
 
         // Main function for handling all the initial processes for creating an OpenGL window
@@ -184,6 +371,12 @@ namespace WindowManager
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+        RenderResources& resources = RenderResources::Get();
+        if (!m_winContext)
+        {
+            // Every window shares with the first, so they can all use each other's objects
+            m_winContext = resources.GetShareContext();
+        }
         m_window = glfwCreateWindow(m_winWidth, m_winHeight, m_winTitle, NULL, m_winContext);
 
         if (!m_window)
@@ -194,9 +387,10 @@ namespace WindowManager
 
         glfwMakeContextCurrent(m_window);
 
-        // Initialize IMGUI
+        // Initialize IMGUI. A context per window, but the fonts are only built and uploaded once
         IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
+        m_imguiContext = ImGui::CreateContext(resources.GetFontAtlas());
+        ImGui::SetCurrentContext(m_imguiContext);
         ImGuiIO& io = ImGui::GetIO(); (void)io;
         m_io = &io;
         ImGui::StyleColorsDark();
@@ -208,15 +402,39 @@ namespace WindowManager
             std::cout << "Failed to initialize GLAD" << std::endl;
             return false;
         }
+        RenderDevice::Get()->InitContext();
 
-        glViewport(0, 0, m_winWidth, m_winHeight);
-        glDisable(GL_DEPTH_TEST);
+        RenderDevice::Get()->Viewport(0, 0, m_winWidth, m_winHeight);
+        RenderDevice::Get()->Disable(GL_DEPTH_TEST);
 
+        // Sets the swap interval, so the context needs to be current
+        m_pacer.Attach(m_window);
+        resources.AddContext(m_window);
+        // Shader reloads build on their own context. Already running if another window started it
+        UploadThread::Get().Start(m_window);
+
+        // Every window shares a context with the first, so the programs are shared too
+        ShaderLibrary& shaders = ShaderLibrary::Get();
+        if (!shaders.IsRegistered("grid"))
+        {
+            shaders.Register("grid", "../TilemapEditor/Shaders/shader.vs", "../TilemapEditor/Shaders/shader.fs");
+            shaders.Register("ui", "../TilemapEditor/Shaders/ui_shader.vs", "../TilemapEditor/Shaders/ui_shader.fs");
+            shaders.Register("tiles", "../TilemapEditor/Shaders/tile_shader.vs", "../TilemapEditor/Shaders/tile_shader.fs");
+            shaders.Register("minimap", "../TilemapEditor/Shaders/minimap_shader.vs", "../TilemapEditor/Shaders/minimap_shader.fs");
+        }
         // Grid Shader program
-        m_shaderPtr = new Shader("../TilemapEditor/Shaders/shader.vs", "../TilemapEditor/Shaders/shader.fs");
+        m_shaderPtr = shaders.GetShader("grid");
         // UI shader program
-        m_uiShaderPtr = new Shader("../TilemapEditor/Shaders/ui_shader.vs", "../TilemapEditor/Shaders/ui_shader.fs");
-        m_uiShaderPtr->setVec3("chColor", glm::vec3(0.98f, 0.03f, 0.84));
+        m_uiShaderPtr = shaders.GetShader("ui");
+        // Filled tiles shader program
+        m_tileShaderPtr = shaders.GetShader("tiles");
+        // Chunk imposters, for minimaps
+        m_minimapShaderPtr = shaders.GetShader("minimap");
+        if (!shaders.IsHotReloadEnabled())
+        {
+            // Wakes the event driven loop, so a save shows up without moving the mouse
+            shaders.EnableHotReload([] { glfwPostEmptyEvent(); });
+        }
 
         // Callback functions
         glfwSetCursorPosCallback(m_window, mouse_callback);
@@ -225,12 +443,14 @@ namespace WindowManager
         glfwSetWindowFocusCallback(m_window, window_focus_callback);
         glfwSetWindowUserPointer(m_window, reinterpret_cast<void *>(this));
         glfwSetScrollCallback(m_window, mouse_scroll_callback);
+        glfwSetKeyCallback(m_window, key_callback);
+        glfwSetCharCallback(m_window, char_callback);
 
         SetupCamera();
 
-        m_isoMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        m_isoMatrix = glm::scale(m_isoMatrix, glm::vec3(0.5f, 1.0f, 1.0f));
-        m_isoMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(-45.0f), glm::vec3(0, 1, 0));
+        // "Squish in half" then rotate for the isometric POV. Same order m_model is built in
+        m_isoMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 1.0f, 1.0f));
+        m_isoMatrix = glm::rotate(m_isoMatrix, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         m_invIsoMatrix = glm::inverse(m_isoMatrix);
 
         return true;
@@ -250,28 +470,64 @@ namespace WindowManager
         // Process Rendering data
     void Window::PrepareRendering()
     {
-        glGenVertexArrays(1, &lineVAO);
-        glGenBuffers(1, &lineVBO);
+        PROFILE_SCOPE("Load");
+        MakeCurrent();
+        RenderDevice* device = RenderDevice::Get();
+        RenderResources& resources = RenderResources::Get();
 
-        glBindVertexArray(lineVAO);
+        // The vertex data is shared between windows, the vertex arrays can't be
+        m_gridBufferName = "grid" + std::to_string(m_numCols) + "x" + std::to_string(m_numRows);
+        lineVAO = device->CreateVertexArray();
+        lineVBO = resources.AcquireBuffer(m_gridBufferName, m_gridLines.data(), m_gridLines.size() * sizeof(glm::vec3));
 
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-        glBufferData(GL_ARRAY_BUFFER, m_gridLines.size() * sizeof(glm::vec3), m_gridLines.data(), GL_STATIC_DRAW);
+        device->BindVertexArray(lineVAO);
+        device->BindBuffer(GL_ARRAY_BUFFER, lineVBO);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-        glEnableVertexAttribArray(0);
+        device->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(glm::vec3), 0);
+        device->EnableVertexAttribArray(0);
 
         // UI VAO & VBO
 
-        glGenVertexArrays(1, &crossHairVAO);
-        glGenBuffers(1, &crossHairVBO);
+        crossHairVAO = device->CreateVertexArray();
+        crossHairVBO = resources.AcquireBuffer("crosshair", m_crossHairLines.data(), m_crossHairLines.size() * sizeof(glm::vec3));
+
+        device->BindVertexArray(crossHairVAO);
+        device->BindBuffer(GL_ARRAY_BUFFER, crossHairVBO);
+
+        device->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(glm::vec3), 0);
+        device->EnableVertexAttribArray(0);
+
+        // Hovered tile outline. Only 4 corners, rewritten when the hovered tile changes
+
+        hoverVAO = device->CreateVertexArray();
+        hoverVBO = device->CreateBuffer();
 
-        glBindVertexArray(crossHairVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, crossHairVBO);
-        glBufferData(GL_ARRAY_BUFFER, m_crossHairLines.size() * sizeof(glm::vec3), m_crossHairLines.data(), GL_STATIC_DRAW);
+        device->BindVertexArray(hoverVAO);
+        device->BindBuffer(GL_ARRAY_BUFFER, hoverVBO);
+        device->BufferData(GL_ARRAY_BUFFER, 4 * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-        glEnableVertexAttribArray(0);
+        device->VertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(glm::vec3), 0);
+        device->EnableVertexAttribArray(0);
+
+        // Per chunk tile buffers, meshed once for every window showing this map
+        if (m_tileMap && !m_bMinimap)
+        {
+            m_tileRenderer = resources.AcquireTileRenderer(m_tileMap, m_singleTileSize, m_tileView);
+        }
+
+        // Minimaps draw a single quad over the whole map instead
+        if (m_tileMap && m_bMinimap)
+        {
+            m_tileImposters = resources.AcquireTileImposters(m_tileMap);
+
+            glm::vec2 quad[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 1.0f) };
+            quadVAO = device->CreateVertexArray();
+            quadVBO = resources.AcquireBuffer("unitQuad", quad, sizeof(quad));
+            device->BindVertexArray(quadVAO);
+            device->BindBuffer(GL_ARRAY_BUFFER, quadVBO);
+            device->VertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(glm::vec2), 0);
+            device->EnableVertexAttribArray(0);
+        }
 
     }
 
@@ -288,6 +544,7 @@ namespace WindowManager
     {
         m_winWidth = width;
         m_winHeight = height;
+        MarkDirty();
     }
 
     ///////////////// SHUTDOWN FUNCTIONS //////////////////////////
@@ -301,14 +558,58 @@ namespace WindowManager
     {
         if (!m_winIsClosed)
         {
+            std::cout << m_winTitle << " " << m_pacer.GetReport() << std::endl;
+            std::cout << ShaderCache::Get().GetReport() << std::endl;
+
+            EndStroke();
+            StopRecording();
+
+            // Everything below needs this window's context, so before the window goes
+            MakeCurrent();
+            RenderDevice* device = RenderDevice::Get();
+            RenderResources& resources = RenderResources::Get();
+            if (m_tileRenderer)
+            {
+                resources.ReleaseTileRenderer(m_tileMap, m_tileView);
+                m_tileRenderer = nullptr;
+            }
+            if (m_tileImposters)
+            {
+                resources.ReleaseTileImposters(m_tileMap);
+                resources.ReleaseBuffer("unitQuad");
+                device->DeleteVertexArray(quadVAO);
+                m_tileImposters = nullptr;
+            }
+            if (!m_gridBufferName.empty())
+            {
+                resources.ReleaseBuffer(m_gridBufferName);
+                resources.ReleaseBuffer("crosshair");
+                device->DeleteBuffer(hoverVBO);
+                device->DeleteVertexArray(lineVAO);
+                device->DeleteVertexArray(crossHairVAO);
+                device->DeleteVertexArray(hoverVAO);
+            }
+            // GPU timer queries aren't shared either, and the profiler outlives the window
+            Profiler::Get().ReleaseGpuQueries();
+
             ImGui_ImplOpenGL3_Shutdown();
             ImGui_ImplGlfw_Shutdown();
-            ImGui::DestroyContext();
+            ImGui::DestroyContext(m_imguiContext);
+            m_imguiContext = NULL;
 
             m_winIsClosed = true;
+            if (currentWindow == this)
+            {
+                currentWindow = NULL;
+            }
+            // The last window frees the shared objects and stops the UploadThread
+            resources.RemoveContext(m_window);
             glfwDestroyWindow(m_window);
-            delete m_shaderPtr;
+            // Owned by the ShaderLibrary, other windows may still be drawing with them
             m_shaderPtr = nullptr;
+            m_uiShaderPtr = nullptr;
+            m_tileShaderPtr = nullptr;
+            m_minimapShaderPtr = nullptr;
         }
     }
 
@@ -316,7 +617,9 @@ namespace WindowManager
 
     void Window::SetupCamera()
     {
-        m_camera = new Camera();
+        // High above the grid looking almost straight down, tipped slightly towards +x
+        m_camera = new Camera(glm::vec3(-1.0f, 45.0f, 0.0f) * 5.0f);
+        m_camera->LookAt(glm::vec3(0.0f));
     }
 
     void Window::SetCameraAngle(float xoff, float yoff)
@@ -342,29 +645,181 @@ namespace WindowManager
         return m_view;
     }
 
+        // Screen pixels (top left origin, z from 0 at near to 1 at far) -> grid space
     glm::vec3 Window::UnProject(glm::vec3 inVec3)
     {
-        return glm::unProject(inVec3, m_view, m_projection, glm::vec4(0.0f, 0.0f, m_winWidth, m_winHeight));
+        return Picking::UnProject(m_invMvpMatrix, glm::vec2(m_winWidth, m_winHeight), inVec3);
     }
 
+        // Grid space -> screen pixels (top left origin)
     glm::vec3 Window::Project(glm::vec3 inVec3)
     {
-        return glm::project(inVec3, m_view, m_projection, glm::vec4(0.0f, 0.0f, m_winWidth, m_winHeight));
+        return Picking::Project(m_mvpMatrix, glm::vec2(m_winWidth, m_winHeight), inVec3);
+    }
+
+        // Rebuilt once per frame after the camera and grid matrices are set.
+        // Inverse is put together from the pieces so the iso part doesn't get inverted every frame,
+        // and the camera's part is cached until it changes
+    void Window::UpdatePickMatrices()
+    {
+        if (!m_camera)
+        {
+            return;
+        }
+        m_mvpMatrix = m_camera->GetViewProjectionMatrix() * m_model;
+        m_invMvpMatrix = Picking::InverseGridMVP(m_camera->GetInverseViewProjectionMatrix(), m_invIsoMatrix, m_gridOffset);
+    }
+
+    glm::vec3 Window::ScreenToGrid(double x, double y)
+    {
+        return Picking::ScreenToGrid(m_invMvpMatrix, glm::vec2(m_winWidth, m_winHeight), glm::vec2(x, y));
+    }
+
+    glm::ivec2 Window::ScreenToTile(double x, double y)
+    {
+        return Picking::GridToTile(ScreenToGrid(x, y), m_singleTileSize);
+    }
+
+    glm::vec3 Window::GridToScreen(glm::vec3 gridPos)
+    {
+        return Project(gridPos);
+    }
+
+    glm::ivec2 Window::GetHoveredTile()
+    {
+        return m_hoveredTile;
+    }
+
+    bool Window::IsHoveringTile()
+    {
+        return m_bHoveringTile;
+    }
+
+    void Window::UpdateHoveredTile()
+    {
+        double cursorX, cursorY;
+        GetCursorPos(cursorX, cursorY);
+
+        glm::ivec2 tile = ScreenToTile(cursorX, cursorY);
+        bool hovering = !m_bUICaptureMouse
+            && tile.x >= 0 && tile.y >= 0
+            && tile.x < (int)m_numCols && tile.y < (int)m_numRows;
+
+        if (hovering && (tile != m_hoveredTile || !m_bHoveringTile))
+        {
+            // Outline of the tile in grid space
+            glm::vec3 corner(tile.x * m_singleTileSize.x, 0.0f, tile.y * m_singleTileSize.z);
+            glm::vec3 outline[4] =
+            {
+                corner,
+                corner + glm::vec3(m_singleTileSize.x, 0.0f, 0.0f),
+                corner + glm::vec3(m_singleTileSize.x, 0.0f, m_singleTileSize.z),
+                corner + glm::vec3(0.0f, 0.0f, m_singleTileSize.z),
+            };
+            RenderDevice::Get()->BindBuffer(GL_ARRAY_BUFFER, hoverVBO);
+            RenderDevice::Get()->BufferSubData(GL_ARRAY_BUFFER, 0, sizeof(outline), outline);
+            RenderStats::Get().Add(RENDER_STAT_BUFFER_UPLOADS);
+            RenderStats::Get().Add(RENDER_STAT_BUFFER_BYTES, sizeof(outline));
+        }
+        m_hoveredTile = tile;
+        m_bHoveringTile = hovering;
     }
 
         // IMGUI UI COMMANDS
     void Window::UICommands()
     {
+        if (!m_bShowUI)
+        {
+            return;
+        }
         ImGui::Begin("Grid Information");
 
-        ImGui::SeparatorText("Grid Coordinates");
-        ImGui::PushItemWidth(80);
-        ImGui::SliderFloat("X", &m_gridx, 0.0f, 999.0); ImGui::SameLine();
-        ImGui::SliderFloat("Y", &m_gridy, 0.0f, 999.0);
-        ImGui::PopItemWidth();
+        ImGui::SeparatorText("Hovered Tile");
+        if (m_bHoveringTile)
+        {
+            ImGui::Text("X: %d  Y: %d", m_hoveredTile.x, m_hoveredTile.y);
+        }
+        else
+        {
+            ImGui::Text("None");
+        }
+
+        if (m_tileMap && m_editHistory)
+        {
+            ImGui::SeparatorText("Tiles");
+            int activeTile = m_activeTile;
+            ImGui::PushItemWidth(80);
+            if (ImGui::InputInt("Active tile", &activeTile))
+            {
+                SetActiveTile((TileID)glm::clamp(activeTile, 1, 0xFFFF));
+            }
+            ImGui::PopItemWidth();
+            if (ImGui::Button("Undo")) { Undo(); }
+            ImGui::SameLine();
+            if (ImGui::Button("Redo")) { Redo(); }
+            ImGui::Text("History: %zu undo / %zu redo, %.1f KB",
+                m_editHistory->GetNumUndo(), m_editHistory->GetNumRedo(),
+                m_editHistory->GetMemoryUsage() / 1024.0);
+        }
+
+        const FramePacer::Stats& pacing = m_pacer.GetStats();
+        ImGui::SeparatorText("Frame Pacing");
+        ImGui::Text("Frame: %.2f ms (max %.2f)", pacing.avgFrameMs, pacing.maxFrameMs);
+        ImGui::Text("Busy: %.1f%%", pacing.busyFraction * 100.0);
+        ImGui::Text("Work: %.2f ms (max %.2f)", pacing.avgWorkMs, pacing.maxWorkMs);
+        bool eventDriven = m_pacer.GetMode() == PACING_EVENT_DRIVEN;
+        if (ImGui::Checkbox("Redraw on change", &eventDriven))
+        {
+            SetPacingMode(eventDriven ? PACING_EVENT_DRIVEN : PACING_VSYNC);
+        }
+        ImGui::Checkbox("Partial redraw", &m_bPartialRedraw);
+        ImGui::Checkbox("Profiler", &m_bShowProfiler);
+        ImGui::SameLine();
+        ImGui::Checkbox("Render stats", &m_bShowRenderStats);
+
+        if (m_group && m_group->GetNumWindows() > 1)
+        {
+            // What each window's frames cost, drawn or not
+            ImGui::SeparatorText("Windows");
+            for (unsigned int i = 0; i < m_group->GetNumWindows(); ++i)
+            {
+                Window* window = m_group->GetWindow(i);
+                if (window->IsClosed())
+                {
+                    continue;
+                }
+                const FramePacer::Stats& stats = window->GetFramePacer()->GetStats();
+                ImGui::Text("%s: %.2f ms, %llu frames", window->GetTitle(), stats.avgWorkMs, stats.framesRendered);
+            }
+        }
 
         ImGui::Text("Hello");
         ImGui::End();
+
+        if (m_bShowProfiler)
+        {
+            Profiler::Get().DrawPanel(&m_bShowProfiler);
+        }
+        if (m_bShowRenderStats)
+        {
+            RenderStats::Get().DrawOverlay(&m_bShowRenderStats);
+        }
+    }
+
+    void Window::SetUIVisible(bool visible)
+    {
+        m_bShowUI = visible;
+        MarkDirty();
+    }
+
+    bool Window::IsUICapturingMouse()
+    {
+        return m_bUICaptureMouse;
+    }
+
+    bool Window::IsUICapturingKeyboard()
+    {
+        return m_io && m_io->WantCaptureKeyboard;
     }
 
     ////////////////// UPDATE FUNCTIONS /////////////////////////
@@ -374,55 +829,59 @@ namespace WindowManager
     {
         CalculateDeltaTime();
 
-        glfwPollEvents();
-        Clear();
-
-        ///////////// IMGUI FRAME COMMANDS ///////////////
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        if (m_io->WantCaptureMouse)
+        // Polls or waits for events depending on the pacing mode
+        int numTicks = m_pacer.BeginFrame();
+        if (m_bReplaying)
         {
-            m_bUICaptureMouse = true;
+            // Where live events would have been handled
+            UpdateReplay();
         }
-        else
+        for (int i = 0; i < numTicks; ++i)
         {
-            m_bUICaptureMouse = false;
+            if (m_fixedUpdate)
+            {
+                PROFILE_SCOPE("FixedUpdate");
+                m_fixedUpdate(m_pacer.GetFixedStep());
+            }
         }
 
-        ///////////// IMGUI COMMANDS ///////////////
-        UICommands();
-        ImGui::Render();
-
-        //////////// SHADER RENDERING //////////////
-        m_shaderPtr->Use();
-
-        // Reset m_model to identity matrix
-        m_model = glm::mat4(1.0f);
+        // Saved shaders get swapped in here, and tiles another window rebuilt show up as a new
+        // version. Either way this window needs a frame to show them
+        RenderResources& resources = RenderResources::Get();
+        resources.Update();
+        if (m_resourceVersion != resources.GetVersion())
+        {
+            MarkDirty();
+        }
 
-        /////////////////// TRANSLATIONS ///////////////////////
+        // Nothing changed, don't bother drawing
+        if (!m_pacer.ShouldRender())
+        {
+            m_pacer.EndFrame(false);
+            return;
+        }
 
-        // "Squish in half" for isometric POV
-        m_model = glm::scale(m_model, glm::vec3(0.5f, 1.0f, 1.0f));
-        // Setting the proper angle for isometric POV
-        m_model = glm::rotate(m_model, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        // Only rendered frames are profiled, skipped ones would just be idle time
+        Profiler& profiler = Profiler::Get();
+        profiler.BeginFrame();
+        ProfileScope updateScope("Update");
 
-        glm::vec4 worldOffset = m_model * glm::vec4(m_gridOffset, 1.0f);
+        // Windows in a group take turns, so this one's contexts may not be the current ones
+        MakeCurrent();
+        RenderDevice::Get()->Viewport(0, 0, m_winWidth, m_winHeight);
+        BeginDamageScissor();
+        Clear();
 
-        m_model = glm::translate(m_model, m_gridOffset);
+        /////////////////// TRANSLATIONS ///////////////////////
 
-            // Calculate tile value in integer
-        glm::ivec2 tile = glm::floor(glm::vec2(m_gridOffset.x, m_gridOffset.z) / 5.0f);
-            // Calculate exact tile value
-        glm::vec2 exactTile = glm::vec2(m_gridOffset.x, m_gridOffset.z) / 5.0f;
-        m_gridx = -1 * exactTile.x;
-        m_gridy = -1 * exactTile.y;
+        // Isometric squish and rotation, then move the grid by the pan offset
+        m_model = Picking::GridModel(m_isoMatrix, m_gridOffset);
 
         ////////////////////// CAMERA //////////////////////////
         if (m_camera)
         {
-            m_projection = glm::ortho(
+            // Only marks the camera dirty when the size or zoom actually changed
+            m_camera->SetOrthographic(
                 (-(m_winWidth / 2.0f) * m_zoom), // LEFT
                 ((m_winWidth / 2.0f) * m_zoom), // RIGHT
                 ((m_winHeight / 2.0f) * m_zoom), // BOTTOM
@@ -431,6 +890,7 @@ namespace WindowManager
                 (-200.0f * 5) // ZFAR
                 );
 
+            m_projection = m_camera->GetProjectionMatrix();
             m_view = m_camera->GetViewMatrix();
 
         }
@@ -439,47 +899,88 @@ namespace WindowManager
             std::cout << "Camera is NULL" << std::endl;
         }
 
+        ///////////// IMGUI FRAME COMMANDS ///////////////
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        if (m_bReplaying)
+        {
+            // The GLFW backend polls the real cursor, this one is queued after it so it wins
+            m_io->AddMousePosEvent((float)m_replayCursorX, (float)m_replayCursorY);
+        }
+        resources.BeginImGuiFrame();
+        ImGui::NewFrame();
+
+        if (m_io->WantCaptureMouse)
+        {
+            m_bUICaptureMouse = true;
+        }
+        else
+        {
+            m_bUICaptureMouse = false;
+        }
+
+        ////////////////////// PICKING //////////////////////////
+        // Needs this frame's matrices and UI capture state
+        UpdatePickMatrices();
+        UpdateHoveredTile();
+
+        ///////////// IMGUI COMMANDS ///////////////
+        UICommands();
+        ImGui::Render();
+        updateScope.End();
+
+        //////////// SHADER RENDERING //////////////
+        ProfileScope submitScope("Submit");
+        profiler.BeginGpuScope("Submit");
+        // Filled tiles go under the grid lines
+        DrawTiles();
+        DrawImposters();
+        // After DrawTiles, which bumps it when it rebuilds something the other windows show
+        m_resourceVersion = resources.GetVersion();
+
+        m_shaderPtr->Use();
+
         ///////////// SHADERS AND DRAWING /////////////////////////
         // Fills in data inside shaders for the grid
         SetShaderData(m_shaderPtr);
 
         // Draw calls
-        glLineWidth(1.0f);
-        DrawGridLines();
+        RenderDevice::Get()->LineWidth(1.0f);
+        if (!m_bMinimap)
+        {
+            DrawGridLines();
+        }
+        DrawHoveredTile();
 
         // UI/HUD
-        glLineWidth(2.0f);
+        RenderDevice::Get()->LineWidth(2.0f);
         m_uiShaderPtr->Use();
+        // Every frame, a reloaded program starts with its uniforms back at zero
+        m_uiShaderPtr->setVec3("chColor", glm::vec3(0.98f, 0.03f, 0.84));
         DrawUI();
 
+        // ImGui does its own scissoring
+        EndDamageScissor();
+
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler.EndGpuScope();
+        submitScope.End();
 
         //////////////////// ON FRAME ////////////////////////////
-        // Things to do every frame, not every tick
-        if ((glfwGetTime() - m_lastFrameTime) >= m_fixedDeltaTime)
+        // Every rendered frame gets presented, the pacer handles vsync or the frame cap
         {
-            glfwSwapBuffers(m_window);
-
-            m_lastFrameTime = glfwGetTime();
-
-            /* PRINT GRID COORDS UNSCALED
-            std::cout << "Grid coordinate: ("
-          << m_gridOffset.x << ", "
-          << m_gridOffset.z << ")" << std::endl;
-            */
-
-            /* Print Grid Coords Scaled and Floor
-            std::cout << "Grid coordinate: ("
-          << tile.x << ", "
-          << tile.y << ")" << std::endl;
-          */
-
-            /* Print Grid Coords Scaled with decimals
-            std::cout << "Grid coordinate: ("
-          << exactTile.x << ", "
-          << exactTile.y << ")" << std::endl;
-          */
+            PROFILE_SCOPE("Swap");
+            m_pacer.Present();
         }
+        m_pacer.EndFrame(true);
+        profiler.EndFrame();
+        RenderStats::Get().EndFrame();
+
+        /* PRINT GRID COORDS UNSCALED
+        std::cout << "Grid coordinate: ("
+      << m_gridOffset.x << ", "
+      << m_gridOffset.z << ")" << std::endl;
+        */
 
     }
 
@@ -490,6 +991,45 @@ namespace WindowManager
         Update();
     }
 
+    ////////////////// FRAME PACING /////////////////////////
+
+    void Window::SetPacingMode(Pacing_Mode mode)
+    {
+        GLFWwindow* previous = glfwGetCurrentContext();
+        glfwMakeContextCurrent(m_window);
+        m_pacer.SetMode(mode);
+        glfwMakeContextCurrent(previous);
+    }
+
+    FramePacer* Window::GetFramePacer()
+    {
+        return &m_pacer;
+    }
+
+    void Window::MarkDirty(int numFrames)
+    {
+        m_bFullRedraw = true;
+        m_pacer.MarkDirty(numFrames);
+    }
+
+    bool Window::NeedsRender()
+    {
+        return m_pacer.ShouldRender() || m_resourceVersion != RenderResources::Get().GetVersion();
+    }
+
+    void Window::SetVBlankSync(bool sync)
+    {
+        GLFWwindow* previous = glfwGetCurrentContext();
+        glfwMakeContextCurrent(m_window);
+        m_pacer.SetVBlankSync(sync);
+        glfwMakeContextCurrent(previous);
+    }
+
+    void Window::SetFixedUpdateCallback(std::function<void(double)> callback)
+    {
+        m_fixedUpdate = callback;
+    }
+
     void Window::CalculateDeltaTime()
     {
         double currentFrame = glfwGetTime();
@@ -500,31 +1040,430 @@ namespace WindowManager
 
     void Window::Clear()
     {
-        glClearColor(0.8f, 0.973f, 0.6f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        RenderDevice* device = RenderDevice::Get();
+        device->ClearColor(0.8f, 0.973f, 0.6f, 1.0f);
+        device->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
 
     ///////// FUNCTIONS FOR THE TILEMAP EDITOR /////////////////////
 
+    void Window::ReceiveTileMap(TileMap* tileMap, EditHistory* editHistory)
+    {
+        m_tileMap = tileMap;
+        m_editHistory = editHistory;
+    }
+
+    void Window::SetActiveTile(TileID id)
+    {
+        m_activeTile = id;
+        MarkDirty();
+    }
+
+    void Window::SetPaletteTarget(Window* target)
+    {
+        m_paletteTarget = target;
+    }
+
+    void Window::SetMinimap(bool minimap)
+    {
+        m_bMinimap = minimap;
+    }
+
+    void Window::BeginStroke(bool erase)
+    {
+        if (m_paletteTarget)
+        {
+            // Picks instead of painting
+            double cursorX, cursorY;
+            GetCursorPos(cursorX, cursorY);
+            glm::ivec2 tile = ScreenToTile(cursorX, cursorY);
+            if (!erase && m_tileMap && m_tileMap->InBounds(tile.x, tile.y)
+                && m_tileMap->GetTile(tile.x, tile.y) != EMPTY_TILE)
+            {
+                m_paletteTarget->SetActiveTile(m_tileMap->GetTile(tile.x, tile.y));
+            }
+            return;
+        }
+        if (!m_tileMap || !m_editHistory || m_bPainting)
+        {
+            return;
+        }
+        m_bPainting = true;
+        m_bErasing = erase;
+        m_editHistory->BeginEdit(m_tileMap);
+
+        double cursorX, cursorY;
+        GetCursorPos(cursorX, cursorY);
+        PaintTile(ScreenToTile(cursorX, cursorY));
+    }
+
+    void Window::EndStroke()
+    {
+        if (!m_bPainting)
+        {
+            return;
+        }
+        m_bPainting = false;
+        m_editHistory->EndEdit();
+    }
+
+    void Window::PaintTile(glm::ivec2 tile)
+    {
+        if (!m_tileMap->InBounds(tile.x, tile.y))
+        {
+            return;
+        }
+        m_tileMap->SetTile(tile.x, tile.y, m_bErasing ? (TileID)EMPTY_TILE : m_activeTile);
+        MarkTilesDirty(tile, tile);
+    }
+
+    void Window::Undo()
+    {
+        if (m_editHistory && !m_bPainting && m_editHistory->Undo())
+        {
+            MarkDirty();
+        }
+    }
+
+    void Window::Redo()
+    {
+        if (m_editHistory && !m_bPainting && m_editHistory->Redo())
+        {
+            MarkDirty();
+        }
+    }
+
+    void Window::OnCursorMoved(double x, double y)
+    {
+        if (m_bUICaptureMouse)
+        {
+            // Hovering ImGui widgets, let it redraw its highlights
+            MarkDirty(2);
+            return;
+        }
+
+        glm::ivec2 tile = ScreenToTile(x, y);
+        if (m_bHoveringTile && tile == m_hoveredTile)
+        {
+            return;
+        }
+        // Old and new hover outlines
+        if (m_bHoveringTile)
+        {
+            MarkTilesDirty(m_hoveredTile, m_hoveredTile);
+        }
+        MarkTilesDirty(tile, tile);
+
+        if (m_bPainting)
+        {
+            PaintTile(tile);
+        }
+    }
+
+    ////////////////// INPUT RECORDING /////////////////////////
+
+    void Window::StartRecording(const std::string& path)
+    {
+        m_inputRecorder.Start(path, m_winWidth, m_winHeight);
+        m_recordStart = glfwGetTime();
+    }
+
+    void Window::StopRecording()
+    {
+        if (m_inputRecorder.IsRecording())
+        {
+            m_inputRecorder.Stop();
+        }
+    }
+
+    bool Window::StartReplay(const std::string& path, bool closeWhenDone)
+    {
+        if (!m_inputReplay.Load(path))
+        {
+            return false;
+        }
+        if (m_inputReplay.GetWidth() != (int)m_winWidth || m_inputReplay.GetHeight() != (int)m_winHeight)
+        {
+            // Picking depends on the size, so match what was recorded
+            std::cout << path << " was recorded at " << m_inputReplay.GetWidth() << "x" << m_inputReplay.GetHeight()
+                << ", resizing from " << m_winWidth << "x" << m_winHeight << std::endl;
+            RenderDevice::Get()->Viewport(0, 0, m_inputReplay.GetWidth(), m_inputReplay.GetHeight());
+            SetFramebufferValues(m_inputReplay.GetWidth(), m_inputReplay.GetHeight());
+        }
+
+        // Replayed events go to this window even if it never gets focus (hidden for headless runs)
+        currentWindow = this;
+        m_bReplaying = true;
+        m_bCloseAfterReplay = closeWhenDone;
+        m_replayTime = 0.0;
+        m_replayFrames = 0;
+        m_replayStart = glfwGetTime();
+
+        // Render every frame, as fast as it goes
+        m_preReplayMode = m_pacer.GetMode();
+        SetPacingMode(PACING_CAPPED);
+        m_pacer.SetTargetFrameRate(100000.0);
+        Profiler::Get().ResetStats();
+        RenderStats::Get().Reset();
+
+        std::cout << "Replaying " << m_inputReplay.GetNumEvents() << " input events ("
+            << m_inputReplay.GetDuration() << " s) from " << path << std::endl;
+        return true;
+    }
+
+    bool Window::IsReplaying()
+    {
+        return m_bReplaying;
+    }
+
+    bool Window::FilterInput(const InputEvent& event)
+    {
+        if (m_bReplaying && !m_bInjectingInput)
+        {
+            // Live input would make the replay do different work
+            return false;
+        }
+        if (m_bInjectingInput && event.type == INPUT_EVENT_CURSOR)
+        {
+            m_replayCursorX = event.x;
+            m_replayCursorY = event.y;
+        }
+        if (m_inputRecorder.IsRecording())
+        {
+            InputEvent stamped = event;
+            stamped.time = glfwGetTime() - m_recordStart;
+            m_inputRecorder.Record(stamped);
+        }
+        return true;
+    }
+
+    void Window::UpdateReplay()
+    {
+        // Checked a frame late so the frame for the last events gets rendered and timed
+        if (m_inputReplay.IsFinished())
+        {
+            FinishReplay();
+            return;
+        }
+
+        m_replayTime += m_pacer.GetFixedStep();
+        m_bInjectingInput = true;
+        InputEvent event;
+        while (m_inputReplay.Next(m_replayTime, event))
+        {
+            switch (event.type)
+            {
+                case INPUT_EVENT_CURSOR:
+                    mouse_callback(m_window, event.x, event.y);
+                    break;
+                case INPUT_EVENT_BUTTON:
+                    mouse_button_callback(m_window, event.code, event.action, event.mods);
+                    break;
+                case INPUT_EVENT_SCROLL:
+                    mouse_scroll_callback(m_window, event.x, event.y);
+                    break;
+                case INPUT_EVENT_KEY:
+                    key_callback(m_window, event.code, event.scancode, event.action, event.mods);
+                    break;
+                case INPUT_EVENT_CHAR:
+                    char_callback(m_window, (unsigned int)event.code);
+                    break;
+                case INPUT_EVENT_RESIZE:
+                    framebuffer_size_callback(m_window, (int)event.x, (int)event.y);
+                    break;
+            }
+        }
+        m_bInjectingInput = false;
+        m_replayFrames++;
+        MarkDirty();
+    }
+
+    void Window::FinishReplay()
+    {
+        double seconds = glfwGetTime() - m_replayStart;
+        std::cout << "Replay finished: " << m_replayFrames << " frames in " << seconds << " s, "
+            << (m_replayFrames ? seconds * 1000.0 / m_replayFrames : 0.0) << " ms per frame" << std::endl;
+        std::cout << Profiler::Get().GetReport() << std::endl;
+        std::cout << RenderStats::Get().GetReport() << std::endl;
+
+        m_bReplaying = false;
+        SetPacingMode(m_preReplayMode);
+        m_pacer.SetTargetFrameRate(DEFAULT_TARGET_FRAME_RATE);
+        if (m_bCloseAfterReplay)
+        {
+            glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+        }
+    }
+
+    void Window::GetCursorPos(double& x, double& y)
+    {
+        if (m_bReplaying)
+        {
+            x = m_replayCursorX;
+            y = m_replayCursorY;
+            return;
+        }
+        glfwGetCursorPos(m_window, &x, &y);
+    }
+
+    void Window::MarkTilesDirty(glm::ivec2 minTile, glm::ivec2 maxTile)
+    {
+        m_pacer.MarkDirty();
+
+        // Screen bounds of the tile rectangle's corners
+        glm::vec3 lo(minTile.x * m_singleTileSize.x, 0.0f, minTile.y * m_singleTileSize.z);
+        glm::vec3 hi((maxTile.x + 1) * m_singleTileSize.x, 0.0f, (maxTile.y + 1) * m_singleTileSize.z);
+        glm::vec3 corners[4] =
+        {
+            Project(lo),
+            Project(glm::vec3(hi.x, 0.0f, lo.z)),
+            Project(hi),
+            Project(glm::vec3(lo.x, 0.0f, hi.z)),
+        };
+        glm::vec2 rectMin(corners[0]);
+        glm::vec2 rectMax(corners[0]);
+        for (const glm::vec3& corner : corners)
+        {
+            rectMin = glm::min(rectMin, glm::vec2(corner));
+            rectMax = glm::max(rectMax, glm::vec2(corner));
+        }
+        // A couple of pixels extra for line width
+        rectMin -= glm::vec2(2.0f);
+        rectMax += glm::vec2(2.0f);
+
+        if (m_bHasDamage)
+        {
+            m_damageMin = glm::min(m_damageMin, rectMin);
+            m_damageMax = glm::max(m_damageMax, rectMax);
+        }
+        else
+        {
+            m_damageMin = rectMin;
+            m_damageMax = rectMax;
+            m_bHasDamage = true;
+        }
+    }
+
+    void Window::SetPartialRedraw(bool enabled)
+    {
+        m_bPartialRedraw = enabled;
+        MarkDirty();
+    }
+
+    void Window::BeginDamageScissor()
+    {
+        bool partial = m_bPartialRedraw && m_bHasDamage && !m_bFullRedraw && !m_bPrevFullRedraw;
+        if (partial)
+        {
+            glm::vec2 lo = m_damageMin;
+            glm::vec2 hi = m_damageMax;
+            if (m_bPrevHasDamage)
+            {
+                lo = glm::min(lo, m_prevDamageMin);
+                hi = glm::max(hi, m_prevDamageMax);
+            }
+            lo = glm::clamp(lo, glm::vec2(0.0f), glm::vec2(m_winWidth, m_winHeight));
+            hi = glm::clamp(hi, glm::vec2(0.0f), glm::vec2(m_winWidth, m_winHeight));
+
+            // glScissor counts from the bottom left
+            RenderDevice::Get()->Enable(GL_SCISSOR_TEST);
+            RenderDevice::Get()->Scissor((GLint)lo.x, (GLint)(m_winHeight - hi.y), (GLsizei)(hi.x - lo.x), (GLsizei)(hi.y - lo.y));
+        }
+
+        // This frame's damage is the previous frame's damage next time around
+        m_bPrevFullRedraw = m_bFullRedraw || !m_bHasDamage;
+        m_bPrevHasDamage = m_bHasDamage;
+        m_prevDamageMin = m_damageMin;
+        m_prevDamageMax = m_damageMax;
+        m_bFullRedraw = false;
+        m_bHasDamage = false;
+    }
+
+    void Window::EndDamageScissor()
+    {
+        RenderDevice::Get()->Disable(GL_SCISSOR_TEST);
+    }
+
     void Window::ReceiveGridData(GridData m_gridData)
     {
         m_gridLines = m_gridData.gridData;
         m_singleTileSize = m_gridData.tileSize;
+        m_numCols = m_gridData.numCols;
+        m_numRows = m_gridData.numRows;
     }
 
     void Window::DrawGridLines()
     {
         //std::cout << "drawing lines..." << std::endl;
-        glBindVertexArray(lineVAO);
-        glDrawArrays(GL_LINES, 0, m_gridLines.size());
+        RenderDevice::Get()->BindVertexArray(lineVAO);
+        RenderDevice::Get()->DrawArrays(GL_LINES, 0, m_gridLines.size());
+        RenderStats::Get().Add(RENDER_STAT_STATE_CHANGES);
+        RenderStats::Get().AddDraw(GL_LINES, m_gridLines.size());
         //glBindVertexArray(0);
     }
 
+    void Window::DrawTiles()
+    {
+        if (!m_tileRenderer)
+        {
+            return;
+        }
+        // Only chunks that were edited get their buffers rebuilt. Whichever window gets here
+        // first does it for all of them, and the rest redraw once they see the new version
+        if (m_tileRenderer->RebuildDirtyChunks() > 0)
+        {
+            RenderResources::Get().MarkChanged();
+        }
+
+        m_tileShaderPtr->Use();
+        SetShaderData(m_tileShaderPtr);
+        m_tileRenderer->Draw(m_tileView);
+    }
+
+    void Window::DrawImposters()
+    {
+        if (!m_tileImposters)
+        {
+            return;
+        }
+        // Only chunks whose version changed since the last frame get pictured again
+        m_tileImposters->Update();
+        m_tileImposters->Upload();
+
+        RenderDevice* device = RenderDevice::Get();
+        m_minimapShaderPtr->Use();
+        SetShaderData(m_minimapShaderPtr);
+        m_minimapShaderPtr->setVec2("mapSize", m_tileImposters->GetCoveredSize(m_singleTileSize));
+        m_minimapShaderPtr->setInt("imposters", 0);
+        device->ActiveTexture(0);
+        device->BindTexture(GL_TEXTURE_2D, m_tileImposters->GetTexture());
+        device->BindVertexArray(quadVAO);
+        device->DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        RenderStats::Get().Add(RENDER_STAT_STATE_CHANGES, 2);
+        RenderStats::Get().AddDraw(GL_TRIANGLE_STRIP, 4);
+    }
+
+    void Window::DrawHoveredTile()
+    {
+        if (!m_bHoveringTile)
+        {
+            return;
+        }
+        m_shaderPtr->setVec3("lineColor", glm::vec3(0.98f, 0.03f, 0.84f));
+        RenderDevice::Get()->BindVertexArray(hoverVAO);
+        RenderDevice::Get()->DrawArrays(GL_LINE_LOOP, 0, 4);
+        RenderStats::Get().Add(RENDER_STAT_STATE_CHANGES);
+        RenderStats::Get().AddDraw(GL_LINE_LOOP, 4);
+        m_shaderPtr->setVec3("lineColor", glm::vec3(0.0f, 0.0f, 0.0f));
+    }
+
         // This is just the crosshair, will probably change this eventually
     void Window::DrawUI()
     {
-        glBindVertexArray(crossHairVAO);
-        glDrawArrays(GL_LINES, 0, m_crossHairLines.size());
+        RenderDevice::Get()->BindVertexArray(crossHairVAO);
+        RenderDevice::Get()->DrawArrays(GL_LINES, 0, m_crossHairLines.size());
+        RenderStats::Get().Add(RENDER_STAT_STATE_CHANGES);
+        RenderStats::Get().AddDraw(GL_LINES, m_crossHairLines.size());
     }
 
 
@@ -571,5 +1510,128 @@ namespace WindowManager
     {
         return m_winTitle;
     }
+
+    ////////////////// WINDOW GROUP /////////////////////////
+
+    void WindowGroup::Add(Window* window)
+    {
+        window->m_group = this;
+        // Events are handled once for the whole group in Update
+        window->GetFramePacer()->SetHandlesEvents(false);
+        m_windows.push_back(window);
+        UpdateVBlankSync();
+    }
+
+    void WindowGroup::Update()
+    {
+        bool needsRender = false;
+        for (Window* window : m_windows)
+        {
+            if (!window->IsClosed() && (window->NeedsRender() || window->ShouldClose()))
+            {
+                needsRender = true;
+            }
+        }
+
+        if (needsRender)
+        {
+            glfwPollEvents();
+        }
+        else
+        {
+            // Nothing to draw, so block until input shows up (or the timeout, so fixed updates still happen)
+            double waitStart = glfwGetTime();
+            glfwWaitEventsTimeout(DEFAULT_IDLE_TIMEOUT);
+            double waited = glfwGetTime() - waitStart;
+            for (Window* window : m_windows)
+            {
+                window->GetFramePacer()->AddIdleTime(waited);
+            }
+        }
+
+        bool closed = false;
+        for (Window* window : m_windows)
+        {
+            if (window->IsClosed())
+            {
+                continue;
+            }
+            if (window->ShouldClose())
+            {
+                window->DestroyWindow();
+                closed = true;
+                continue;
+            }
+            window->onUpdate();
+        }
+        if (closed)
+        {
+            UpdateVBlankSync();
+        }
+    }
+
+    void WindowGroup::CloseAll()
+    {
+        for (Window* window : m_windows)
+        {
+            window->DestroyWindow();
+        }
+    }
+
+    bool WindowGroup::IsClosed()
+    {
+        for (Window* window : m_windows)
+        {
+            if (!window->IsClosed())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    unsigned int WindowGroup::GetNumWindows()
+    {
+        return (unsigned int)m_windows.size();
+    }
+
+    Window* WindowGroup::GetWindow(unsigned int index)
+    {
+        return m_windows[index];
+    }
+
+    std::string WindowGroup::GetReport()
+    {
+        std::ostringstream report;
+        report << "Windows (" << m_windows.size() << ")\n";
+        double totalMs = 0.0;
+        for (Window* window : m_windows)
+        {
+            const FramePacer::Stats& stats = window->GetFramePacer()->GetStats();
+            report << "  " << window->GetTitle() << ": " << stats.framesRendered << " frames, work avg "
+                << stats.avgWorkMs << " ms / max " << stats.maxWorkMs << " ms\n";
+            // Spread over every pass of the loop, so windows that rarely draw barely count
+            if (stats.loops > 0)
+            {
+                totalMs += stats.avgWorkMs * stats.workSamples / stats.loops;
+            }
+        }
+        report << "  work per loop:  " << totalMs << " ms";
+        return report.str();
+    }
+
+    void WindowGroup::UpdateVBlankSync()
+    {
+        bool first = true;
+        for (Window* window : m_windows)
+        {
+            if (window->IsClosed())
+            {
+                continue;
+            }
+            window->SetVBlankSync(first);
+            first = false;
+        }
+    }
 }
 
@@ -13,72 +13,50 @@ enum Camera_Movement
     RIGHT
 };
 
+enum Camera_Projection
+{
+    CAMERA_PERSPECTIVE,
+    // Also isometric, which is orthographic looking down at an angle (see LookAt)
+    CAMERA_ORTHOGRAPHIC
+};
+
+// Frustum planes, in the order GetFrustumPlanes gives them
+enum Camera_Plane
+{
+    CAMERA_PLANE_LEFT,
+    CAMERA_PLANE_RIGHT,
+    CAMERA_PLANE_BOTTOM,
+    CAMERA_PLANE_TOP,
+    CAMERA_PLANE_NEAR,
+    CAMERA_PLANE_FAR,
+    CAMERA_PLANE_COUNT
+};
+
 // Default values
 const float YAW         = 0.0f;
 const float PITCH       = 0.0f;
 const float SPEED       =  2.5f;
 const float SENSITIVITY =  0.1f;
-const float ZOOM        =  1.0f;
+const float FOV         = 45.0f;
 
+// A view and a projection. Setters only mark what changed, the matrices (and their inverses)
+// are rebuilt on the first Get after it, so asking several times a frame is free. Plain data,
+// so it can be copied or kept in a component.
 class Camera
 {
 public:
 
-    // Cam attributes
-    glm::vec3 Position;
-    glm::vec3 Front;
-    glm::vec3 Up;
-    glm::vec3 Right;
-    glm::vec3 WorldUp;
-
-    // Euler Angles
-    float Yaw;
-    float Pitch;
-
     // Camera options and modifiers
     float MovementSpeed;
     float MouseSensitivity;
-    float Zoom;
 
-    // Constructor with vectors
+    // Constructor with vectors. Starts as a 45 degree perspective with a square aspect
     Camera(glm::vec3 position = glm::vec3(0.0f, 100.0f, 0.0f),
         glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f),
         float yaw = YAW,
-        float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, 0.0f)),
-        MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
-    {
-        Position = position;
-        WorldUp = up;
-        Yaw = yaw;
-        Pitch = pitch;
-        updateCameraVectors();
-    }
+        float pitch = PITCH);
     // Constructor with Euler angles
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
-    {
-        Position = glm::vec3(posX, posY, posZ);
-        WorldUp = glm::vec3(upX, upY, upZ);
-        Yaw = yaw;
-        Pitch = pitch;
-        updateCameraVectors();
-    }
-
-    glm::mat4 GetViewMatrix()
-    {
-        //return glm::lookAt(Position, Position + Front, WorldUp);
-        glm::mat4 view;
-        view = glm::lookAt(
-             (glm::vec3(-1.0f, 45.0f, 0.0f) * 5.0f), // Camera position
-             (glm::vec3(0.0f, 0.0f, 0.0f) * 5.0f),  // Target to look at
-            WorldUp                             // World UP
-        );
-        return view;
-    }
-
-    void SetLookAtTarget(glm::vec3 lookAtIn)
-    {
-        m_lookAtTarget = lookAtIn;
-    }
+    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch);
 
     // Process input received from keyboard-like input system.
     // Input is parameter in the form of camera defined ENUM
@@ -90,11 +68,89 @@ public:
         // Optional constrain pitch boolean
     void ProcessMouseMovement(float xOffset, float yOffset, GLboolean constrainPitch = true);
 
+    ////////////// PLACEMENT ///////////////
+    void SetPosition(const glm::vec3& position);
+    // Degrees
+    void SetRotation(float yaw, float pitch);
+    // Turns to face target, keeping the position
+    void LookAt(const glm::vec3& target);
+    const glm::vec3& GetPosition() const;
+    const glm::vec3& GetFront() const;
+    const glm::vec3& GetRight() const;
+    const glm::vec3& GetUp() const;
+    float GetYaw() const;
+    float GetPitch() const;
+
+    ////////////// PROJECTION ///////////////
+    // fov is vertical, in degrees
+    void SetPerspective(float fov, float aspect, float nearPlane, float farPlane);
+    // Keeps the rest of the perspective, for window resizes
+    void SetAspect(float aspect);
+    void SetOrthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane);
+    Camera_Projection GetProjectionType() const;
+    float GetFov() const;
+    float GetAspect() const;
+
+    ////////////// MATRICES ///////////////
+    const glm::mat4& GetViewMatrix() const;
+    const glm::mat4& GetProjectionMatrix() const;
+    // projection * view
+    const glm::mat4& GetViewProjectionMatrix() const;
+    const glm::mat4& GetInverseViewMatrix() const;
+    const glm::mat4& GetInverseProjectionMatrix() const;
+    const glm::mat4& GetInverseViewProjectionMatrix() const;
+    // Goes up whenever the matrices change, so anything built from them knows to rebuild
+    unsigned int GetVersion() const;
+
+    ////////////// CULLING AND PICKING ///////////////
+    // World space planes as (normal, distance) with the normals pointing inwards, so a point
+    // is inside when dot(plane.xyz, point) + plane.w >= 0 for all of them
+    void GetFrustumPlanes(glm::vec4 planes[CAMERA_PLANE_COUNT]) const;
+    // World space box against planes from GetFrustumPlanes. Conservative: a box near a corner
+    // of the frustum can pass without being on screen, but nothing on screen fails
+    static bool IsBoxVisible(const glm::vec4 planes[CAMERA_PLANE_COUNT], const glm::vec3& min, const glm::vec3& max);
+    // Ray through a point in normalized device coordinates (-1 to 1, y up), from the near plane
+    // towards the far one. direction is normalized
+    void GetRay(const glm::vec2& ndc, glm::vec3& origin, glm::vec3& direction) const;
+
 private:
     // Calculates the front vector
     void updateCameraVectors();
+    void UpdateMatrices() const;
+    void MarkViewDirty();
+    void MarkProjectionDirty();
+
+    // Cam attributes
+    glm::vec3 m_position;
+    glm::vec3 m_front;
+    glm::vec3 m_up;
+    glm::vec3 m_right;
+    glm::vec3 m_worldUp;
+
+    // Euler Angles
+    float m_yaw;
+    float m_pitch;
+
+    Camera_Projection m_projectionType;
+    float m_fov;
+    float m_aspect;
+    float m_nearPlane;
+    float m_farPlane;
+    // Orthographic bounds
+    float m_left;
+    float m_rightEdge;
+    float m_bottom;
+    float m_top;
 
-    glm::vec3 m_lookAtTarget;
+    mutable glm::mat4 m_view;
+    mutable glm::mat4 m_projection;
+    mutable glm::mat4 m_viewProjection;
+    mutable glm::mat4 m_inverseView;
+    mutable glm::mat4 m_inverseProjection;
+    mutable glm::mat4 m_inverseViewProjection;
+    mutable bool m_viewDirty;
+    mutable bool m_projectionDirty;
+    unsigned int m_version;
 };
 
 #endif
\ No newline at end of file
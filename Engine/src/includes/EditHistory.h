@@ -0,0 +1,99 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <TileMap.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 16MB of undo history before the oldest edits get dropped
+#define DEFAULT_HISTORY_MEMORY_CAP (16 * 1024 * 1024)
+
+// Undo/redo journal for tile edits.
+// Chunks are copied the first time they're written during an edit, then on EndEdit()
+// the copy is diffed against the chunk and stored as run-length deltas. A stroke that
+// fills whole chunks with one tile ends up as a single run per chunk.
+class EditHistory
+{
+public:
+    // Consecutive cells in a chunk that all went from 'before' to 'after'
+    struct Run
+    {
+        uint16_t start;
+        uint16_t count;
+        TileID before;
+        TileID after;
+    };
+
+    struct ChunkDelta
+    {
+        unsigned int chunk;
+        std::vector<Run> runs;
+    };
+
+    struct Edit
+    {
+        std::vector<ChunkDelta> chunks;
+        size_t numCells = 0;
+        size_t numBytes = 0;
+    };
+
+    EditHistory(size_t memoryCap = DEFAULT_HISTORY_MEMORY_CAP);
+
+    ////////////// RECORDING ////////////////
+
+    // Every SetTile() on the map between these two calls becomes one undo step
+    void BeginEdit(TileMap* map);
+    void EndEdit();
+    bool IsRecording() const;
+
+    // Called by TileMap before a chunk gets written. Safe to call from several threads
+    // as long as each chunk is only written by one of them
+    void OnChunkWrite(unsigned int index, TileMap::Chunk& chunk);
+
+    ////////////// UNDO / REDO ////////////////
+
+    bool Undo();
+    bool Redo();
+    bool CanUndo() const;
+    bool CanRedo() const;
+    void Clear();
+
+    ////////////// MEMORY ////////////////
+
+    void SetMemoryCap(size_t bytes);
+    size_t GetMemoryCap() const;
+    size_t GetMemoryUsage() const;
+    size_t GetNumUndo() const;
+    size_t GetNumRedo() const;
+
+private:
+    struct Snapshot
+    {
+        unsigned int chunk;
+        std::unique_ptr<TileID[]> cells;
+    };
+
+    static void CompressChunk(const TileID* before, const TileID* after, ChunkDelta& out);
+    void ApplyEdit(const Edit& edit, bool redo);
+    void TrimToCap();
+
+    TileMap* m_map = nullptr;
+    bool m_recording = false;
+    // Stamped onto chunks so each one is only copied once per edit
+    uint32_t m_editStamp = 0;
+
+    std::mutex m_snapshotMutex;
+    std::vector<Snapshot> m_snapshots;
+
+    std::deque<Edit> m_undoStack;
+    std::vector<Edit> m_redoStack;
+
+    size_t m_memoryUsage = 0;
+    size_t m_memoryCap;
+};
+
+#endif
@@ -14,10 +14,12 @@
 
 #include <Camera.h>
 #include <SHADER.h>
+#include <FramePacer.h>
 
 #include <iostream>
 #include <string>
 
+class EntityStore;
 
 class Engine {
 
@@ -29,6 +31,11 @@ public:
     void CreateWindow();
     void DestroyWindow();
     void StartRenderLoop();
+    // Runs numFrames of the scene through the active RenderDevice without GLFW. For CI and
+    // benchmarking with a NullRenderDevice
+    void RunHeadless(unsigned int numFrames);
+    // Sets the camera matrices on shader, then updates and draws the entities
+    void DrawScene(Shader& shader, EntityStore& entities);
 
     void SetBufferColor(float r, float g, float b, float a);
     void InitColors();
@@ -42,7 +49,7 @@ public:
     void CalculateDeltaTime();
 
     // MATRICES
-    void CreateMatrices(Shader s);
+    void CreateMatrices(Shader& s);
 
     // Input
     void ProcessInput(GLFWwindow *window);
@@ -75,23 +82,6 @@ public:
     // CAMERA
     Camera* camera;
 
-    // SHADERS
-    unsigned int vertexShader;
-    const char *vertexShaderSource = "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    "}\0";
-
-    unsigned int fragmentShader;
-    const char* fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main() {\n"
-    "FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);}\0";
-
-    //unsigned int shaderProgram;
-
     // VAO
     unsigned int VAO;
 
@@ -118,6 +108,8 @@ public:
 
     // TIME
     float deltaTime, lastFrame;
+    // Event polling, vsync and frame timing stats for the render loop
+    FramePacer pacer;
 
 };
 
@@ -0,0 +1,259 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <JobSystem.h>
+
+// Component types a program can use, each is one bit of an archetype's mask
+#define ENTITY_MAX_COMPONENTS 64
+// Size of a chunk, every component array of an archetype's chunk fits in one
+#define ENTITY_CHUNK_BYTES 16384
+// Chunks handed to each job by the parallel loops
+#define ENTITY_CHUNKS_PER_JOB 4
+
+typedef unsigned long long ComponentMask;
+
+// Handle to an entity. The generation tells a destroyed entity's handle apart from whatever
+// reuses its index later
+struct Entity
+{
+    unsigned int index = 0xFFFFFFFFu;
+    unsigned int generation = 0;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// Entities grouped by archetype, the exact set of components they have. Each archetype stores
+// its entities in fixed size chunks, and within a chunk every component type has its own packed
+// array, so a loop over a few components only touches their arrays.
+//
+// Components are plain data (trivially copyable), moved around with memcpy. Adding or removing
+// a component moves the entity to another archetype, so pointers from Get are only good until
+// the next Create, Destroy, Add or Remove, and none of those can be called from inside a loop.
+//
+// Queries are cached per component set and only look at archetypes made since they last ran.
+//
+//     Entity e = store.Create(TransformComponent{ ... }, WorldTransformComponent{});
+//     store.ForEach<TransformComponent>([](Entity e, TransformComponent& t) { t.position.y += 1.0f; });
+//     store.ParallelForEachChunk<TransformComponent, WorldTransformComponent>(
+//         [](unsigned int count, const Entity* entities, TransformComponent* t, WorldTransformComponent* w) { ... });
+class EntityStore
+{
+public:
+    EntityStore();
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    // Ids are handed out on first use and shared by every store
+    template<typename T>
+    static unsigned int GetComponentId()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Components have to be plain data");
+        static unsigned int id = RegisterComponent(sizeof(T), alignof(T));
+        return id;
+    }
+
+    // Straight into the archetype of the components given, no moves
+    template<typename... T>
+    Entity Create(const T&... components)
+    {
+        ComponentMask mask = MakeMask<T...>();
+        Entity entity = Allocate(GetArchetype(mask));
+        int unused[] = { 0, (Write<T>(entity, components), 0)... };
+        (void)unused;
+        return entity;
+    }
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const;
+    void Clear();
+
+    // Overwrites the component if the entity already has one
+    template<typename T>
+    void Add(Entity entity, const T& component = T())
+    {
+        if (!IsAlive(entity))
+        {
+            return;
+        }
+        unsigned int id = GetComponentId<T>();
+        Archetype* from = m_records[entity.index].archetype;
+        if (!(from->mask & Bit(id)))
+        {
+            Move(entity, GetTransition(from, id, true));
+        }
+        Write<T>(entity, component);
+    }
+    template<typename T>
+    void Remove(Entity entity)
+    {
+        unsigned int id = GetComponentId<T>();
+        if (IsAlive(entity) && (m_records[entity.index].archetype->mask & Bit(id)))
+        {
+            Move(entity, GetTransition(m_records[entity.index].archetype, id, false));
+        }
+    }
+    template<typename T>
+    bool Has(Entity entity) const
+    {
+        return IsAlive(entity) && (m_records[entity.index].archetype->mask & Bit(GetComponentId<T>())) != 0;
+    }
+    // NULL if the entity is dead or doesn't have one
+    template<typename T>
+    T* Get(Entity entity)
+    {
+        return Has<T>(entity) ? (T*)GetComponent(entity, GetComponentId<T>()) : NULL;
+    }
+
+    unsigned int GetCount() const;
+    unsigned int GetNumArchetypes() const;
+
+    // f(count, entities, T* arrays...) for every chunk of every archetype with all of T
+    template<typename... T, typename F>
+    void ForEachChunk(F&& f)
+    {
+        for (Archetype* archetype : GetQuery(MakeMask<T...>()))
+        {
+            for (Chunk& chunk : archetype->chunks)
+            {
+                CallChunk<T...>(*archetype, chunk, f);
+            }
+        }
+    }
+    // f(entity, T&...) for every entity with all of T
+    template<typename... T, typename F>
+    void ForEach(F&& f)
+    {
+        ForEachChunk<T...>([&f](unsigned int count, const Entity* entities, T*... components)
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                f(entities[i], components[i]...);
+            }
+        });
+    }
+    // As ForEachChunk, with the chunks spread over the JobSystem. f runs on several threads at
+    // once, each call with its own chunk
+    template<typename... T, typename F>
+    void ParallelForEachChunk(F&& f)
+    {
+        std::vector<std::pair<Archetype*, Chunk*>> chunks;
+        for (Archetype* archetype : GetQuery(MakeMask<T...>()))
+        {
+            for (Chunk& chunk : archetype->chunks)
+            {
+                chunks.push_back({ archetype, &chunk });
+            }
+        }
+        JobSystem::Get().ParallelFor((unsigned int)chunks.size(), ENTITY_CHUNKS_PER_JOB, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                CallChunk<T...>(*chunks[i].first, *chunks[i].second, f);
+            }
+        });
+    }
+    template<typename... T, typename F>
+    void ParallelForEach(F&& f)
+    {
+        ParallelForEachChunk<T...>([&f](unsigned int count, const Entity* entities, T*... components)
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                f(entities[i], components[i]...);
+            }
+        });
+    }
+
+private:
+    struct alignas(64) ChunkMemory
+    {
+        unsigned char bytes[ENTITY_CHUNK_BYTES];
+    };
+    struct Chunk
+    {
+        std::unique_ptr<ChunkMemory> memory;
+        unsigned int count = 0;
+    };
+    struct Archetype
+    {
+        ComponentMask mask = 0;
+        std::vector<unsigned int> components;
+        // Byte offset of each component id's array in a chunk, the entity array is at 0
+        unsigned int offsets[ENTITY_MAX_COMPONENTS];
+        // Size of each component id, copied here so the hot paths don't lock the registry
+        unsigned int sizes[ENTITY_MAX_COMPONENTS];
+        unsigned int capacity = 0;
+        // Full chunks first, only the last one has room
+        std::vector<Chunk> chunks;
+        // Where adding or removing a component id leads, filled in as they're used
+        std::unordered_map<unsigned int, Archetype*> added;
+        std::unordered_map<unsigned int, Archetype*> removed;
+    };
+    struct Record
+    {
+        Archetype* archetype = NULL;
+        unsigned int chunk = 0;
+        unsigned int row = 0;
+        unsigned int generation = 0;
+    };
+    struct Query
+    {
+        std::vector<Archetype*> archetypes;
+        // How many of m_archetypes have been checked
+        size_t numChecked = 0;
+    };
+
+    static unsigned int RegisterComponent(size_t size, size_t alignment);
+    static ComponentMask Bit(unsigned int id) { return 1ull << id; }
+    template<typename... T>
+    static ComponentMask MakeMask()
+    {
+        ComponentMask mask = 0;
+        int unused[] = { 0, (mask |= Bit(GetComponentId<T>()), 0)... };
+        (void)unused;
+        return mask;
+    }
+
+    template<typename T>
+    void Write(Entity entity, const T& component)
+    {
+        std::memcpy(GetComponent(entity, GetComponentId<T>()), &component, sizeof(T));
+    }
+    template<typename... T, typename F>
+    static void CallChunk(Archetype& archetype, Chunk& chunk, F& f)
+    {
+        if (chunk.count > 0)
+        {
+            unsigned char* bytes = chunk.memory->bytes;
+            f(chunk.count, (const Entity*)bytes, (T*)(bytes + archetype.offsets[GetComponentId<T>()])...);
+        }
+    }
+
+    Archetype* GetArchetype(ComponentMask mask);
+    Archetype* GetTransition(Archetype* from, unsigned int id, bool add);
+    const std::vector<Archetype*>& GetQuery(ComponentMask mask);
+    void* GetComponent(Entity entity, unsigned int id);
+    // A new entity in archetype, with its components uninitialized
+    Entity Allocate(Archetype* archetype);
+    // Adds a row at the end of archetype for the entity at index
+    void AddRow(Archetype* archetype, unsigned int index);
+    // Fills the row with the archetype's last one, so chunks stay packed
+    void RemoveRow(Archetype* archetype, unsigned int chunk, unsigned int row);
+    // Keeps the components both archetypes have
+    void Move(Entity entity, Archetype* to);
+
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_archetypesByMask;
+    std::unordered_map<ComponentMask, Query> m_queries;
+    std::vector<Record> m_records;
+    std::vector<unsigned int> m_freeIndices;
+    unsigned int m_count = 0;
+};
+
+#endif
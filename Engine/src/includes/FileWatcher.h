@@ -0,0 +1,60 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// How often the watcher thread looks at modification times where there's no inotify, and how
+// long it blocks on inotify before checking whether it's been stopped
+#define FILE_WATCH_POLL_SECONDS 0.05
+
+// Reports files that were written to, from a thread of its own. On Linux it sleeps on inotify,
+// elsewhere it compares modification times every FILE_WATCH_POLL_SECONDS.
+//
+// Whole directories are watched rather than the files in them, since most editors save by
+// writing a new file and renaming it over the old one, which a watch on the file itself misses.
+class FileWatcher
+{
+public:
+    // onChange is called on the watcher thread whenever something changed, e.g. to wake up a loop
+    // that's waiting on events. The changes themselves are picked up with TakeChanges
+    explicit FileWatcher(std::function<void()> onChange = NULL);
+    ~FileWatcher();
+
+    // Any thread. Starts reporting changes to path (made absolute). False if it doesn't exist
+    bool Watch(const std::string& path);
+    // Any thread. Never blocks. Fills changed with the watched files written since the last call,
+    // each once however many times it was written
+    void TakeChanges(std::vector<std::string>& changed);
+
+    // The form paths are reported in, for comparing with them
+    static std::string Normalize(const std::string& path);
+
+private:
+    void ThreadLoop();
+    void PollModifiedTimes();
+#ifdef __linux__
+    void ReadEvents();
+#endif
+    void AddChange(const std::string& path);
+
+    std::function<void()> m_onChange;
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_files;
+    std::unordered_set<std::string> m_changed;
+    bool m_quit = false;
+#ifdef __linux__
+    int m_inotify = -1;
+    // inotify watch descriptor to the directory it's on
+    std::unordered_map<int, std::string> m_directories;
+#endif
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#define GLFW_INCLUDE_NONE
+
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+enum Pacing_Mode
+{
+    // Swap interval of 1, the driver blocks in glfwSwapBuffers until the next vblank
+    PACING_VSYNC,
+    // No vsync, sleeps (then yields for the last bit) until the target frame time
+    PACING_CAPPED,
+    // Blocks on events and only renders when something marked the frame dirty
+    PACING_EVENT_DRIVEN
+};
+
+#define DEFAULT_TARGET_FRAME_RATE 60.0
+#define DEFAULT_FIXED_STEP (1.0 / 60.0)
+// How long an event driven loop sleeps with nothing happening before checking in anyway
+#define DEFAULT_IDLE_TIMEOUT 0.5
+
+// Runs the main loop's timing: event polling/waiting, a fixed-step update accumulator
+// that's separate from rendering, frame limiting, and stats on where the time went.
+//
+// Per loop iteration:
+//     int ticks = pacer.BeginFrame();
+//     for (int i = 0; i < ticks; ++i) { FixedUpdate(pacer.GetFixedStep()); }
+//     if (pacer.ShouldRender()) { Render(); pacer.Present(); }
+//     pacer.EndFrame(rendered);
+class FramePacer
+{
+public:
+    struct Stats
+    {
+        unsigned long long loops = 0;
+        unsigned long long framesRendered = 0;
+        unsigned long long fixedUpdates = 0;
+        // Time per rendered frame, in milliseconds
+        double avgFrameMs = 0.0;
+        double minFrameMs = 0.0;
+        double maxFrameMs = 0.0;
+        // Time from the end of BeginFrame to Present, so what drawing the frame cost without
+        // any waits. The frame time above includes vsync, this is what adding a window costs
+        double avgWorkMs = 0.0;
+        double maxWorkMs = 0.0;
+        // Samples behind the averages. Frame time is measured between rendered frames, so the
+        // first frame only starts the clock and there's one fewer frame sample than frames drawn
+        unsigned long long frameSamples = 0;
+        unsigned long long workSamples = 0;
+        // Time spent blocked in event waits or sleeping
+        double idleSeconds = 0.0;
+        double totalSeconds = 0.0;
+        // Fraction of wall time the loop was actually doing work
+        double busyFraction = 0.0;
+    };
+
+    FramePacer(Pacing_Mode mode = PACING_VSYNC,
+        double targetFrameRate = DEFAULT_TARGET_FRAME_RATE,
+        double fixedStep = DEFAULT_FIXED_STEP);
+
+    // Applies the swap interval for the mode. The window's context has to be current
+    void Attach(GLFWwindow* window);
+
+    void SetMode(Pacing_Mode mode);
+    Pacing_Mode GetMode() const;
+    void SetTargetFrameRate(double frameRate);
+    void SetFixedStep(double step);
+    double GetFixedStep() const;
+    void SetIdleTimeout(double seconds);
+    // Off when something else handles events for this window, like a WindowGroup running
+    // several windows off one loop. BeginFrame then only does the fixed step timing
+    void SetHandlesEvents(bool handles);
+    // Time the owner spent waiting on events for this window, when it handles them
+    void AddIdleTime(double seconds);
+    // With several windows only one of them should wait for vblank, or each swap waits its own
+    // and the loop runs at a fraction of the refresh rate. Off swaps straight away in every mode
+    void SetVBlankSync(bool sync);
+
+    ////////////////// PER FRAME /////////////////////////
+
+    // Handles events for this iteration and returns how many fixed updates to run
+    int BeginFrame();
+    bool ShouldRender() const;
+    // Swaps the attached window. Time blocked on vsync in here counts as idle
+    void Present();
+    void EndFrame(bool rendered);
+
+    // Requests a redraw in event driven mode. A few extra frames can be asked for, ImGui
+    // usually needs one or two to settle after input
+    void MarkDirty(int numFrames = 1);
+    bool IsDirty() const;
+    // How far between fixed updates the current frame is, for interpolating
+    double GetInterpolationAlpha() const;
+
+    ////////////////// STATS /////////////////////////
+
+    const Stats& GetStats() const;
+    void ResetStats();
+    std::string GetReport() const;
+
+private:
+    void TimedWait(double seconds);
+    void UpdateSwapInterval();
+
+    GLFWwindow* m_window = NULL;
+    Pacing_Mode m_mode;
+
+    double m_targetFrameTime;
+    double m_fixedStep;
+    double m_idleTimeout = DEFAULT_IDLE_TIMEOUT;
+    bool m_handlesEvents = true;
+    bool m_vblankSync = true;
+    // Caps the accumulator after a long stall so the loop doesn't try to catch up all at once
+    double m_maxAccumulated = 0.25;
+
+    double m_accumulator = 0.0;
+    double m_lastTime = -1.0;
+    double m_lastRenderTime = -1.0;
+    double m_nextFrameTime = 0.0;
+    double m_workStart = 0.0;
+    double m_statsStart = 0.0;
+    int m_dirtyFrames = 1;
+
+    Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef GLRENDERDEVICE_H
+#define GLRENDERDEVICE_H
+
+#include <RenderDevice.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The real backend. Every call maps onto the matching gl* function, so a context has to be
+// current and GLAD loaded before anything is called on it
+class GLRenderDevice : public RenderDevice
+{
+public:
+    const char* GetName() const override;
+    bool NeedsContext() const override;
+    std::string GetDriverString() override;
+    void InitContext() override;
+
+    ////////////////// BUFFERS /////////////////////////
+
+    unsigned int CreateVertexArray() override;
+    void DeleteVertexArray(unsigned int vertexArray) override;
+    void BindVertexArray(unsigned int vertexArray) override;
+
+    unsigned int CreateBuffer() override;
+    void DeleteBuffer(unsigned int buffer) override;
+    void BindBuffer(GLenum target, unsigned int buffer) override;
+    void BufferData(GLenum target, size_t size, const void* data, GLenum usage) override;
+    void BufferSubData(GLenum target, size_t offset, size_t size, const void* data) override;
+
+    void EnableVertexAttribArray(unsigned int index) override;
+    void VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+        size_t offset) override;
+    void VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset) override;
+
+    ////////////////// TEXTURES /////////////////////////
+
+    unsigned int CreateTexture() override;
+    void DeleteTexture(unsigned int texture) override;
+    void ActiveTexture(unsigned int unit) override;
+    void BindTexture(GLenum target, unsigned int texture) override;
+    void TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void GenerateMipmap(GLenum target) override;
+    void TexParameter(GLenum target, GLenum name, int value) override;
+
+    ////////////////// SHADERS /////////////////////////
+
+    unsigned int CreateShader(GLenum stage) override;
+    void ShaderSource(unsigned int shader, const char* source) override;
+    void CompileShader(unsigned int shader) override;
+    bool GetShaderStatus(unsigned int shader, std::string& log) override;
+    void DeleteShader(unsigned int shader) override;
+
+    unsigned int CreateProgram() override;
+    void AttachShader(unsigned int program, unsigned int shader) override;
+    void LinkProgram(unsigned int program) override;
+    bool IsProgramReady(unsigned int program) override;
+    bool GetProgramStatus(unsigned int program, std::string& log) override;
+    void DeleteProgram(unsigned int program) override;
+    void UseProgram(unsigned int program) override;
+    bool GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format) override;
+    bool ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size) override;
+
+    int GetUniformLocation(unsigned int program, const char* name) override;
+    void Uniform1i(int location, int value) override;
+    void Uniform1f(int location, float value) override;
+    void Uniform2f(int location, float x, float y) override;
+    void Uniform3f(int location, float x, float y, float z) override;
+    void Uniform4f(int location, float x, float y, float z, float w) override;
+    void Uniform2fv(int location, int count, const float* value) override;
+    void Uniform3fv(int location, int count, const float* value) override;
+    void Uniform4fv(int location, int count, const float* value) override;
+    void UniformMatrix2fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix3fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix4fv(int location, int count, bool transpose, const float* value) override;
+
+    ////////////////// QUERIES /////////////////////////
+
+    unsigned int CreateQuery() override;
+    void DeleteQuery(unsigned int query) override;
+    void BeginQuery(GLenum target, unsigned int query) override;
+    void EndQuery(GLenum target) override;
+    bool GetQueryResult(unsigned int query, unsigned long long& result) override;
+
+    ////////////////// FENCES /////////////////////////
+
+    unsigned int CreateFence() override;
+    Fence_Status WaitFence(unsigned int fence, unsigned long long timeoutNs) override;
+    void DeleteFence(unsigned int fence) override;
+
+    ////////////////// STATE AND DRAWING /////////////////////////
+
+    void Enable(GLenum capability) override;
+    void Disable(GLenum capability) override;
+    void Viewport(int x, int y, int width, int height) override;
+    void Scissor(int x, int y, int width, int height) override;
+    void LineWidth(float width) override;
+    void ClearColor(float r, float g, float b, float a) override;
+    void Clear(GLbitfield mask) override;
+
+    void DrawArrays(GLenum mode, int first, int count) override;
+    void DrawElements(GLenum mode, int count, GLenum type, size_t offset) override;
+
+private:
+    // Entry points past GL 3.3 are looked up the first time they're needed, since GLAD is only
+    // generated for 3.3 core. Safe from any thread with a context current: the first caller loads
+    // them and any other waits until it has, so nobody sees the flags before the pointers
+    void LoadExtensions();
+
+    std::once_flag m_extensionsLoaded;
+    bool m_programBinaries = false;
+    bool m_parallelCompile = false;
+
+    // GL sync objects are pointers rather than names, so fence handles index into this (handle
+    // - 1). Locked since fences are made on loader threads too
+    std::mutex m_fenceMutex;
+    std::vector<GLsync> m_fences;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define INPUT_LOG_MAGIC "ILOG"
+// 2: timestamps are microseconds since the previous event instead of since the start
+#define INPUT_LOG_VERSION 2
+
+enum Input_Event_Type
+{
+    INPUT_EVENT_CURSOR = 1,
+    INPUT_EVENT_BUTTON,
+    INPUT_EVENT_SCROLL,
+    INPUT_EVENT_KEY,
+    INPUT_EVENT_CHAR,
+    INPUT_EVENT_RESIZE
+};
+
+// One GLFW callback's worth of input. Which fields mean something depends on the type:
+//   cursor: x, y in pixels            scroll: x, y offsets
+//   button: code = button, action, mods
+//   key:    code = key, scancode, action, mods
+//   char:   code = codepoint          resize: x, y = framebuffer width and height
+struct InputEvent
+{
+    Input_Event_Type type = INPUT_EVENT_CURSOR;
+    // Seconds since the recording started
+    double time = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    int code = 0;
+    int scancode = 0;
+    int action = 0;
+    int mods = 0;
+};
+
+// Records input events into a compact binary log: a small header, then per event a type byte,
+// the microseconds since the event before it and only the fields that type uses (cursor moves
+// are 13 bytes). Deltas never run out however long a recording goes, only a single gap of over
+// 71 minutes between two events is cut short. Events are encoded as they come in and written
+// out in one go by Stop.
+class InputRecorder
+{
+public:
+    // width and height are the framebuffer size when recording starts, replays check against it
+    void Start(const std::string& path, int width, int height);
+    bool IsRecording() const;
+    void Record(const InputEvent& event);
+    // Writes the log, returns false if it couldn't be
+    bool Stop();
+    size_t GetNumEvents() const;
+
+private:
+    std::string m_path;
+    std::vector<uint8_t> m_data;
+    size_t m_numEvents = 0;
+    // Timestamp of the last event recorded, in microseconds
+    uint64_t m_lastTime = 0;
+    bool m_recording = false;
+};
+
+// Reads a log back and hands out the events in order, as a caller's clock passes their timestamps
+class InputReplay
+{
+public:
+    // Returns false (and prints why) if the file is missing or isn't a valid log
+    bool Load(const std::string& path);
+    bool IsLoaded() const;
+    // The next event with time <= the given time, if there is one
+    bool Next(double time, InputEvent& event);
+    bool IsFinished() const;
+    void Rewind();
+
+    size_t GetNumEvents() const;
+    // Timestamp of the last event
+    double GetDuration() const;
+    int GetWidth() const;
+    int GetHeight() const;
+
+private:
+    std::vector<InputEvent> m_events;
+    size_t m_next = 0;
+    int m_width = 0;
+    int m_height = 0;
+    bool m_loaded = false;
+};
+
+#endif
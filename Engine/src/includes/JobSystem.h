@@ -0,0 +1,121 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Counts unfinished jobs. Pass one to Run for every job in a group, then Wait on it or hang
+// continuation jobs off it with RunAfter. Reusable, or safe to destroy, once Wait returns
+class JobCounter
+{
+public:
+    bool IsDone() const;
+
+private:
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    std::atomic<int> m_pending{ 0 };
+    // Guards the continuations, so one can't be added while the last job is draining them
+    std::mutex m_mutex;
+    std::vector<Continuation> m_continuations;
+};
+
+// Work stealing job scheduler shared by the engine's subsystems.
+//
+// Each worker has its own deque. It pushes and pops its own jobs at the back (newest first, so a
+// job's children run while their data is still in cache) and steals from the front of the others'
+// when it runs dry. Threads that aren't workers, like the main thread, submit into a shared queue
+// that workers steal from the same way.
+//
+// There are no fibers. A thread that waits on a counter runs other jobs until it's done, and
+// anything that should happen after a group finishes can be queued as a continuation instead
+// of blocking.
+//
+//     JobCounter counter;
+//     for (Chunk& chunk : chunks) { jobs.Run([&chunk] { Mesh(chunk); }, &counter); }
+//     jobs.RunAfter(counter, [] { Upload(); });
+//     jobs.Wait(counter);
+class JobSystem
+{
+public:
+    // Total threads including the ones that call Wait, so numThreads - 1 workers are started.
+    // 0 uses every hardware thread
+    explicit JobSystem(unsigned int numThreads = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // The scheduler engine code submits to. Defaults to one using every hardware thread
+    static JobSystem& Get();
+    // Swaps it, e.g. for a benchmark pinned to a thread count. Doesn't take ownership, and
+    // passing NULL goes back to the default
+    static void Set(JobSystem* jobSystem);
+
+    unsigned int GetNumThreads() const;
+
+    // counter (optional) is incremented now and decremented when the job finishes. With no
+    // workers (a single thread system) the job runs right away on the calling thread
+    void Run(std::function<void()> job, JobCounter* counter = NULL);
+    // Queues job once every job counted by dependency has finished, right away if it already has
+    void RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = NULL);
+    // Runs other jobs on the calling thread until the counter is done
+    void Wait(JobCounter& counter);
+
+    // body(begin, end) over [0, count) in batches of batchSize, returns once all of it has run.
+    // The calling thread takes batches too
+    void ParallelFor(unsigned int count, unsigned int batchSize,
+        const std::function<void(unsigned int begin, unsigned int end)>& body);
+
+    unsigned long long GetNumJobsRun() const;
+    unsigned long long GetNumSteals() const;
+
+private:
+    struct Job
+    {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void Push(Job job);
+    // Own queue first (newest), then steals (oldest) starting from a neighbour
+    bool TryRunOne();
+    void Execute(Job& job);
+    void Finish(JobCounter* counter);
+    void WorkerLoop(unsigned int index);
+    // The calling thread's queue, the shared one for threads that aren't this system's workers
+    unsigned int GetQueueIndex() const;
+
+    std::vector<std::thread> m_workers;
+    // One per worker, then the shared queue last
+    std::vector<Queue> m_queues;
+
+    // Jobs queued and not yet taken, so idle workers know when to sleep
+    std::atomic<int> m_numQueued{ 0 };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_quit = false;
+
+    std::atomic<unsigned long long> m_numJobsRun{ 0 };
+    std::atomic<unsigned long long> m_numSteals{ 0 };
+};
+
+#endif
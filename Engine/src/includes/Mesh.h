@@ -43,12 +43,23 @@ public:
     vector<unsigned int> indices;
     vector<Texture> textures;
 
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures);
+    // upload = false keeps it CPU side only, so it can be built off the render thread and
+    // uploaded later with Upload
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool upload = true);
+    // Render thread. Uploads the buffers if UploadBuffers hasn't already, then sets up the vertex array
+    void Upload();
+    // Just the vertex and index buffers. Buffers are shared between contexts (vertex arrays
+    // aren't), so this part can run on a loader thread with a shared context current
+    void UploadBuffers();
+    bool IsUploaded() const;
+    // Does nothing until it's uploaded
     void Draw(Shader &shader);
 
 private:
     // render data
-    unsigned int VAO, VBO, EBO;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    bool buffersUploaded = false;
+    bool uploaded = false;
 
     void SetupMesh();
 
@@ -13,8 +13,10 @@
 #include <assimp/postprocess.h>
 
 #include <Mesh.h>
+#include <SceneGraph.h>
 #include <SHADER.h>
 
+#include <atomic>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -23,27 +25,86 @@
 #include <vector>
 using namespace std;
 
+enum Model_Load_State
+{
+    MODEL_LOADING,
+    // Imported, waiting on the render thread to upload it
+    MODEL_UPLOADING,
+    MODEL_READY,
+    MODEL_FAILED
+};
+
 class Model
 {
 public:
+    // Loads and uploads everything before returning. ModelLoader::Load is the version that doesn't block
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
-        LoadModel(path);
+        m_state = LoadModel(path) ? MODEL_READY : MODEL_FAILED;
     }
-    void Draw(Shader &shader);
+    // Sets "model" to transform times each mesh's node transform and draws it. Draws a
+    // placeholder cube while the model is still loading, nothing if it failed
+    void Draw(Shader &shader, const glm::mat4 &transform = glm::mat4(1.0f));
+
+    Model_Load_State GetState() const;
+    bool IsReady() const;
 
     bool gammaCorrection;
 private:
+    friend class ModelLoader;
+
+    // A texture decoded off the render thread, waiting to be uploaded
+    struct PendingTexture
+    {
+        string path;
+        unsigned char* data = NULL;
+        int width = 0;
+        int height = 0;
+        int components = 0;
+    };
+
+    // Empty, for ModelLoader to fill in with deferred uploads. A tag rather than a bool
+    // overload, since a string literal would pick Model(bool) over Model(string)
+    struct Deferred {};
+    Model(Deferred, bool gamma) : gammaCorrection(gamma), m_deferUpload(true)
+    {
+    }
+
     // model data
     vector<Mesh> meshes;
+    // The file's node hierarchy, and the node each mesh hangs off
+    SceneGraph m_nodes;
+    vector<SceneNode> m_meshNodes;
     vector<Texture> textures_loaded;
     string directory;
 
-    void LoadModel(string path);
-    void ProcessNode(aiNode *node, const aiScene *scene);
-    Mesh ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    std::atomic<int> m_state{ MODEL_LOADING };
+    // Leaves GL work to UploadPending, so LoadModel can run on any thread
+    bool m_deferUpload = false;
+    vector<PendingTexture> m_pendingTextures;
+    size_t m_nextTexture = 0;
+    size_t m_nextMesh = 0;
+
+    // Returns false if the file couldn't be imported
+    bool LoadModel(string path);
+    // Collects the scene's meshes depth first, the order they end up in meshes, and adds the
+    // node under parent in m_nodes
+    void ProcessNode(aiNode *node, SceneNode parent, const aiScene *scene, vector<aiMesh*> &sceneMeshes);
+    // Resolves materials once each, then decodes textures and converts meshes across the JobSystem
+    void ProcessMeshes(const vector<aiMesh*> &sceneMeshes, const aiScene *scene);
+    // Only touches its arguments, so any number can run at once
+    static void ProcessMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices);
+    // Queues textures it hasn't seen before in m_pendingTextures, still to be decoded
     vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName);
-    unsigned int TextureFromFile(const char *path, const string &directory);
+    static void DecodeTexture(PendingTexture &texture, const string &directory);
+    static unsigned int UploadTexture(PendingTexture &texture);
+    // Render thread only. Uploads textures, then meshes, one at a time until budgetSeconds have
+    // passed (always at least one). Returns true once there's nothing left
+    bool UploadPending(double budgetSeconds);
+    // Every texture and mesh buffer, for a loader thread with a shared context. Vertex arrays
+    // can't be shared, so UploadPending still has those left to make on the render thread
+    void UploadBuffers();
+    void UploadNextTexture();
 };
 
 
@@ -0,0 +1,51 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Model.h>
+
+// Time the render thread spends uploading loaded models per frame
+#define MODEL_UPLOAD_BUDGET_MS 2.0
+
+// Loads models without blocking the render thread. The Assimp import, vertex processing and
+// texture decoding run as a job on the JobSystem. If the UploadThread is running the buffers and
+// textures are uploaded there, otherwise the render thread does them a few at a time in Update
+// so a big model is spread over several frames instead of stalling one. Either way the vertex
+// arrays are made in Update, and until then the model draws a placeholder.
+//
+//     std::shared_ptr<Model> model = ModelLoader::Get().Load(path);
+//     while (running) { ModelLoader::Get().Update(); model->Draw(shader); }
+class ModelLoader
+{
+public:
+    // Called on the render thread once the model is ready to draw, or failed to load
+    typedef std::function<void(Model& model, bool loaded)> Callback;
+
+    static ModelLoader& Get();
+
+    // Render thread only. Returns right away, the model is drawable (as a placeholder) immediately
+    std::shared_ptr<Model> Load(const std::string& path, Callback onLoaded = NULL, bool gamma = false);
+    // Render thread, once a frame. Uploads imported models for up to budgetMs and runs the
+    // callbacks of the ones that finished
+    void Update(double budgetMs = MODEL_UPLOAD_BUDGET_MS);
+    // Models loading or waiting to upload
+    unsigned int GetNumPending() const;
+
+private:
+    struct Request
+    {
+        std::shared_ptr<Model> model;
+        Callback onLoaded;
+        std::string path;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::vector<Request> m_requests;
+};
+
+#endif
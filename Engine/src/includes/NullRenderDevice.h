@@ -0,0 +1,212 @@
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include <RenderDevice.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A backend with no GPU behind it. Calls are validated against a small model of GL state
+// (bindings, buffer sizes, live objects), counted, and optionally logged, but nothing is drawn.
+// Meant for running the engine in CI or on machines without a display, and for checking what a
+// frame actually submits.
+class NullRenderDevice : public RenderDevice
+{
+public:
+    struct Command
+    {
+        // The RenderDevice function that was called, e.g. "DrawElements"
+        const char* name;
+        // The handle or enum the call was about, 0 if it has none
+        unsigned int object;
+        // Bytes uploaded for buffer/texture calls, vertex count for draws
+        size_t amount;
+    };
+
+    struct Stats
+    {
+        unsigned long long commands = 0;
+        unsigned long long drawCalls = 0;
+        unsigned long long verticesSubmitted = 0;
+        unsigned long long triangles = 0;
+        // Binds, enables and program switches that actually changed something
+        unsigned long long stateChanges = 0;
+        // Same calls, but setting what was already set
+        unsigned long long redundantStateChanges = 0;
+        unsigned long long uniformUploads = 0;
+        unsigned long long bufferUploads = 0;
+        unsigned long long bufferBytesUploaded = 0;
+        unsigned long long textureUploads = 0;
+        unsigned long long textureBytesUploaded = 0;
+        unsigned long long shaderCompiles = 0;
+        unsigned long long programLinks = 0;
+        unsigned long long programBinaryLoads = 0;
+        // Calls a real driver would reject or that would draw garbage (nothing bound, deleted handles,
+        // drawing past the end of a buffer, ...)
+        unsigned long long invalidCalls = 0;
+    };
+
+    const char* GetName() const override;
+    bool NeedsContext() const override;
+    std::string GetDriverString() override;
+    void InitContext() override;
+
+    ////////////////// BUFFERS /////////////////////////
+
+    unsigned int CreateVertexArray() override;
+    void DeleteVertexArray(unsigned int vertexArray) override;
+    void BindVertexArray(unsigned int vertexArray) override;
+
+    unsigned int CreateBuffer() override;
+    void DeleteBuffer(unsigned int buffer) override;
+    void BindBuffer(GLenum target, unsigned int buffer) override;
+    void BufferData(GLenum target, size_t size, const void* data, GLenum usage) override;
+    void BufferSubData(GLenum target, size_t offset, size_t size, const void* data) override;
+
+    void EnableVertexAttribArray(unsigned int index) override;
+    void VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+        size_t offset) override;
+    void VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset) override;
+
+    ////////////////// TEXTURES /////////////////////////
+
+    unsigned int CreateTexture() override;
+    void DeleteTexture(unsigned int texture) override;
+    void ActiveTexture(unsigned int unit) override;
+    void BindTexture(GLenum target, unsigned int texture) override;
+    void TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void GenerateMipmap(GLenum target) override;
+    void TexParameter(GLenum target, GLenum name, int value) override;
+
+    ////////////////// SHADERS /////////////////////////
+
+    unsigned int CreateShader(GLenum stage) override;
+    void ShaderSource(unsigned int shader, const char* source) override;
+    void CompileShader(unsigned int shader) override;
+    bool GetShaderStatus(unsigned int shader, std::string& log) override;
+    void DeleteShader(unsigned int shader) override;
+
+    unsigned int CreateProgram() override;
+    void AttachShader(unsigned int program, unsigned int shader) override;
+    void LinkProgram(unsigned int program) override;
+    bool IsProgramReady(unsigned int program) override;
+    bool GetProgramStatus(unsigned int program, std::string& log) override;
+    void DeleteProgram(unsigned int program) override;
+    void UseProgram(unsigned int program) override;
+    bool GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format) override;
+    bool ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size) override;
+
+    int GetUniformLocation(unsigned int program, const char* name) override;
+    void Uniform1i(int location, int value) override;
+    void Uniform1f(int location, float value) override;
+    void Uniform2f(int location, float x, float y) override;
+    void Uniform3f(int location, float x, float y, float z) override;
+    void Uniform4f(int location, float x, float y, float z, float w) override;
+    void Uniform2fv(int location, int count, const float* value) override;
+    void Uniform3fv(int location, int count, const float* value) override;
+    void Uniform4fv(int location, int count, const float* value) override;
+    void UniformMatrix2fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix3fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix4fv(int location, int count, bool transpose, const float* value) override;
+
+    ////////////////// QUERIES /////////////////////////
+
+    unsigned int CreateQuery() override;
+    void DeleteQuery(unsigned int query) override;
+    void BeginQuery(GLenum target, unsigned int query) override;
+    void EndQuery(GLenum target) override;
+    bool GetQueryResult(unsigned int query, unsigned long long& result) override;
+
+    ////////////////// FENCES /////////////////////////
+
+    unsigned int CreateFence() override;
+    Fence_Status WaitFence(unsigned int fence, unsigned long long timeoutNs) override;
+    void DeleteFence(unsigned int fence) override;
+
+    ////////////////// STATE AND DRAWING /////////////////////////
+
+    void Enable(GLenum capability) override;
+    void Disable(GLenum capability) override;
+    void Viewport(int x, int y, int width, int height) override;
+    void Scissor(int x, int y, int width, int height) override;
+    void LineWidth(float width) override;
+    void ClearColor(float r, float g, float b, float a) override;
+    void Clear(GLbitfield mask) override;
+
+    void DrawArrays(GLenum mode, int first, int count) override;
+    void DrawElements(GLenum mode, int count, GLenum type, size_t offset) override;
+
+    ////////////////// RECORDING /////////////////////////
+
+    // The command log is on by default. Turn it off for long runs where only the counters matter
+    void SetRecording(bool recording);
+    const std::vector<Command>& GetCommands() const;
+    void ClearCommands();
+
+    const Stats& GetStats() const;
+    void ResetStats();
+    // The last invalid call, empty if there hasn't been one
+    const std::string& GetLastError() const;
+
+    // Size of the data store given to a buffer, 0 if it doesn't exist
+    size_t GetBufferSize(unsigned int buffer) const;
+    // Everything currently allocated in live buffers/textures (textures count their mip chain)
+    size_t GetBufferMemory() const;
+    size_t GetTextureMemory() const;
+    size_t GetNumLiveObjects() const;
+
+    std::string GetReport() const;
+
+private:
+    struct TextureInfo
+    {
+        size_t baseBytes = 0;
+        bool mipmapped = false;
+    };
+
+    void Record(const char* name, unsigned int object = 0, size_t amount = 0);
+    void Invalid(const char* name, const char* reason);
+    void StateChange(bool changed);
+    bool CanUploadUniform(const char* name, int location);
+    unsigned int* GetBinding(GLenum target);
+    unsigned int GetBoundTexture() const;
+
+    bool m_recording = true;
+    std::vector<Command> m_commands;
+    Stats m_stats;
+    std::string m_lastError;
+
+    // Handles are shared between every object type, 0 is never handed out
+    unsigned int m_nextHandle = 1;
+
+    std::unordered_set<unsigned int> m_vertexArrays;
+    std::unordered_map<unsigned int, size_t> m_buffers;
+    std::unordered_map<unsigned int, TextureInfo> m_textures;
+    std::unordered_set<unsigned int> m_shaders;
+    // Live programs and the locations handed out for their uniforms
+    std::unordered_map<unsigned int, std::unordered_map<std::string, int>> m_programs;
+    std::unordered_set<unsigned int> m_queries;
+    std::unordered_set<unsigned int> m_fences;
+
+    // Bound state. The element buffer binding belongs to the vertex array like it does in GL
+    unsigned int m_vertexArray = 0;
+    unsigned int m_arrayBuffer = 0;
+    std::unordered_map<unsigned int, unsigned int> m_elementBuffers;
+    unsigned int m_program = 0;
+    unsigned int m_activeUnit = 0;
+    std::unordered_map<unsigned int, unsigned int> m_boundTextures;
+    std::unordered_set<GLenum> m_enabled;
+    // Query active on each target, 0 when none is
+    std::unordered_map<GLenum, unsigned int> m_activeQueries;
+    int m_viewport[4] = { 0, 0, 0, 0 };
+    int m_scissor[4] = { 0, 0, 0, 0 };
+    float m_lineWidth = 1.0f;
+    float m_clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include <glm/glm.hpp>
+
+// Cursor <-> grid math for the isometric editor view, on plain matrices so it can be checked
+// without a window. Screen positions are in pixels with the origin at the top left, and z going
+// from 0 at the near plane to 1 at the far one. The grid's model matrix is the iso squish and
+// rotation followed by the pan offset, the way Window builds it.
+namespace Picking
+{
+    // translate(isoMatrix, gridOffset)
+    glm::mat4 GridModel(const glm::mat4& isoMatrix, glm::vec3 gridOffset);
+    // Inverse of viewProjection * GridModel(...), put together from the inverted pieces so nothing
+    // gets inverted per frame
+    glm::mat4 InverseGridMVP(const glm::mat4& inverseViewProjection, const glm::mat4& invIsoMatrix, glm::vec3 gridOffset);
+
+    // Screen -> grid space, and back
+    glm::vec3 UnProject(const glm::mat4& invMvp, glm::vec2 viewport, glm::vec3 screen);
+    glm::vec3 Project(const glm::mat4& mvp, glm::vec2 viewport, glm::vec3 gridPos);
+
+    // Where the ray through the screen position crosses the grid plane (y = 0 in grid space)
+    glm::vec3 ScreenToGrid(const glm::mat4& invMvp, glm::vec2 viewport, glm::vec2 screen);
+    // Tile the grid position is in, (0, 0) if the tile size is degenerate
+    glm::ivec2 GridToTile(glm::vec3 gridPos, glm::vec3 tileSize);
+}
+
+#endif
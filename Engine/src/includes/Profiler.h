@@ -0,0 +1,220 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Events a thread can have waiting for the main thread to collect them. Past this they're dropped
+#define PROFILER_THREAD_BUFFER_SIZE 16384
+#define PROFILER_MAX_THREADS 64
+// Frames kept for the trace dump and the frame time graph
+#define PROFILER_HISTORY_FRAMES 300
+// Frames of GPU queries kept in flight, results are read once the oldest set is reused so it never stalls
+#define PROFILER_GPU_LATENCY 4
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+// Times the rest of the enclosing block. The name is kept as a pointer, so use a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name)
+// Same for GPU time, through a GL_TIME_ELAPSED query. These don't nest, an inner one is ignored
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILER_CONCAT(gpuProfileScope, __LINE__)(name)
+
+// Hierarchical CPU (and GPU) frame profiler.
+//
+// Scopes can be opened on any thread. Each thread writes finished scopes into its own ring
+// buffer without locking, and the main thread drains every buffer in EndFrame, so recording
+// never waits on anything. Nesting comes from a per-thread depth counter, which is enough to
+// rebuild the tree afterwards since a thread's scopes can't overlap without nesting.
+//
+// GPU scopes need a context (RenderDevice::NeedsContext) and are skipped otherwise. Their results
+// are read PROFILER_GPU_LATENCY frames later. Queries can't be shared between contexts, so each
+// context gets its own, read the next time a GPU scope begins with that context current.
+//
+// Per frame, on the main thread:
+//     Profiler::Get().BeginFrame();
+//     { PROFILE_SCOPE("Update"); ... }
+//     { PROFILE_SCOPE("Submit"); PROFILE_GPU_SCOPE("Submit"); ... }
+//     Profiler::Get().EndFrame();
+class Profiler
+{
+public:
+    struct Event
+    {
+        const char* name;
+        // Nanoseconds since the profiler was created
+        int64_t start;
+        int64_t end;
+        uint16_t depth;
+        uint16_t thread;
+    };
+
+    // A scope at one place in the hierarchy, e.g. "Main/Frame/Submit"
+    struct ScopeStats
+    {
+        std::string path;
+        const char* name;
+        unsigned int thread;
+        unsigned int depth;
+        // Summed over every time the scope ran in the last frame it appeared in
+        double lastMs = 0.0;
+        unsigned int calls = 0;
+        double avgMs = 0.0;
+        double maxMs = 0.0;
+        unsigned long long lastFrame = 0;
+    };
+
+    struct GpuStats
+    {
+        const char* name;
+        double lastMs = 0.0;
+        double avgMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static Profiler& Get();
+
+    // Disabled scopes cost one branch
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+    // Label for the calling thread in the panel and trace
+    void SetThreadName(const std::string& name);
+
+    ////////////////// PER FRAME /////////////////////////
+
+    // Main thread only. Everything between the two is nested under a "Frame" scope
+    void BeginFrame();
+    void EndFrame();
+
+    ////////////////// RECORDING /////////////////////////
+
+    // Used by the scope classes, but can be called directly for scopes that aren't blocks
+    int64_t Now() const;
+    // Returns the depth the new scope is at
+    unsigned int PushScope();
+    void PopScope(const char* name, int64_t start, unsigned int depth);
+    // Main thread only. Returns false if the scope wasn't started (no context, or one is open).
+    // End it with the same context current
+    bool BeginGpuScope(const char* name);
+    void EndGpuScope();
+    // Main thread, while a context that's going away is still current. Deletes the queries made
+    // on it, along with any results they still had coming
+    void ReleaseGpuQueries();
+
+    ////////////////// RESULTS /////////////////////////
+
+    unsigned long long GetFrameIndex() const;
+    double GetLastFrameMs() const;
+    double GetAvgFrameMs() const;
+    // In the order the scopes ran last frame, then anything that didn't run
+    const std::vector<ScopeStats>& GetScopeStats() const;
+    const std::vector<GpuStats>& GetGpuStats() const;
+    unsigned long long GetNumDroppedEvents() const;
+    void ResetStats();
+
+    // An ImGui window with the scope tree and a frame time graph. Needs an ImGui frame in progress
+    void DrawPanel(bool* open = NULL);
+    // Everything in the history as Chrome trace JSON (chrome://tracing, Perfetto)
+    bool WriteChromeTrace(const std::string& path) const;
+    std::string GetReport() const;
+
+private:
+    struct ThreadBuffer;
+
+    struct Frame
+    {
+        unsigned long long index = 0;
+        int64_t start = 0;
+        int64_t end = 0;
+        std::vector<Event> events;
+        std::vector<Event> gpuEvents;
+    };
+
+    struct PendingQuery
+    {
+        const char* name;
+        unsigned int query;
+        int64_t cpuStart;
+    };
+
+    // The queries of one context
+    struct GpuQuerySet
+    {
+        std::vector<PendingQuery> pending[PROFILER_GPU_LATENCY];
+        // Frame each slot was last filled in
+        unsigned long long frames[PROFILER_GPU_LATENCY] = {};
+        std::vector<unsigned int> freeQueries;
+    };
+
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    ThreadBuffer* GetThreadBuffer();
+    void Collect(std::vector<Event>& out);
+    void UpdateScopeStats(const Frame& frame);
+    void ResolveGpuQueries(GpuQuerySet& set, unsigned int slot, Frame& frame);
+    std::string GetThreadName(unsigned int thread) const;
+
+    std::atomic<bool> m_enabled{ true };
+    int64_t m_epoch;
+
+    // Registered threads. Slots are filled once and never change after that
+    std::atomic<ThreadBuffer*> m_threads[PROFILER_MAX_THREADS];
+    std::atomic<unsigned int> m_numThreads{ 0 };
+    // Only guards the names, events never take it
+    mutable std::mutex m_namesMutex;
+
+    // Everything below is main thread only
+    Frame m_current;
+    bool m_inFrame = false;
+    int64_t m_frameStart = 0;
+    unsigned int m_frameDepth = 0;
+    unsigned long long m_frameIndex = 0;
+    std::deque<Frame> m_history;
+    double m_lastFrameMs = 0.0;
+    double m_avgFrameMs = 0.0;
+
+    std::vector<ScopeStats> m_scopes;
+    std::unordered_map<std::string, size_t> m_scopeIndex;
+
+    // Keyed by the GLFWwindow whose context made them
+    std::unordered_map<const void*, GpuQuerySet> m_gpuQueries;
+    std::vector<GpuStats> m_gpuStats;
+    bool m_gpuScopeOpen = false;
+    unsigned long long m_droppedGpuResults = 0;
+};
+
+// RAII CPU scope, normally through PROFILE_SCOPE
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+    // Closes the scope early, for timing part of a block whose locals have to outlive it
+    void End();
+
+private:
+    const char* m_name;
+    int64_t m_start = 0;
+    unsigned int m_depth = 0;
+    bool m_open;
+};
+
+// RAII GPU scope, normally through PROFILE_GPU_SCOPE
+class GpuProfileScope
+{
+public:
+    explicit GpuProfileScope(const char* name);
+    ~GpuProfileScope();
+
+private:
+    bool m_open;
+};
+
+#endif
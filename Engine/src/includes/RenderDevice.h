@@ -0,0 +1,153 @@
+#ifndef RENDERDEVICE_H
+#define RENDERDEVICE_H
+
+// Only for the GL types and enum values, nothing here needs a loaded context
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum Fence_Status
+{
+    // Everything before the fence has finished
+    FENCE_SIGNALED,
+    // Still running when the wait timed out, worth waiting again
+    FENCE_TIMEOUT,
+    // The wait itself failed (a lost context, ...), it will never signal
+    FENCE_FAILED
+};
+
+// Everything the engine draws with goes through one of these instead of calling gl* directly.
+// The arguments keep OpenGL's meaning (GL_ARRAY_BUFFER, GL_TRIANGLES, ...) so the GL backend is a
+// straight pass through, and other backends (NullRenderDevice) interpret them without a context.
+//
+// Object handles are plain unsigned ints that are only meaningful to the device that made them.
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() {}
+
+    // The device the engine is currently drawing through. Defaults to the OpenGL one
+    static RenderDevice* Get();
+    // Swaps the active device, e.g. to a NullRenderDevice for headless runs. Doesn't take ownership,
+    // and passing NULL goes back to the OpenGL device
+    static void Set(RenderDevice* device);
+
+    virtual const char* GetName() const = 0;
+    // False for backends that never touch a GPU, so callers can skip context-only work (ImGui, swaps)
+    virtual bool NeedsContext() const = 0;
+    // Vendor, renderer and version. Anything cached from the driver's output (program binaries)
+    // is only valid for the driver string it was made with
+    virtual std::string GetDriverString() = 0;
+    // Once on every context the device draws or uploads through (each window's and the loader
+    // thread's), right after it's first made current. Sets up driver state that's per context
+    virtual void InitContext() = 0;
+
+    ////////////////// BUFFERS /////////////////////////
+
+    virtual unsigned int CreateVertexArray() = 0;
+    virtual void DeleteVertexArray(unsigned int vertexArray) = 0;
+    virtual void BindVertexArray(unsigned int vertexArray) = 0;
+
+    virtual unsigned int CreateBuffer() = 0;
+    virtual void DeleteBuffer(unsigned int buffer) = 0;
+    virtual void BindBuffer(GLenum target, unsigned int buffer) = 0;
+    virtual void BufferData(GLenum target, size_t size, const void* data, GLenum usage) = 0;
+    virtual void BufferSubData(GLenum target, size_t offset, size_t size, const void* data) = 0;
+
+    // offset is in bytes from the start of the bound GL_ARRAY_BUFFER
+    virtual void EnableVertexAttribArray(unsigned int index) = 0;
+    virtual void VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+        size_t offset) = 0;
+    virtual void VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset) = 0;
+
+    ////////////////// TEXTURES /////////////////////////
+
+    virtual unsigned int CreateTexture() = 0;
+    virtual void DeleteTexture(unsigned int texture) = 0;
+    // unit is 0 based, not GL_TEXTURE0 based
+    virtual void ActiveTexture(unsigned int unit) = 0;
+    virtual void BindTexture(GLenum target, unsigned int texture) = 0;
+    virtual void TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+        GLenum format, GLenum type, const void* data) = 0;
+    // Overwrites part of a level TexImage2D already sized
+    virtual void TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+        GLenum format, GLenum type, const void* data) = 0;
+    virtual void GenerateMipmap(GLenum target) = 0;
+    virtual void TexParameter(GLenum target, GLenum name, int value) = 0;
+
+    ////////////////// SHADERS /////////////////////////
+
+    virtual unsigned int CreateShader(GLenum stage) = 0;
+    virtual void ShaderSource(unsigned int shader, const char* source) = 0;
+    virtual void CompileShader(unsigned int shader) = 0;
+    // Returns the compile status, and fills log with the info log when it failed
+    virtual bool GetShaderStatus(unsigned int shader, std::string& log) = 0;
+    virtual void DeleteShader(unsigned int shader) = 0;
+
+    virtual unsigned int CreateProgram() = 0;
+    virtual void AttachShader(unsigned int program, unsigned int shader) = 0;
+    virtual void LinkProgram(unsigned int program) = 0;
+    // Never blocks. False while the driver is still compiling or linking the program on its own
+    // threads, when asking for its status would stall. Always true without parallel compiling
+    virtual bool IsProgramReady(unsigned int program) = 0;
+    // Returns the link status, and fills log with the info log when it failed
+    virtual bool GetProgramStatus(unsigned int program, std::string& log) = 0;
+    virtual void DeleteProgram(unsigned int program) = 0;
+    virtual void UseProgram(unsigned int program) = 0;
+    // Linked programs in the driver's own format, for caching between runs. False when the device
+    // can't, in which case the program has to be built from source
+    virtual bool GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format) = 0;
+    // Loads a binary from GetProgramBinary in place of attaching and linking shaders. Can still
+    // fail on the same driver string (e.g. a driver update), so keep the sources to fall back on
+    virtual bool ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size) = 0;
+
+    virtual int GetUniformLocation(unsigned int program, const char* name) = 0;
+    virtual void Uniform1i(int location, int value) = 0;
+    virtual void Uniform1f(int location, float value) = 0;
+    virtual void Uniform2f(int location, float x, float y) = 0;
+    virtual void Uniform3f(int location, float x, float y, float z) = 0;
+    virtual void Uniform4f(int location, float x, float y, float z, float w) = 0;
+    virtual void Uniform2fv(int location, int count, const float* value) = 0;
+    virtual void Uniform3fv(int location, int count, const float* value) = 0;
+    virtual void Uniform4fv(int location, int count, const float* value) = 0;
+    virtual void UniformMatrix2fv(int location, int count, bool transpose, const float* value) = 0;
+    virtual void UniformMatrix3fv(int location, int count, bool transpose, const float* value) = 0;
+    virtual void UniformMatrix4fv(int location, int count, bool transpose, const float* value) = 0;
+
+    ////////////////// QUERIES /////////////////////////
+
+    virtual unsigned int CreateQuery() = 0;
+    virtual void DeleteQuery(unsigned int query) = 0;
+    // Only one query per target can be active at a time (GL_TIME_ELAPSED queries don't nest)
+    virtual void BeginQuery(GLenum target, unsigned int query) = 0;
+    virtual void EndQuery(GLenum target) = 0;
+    // Never blocks. Returns false while the result isn't available yet
+    virtual bool GetQueryResult(unsigned int query, unsigned long long& result) = 0;
+
+    ////////////////// FENCES /////////////////////////
+
+    // Marks the point after every command issued so far on the calling thread's context, and
+    // flushes so it's sure to signal. Safe to call from any thread with a context current
+    virtual unsigned int CreateFence() = 0;
+    // Blocks up to timeoutNs (0 just polls). FENCE_TIMEOUT can be waited on again, FENCE_FAILED can't
+    virtual Fence_Status WaitFence(unsigned int fence, unsigned long long timeoutNs) = 0;
+    virtual void DeleteFence(unsigned int fence) = 0;
+
+    ////////////////// STATE AND DRAWING /////////////////////////
+
+    virtual void Enable(GLenum capability) = 0;
+    virtual void Disable(GLenum capability) = 0;
+    virtual void Viewport(int x, int y, int width, int height) = 0;
+    virtual void Scissor(int x, int y, int width, int height) = 0;
+    virtual void LineWidth(float width) = 0;
+    virtual void ClearColor(float r, float g, float b, float a) = 0;
+    virtual void Clear(GLbitfield mask) = 0;
+
+    virtual void DrawArrays(GLenum mode, int first, int count) = 0;
+    // offset is in bytes into the bound GL_ELEMENT_ARRAY_BUFFER
+    virtual void DrawElements(GLenum mode, int count, GLenum type, size_t offset) = 0;
+};
+
+#endif
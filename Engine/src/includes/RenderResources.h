@@ -0,0 +1,110 @@
+#ifndef RENDERRESOURCES_H
+#define RENDERRESOURCES_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <TileImposters.h>
+#include <TileMap.h>
+#include <TileRenderer.h>
+
+struct GLFWwindow;
+struct ImFontAtlas;
+
+// GL objects every window can draw with. Each window's context shares with the first one made,
+// so a program, buffer or texture uploaded through any of them works in all of them and only
+// needs making once. Programs already work that way through the ShaderLibrary; this holds the
+// rest: named static buffers, the tile renderers (one set of chunk buffers per map), the chunk
+// imposters minimaps draw with and the font atlas behind every window's ImGui context.
+//
+// Windows acquire what they draw with and release it when they close. The last window to close
+// frees whatever is left, and stops the UploadThread, which shares the same objects.
+//
+//     unsigned int VBO = RenderResources::Get().AcquireBuffer("crosshair", lines, size);
+//     ...
+//     RenderResources::Get().ReleaseBuffer("crosshair");
+class RenderResources
+{
+public:
+    static RenderResources& Get();
+
+    ////////////////// CONTEXTS /////////////////////////
+
+    // Context new windows should share with, NULL until the first window adds its own
+    GLFWwindow* GetShareContext() const;
+    // Once the window's context is current and GLAD is loaded
+    void AddContext(GLFWwindow* context);
+    // While the context is still current. The last one frees everything still held
+    void RemoveContext(GLFWwindow* context);
+    unsigned int GetNumContexts() const;
+
+    ////////////////// SHARED OBJECTS /////////////////////////
+
+    // Static vertex data stored under name. The first window to ask uploads it, the rest get the
+    // same buffer, so the data has to be the same for everyone asking for that name
+    unsigned int AcquireBuffer(const std::string& name, const void* data, size_t size);
+    void ReleaseBuffer(const std::string& name);
+
+    // The renderer for tileMap, made by the first window to ask for it. view is set to the
+    // vertex arrays for the calling context, to pass to TileRenderer::Draw
+    TileRenderer* AcquireTileRenderer(TileMap* tileMap, glm::vec3 tileSize, unsigned int& view);
+    // With the context view was made on current
+    void ReleaseTileRenderer(TileMap* tileMap, unsigned int view);
+
+    // Low resolution chunk pictures of tileMap, for minimaps. Textures are shared, so unlike the
+    // renderer there's nothing per context
+    TileImposters* AcquireTileImposters(TileMap* tileMap);
+    void ReleaseTileImposters(TileMap* tileMap);
+
+    // For ImGui::CreateContext, so the glyphs are only rasterized and uploaded once. ImGui frees
+    // it with the last context using it
+    ImFontAtlas* GetFontAtlas();
+    // Right before each ImGui::NewFrame. Nothing owns a shared atlas, so this does the per frame
+    // work the owning context would have done
+    void BeginImGuiFrame();
+
+    ////////////////// CHANGES /////////////////////////
+
+    // Once a frame per window. Swaps in hot reloaded programs and returns how many were swapped
+    unsigned int Update();
+    // Something every window draws with has changed, like a program reloading or tile buffers
+    // being rebuilt
+    void MarkChanged();
+    // Bumped by MarkChanged. Windows redraw when it isn't the one they last drew with
+    unsigned int GetVersion() const;
+
+private:
+    struct SharedBuffer
+    {
+        unsigned int buffer = 0;
+        unsigned int refCount = 0;
+    };
+
+    struct SharedTileRenderer
+    {
+        TileRenderer* renderer = NULL;
+        unsigned int refCount = 0;
+    };
+
+    struct SharedTileImposters
+    {
+        TileImposters* imposters = NULL;
+        unsigned int refCount = 0;
+    };
+
+    void FreeAll();
+
+    std::vector<GLFWwindow*> m_contexts;
+    std::unordered_map<std::string, SharedBuffer> m_buffers;
+    std::unordered_map<TileMap*, SharedTileRenderer> m_tileRenderers;
+    std::unordered_map<TileMap*, SharedTileImposters> m_tileImposters;
+    ImFontAtlas* m_fontAtlas = NULL;
+    int m_imguiFrame = 0;
+    unsigned int m_version = 0;
+};
+
+#endif
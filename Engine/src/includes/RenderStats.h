@@ -0,0 +1,83 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <string>
+
+// Frames the rolling averages and maxima are taken over, and the CSV export keeps
+#define RENDER_STATS_HISTORY_FRAMES 120
+
+enum RenderStat
+{
+    RENDER_STAT_DRAW_CALLS,
+    RENDER_STAT_TRIANGLES,
+    RENDER_STAT_VERTICES,
+    // Program, vertex array and texture binds
+    RENDER_STAT_STATE_CHANGES,
+    RENDER_STAT_UNIFORM_UPLOADS,
+    RENDER_STAT_BUFFER_UPLOADS,
+    RENDER_STAT_BUFFER_BYTES,
+    RENDER_STAT_TEXTURE_UPLOADS,
+    RENDER_STAT_TEXTURE_BYTES,
+    RENDER_STAT_COUNT
+};
+
+// What a frame cost the renderer, counted by the code issuing the work (Mesh::Draw, the Shader
+// setters, the tile and grid draws, texture loads) so it's the same whichever RenderDevice is active.
+//
+// Counting is a relaxed atomic add, so it's fine from loader threads too. Whatever is counted between
+// two EndFrame calls is one frame, including uploads done while loading before the first frame.
+class RenderStats
+{
+public:
+    static RenderStats& Get();
+
+    void Add(RenderStat stat, unsigned long long amount = 1)
+    {
+        m_current[stat].fetch_add(amount, std::memory_order_relaxed);
+    }
+    // One draw call of count vertices, with the triangles it makes for mode
+    void AddDraw(GLenum mode, unsigned int count);
+
+    // Main thread only. Closes the frame and rolls it into the history
+    void EndFrame();
+
+    ////////////////// RESULTS /////////////////////////
+
+    static const char* GetName(RenderStat stat);
+    unsigned long long GetFrameIndex() const;
+    // The last finished frame
+    unsigned long long GetLast(RenderStat stat) const;
+    // Over the last RENDER_STATS_HISTORY_FRAMES frames
+    double GetAverage(RenderStat stat) const;
+    unsigned long long GetMax(RenderStat stat) const;
+    // Since startup or the last Reset
+    unsigned long long GetTotal(RenderStat stat) const;
+    void Reset();
+
+    // An ImGui window with the counters. Needs an ImGui frame in progress
+    void DrawOverlay(bool* open = NULL);
+    // One row per frame in the history
+    bool WriteCSV(const std::string& path) const;
+    // Last, average, max and total of every counter
+    bool WriteJSON(const std::string& path) const;
+    std::string GetReport() const;
+
+private:
+    RenderStats() {}
+    RenderStats(const RenderStats&) = delete;
+    RenderStats& operator=(const RenderStats&) = delete;
+
+    std::atomic<unsigned long long> m_current[RENDER_STAT_COUNT] = {};
+
+    // Everything below is main thread only
+    unsigned long long m_history[RENDER_STATS_HISTORY_FRAMES][RENDER_STAT_COUNT] = {};
+    unsigned long long m_historySum[RENDER_STAT_COUNT] = {};
+    unsigned long long m_total[RENDER_STAT_COUNT] = {};
+    unsigned long long m_frameIndex = 0;
+    unsigned int m_numHistory = 0;
+};
+
+#endif
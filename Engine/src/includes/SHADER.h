@@ -2,7 +2,14 @@
 #define SHADER_H
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <RenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <ShaderCache.h>
+
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -14,6 +21,11 @@ public:
     // ID of shader program
     unsigned int ID;
 
+    // Not built yet, for when the sources come from somewhere other than files (ShaderLibrary)
+    Shader() : ID(0)
+    {
+    }
+
     // constructor reads and builds shader
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
     {
@@ -60,128 +72,284 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << e.what() << std::endl;
         }
+        Build(vertexCode, fragmentCode, geometryCode);
+    }
+
+    // Starts compiling and linking the given sources into ID. No geometry stage if geometryCode is
+    // empty. Nothing waits on the driver here, so building a whole set of shaders back to back
+    // lets it work on them together (on its own threads where it supports that). The results are
+    // checked by Finish, at the latest on first use
+    void Build(const std::string& vertexCode, const std::string& fragmentCode, const std::string& geometryCode = "")
+    {
+        PROFILE_SCOPE("CompileShader");
         const char* vShaderCode = vertexCode.c_str();
         const char* fShaderCode = fragmentCode.c_str();
+        bool hasGeometry = !geometryCode.empty();
 
+        // A program linked from these sources on an earlier run skips compiling altogether
+        RenderDevice* device = RenderDevice::Get();
+        ShaderCache& cache = ShaderCache::Get();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        m_cacheKey = ShaderCache::MakeKey({ vertexCode, fragmentCode, geometryCode });
+        ID = device->CreateProgram();
+        if (cache.Load(m_cacheKey, ID))
+        {
+            m_pending = false;
+            m_linked = true;
+            cache.AddTime(true, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            return;
+        }
 
-        // Compile
+        // Compile. Asking for the status after each stage would make the driver finish it right
+        // there, so errors are only looked at once the program is needed
         unsigned int vertex, fragment;
 
         // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        // print compile errors
-        checkCompileErrors(vertex, "VERTEX");
+        vertex = device->CreateShader(GL_VERTEX_SHADER);
+        device->ShaderSource(vertex, vShaderCode);
+        device->CompileShader(vertex);
 
         // fragment shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        fragment = device->CreateShader(GL_FRAGMENT_SHADER);
+        device->ShaderSource(fragment, fShaderCode);
+        device->CompileShader(fragment);
 
-        unsigned int geometry;
-        if (geometryPath != nullptr)
+        unsigned int geometry = 0;
+        if (hasGeometry)
         {
             const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            geometry = device->CreateShader(GL_GEOMETRY_SHADER);
+            device->ShaderSource(geometry, gShaderCode);
+            device->CompileShader(geometry);
+        }
+
+        // Link shader program
+        device->AttachShader(ID, vertex);
+        device->AttachShader(ID, fragment);
+        if (hasGeometry)
+            device->AttachShader(ID, geometry);
+        device->LinkProgram(ID);
+
+        // Kept until Finish, for their logs if the link failed
+        m_stages[0] = vertex;
+        m_stages[1] = fragment;
+        m_stages[2] = geometry;
+        m_pending = true;
+        m_linked = false;
+        m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Builds a program and waits for the driver, for threads where stalling doesn't matter (hot
+    // reloads build on the loader thread). Returns 0 if it failed, with the errors in log
+    static unsigned int CompileNow(const std::string& vertexCode, const std::string& fragmentCode,
+        const std::string& geometryCode, std::string& log)
+    {
+        RenderDevice* device = RenderDevice::Get();
+        GLenum stageTypes[3] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+        const std::string* stageCode[3] = { &vertexCode, &fragmentCode, &geometryCode };
+        unsigned int stages[3] = { 0, 0, 0 };
+        bool compiled = true;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (stageCode[i]->empty() && i == 2)
+            {
+                continue;
+            }
+            stages[i] = device->CreateShader(stageTypes[i]);
+            device->ShaderSource(stages[i], stageCode[i]->c_str());
+            device->CompileShader(stages[i]);
+            std::string stageLog;
+            if (!device->GetShaderStatus(stages[i], stageLog))
+            {
+                log += stageLog;
+                compiled = false;
+            }
+        }
+
+        unsigned int program = 0;
+        if (compiled)
+        {
+            program = device->CreateProgram();
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                if (stages[i])
+                    device->AttachShader(program, stages[i]);
+            }
+            device->LinkProgram(program);
+            if (!device->GetProgramStatus(program, log))
+            {
+                device->DeleteProgram(program);
+                program = 0;
+            }
+        }
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (stages[i])
+                device->DeleteShader(stages[i]);
+        }
+        return program;
+    }
+
+    // Puts a linked program in place of this one and returns the old one for the caller to
+    // delete. Render thread only, between draws, so nothing ever draws with half of a swap.
+    // Uniforms start over at their defaults in the new program
+    unsigned int Replace(unsigned int program)
+    {
+        Finish();
+        unsigned int old = ID;
+        ID = program;
+        m_linked = true;
+        return old;
+    }
+
+    // Never blocks. False while the driver is still working on the program
+    bool IsReady() const
+    {
+        return !m_pending || RenderDevice::Get()->IsProgramReady(ID);
+    }
+    // Built but not checked yet
+    bool IsPending() const
+    {
+        return m_pending;
+    }
+
+    // Waits for the driver if it isn't done, prints any errors and saves the binary to the cache.
+    // Use and the uniform setters call it, so it only needs calling to check a shader early.
+    // False if it didn't link
+    bool Finish() const
+    {
+        if (!m_pending)
+        {
+            return m_linked;
         }
+        PROFILE_SCOPE("FinishShader");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        RenderDevice* device = RenderDevice::Get();
+        m_pending = false;
 
-        // Create shader program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if (geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        m_linked = checkCompileErrors(ID, "PROGRAM");
+        if (m_linked)
+        {
+            ShaderCache::Get().Store(m_cacheKey, ID);
+        }
+        else
+        {
+            // Which stage broke it
+            const char* stageNames[3] = { "VERTEX", "FRAGMENT", "GEOMETRY" };
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                if (m_stages[i])
+                {
+                    checkCompileErrors(m_stages[i], stageNames[i]);
+                }
+            }
+        }
         // delete shaders after being linked
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if (geometryPath != nullptr)
-            glDeleteShader(geometry);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (m_stages[i])
+            {
+                device->DeleteShader(m_stages[i]);
+                m_stages[i] = 0;
+            }
+        }
+        ShaderCache::Get().AddTime(false,
+            m_buildMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return m_linked;
     }
     // Use/activate shader
     void Use()
     {
-        glUseProgram(ID);
+        Finish();
+        RenderStats::Get().Add(RENDER_STAT_STATE_CHANGES);
+        RenderDevice::Get()->UseProgram(ID);
     }
     // utility uniform functions
     void setBool(const std::string &name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        RenderDevice::Get()->Uniform1i(GetLocation(name), (int)value);
     }
     void setInt(const std::string &name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        RenderDevice::Get()->Uniform1i(GetLocation(name), value);
     }
     void setFloat(const std::string &name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        RenderDevice::Get()->Uniform1f(GetLocation(name), value);
     }
     void setVec2(const std::string &name, const glm::vec2 &value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RenderDevice::Get()->Uniform2fv(GetLocation(name), 1, &value[0]);
     }
     void setVec2(const std::string &name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        RenderDevice::Get()->Uniform2f(GetLocation(name), x, y);
     }
     void setVec3(const std::string &name, const glm::vec3 &value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RenderDevice::Get()->Uniform3fv(GetLocation(name), 1, &value[0]);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        RenderDevice::Get()->Uniform3f(GetLocation(name), x, y, z);
     }
     void setVec4(const std::string &name, const glm::vec4 &value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RenderDevice::Get()->Uniform4fv(GetLocation(name), 1, &value[0]);
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        RenderDevice::Get()->Uniform4f(GetLocation(name), x, y, z, w);
     }
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderDevice::Get()->UniformMatrix2fv(GetLocation(name), 1, false, &mat[0][0]);
     }
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderDevice::Get()->UniformMatrix3fv(GetLocation(name), 1, false, &mat[0][0]);
     }
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderDevice::Get()->UniformMatrix4fv(GetLocation(name), 1, false, &mat[0][0]);
     }
 private:
-    void checkCompileErrors(GLuint shader, std::string type)
+    // Every setter goes through here once, so it's where uploads are counted
+    int GetLocation(const std::string &name) const
     {
-        GLint success;
-        GLchar infoLog[1024];
+        RenderStats::Get().Add(RENDER_STAT_UNIFORM_UPLOADS);
+        Finish();
+        return RenderDevice::Get()->GetUniformLocation(ID, name.c_str());
+    }
+    // False if it failed, after printing the log
+    static bool checkCompileErrors(unsigned int shader, std::string type)
+    {
+        std::string infoLog;
         if ( type != "PROGRAM" )
         {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if (!success)
+            if (!RenderDevice::Get()->GetShaderStatus(shader, infoLog))
             {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
                 std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                return false;
             }
         }
         else
         {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success)
+            if (!RenderDevice::Get()->GetProgramStatus(shader, infoLog))
             {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                return false;
             }
         }
+        return true;
     }
 
+    // Between Build and Finish. Mutable since the const setters can be what finishes it
+    mutable bool m_pending = false;
+    mutable bool m_linked = false;
+    mutable unsigned int m_stages[3] = { 0, 0, 0 };
+    unsigned long long m_cacheKey = 0;
+    double m_buildMs = 0.0;
+
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef SCENECOMPONENTS_H
+#define SCENECOMPONENTS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <EntityStore.h>
+
+#include <vector>
+
+class Camera;
+class Model;
+class Shader;
+class TileMap;
+class TileRenderer;
+
+// Components scene objects are made of, and the systems that run over them
+
+struct TransformComponent
+{
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+};
+
+// Worked out from TransformComponent by UpdateWorldTransforms
+struct WorldTransformComponent
+{
+    glm::mat4 world;
+};
+
+// Axis aligned box in the entity's local space
+struct BoundsComponent
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Not owned, whoever creates the entity keeps the model and shader alive
+struct RenderableComponent
+{
+    Model* model;
+    Shader* shader;
+};
+
+// Something the scene is drawn from. Not owned, like the renderable's model. Several can be
+// active at once (main view, minimap, shadow views), drawn in order
+struct CameraComponent
+{
+    Camera* camera;
+    // Part of the target it draws to, as fractions of its size: x, y (from the bottom left), width, height
+    glm::vec4 viewport;
+    int order;
+    bool active;
+};
+
+// A tile map drawn as part of the scene, in the same space as everything else
+struct TileLayerComponent
+{
+    TileMap* map;
+    TileRenderer* renderer;
+    Shader* shader;
+};
+
+// world = translate(position) * mat4_cast(rotation) * scale(scale) for every entity with both,
+// chunks in parallel on the JobSystem
+void UpdateWorldTransforms(EntityStore& store);
+// The active cameras, lowest order first
+void GetActiveCameras(EntityStore& store, std::vector<CameraComponent>& cameras);
+// Draws every renderable with a world transform, with "model" set to it. The shaders'
+// other uniforms (projection, view, ...) have to be set already
+void DrawRenderables(EntityStore& store);
+// Rebuilds edited chunks and draws every tile layer
+void DrawTileLayers(EntityStore& store);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Handle to a node. Stays the same while the graph reorders its arrays
+typedef unsigned int SceneNode;
+#define SCENE_NODE_NONE 0xFFFFFFFFu
+
+// Dirty subtrees bigger than this are split over their children, so one moving root doesn't
+// end up as a single job
+#define SCENE_GRAPH_SPLIT_SIZE 4096
+// Roughly how many nodes each update job recomputes
+#define SCENE_GRAPH_JOB_NODES 2048
+
+// Local and world transforms of a node hierarchy, in flat arrays sorted depth first: a parent
+// always comes before its children, and every subtree is one contiguous range. Updating a
+// range is a single forward pass, world[i] = world[parent[i]] * local[i].
+//
+// Changing a local transform only marks the node dirty. Update recomputes just the dirty nodes'
+// subtrees, and runs separate subtrees in parallel on the JobSystem.
+//
+//     SceneNode body = graph.Create();
+//     SceneNode arm = graph.Create(body, armOffset);
+//     graph.SetLocal(body, glm::translate(...));   // any number of times a frame
+//     graph.Update();
+//     shader.setMat4("model", graph.GetWorld(arm));
+class SceneGraph
+{
+public:
+    SceneNode Create(SceneNode parent = SCENE_NODE_NONE, const glm::mat4& local = glm::mat4(1.0f));
+    // Removes the node and everything under it
+    void Destroy(SceneNode node);
+    bool IsValid(SceneNode node) const;
+    void Clear();
+
+    // Keeps the local transform, so the node moves with its new parent. SCENE_NODE_NONE makes it
+    // a root. Refused if parent is the node itself or under it
+    bool SetParent(SceneNode node, SceneNode parent);
+    SceneNode GetParent(SceneNode node) const;
+
+    void SetLocal(SceneNode node, const glm::mat4& local);
+    const glm::mat4& GetLocal(SceneNode node) const;
+    // As of the last Update
+    const glm::mat4& GetWorld(SceneNode node) const;
+
+    unsigned int GetCount() const;
+    // Reorders the arrays if the hierarchy changed, then recomputes the world transforms of the
+    // dirty nodes and everything under them. Returns how many nodes were recomputed
+    unsigned int Update();
+
+private:
+    // Back into depth first order, dropping destroyed nodes
+    void Sort();
+    void MarkDirty(unsigned int index);
+    void UpdateRange(unsigned int begin, unsigned int end);
+
+    // Per node, indexed by position in the arrays
+    std::vector<glm::mat4> m_local;
+    std::vector<glm::mat4> m_world;
+    // Index of the parent, SCENE_NODE_NONE for roots
+    std::vector<unsigned int> m_parent;
+    // The node and all its descendants, only right while m_sorted
+    std::vector<unsigned int> m_subtreeSize;
+    // The handle at each index, SCENE_NODE_NONE once destroyed
+    std::vector<SceneNode> m_node;
+    std::vector<unsigned char> m_isDirty;
+    std::vector<unsigned int> m_dirty;
+
+    // Index of each handle, SCENE_NODE_NONE for free ones
+    std::vector<unsigned int> m_index;
+    std::vector<SceneNode> m_freeNodes;
+    unsigned int m_count = 0;
+    bool m_sorted = true;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <string>
+#include <vector>
+
+// Relative to the working directory, like the shader paths
+#define SHADER_CACHE_DIRECTORY "shader_cache"
+// Bumped whenever the file layout changes, so old files are ignored instead of misread
+#define SHADER_CACHE_VERSION 1
+
+// Keeps linked programs on disk between runs, so shaders are only compiled the first time (and
+// again whenever their sources or the driver change). Each program is saved under a hash of
+// everything that went into it plus the device's driver string, so stale binaries are never even
+// looked up. A driver can still reject one it made itself, in which case it's rebuilt from source
+// and saved again.
+//
+// Devices that can't save binaries (software) just miss every time.
+class ShaderCache
+{
+public:
+    struct Stats
+    {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        // Found on disk but the driver wouldn't take it
+        unsigned int rejected = 0;
+        unsigned int stores = 0;
+        // Built from source, whether it missed, was rejected or the cache is off
+        unsigned int compiled = 0;
+        // Time spent building programs either way, the part of startup this saves
+        double loadMs = 0.0;
+        double compileMs = 0.0;
+    };
+
+    static ShaderCache& Get();
+
+    void SetDirectory(const std::string& directory);
+    const std::string& GetDirectory() const;
+    // Off compiles every time, for checking the cache isn't hiding a shader error
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    // FNV-1a over every source (and define, or anything else that changes the output) and the
+    // driver string of the active device
+    static unsigned long long MakeKey(const std::vector<std::string>& sources);
+
+    // Loads the binary saved under key into program, which must be freshly created. False on a
+    // miss or when the driver rejects it, then the program needs building from source
+    bool Load(unsigned long long key, unsigned int program);
+    // Saves a just linked program under key
+    void Store(unsigned long long key, unsigned int program);
+
+    // How long a program took to build, and whether it came from the cache
+    void AddTime(bool fromCache, double ms);
+    const Stats& GetStats() const;
+    std::string GetReport() const;
+
+private:
+    std::string GetPath(unsigned long long key) const;
+
+    std::string m_directory = SHADER_CACHE_DIRECTORY;
+    bool m_enabled = true;
+    Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef SHADERLIBRARY_H
+#define SHADERLIBRARY_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <FileWatcher.h>
+#include <SHADER.h>
+
+// Optional parts of a shader, switched on with #ifdef on the matching define, so each draw only
+// pays for what its mesh actually uses instead of branching in one shader that does everything
+enum Shader_Feature
+{
+    // #define SKINNED, bone weights in the vertex shader
+    SHADER_SKINNED = 1 << 0,
+    // #define INSTANCED, per-instance transforms
+    SHADER_INSTANCED = 1 << 1,
+    // #define NORMAL_MAP, tangent space normals from texture_normal1
+    SHADER_NORMAL_MAP = 1 << 2,
+    // #define ALPHA_TEST, discards cut out pixels
+    SHADER_ALPHA_TEST = 1 << 3
+};
+#define SHADER_FEATURE_COUNT 4
+
+// Names shader programs and builds their feature permutations on first use.
+//
+//     ShaderLibrary::Get().Register("model", "Shaders/model.vs", "Shaders/model.fs");
+//     Shader* shader = ShaderLibrary::Get().GetShader("model", SHADER_NORMAL_MAP | SHADER_ALPHA_TEST);
+//
+// Sources can pull in other files with #include "file", relative to the file doing the including.
+// Each file is only included once per stage, so shared headers can include each other freely.
+// The feature defines go right after #version, and only for features the sources mention, so
+// asking for a feature a shader doesn't have gives back the same program as not asking. Any two
+// permutations (of any names) that end up with identical sources share one program.
+//
+// Compiler errors count lines in the expanded source, with includes and defines pasted in.
+//
+// GetShader doesn't wait for the driver (see Shader::Build), so asking for a whole set up front
+// and then polling lets the compiles overlap each other and whatever else is loading:
+//
+//     for (...) library.GetShader(name, features);
+//     while (library.Poll() > 0) { /* load assets, draw a loading screen */ }
+//
+// With hot reload on, saving any file a program was built from (includes too) rebuilds it on the
+// UploadThread's context and swaps it into the same Shader, so nothing holding the Shader has to
+// change. Uniforms start over in the new program, so set them when drawing rather than once.
+// Except when another name shares the Shader, or the edit makes the sources match some other
+// program: then the permutation moves to a different Shader and the old one keeps its program for
+// whoever else uses it. Code that holds on to a Shader should GetShader again when Update swaps.
+class ShaderLibrary
+{
+public:
+    static ShaderLibrary& Get();
+
+    // Nothing is read or compiled until the first GetShader. Registering a name again replaces it
+    void Register(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+        const std::string& geometryPath = "");
+    bool IsRegistered(const std::string& name) const;
+    // Builds the permutation the first time it's asked for. NULL if name isn't registered. The
+    // library owns the shader, it stays valid until Clear
+    Shader* GetShader(const std::string& name, unsigned int features = 0);
+
+    // Never blocks. Checks the programs the driver has finished and returns how many it's still on
+    unsigned int Poll();
+    // Waits for and checks every program
+    void FinishAll();
+
+    // Watches the files of every shader built from now on (and the ones already built). wake is
+    // called from other threads when Update has something to do, e.g. glfwPostEmptyEvent so an
+    // event driven loop doesn't sleep through a save
+    void EnableHotReload(std::function<void()> wake = NULL);
+    bool IsHotReloadEnabled() const;
+    // Render thread, once a frame. Starts rebuilding the programs whose files changed and swaps
+    // in the rebuilt ones. A program that fails to build keeps the one it had. Returns how many
+    // were swapped, so the caller knows to redraw
+    unsigned int Update();
+
+    // Deletes every program and forgets the expanded sources, so the next GetShader rereads the
+    // files. Needs the context the programs were made on to still be current
+    void Clear();
+
+    // Distinct programs built, and permutations handed out (several can share a program)
+    unsigned int GetNumPrograms() const;
+    unsigned int GetNumPermutations() const;
+
+    // "#define SKINNED\n..." for each feature set in features
+    static std::string GetDefines(unsigned int features);
+    static const char* GetFeatureName(Shader_Feature feature);
+
+private:
+    struct Entry
+    {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::string geometryPath;
+        // Filled the first time any permutation is built
+        bool expanded = false;
+        std::string vertexSource;
+        std::string fragmentSource;
+        std::string geometrySource;
+        // Features the sources mention, the others are dropped from requests
+        unsigned int usedFeatures = 0;
+        // Everything read to expand it, includes and all, in FileWatcher::Normalize form
+        std::vector<std::string> files;
+    };
+
+    // A hot reload on its way back from the loader thread
+    struct Reload
+    {
+        // The permutation, "name#features"
+        std::string name;
+        std::string vertex;
+        std::string fragment;
+        std::string geometry;
+        // 0 if it failed to build
+        unsigned int program = 0;
+        std::string log;
+        // Results from before a Clear are thrown away
+        unsigned int generation = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    bool Expand(Entry& entry);
+    void StartReload(const std::string& name, Entry& entry);
+    bool FinishReload(Reload& reload);
+    // Reads path with its #includes pasted in. included tracks what this stage already has
+    static bool Preprocess(const std::string& path, std::unordered_set<std::string>& included, std::string& out);
+    static std::string MakeProgramKey(const std::string& vertex, const std::string& fragment, const std::string& geometry);
+    static std::string InsertDefines(const std::string& source, const std::string& defines);
+    static unsigned int FindFeatures(const std::string& source);
+
+    std::unordered_map<std::string, Entry> m_entries;
+    // "name#features" to the program it resolved to
+    std::unordered_map<std::string, Shader*> m_permutations;
+    // Keyed by the full expanded sources, which is what decides if two programs are the same
+    std::unordered_map<std::string, std::unique_ptr<Shader>> m_programs;
+
+    std::unique_ptr<FileWatcher> m_watcher;
+    std::function<void()> m_wake;
+    unsigned int m_generation = 0;
+    // Filled by the loader thread
+    std::mutex m_reloadMutex;
+    std::vector<Reload> m_reloaded;
+};
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef SOFTWARERENDERDEVICE_H
+#define SOFTWARERENDERDEVICE_H
+
+#include <RenderDevice.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Screen tiles are rasterized independently, one worker per tile at a time
+#define SOFTWARE_TILE_SIZE 64
+// Keeps the fixed point edge functions inside 32 bits
+#define SOFTWARE_MAX_FRAMEBUFFER_SIZE 4096
+// Units per pixel of the fixed point vertex positions (4 bits of subpixel precision)
+#define SOFTWARE_SUBPIXEL_SCALE 16
+#define SOFTWARE_MAX_VARYINGS 4
+#define SOFTWARE_MAX_ATTRIBS 16
+#define SOFTWARE_MAX_TEXTURE_UNITS 16
+
+// A CPU backend that actually produces pixels, for golden image tests and for benchmarking
+// without a GPU. Draws are transformed and binned into SOFTWARE_TILE_SIZE screen tiles as they
+// come in, and the tiles are rasterized in parallel when the frame is flushed (on Clear, reading
+// the framebuffer, or changing a texture). Coverage uses fixed point edge functions evaluated a
+// 2x2 quad at a time with SSE2, which also gives the derivatives for mip selection.
+//
+// It doesn't run GLSL. Each program is matched to one of three fixed pipelines by looking at its
+// source, which covers every shader the engine has:
+//   - textured:      the fragment shader calls texture(), samples the first sampler2D with the
+//                    texcoords in attribute 2 (shader.vs layout)
+//   - vertex color:  the vertex shader has an aColor input, interpolates attribute 1
+//   - flat color:    everything else, uses the first vec3 uniform of the fragment shader
+// Positions always come from attribute 0 and go through projection * view * model, with any of
+// the three left unset treated as identity. Depth testing is GL_LESS, there's no blending.
+class SoftwareRenderDevice : public RenderDevice
+{
+public:
+    // numThreads = 0 uses every hardware thread
+    SoftwareRenderDevice(int width, int height, unsigned int numThreads = 0);
+    ~SoftwareRenderDevice();
+
+    const char* GetName() const override;
+    bool NeedsContext() const override;
+    std::string GetDriverString() override;
+    void InitContext() override;
+
+    ////////////////// BUFFERS /////////////////////////
+
+    unsigned int CreateVertexArray() override;
+    void DeleteVertexArray(unsigned int vertexArray) override;
+    void BindVertexArray(unsigned int vertexArray) override;
+
+    unsigned int CreateBuffer() override;
+    void DeleteBuffer(unsigned int buffer) override;
+    void BindBuffer(GLenum target, unsigned int buffer) override;
+    void BufferData(GLenum target, size_t size, const void* data, GLenum usage) override;
+    void BufferSubData(GLenum target, size_t offset, size_t size, const void* data) override;
+
+    void EnableVertexAttribArray(unsigned int index) override;
+    void VertexAttribPointer(unsigned int index, int size, GLenum type, bool normalized, int stride,
+        size_t offset) override;
+    void VertexAttribIPointer(unsigned int index, int size, GLenum type, int stride, size_t offset) override;
+
+    ////////////////// TEXTURES /////////////////////////
+
+    unsigned int CreateTexture() override;
+    void DeleteTexture(unsigned int texture) override;
+    void ActiveTexture(unsigned int unit) override;
+    void BindTexture(GLenum target, unsigned int texture) override;
+    void TexImage2D(GLenum target, int level, GLenum internalFormat, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void TexSubImage2D(GLenum target, int level, int x, int y, int width, int height,
+        GLenum format, GLenum type, const void* data) override;
+    void GenerateMipmap(GLenum target) override;
+    void TexParameter(GLenum target, GLenum name, int value) override;
+
+    ////////////////// SHADERS /////////////////////////
+
+    unsigned int CreateShader(GLenum stage) override;
+    void ShaderSource(unsigned int shader, const char* source) override;
+    void CompileShader(unsigned int shader) override;
+    bool GetShaderStatus(unsigned int shader, std::string& log) override;
+    void DeleteShader(unsigned int shader) override;
+
+    unsigned int CreateProgram() override;
+    void AttachShader(unsigned int program, unsigned int shader) override;
+    void LinkProgram(unsigned int program) override;
+    bool IsProgramReady(unsigned int program) override;
+    bool GetProgramStatus(unsigned int program, std::string& log) override;
+    void DeleteProgram(unsigned int program) override;
+    void UseProgram(unsigned int program) override;
+    bool GetProgramBinary(unsigned int program, std::vector<unsigned char>& binary, GLenum& format) override;
+    bool ProgramBinary(unsigned int program, GLenum format, const void* binary, size_t size) override;
+
+    int GetUniformLocation(unsigned int program, const char* name) override;
+    void Uniform1i(int location, int value) override;
+    void Uniform1f(int location, float value) override;
+    void Uniform2f(int location, float x, float y) override;
+    void Uniform3f(int location, float x, float y, float z) override;
+    void Uniform4f(int location, float x, float y, float z, float w) override;
+    void Uniform2fv(int location, int count, const float* value) override;
+    void Uniform3fv(int location, int count, const float* value) override;
+    void Uniform4fv(int location, int count, const float* value) override;
+    void UniformMatrix2fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix3fv(int location, int count, bool transpose, const float* value) override;
+    void UniformMatrix4fv(int location, int count, bool transpose, const float* value) override;
+
+    ////////////////// QUERIES /////////////////////////
+
+    unsigned int CreateQuery() override;
+    void DeleteQuery(unsigned int query) override;
+    void BeginQuery(GLenum target, unsigned int query) override;
+    void EndQuery(GLenum target) override;
+    bool GetQueryResult(unsigned int query, unsigned long long& result) override;
+
+    ////////////////// FENCES /////////////////////////
+
+    unsigned int CreateFence() override;
+    Fence_Status WaitFence(unsigned int fence, unsigned long long timeoutNs) override;
+    void DeleteFence(unsigned int fence) override;
+
+    ////////////////// STATE AND DRAWING /////////////////////////
+
+    void Enable(GLenum capability) override;
+    void Disable(GLenum capability) override;
+    void Viewport(int x, int y, int width, int height) override;
+    void Scissor(int x, int y, int width, int height) override;
+    // Lines are always one pixel wide
+    void LineWidth(float width) override;
+    void ClearColor(float r, float g, float b, float a) override;
+    void Clear(GLbitfield mask) override;
+
+    void DrawArrays(GLenum mode, int first, int count) override;
+    void DrawElements(GLenum mode, int count, GLenum type, size_t offset) override;
+
+    ////////////////// FRAMEBUFFER /////////////////////////
+
+    // Reallocates (and clears) the framebuffer, sizes are clamped to SOFTWARE_MAX_FRAMEBUFFER_SIZE
+    void Resize(int width, int height);
+    int GetWidth() const;
+    int GetHeight() const;
+    unsigned int GetNumThreads() const;
+
+    // Rasterizes everything queued so far
+    void Flush();
+    // RGBA8 packed as r | g << 8 | b << 16 | a << 24, bottom row first like glReadPixels
+    const std::vector<uint32_t>& GetColorBuffer();
+    const std::vector<float>& GetDepthBuffer();
+    uint32_t ReadPixel(int x, int y);
+    // Binary PPM (P6), top row first
+    bool SaveImage(const std::string& path);
+
+    // Primitives that reached the rasterizer since the last ResetCounters (after clipping)
+    unsigned long long GetNumTriangles() const;
+    unsigned long long GetNumLines() const;
+    void ResetCounters();
+
+private:
+    enum Shading_Kind
+    {
+        SHADING_FLAT,
+        SHADING_VERTEX_COLOR,
+        SHADING_TEXTURED
+    };
+
+    struct MipLevel
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> texels;
+    };
+
+    struct TextureData
+    {
+        std::vector<MipLevel> levels;
+        // Set when levels goes all the way down to 1x1, mipmapped filters need it
+        bool fullChain = false;
+        // GL's defaults
+        GLenum minFilter = GL_NEAREST_MIPMAP_LINEAR;
+        GLenum magFilter = GL_LINEAR;
+        GLenum wrapS = GL_REPEAT;
+        GLenum wrapT = GL_REPEAT;
+    };
+
+    struct Attrib
+    {
+        bool enabled = false;
+        int size = 4;
+        GLenum type = GL_FLOAT;
+        bool normalized = false;
+        int stride = 0;
+        size_t offset = 0;
+        unsigned int buffer = 0;
+    };
+
+    struct VertexArrayData
+    {
+        Attrib attribs[SOFTWARE_MAX_ATTRIBS];
+        unsigned int elementBuffer = 0;
+    };
+
+    struct ShaderData
+    {
+        GLenum stage;
+        std::string source;
+    };
+
+    struct UniformValue
+    {
+        float f[16] = {};
+        int i = 0;
+        bool set = false;
+    };
+
+    struct ProgramData
+    {
+        std::vector<unsigned int> shaders;
+        Shading_Kind shading = SHADING_FLAT;
+        // Uniform names the fixed pipelines read, pulled out of the source at link time
+        std::string colorUniform;
+        std::string samplerUniform;
+        std::unordered_map<std::string, int> locations;
+        std::vector<UniformValue> values;
+    };
+
+    // Everything a primitive needs from the state it was drawn with
+    struct DrawState
+    {
+        Shading_Kind shading;
+        glm::vec4 color;
+        uint32_t packedColor;
+        const TextureData* texture;
+        bool depthTest;
+    };
+
+    struct ClipVertex
+    {
+        glm::vec4 position;
+        float varyings[SOFTWARE_MAX_VARYINGS];
+    };
+
+    // Screen space value = base + dx * (x - originX) + dy * (y - originY)
+    struct Plane
+    {
+        float base, dx, dy;
+    };
+
+    struct Triangle
+    {
+        // Window position in SOFTWARE_SUBPIXEL_SCALE fixed point, counter-clockwise
+        int x[3], y[3];
+        float originX, originY;
+        Plane depth;
+        Plane invW;
+        // varying / w, divided by the interpolated 1 / w per pixel
+        Plane varyings[SOFTWARE_MAX_VARYINGS];
+        // Pixel bounds, already clipped to the viewport and scissor
+        int minX, minY, maxX, maxY;
+        unsigned int state;
+    };
+
+    struct Line
+    {
+        float x0, y0, z0, x1, y1, z1;
+        float varyings0[SOFTWARE_MAX_VARYINGS];
+        float varyings1[SOFTWARE_MAX_VARYINGS];
+        int minX, minY, maxX, maxY;
+        unsigned int state;
+    };
+
+    struct WorkerPool;
+
+    void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+    void Draw(GLenum mode, const std::vector<uint32_t>& indices);
+    void SetupTriangle(const ClipVertex* vertices, const DrawState& state, unsigned int stateIndex,
+        int numVaryings, std::vector<Triangle>& out) const;
+    void SetupLine(ClipVertex a, ClipVertex b, unsigned int stateIndex, int numVaryings,
+        std::vector<Line>& out) const;
+    glm::vec3 ToWindow(const glm::vec4& clip) const;
+    void GetClipRect(int& minX, int& minY, int& maxX, int& maxY) const;
+
+    void RasterizeTile(unsigned int tile);
+    void RasterizeTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+    void RasterizeLine(const Line& line, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+    void ShadePixel(const DrawState& state, int x, int y, float z, const float* varyings, float lod);
+    // Returns a packed texel like the color buffer holds
+    uint32_t Sample(const TextureData& texture, float u, float v, float lod) const;
+
+    std::vector<uint8_t>* GetBoundBuffer(GLenum target);
+    unsigned int GetBoundTexture() const;
+    UniformValue* GetUniform(int location);
+    void UploadUniform(int location, const float* values, int count);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<uint32_t> m_color;
+    std::vector<float> m_depth;
+
+    WorkerPool* m_pool;
+
+    // Queued since the last flush
+    std::vector<DrawState> m_states;
+    std::vector<Triangle> m_triangles;
+    std::vector<Line> m_lines;
+    // Per tile, primitive index << 1 with the low bit set for lines, in submission order
+    std::vector<std::vector<uint32_t>> m_bins;
+    unsigned long long m_numTriangles = 0;
+    unsigned long long m_numLines = 0;
+
+    // Objects. Handles are shared between every type, 0 is never handed out
+    unsigned int m_nextHandle = 1;
+    std::unordered_map<unsigned int, VertexArrayData> m_vertexArrays;
+    std::unordered_map<unsigned int, std::vector<uint8_t>> m_buffers;
+    std::unordered_map<unsigned int, TextureData> m_textures;
+    std::unordered_map<unsigned int, ShaderData> m_shaders;
+    std::unordered_map<unsigned int, ProgramData> m_programs;
+
+    // Bound state
+    unsigned int m_vertexArray = 0;
+    unsigned int m_arrayBuffer = 0;
+    unsigned int m_program = 0;
+    unsigned int m_activeUnit = 0;
+    unsigned int m_boundTextures[SOFTWARE_MAX_TEXTURE_UNITS] = {};
+    bool m_depthTest = false;
+    bool m_scissorTest = false;
+    int m_viewport[4] = { 0, 0, 0, 0 };
+    int m_scissor[4] = { 0, 0, 0, 0 };
+    glm::vec4 m_clearColor = glm::vec4(0.0f);
+};
+
+#endif
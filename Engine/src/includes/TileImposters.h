@@ -0,0 +1,72 @@
+#ifndef TILEIMPOSTERS_H
+#define TILEIMPOSTERS_H
+
+#include <glm/glm.hpp>
+
+#include <TileMap.h>
+
+#include <cstdint>
+#include <vector>
+
+// Texels per chunk side. Each texel covers a 2x2 block of tiles at the default chunk size
+#define TILE_IMPOSTER_SIZE 16
+
+// A small picture of each chunk of a TileMap, for drawing the whole map zoomed out. A chunk's
+// picture is only rebuilt when its version changes, so keeping a minimap up to date while
+// painting costs one chunk's worth of work however big the map is.
+//
+// The pictures are built on the CPU, across the job system's threads, into a cache that can be
+// read back without a GPU. Upload copies the rebuilt ones into one texture with the chunks laid
+// out like they are in the map, so the whole minimap is a single textured quad.
+//
+//     imposters.Update();    // after edits
+//     imposters.Upload();    // render thread
+//     // bind GetTexture(), draw a quad over GetCoveredSize(tileSize) in grid space
+class TileImposters
+{
+public:
+    // size is texels per chunk side. Nothing is built until the first Update
+    TileImposters(TileMap* tileMap, unsigned int size = TILE_IMPOSTER_SIZE);
+    // Deletes the texture through the active RenderDevice, if there is one
+    ~TileImposters();
+
+    // Rebuilds every chunk whose version moved since the last call (all of them the first
+    // time), returns how many were rebuilt
+    unsigned int Update();
+    // Copies the chunks Update rebuilt into the texture, making it the first time. Returns how
+    // many chunks were copied
+    unsigned int Upload();
+
+    // 0 until the first Upload
+    unsigned int GetTexture() const;
+    unsigned int GetSize() const;
+    // The texture's size in texels
+    unsigned int GetWidth() const;
+    unsigned int GetHeight() const;
+    // Cached picture of a chunk, size * size texels with rows going down the map (+z)
+    const uint32_t* GetImposter(unsigned int index) const;
+    // Grid space area the texture covers, from the origin. It's whole chunks, so it goes past the
+    // map's edge when the map isn't a multiple of TILE_CHUNK_SIZE
+    glm::vec2 GetCoveredSize(glm::vec3 tileSize) const;
+
+    // One chunk's picture, size * size texels packed as RGBA bytes (red lowest). Each texel
+    // averages the colours of the tiles under it, and its alpha is how many of them aren't empty
+    static void BuildImposter(const TileMap& tileMap, unsigned int index, unsigned int size, uint32_t* out);
+
+private:
+    TileMap* m_tileMap;
+    unsigned int m_size;
+    unsigned int m_texture = 0;
+    // Every chunk's picture, one after the other
+    std::vector<uint32_t> m_texels;
+    // Chunk versions the pictures were built from
+    std::vector<uint32_t> m_versions;
+    bool m_bBuilt = false;
+    // Rebuilt by the last Update
+    std::vector<unsigned int> m_dirty;
+    // Rebuilt since the last Upload
+    std::vector<unsigned int> m_pending;
+    std::vector<uint8_t> m_bPending;
+};
+
+#endif
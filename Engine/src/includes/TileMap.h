@@ -0,0 +1,77 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Tiles are stored in square chunks so edits, undo deltas and rendering can all
+// work on a chunk at a time instead of the whole map
+#define TILE_CHUNK_SIZE 32
+#define TILE_CHUNK_CELLS (TILE_CHUNK_SIZE * TILE_CHUNK_SIZE)
+#define EMPTY_TILE 0
+
+typedef uint16_t TileID;
+
+class EditHistory;
+
+class TileMap
+{
+public:
+    struct Chunk
+    {
+        TileID cells[TILE_CHUNK_CELLS];
+        // Bumped on every change, anything caching chunk data compares against this
+        uint32_t version = 0;
+        // Set on every change, cleared by whoever rebuilds the chunk's render data
+        bool dirty = false;
+        // Last edit that snapshotted this chunk (see EditHistory)
+        uint32_t editStamp = 0;
+    };
+
+    TileMap(unsigned int numCols, unsigned int numRows);
+
+    ////////////// TILE ACCESS ////////////////
+
+    bool InBounds(int x, int y) const;
+    TileID GetTile(int x, int y) const;
+    // Goes through the edit recorder if there is one
+    void SetTile(int x, int y, TileID id);
+    void Clear();
+
+    ////////////// CHUNK ACCESS ////////////////
+
+    unsigned int GetChunkIndex(int x, int y) const;
+    glm::ivec2 GetChunkOrigin(unsigned int index) const;
+    Chunk& GetChunk(unsigned int index);
+    const Chunk& GetChunk(unsigned int index) const;
+    // Notifies the recorder, marks the chunk changed and hands back its cells for direct writes.
+    // Used by bulk operations that work a chunk at a time
+    TileID* BeginChunkWrite(unsigned int index);
+    // Writes a run of cells inside one chunk, skipping the recorder. Used to apply undo/redo deltas
+    void WriteChunkRun(unsigned int index, unsigned int start, unsigned int count, TileID id);
+
+    unsigned int GetNumChunks() const;
+    unsigned int GetChunkCols() const;
+    unsigned int GetChunkRows() const;
+    unsigned int GetNumCols() const;
+    unsigned int GetNumRows() const;
+
+    ////////////// EDIT RECORDING ////////////////
+
+    void SetRecorder(EditHistory* history);
+    EditHistory* GetRecorder() const;
+
+private:
+    unsigned int m_numCols;
+    unsigned int m_numRows;
+    unsigned int m_chunkCols;
+    unsigned int m_chunkRows;
+
+    std::vector<Chunk> m_chunks;
+
+    EditHistory* m_recorder = nullptr;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef TILEOPERATIONS_H
+#define TILEOPERATIONS_H
+
+#include <glm/glm.hpp>
+
+#include <TileMap.h>
+#include <EditHistory.h>
+
+#include <vector>
+
+// Bulk edits on a TileMap. Every operation is recorded as a single undo step when a
+// history is passed in, and returns the number of cells it changed.
+namespace TileOperations
+{
+    // Fills every cell in [min, max] (inclusive, clamped to the map)
+    size_t FillRect(TileMap& map, glm::ivec2 min, glm::ivec2 max, TileID id, EditHistory* history = nullptr);
+
+    // Repeats a patternSize.x by patternSize.y pattern (row major) across [min, max].
+    // EMPTY_TILE entries in the pattern leave the cell underneath alone
+    size_t StampPattern(TileMap& map, glm::ivec2 min, glm::ivec2 max,
+        const std::vector<TileID>& pattern, glm::ivec2 patternSize, EditHistory* history = nullptr);
+
+    // 4-way bucket fill from seed. Scanline based with an explicit stack so big regions can't overflow
+    size_t FloodFill(TileMap& map, glm::ivec2 seed, TileID id, EditHistory* history = nullptr);
+
+    // Same result as FloodFill, but spans are filled a chunk at a time across worker threads.
+    // numThreads = 0 uses every hardware thread
+    size_t ParallelFloodFill(TileMap& map, glm::ivec2 seed, TileID id, EditHistory* history = nullptr,
+        unsigned int numThreads = 0);
+}
+
+#endif
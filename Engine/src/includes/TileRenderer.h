@@ -0,0 +1,65 @@
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <TileMap.h>
+
+#include <vector>
+
+struct TileVertex
+{
+    glm::vec3 Position;
+    glm::vec3 Color;
+};
+
+// Draws the filled tiles of a TileMap. Each chunk has its own vertex buffer, which is only
+// rebuilt when the chunk's dirty flag is set.
+//
+// Windows sharing a context can share one renderer, so the map is only meshed and uploaded
+// once however many windows show it. Vertex arrays can't be shared between contexts though, so
+// each context draws through its own view, a set of vertex arrays over the shared buffers.
+class TileRenderer
+{
+public:
+    // Creates its buffers through the active RenderDevice, and view 0 for the current context
+    TileRenderer(TileMap* tileMap, glm::vec3 tileSize);
+    // Deletes the buffers and any views left, so the other contexts' views have to be
+    // destroyed on their own contexts first
+    ~TileRenderer();
+
+    // Vertex arrays for the current context, which has to share objects with the one the
+    // renderer was made on
+    unsigned int CreateView();
+    // With the view's context current
+    void DestroyView(unsigned int view);
+
+    // Rebuilds every chunk that changed since the last call, returns how many were rebuilt.
+    // Vertices are built across the job system's threads, the uploads stay on the calling thread
+    unsigned int RebuildDirtyChunks();
+    void Draw(unsigned int view = 0);
+
+    // CPU side of a chunk rebuild: two triangles per non-empty tile, in grid space
+    static void BuildChunkVertices(const TileMap& tileMap, unsigned int index, glm::vec3 tileSize,
+        std::vector<TileVertex>& out);
+    static glm::vec3 GetTileColor(TileID id);
+
+private:
+    struct ChunkBuffers
+    {
+        unsigned int VBO = 0;
+        unsigned int numVertices = 0;
+    };
+
+    TileMap* m_tileMap;
+    glm::vec3 m_tileSize;
+    std::vector<ChunkBuffers> m_chunks;
+    // A vertex array per chunk for each view. Destroyed views are left empty and reused
+    std::vector<std::vector<unsigned int>> m_views;
+    // One per chunk being rebuilt, reused between rebuilds so they don't reallocate every time
+    std::vector<std::vector<TileVertex>> m_scratch;
+    std::vector<unsigned int> m_dirty;
+};
+
+#endif
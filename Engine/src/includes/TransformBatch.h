@@ -0,0 +1,76 @@
+#ifndef TRANSFORMBATCH_H
+#define TRANSFORMBATCH_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+enum Transform_Kernel
+{
+    // Plain loops. For CPUs without SSE, and the reference the others are checked against
+    TRANSFORM_KERNEL_SCALAR,
+    // Four instances at a time, any x86-64 CPU has it
+    TRANSFORM_KERNEL_SSE,
+    // Eight at a time with fused multiply-adds, used when the CPU has AVX2 and FMA
+    TRANSFORM_KERNEL_AVX2
+};
+
+// Positions, rotations and scales of many instances, with every component in an array of its
+// own (all the position x's, then all the y's, ...). The kernels load the same component of four
+// or eight instances with one instruction and compose their matrices side by side, instead of
+// building one glm::translate * mat4_cast * glm::scale at a time.
+//
+//     TransformBatch batch;
+//     batch.Add(position, rotation, scale);   // per instance, once
+//     batch.ComputeWorldClip(projection * view, world.data(), clip.data());   // per frame
+class TransformBatch
+{
+public:
+    // Returns the new instance's index
+    unsigned int Add(const glm::vec3& position, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+        const glm::vec3& scale = glm::vec3(1.0f));
+    void Set(unsigned int index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void SetPosition(unsigned int index, const glm::vec3& position);
+    void SetRotation(unsigned int index, const glm::quat& rotation);
+    void SetScale(unsigned int index, const glm::vec3& scale);
+    glm::vec3 GetPosition(unsigned int index) const;
+    glm::quat GetRotation(unsigned int index) const;
+    glm::vec3 GetScale(unsigned int index) const;
+
+    unsigned int GetCount() const;
+    void Reserve(unsigned int count);
+    void Clear();
+
+    // world[i] = translate(position) * mat4_cast(rotation) * scale(scale), the same matrix glm
+    // gives. Rotations are expected to be unit length
+    void ComputeWorld(glm::mat4* world) const;
+    // world as above, and clip[i] = viewProjection * world[i]. world can be NULL when only the
+    // clip matrices are needed
+    void ComputeWorldClip(const glm::mat4& viewProjection, glm::mat4* world, glm::mat4* clip) const;
+
+    // The best kernel the CPU can run, unless SetKernel picked another
+    static Transform_Kernel GetKernel();
+    // For comparing kernels. One the CPU can't run falls back to the best one it can
+    static void SetKernel(Transform_Kernel kernel);
+    // Back to the best one
+    static void ResetKernel();
+    static bool IsKernelSupported(Transform_Kernel kernel);
+    static const char* GetKernelName(Transform_Kernel kernel);
+
+private:
+    void Compute(const float* viewProjection, glm::mat4* world, glm::mat4* clip) const;
+
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_positionZ;
+    std::vector<float> m_rotationX;
+    std::vector<float> m_rotationY;
+    std::vector<float> m_rotationZ;
+    std::vector<float> m_rotationW;
+    std::vector<float> m_scaleX;
+    std::vector<float> m_scaleY;
+    std::vector<float> m_scaleZ;
+};
+
+#endif
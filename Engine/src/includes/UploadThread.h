@@ -0,0 +1,65 @@
+#ifndef UPLOADTHREAD_H
+#define UPLOADTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct GLFWwindow;
+
+// How long the loader thread blocks on a fence before checking it again
+#define UPLOAD_FENCE_WAIT_NS 1000000ull
+
+// A loader thread with its own hidden context, sharing objects with a window's, that does
+// buffer and texture uploads off the render thread. After each batch it waits on a fence, so by
+// the time a task's onDone runs the data is on the GPU and the render thread can use the objects
+// straight away.
+//
+// Only buffers and textures are shared between contexts. Vertex arrays (and framebuffers) still
+// have to be made on the render thread, after onDone.
+//
+// When there's no context to share (headless or software devices), Start returns false and
+// Submit keeps returning false, so callers fall back to uploading on the render thread. The same
+// goes once a fence wait fails (a lost context): the batch it was for still finishes, then Submit
+// turns everything else away.
+class UploadThread
+{
+public:
+    static UploadThread& Get();
+
+    // Main thread, once shareWith's context is created and GLAD is loaded, before it's shown or
+    // hidden. Creates the hidden context (GLFW windows can only be made here) and starts the
+    // thread on it. The window hints are left the way shareWith was made with them
+    bool Start(GLFWwindow* shareWith);
+    // Main thread, before shareWith is destroyed. Finishes everything queued first
+    void Stop();
+    bool IsRunning() const;
+
+    // Any thread. upload runs on the loader thread with its context current, then onDone (also on
+    // the loader thread) once the GPU has finished it. False if the thread isn't running or a
+    // fence wait has failed, in which case neither is called
+    bool Submit(std::function<void()> upload, std::function<void()> onDone);
+
+private:
+    struct Task
+    {
+        std::function<void()> upload;
+        std::function<void()> onDone;
+    };
+
+    void ThreadLoop();
+
+    GLFWwindow* m_context = NULL;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Task> m_tasks;
+    bool m_running = false;
+    bool m_quit = false;
+    // A fence wait failed, see above
+    bool m_failed = false;
+};
+
+#endif
@@ -9,8 +9,16 @@
 
 #include <GLFW/glfw3.h>
 #include <Camera.h>
+#include <functional>
+#include <string>
 #include <vector>
 #include <SHADER.h>
+#include <FramePacer.h>
+#include <TileMap.h>
+#include <EditHistory.h>
+#include <TileRenderer.h>
+#include <TileImposters.h>
+#include <InputLog.h>
 
 #include <InputManager.h>
 
@@ -21,6 +29,8 @@
 namespace WindowManager
 {
 
+    class WindowGroup;
+
     class Window
     {
     public:
@@ -33,7 +43,8 @@ namespace WindowManager
             float numRows;
         };
 
-            // Constructor
+            // Constructor. Without a winContext it shares with the first window made, so
+            // programs, buffers and textures are shared with every other window (see RenderResources)
         Window(unsigned int width=DEFAULT_WINDOW_WIDTH,
             unsigned int height=DEFAULT_WINDOW_HEIGHT,
             const char *title=DEFAULT_TITLE,
@@ -44,6 +55,10 @@ namespace WindowManager
         void SetFocused();
         void TransformScreen(float x, float y);
         void ZoomScreen(float zoom);
+        // Centers the grid and zooms so all of it fits the window. Call after PrepareRendering()
+        void FitToMap();
+        // Makes this window's GL and ImGui contexts current, if they aren't already
+        void MakeCurrent();
 
         //////////////// INITIALIZING FUNCTIONS ///////////////////////////
 
@@ -62,16 +77,74 @@ namespace WindowManager
         glm::mat4 GetProjectionMatrix();
         glm::mat4 GetViewMatrix();
 
+        // Cursor picking. Screen coordinates are in pixels from the top left of the window
+        glm::vec3 ScreenToGrid(double x, double y);
+        glm::ivec2 ScreenToTile(double x, double y);
+        glm::vec3 GridToScreen(glm::vec3 gridPos);
+        glm::ivec2 GetHoveredTile();
+        bool IsHoveringTile();
+
         ////////////////// UPDATE FUNCTIONS /////////////////////////
 
         void onUpdate();
 
+        ////////////////// FRAME PACING /////////////////////////
+
+        void SetPacingMode(Pacing_Mode mode);
+        FramePacer* GetFramePacer();
+        // Asks for a redraw, only matters in PACING_EVENT_DRIVEN
+        void MarkDirty(int numFrames = 1);
+        // Whether the next update draws anything, including for changes made through other windows
+        bool NeedsRender();
+        // Only one window in a group should wait for vblank
+        void SetVBlankSync(bool sync);
+        // Runs at the pacer's fixed step, independent of how often frames get rendered
+        void SetFixedUpdateCallback(std::function<void(double)> callback);
+
         ////////////// IMGUI COMMANDS ////////////////
         void UICommands();
+        // Hides the "Grid Information" panel, for small windows like the palette
+        void SetUIVisible(bool visible);
+        bool IsUICapturingMouse();
+        bool IsUICapturingKeyboard();
 
         ///////// FUNCTIONS FOR THE TILEMAP EDITOR /////////////////////
 
         void ReceiveGridData(GridData gridData);
+        // Tiles to draw and edit. Call before PrepareRendering()
+        void ReceiveTileMap(TileMap* tileMap, EditHistory* editHistory);
+        void SetActiveTile(TileID id);
+        // Clicking a tile in this window picks it as target's active tile instead of painting
+        void SetPaletteTarget(Window* target);
+        // Draws the map as one quad textured with its chunk imposters, and leaves out the grid
+        // lines, for an overview that costs the same however big the map is. Call before PrepareRendering()
+        void SetMinimap(bool minimap);
+
+        // Painting with the mouse, a whole stroke is one undo step
+        void BeginStroke(bool erase);
+        void EndStroke();
+        void Undo();
+        void Redo();
+
+        // Input handling for the tilemap editor, called from the GLFW callbacks
+        void OnCursorMoved(double x, double y);
+
+        ////////////////// INPUT RECORDING /////////////////////////
+
+        // Logs every input event until StopRecording, or the window closing
+        void StartRecording(const std::string& path);
+        void StopRecording();
+        // Feeds a recorded log back through the input callbacks, one fixed step of log time per frame
+        // however long the frames take, so every replay does the same work. Live input is ignored
+        // until it's done, then the timing is printed
+        bool StartReplay(const std::string& path, bool closeWhenDone);
+        bool IsReplaying();
+        // Every input callback calls this first. Records the event, returns false if it should be dropped
+        bool FilterInput(const InputEvent& event);
+
+        // Only redraws the screen area these tiles cover, if partial redraw is on
+        void MarkTilesDirty(glm::ivec2 minTile, glm::ivec2 maxTile);
+        void SetPartialRedraw(bool enabled);
 
         //////////// GET INFORMATION ABOUT WINDOW //////////////////
 
@@ -95,17 +168,31 @@ namespace WindowManager
         glm::vec3 UnProject(glm::vec3 inVec3);
         glm::vec3 Project(glm::vec3 inVec3);
         void SetupCamera();
+        void UpdatePickMatrices();
+        void UpdateHoveredTile();
 
         ////////////////// UPDATE FUNCTIONS /////////////////////////
 
         void Update();
         void CalculateDeltaTime();
         void Clear();
+        void UpdateReplay();
+        void FinishReplay();
+        // The replayed cursor while replaying, GLFW's otherwise
+        void GetCursorPos(double& x, double& y);
 
         ///////// FUNCTIONS FOR THE TILEMAP EDITOR /////////////////////
 
         void DrawGridLines();
+        void DrawTiles();
+        void DrawImposters();
+        void DrawHoveredTile();
         void DrawUI();
+        void PaintTile(glm::ivec2 tile);
+
+        // Scissors rendering to the damaged area when only a few tiles changed
+        void BeginDamageScissor();
+        void EndDamageScissor();
 
         glm::vec3 m_lastScreenCoordinates = glm::vec3(0.0f);
         glm::vec3 m_currentCoords = glm::vec3(0.0f);
@@ -116,19 +203,29 @@ namespace WindowManager
         const char* m_winTitle = DEFAULT_TITLE;
 
         /// IMGUI ///
+        // Each window has its own context, all of them on the RenderResources font atlas
+        ImGuiContext* m_imguiContext = NULL;
         ImGuiIO* m_io;
+        bool m_bUICaptureMouse = false;
+        bool m_bShowUI = true;
 
         bool m_winIsClosed = false;
         bool m_firstFrame = true;
 
-        double m_frameRate = 60.0;
-        double m_fixedDeltaTime = 1.0 / m_frameRate;
         double m_deltaTime, m_lastUpdate = 0.0;
-        double m_lastFrameTime = 0.0;
+
+        // Event handling, fixed step timing and frame limiting
+        FramePacer m_pacer;
+        std::function<void(double)> m_fixedUpdate;
 
         GLFWwindow* m_winContext = NULL;
         GLFWwindow* m_window = NULL;
 
+        // Set when a WindowGroup runs this window
+        WindowGroup* m_group = nullptr;
+        // RenderResources version the last frame was drawn with
+        unsigned int m_resourceVersion = 0;
+
         Camera* m_camera;
 
         // Position in grid coordinates
@@ -137,13 +234,22 @@ namespace WindowManager
         glm::mat4 m_isoMatrix;
         // Inverse for unprojecting screen deltas
         glm::mat4 m_invIsoMatrix;
+        // projection * view * m_model and its inverse, rebuilt every frame for picking
+        glm::mat4 m_mvpMatrix = glm::mat4(1.0f);
+        glm::mat4 m_invMvpMatrix = glm::mat4(1.0f);
 
         glm::vec3 m_worldOrigin = glm::vec3(0.0f, 0.0f, 0.0f);
 
         glm::vec3 m_deltaScreenPos = glm::vec3(0.0f);
         glm::vec3 m_currentScreenPos = glm::vec3(0.0f, 0.0f, 0.0f);
 
-        glm::vec3 m_singleTileSize;
+        glm::vec3 m_singleTileSize = glm::vec3(0.0f);
+        unsigned int m_numCols = 0;
+        unsigned int m_numRows = 0;
+
+        // Tile under the mouse cursor
+        glm::ivec2 m_hoveredTile = glm::ivec2(0);
+        bool m_bHoveringTile = false;
 
         // SHADER & RENDERING DATA
             // View matrix
@@ -157,12 +263,63 @@ namespace WindowManager
             // Shader program pointers
         Shader* m_shaderPtr;
         Shader* m_uiShaderPtr;
+        Shader* m_tileShaderPtr;
+        Shader* m_minimapShaderPtr;
+
+        // Tile data is owned by the tilemap editor
+        TileMap* m_tileMap = nullptr;
+        EditHistory* m_editHistory = nullptr;
+        // Shared with every window showing the same map, through RenderResources
+        TileRenderer* m_tileRenderer = nullptr;
+        unsigned int m_tileView = 0;
+        TileID m_activeTile = 1;
+        Window* m_paletteTarget = nullptr;
+        // Minimaps draw from these instead of the tile renderer
+        bool m_bMinimap = false;
+        TileImposters* m_tileImposters = nullptr;
+        bool m_bPainting = false;
+        bool m_bErasing = false;
+        bool m_bShowProfiler = false;
+        bool m_bShowRenderStats = false;
+
+        // Input recording and replay
+        InputRecorder m_inputRecorder;
+        double m_recordStart = 0.0;
+        InputReplay m_inputReplay;
+        bool m_bReplaying = false;
+        // Set while replayed events go through the callbacks, to tell them apart from live ones
+        bool m_bInjectingInput = false;
+        bool m_bCloseAfterReplay = false;
+        double m_replayTime = 0.0;
+        double m_replayStart = 0.0;
+        unsigned long long m_replayFrames = 0;
+        double m_replayCursorX = 0.0;
+        double m_replayCursorY = 0.0;
+        Pacing_Mode m_preReplayMode = PACING_EVENT_DRIVEN;
+
+        // Screen area (pixels, top left origin) that needs redrawing. The previous frame's
+        // area is kept too, since with double buffering the back buffer is two frames old
+        bool m_bPartialRedraw = false;
+        bool m_bFullRedraw = true;
+        bool m_bPrevFullRedraw = true;
+        bool m_bHasDamage = false;
+        bool m_bPrevHasDamage = false;
+        glm::vec2 m_damageMin = glm::vec2(0.0f);
+        glm::vec2 m_damageMax = glm::vec2(0.0f);
+        glm::vec2 m_prevDamageMin = glm::vec2(0.0f);
+        glm::vec2 m_prevDamageMax = glm::vec2(0.0f);
 
         std::vector<glm::vec3> m_gridLines;
+        // Name of the shared grid line buffer, one per grid size
+        std::string m_gridBufferName;
         GLuint lineVBO;
         GLuint lineVAO;
         GLuint crossHairVAO;
         GLuint crossHairVBO;
+        GLuint hoverVAO;
+        GLuint hoverVBO;
+        GLuint quadVAO = 0;
+        GLuint quadVBO = 0;
 
         std::vector<glm::vec3> m_crossHairLines =
         {
@@ -172,9 +329,37 @@ namespace WindowManager
             glm::vec3( 0.0f,  0.02f, 0.0f), // Vertical top
         };
 
-        // Variables for working with IMGUI - TEMPORARY
-        float m_gridx = 0.0f;
-        float m_gridy = 0.0f;
+        friend class WindowGroup;
+    };
+
+    // Several windows run off one loop. Events are handled once per pass for all of them, and
+    // only the windows that changed get drawn, so idle windows cost next to nothing. Only the
+    // first open window waits for vblank, otherwise each swap would wait its own.
+    //
+    //     WindowGroup group;
+    //     group.Add(&editor); group.Add(&palette);
+    //     while (!editor.IsClosed()) { group.Update(); }
+    //     group.CloseAll();
+    class WindowGroup
+    {
+    public:
+        void Add(Window* window);
+        // One pass of the loop. Waits for events if no window needs drawing, closes the windows
+        // that were asked to close and updates the rest
+        void Update();
+        void CloseAll();
+        // Every window is closed
+        bool IsClosed();
+
+        unsigned int GetNumWindows();
+        Window* GetWindow(unsigned int index);
+        // Drawing time per window and in total
+        std::string GetReport();
+
+    private:
+        void UpdateVBlankSync();
+
+        std::vector<Window*> m_windows;
     };
 
     ///////////////// SHUTDOWN FUNCTIONS //////////////////////////
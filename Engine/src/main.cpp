@@ -1,14 +1,86 @@
 #define GLFW_INCLUDE_NONE
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include <Engine.h>
+#include <NullRenderDevice.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <RenderDevice.h>
+#include <ShaderCache.h>
+#include <SoftwareRenderDevice.h>
 
-int main()
+int main(int argc, char** argv)
 {
 	Engine newEngineInstance;
+
+	// --headless [frames] [trace.json] [stats.csv|stats.json] draws the scene through the null device, no
+	// window or GPU needed. Fails if anything submitted would have been a GL error
+	if (argc > 1 && std::string(argv[1]) == "--headless")
+	{
+		NullRenderDevice device;
+		device.SetRecording(false);
+		RenderDevice::Set(&device);
+		// The null device's token binaries would fill shader_cache/ and the next run would load
+		// from it, submitting different calls. Every run compiles, so runs compare
+		ShaderCache::Get().SetEnabled(false);
+		newEngineInstance.RunHeadless(argc > 2 ? std::atoi(argv[2]) : 60);
+		RenderDevice::Set(NULL);
+
+		std::cout << device.GetReport() << std::endl;
+		std::cout << Profiler::Get().GetReport() << std::endl;
+		std::cout << RenderStats::Get().GetReport() << std::endl;
+		if (argc > 3 && !Profiler::Get().WriteChromeTrace(argv[3]))
+		{
+			std::cout << "Failed to write " << argv[3] << std::endl;
+			return 1;
+		}
+		if (argc > 4)
+		{
+			std::string statsPath = argv[4];
+			bool json = statsPath.size() >= 5 && statsPath.compare(statsPath.size() - 5, 5, ".json") == 0;
+			if (!(json ? RenderStats::Get().WriteJSON(statsPath) : RenderStats::Get().WriteCSV(statsPath)))
+			{
+				std::cout << "Failed to write " << statsPath << std::endl;
+				return 1;
+			}
+		}
+		return device.GetStats().invalidCalls == 0 ? 0 : 1;
+	}
+
+	// --software [frames] [image.ppm] [trace.json] draws the same scene on the CPU rasterizer and saves
+	// the last frame, which comes out identical on every machine and thread count
+	if (argc > 1 && std::string(argv[1]) == "--software")
+	{
+		unsigned int numFrames = argc > 2 ? std::atoi(argv[2]) : 60;
+		std::string imagePath = argc > 3 ? argv[3] : "software_frame.ppm";
+		std::string tracePath = argc > 4 ? argv[4] : "";
+
+		SoftwareRenderDevice device(newEngineInstance.winX, newEngineInstance.winY);
+		RenderDevice::Set(&device);
+		newEngineInstance.RunHeadless(numFrames);
+		RenderDevice::Set(NULL);
+
+		std::cout << device.GetName() << ": " << numFrames << " frames, " << device.GetNumTriangles()
+			<< " triangles on " << device.GetNumThreads() << " threads" << std::endl;
+		std::cout << Profiler::Get().GetReport() << std::endl;
+		if (!device.SaveImage(imagePath))
+		{
+			std::cout << "Failed to write " << imagePath << std::endl;
+			return 1;
+		}
+		if (!tracePath.empty() && !Profiler::Get().WriteChromeTrace(tracePath))
+		{
+			std::cout << "Failed to write " << tracePath << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
 	newEngineInstance.SetupGLFW();
 	newEngineInstance.StartRenderLoop();
 	return 0;
-}
\ No newline at end of file
+}
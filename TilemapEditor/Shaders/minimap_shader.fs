@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D imposters;
+
+void main()
+{
+    vec4 color = texture(imposters, TexCoord);
+    // Alpha is how much of the texel is filled. Nothing blends, so mostly empty texels are left out
+    if (color.a < 0.5)
+    {
+        discard;
+    }
+    FragColor = vec4(color.rgb, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+
+out vec2 TexCoord;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+// Grid space area the imposter texture covers
+uniform vec2 mapSize;
+
+void main()
+{
+    // Unit quad stretched over the map, lying on the grid plane like the tiles
+    TexCoord = aCorner;
+    gl_Position = projection * view * model * vec4(aCorner.x * mapSize.x, 0.0, aCorner.y * mapSize.y, 1.0);
+}
\ No newline at end of file
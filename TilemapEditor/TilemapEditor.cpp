@@ -1,7 +1,10 @@
 #include <vector>
 #include <glad/glad.h>
 #include <WindowManager.h>
+#include <NullRenderDevice.h>
+#include <RenderDevice.h>
 #include <SHADER.h>
+#include <ShaderCache.h>
 
 #include <TilemapEditor.h>
 
@@ -9,7 +12,7 @@ namespace TilemapEditor
 {
     GLFWwindow* currentWindow = nullptr;
 
-    void OpenWindows()
+    void OpenWindows(const Options& options)
     {
         if (WindowManager::Window::Init())
         {
@@ -19,34 +22,92 @@ namespace TilemapEditor
 
             glfwWindowHint(GLFW_FOCUSED, GLFW_FALSE);
 
-            //WindowManager::Window paletteWindow(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, "Palette");
-            // Share context between the two windows, to share textures, etc.
+            NullRenderDevice nullDevice;
+            if (options.headless)
+            {
+                glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+                nullDevice.SetRecording(false);
+                RenderDevice::Set(&nullDevice);
+                // Nothing real to cache, and a headless run shouldn't leave shader_cache/ behind
+                ShaderCache::Get().SetEnabled(false);
+            }
+
+            // The editor's window is made first, the others share its context so the programs,
+            // grid buffers and tile buffers only exist once
             WindowManager::Window editorWindow(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, "Tilemap Editor");
+            WindowManager::Window paletteWindow(PALETTE_WINDOW_WIDTH, PALETTE_WINDOW_HEIGHT, "Palette");
+            WindowManager::Window minimapWindow(MINIMAP_WINDOW_SIZE, MINIMAP_WINDOW_SIZE, "Minimap");
 
             editorWindow.SetFocused();
             currentWindow = editorWindow.GetWindow();
 
             // Send the generated grid data to the editor window
             editorWindow.ReceiveGridData(grid.GetGridData());
+            editorWindow.ReceiveTileMap(grid.GetTileMap(), grid.GetEditHistory());
             editorWindow.PrepareRendering();
 
+            // One tile of each colour, clicking one picks it for the editor
+            Grid palette(DEFAULT_PALETTE_SIZE, 1);
+            for (unsigned int i = 0; i < DEFAULT_PALETTE_SIZE; ++i)
+            {
+                palette.GetTileMap()->SetTile(i, 0, (TileID)(i + 1));
+            }
+            paletteWindow.ReceiveGridData(palette.GetGridData());
+            paletteWindow.ReceiveTileMap(palette.GetTileMap(), NULL);
+            paletteWindow.SetPaletteTarget(&editorWindow);
+            paletteWindow.PrepareRendering();
+            paletteWindow.FitToMap();
+            paletteWindow.SetUIVisible(false);
+
+            // The editor's map without an edit history, so it can't be painted on. Drawn from
+            // chunk imposters, which only get redone for the chunks an edit touched
+            minimapWindow.ReceiveGridData(grid.GetGridData());
+            minimapWindow.ReceiveTileMap(grid.GetTileMap(), NULL);
+            minimapWindow.SetMinimap(true);
+            minimapWindow.PrepareRendering();
+            minimapWindow.FitToMap();
+            minimapWindow.SetUIVisible(false);
+
+            // Static map doesn't need redrawing until something changes
+            WindowManager::WindowGroup windows;
+            windows.Add(&editorWindow);
+            windows.Add(&paletteWindow);
+            windows.Add(&minimapWindow);
+            editorWindow.SetPacingMode(PACING_EVENT_DRIVEN);
+            paletteWindow.SetPacingMode(PACING_EVENT_DRIVEN);
+            minimapWindow.SetPacingMode(PACING_EVENT_DRIVEN);
+
+            if (!options.recordPath.empty())
+            {
+                editorWindow.StartRecording(options.recordPath);
+            }
+            if (!options.replayPath.empty() && !editorWindow.StartReplay(options.replayPath, true))
+            {
+                editorWindow.DestroyWindow();
+            }
+
             // RENDER LOOP ENTRY
+            // Closing the editor closes the rest, the others can be closed on their own
             while (!editorWindow.IsClosed())
             {
-                if (editorWindow.ShouldClose()) {editorWindow.DestroyWindow();}
-                else
-                {
-                    if (editorWindow.IsCurrent())
-                    {
-                        editorWindow.onUpdate();
-                    }
-                }
+                windows.Update();
             }
-            if (editorWindow.IsClosed()) { WindowManager::CloseGLFW(); }
+            windows.CloseAll();
+            std::cout << windows.GetReport() << std::endl;
+            WindowManager::CloseGLFW();
+            RenderDevice::Set(NULL);
         }
     }
 
     Grid::Grid()
+        : Grid(DEFAULT_NUM_COLS, DEFAULT_NUM_ROWS)
+    {
+    }
+
+    Grid::Grid(unsigned int numCols, unsigned int numRows)
+        : m_numRows(numRows)
+        , m_numCols(numCols)
+        , m_tileMap(numCols, numRows)
     {
         GenerateGrid();
     }
@@ -56,6 +117,16 @@ namespace TilemapEditor
         return m_gridLines.size();
     }
 
+    TileMap* Grid::GetTileMap()
+    {
+        return &m_tileMap;
+    }
+
+    EditHistory* Grid::GetEditHistory()
+    {
+        return &m_editHistory;
+    }
+
     void Grid::GenerateGrid()
     {
         std::cout << "Generating grid..." << std::endl;
@@ -6,6 +6,11 @@
 #define DEFAULT_TILE_SIZE 5.0f
 #define DEFAULT_NUM_COLS 50
 #define DEFAULT_NUM_ROWS 50
+// One tile of each colour, in a row
+#define DEFAULT_PALETTE_SIZE 8
+#define PALETTE_WINDOW_WIDTH 480
+#define PALETTE_WINDOW_HEIGHT 160
+#define MINIMAP_WINDOW_SIZE 320
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -13,13 +18,27 @@
 
 #include <WindowManager.h>
 #include <SHADER.h>
+#include <TileMap.h>
+#include <EditHistory.h>
 #include <glm/glm.hpp>
+#include <string>
 #include <vector>
 #include <glad/glad.h>
 
 namespace TilemapEditor
 {
-    void OpenWindows();
+    struct Options
+    {
+        // Input log to write when the editor closes
+        std::string recordPath;
+        // Input log to play back, the editor closes when it's done
+        std::string replayPath;
+        // Hidden window, and the engine's own drawing goes to the null device. ImGui still
+        // renders through GL, so this needs a context but measures the editor's CPU side
+        bool headless = false;
+    };
+
+    void OpenWindows(const Options& options = Options());
     bool ExitProgram();
 
     void PaletteWindowRenderCommands();
@@ -29,15 +48,21 @@ namespace TilemapEditor
 
         public:
             Grid();
+            Grid(unsigned int numCols, unsigned int numRows);
             void GenerateGrid();
             WindowManager::Window::GridData GetGridData();
             int GetNumLines();
+            TileMap* GetTileMap();
+            EditHistory* GetEditHistory();
         private:
             float m_tileSize = DEFAULT_TILE_SIZE;
-            unsigned int m_numRows = DEFAULT_NUM_ROWS;
-            unsigned int m_numCols = DEFAULT_NUM_COLS;
+            unsigned int m_numRows;
+            unsigned int m_numCols;
             std::vector<glm::vec3> m_gridLines;
             WindowManager::Window::GridData m_gridData;
+            // Tile contents of the grid, plus undo/redo for edits made to it
+            TileMap m_tileMap;
+            EditHistory m_editHistory;
 
 
         };
@@ -1,13 +1,39 @@
 ﻿#define GLFW_INCLUDE_NONE
 #include <iostream>
+#include <string>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include <TilemapEditor.h>
 
 
-int main()
+int main(int argc, char** argv)
 {
-    TilemapEditor::OpenWindows();
+    // --record log.ilog saves the session's input, --replay log.ilog plays one back as fast as
+    // possible and prints the timing, --headless hides the window and skips the engine's drawing
+    TilemapEditor::Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc)
+        {
+            options.recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            options.replayPath = argv[++i];
+        }
+        else if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else
+        {
+            std::cout << "Usage: TOOL_tilemap_editor [--record log] [--replay log] [--headless]" << std::endl;
+            return 1;
+        }
+    }
+
+    TilemapEditor::OpenWindows(options);
     return 0;
 }
\ No newline at end of file